@@ -3,6 +3,29 @@ use cc;
 
 fn main() {
     cc::Build::new()
+        .cpp(true)
+        .std("c++17")
         .file("src/fastwildcompare.cpp")
+        .file("src/wildpatternset.cpp")
+        .file("src/wildbytecode.cpp")
+        .file("src/wildhybrid.cpp")
+        .file("src/wildparallel.cpp")
+        .file("src/wilddfa.cpp")
+        .file("src/wildfnmatch.cpp")
+        .file("src/wildlike.cpp")
+        .file("src/wildtoken.cpp")
+        .file("src/wildpacked.cpp")
+        .file("src/wildcorpus.cpp")
+        .file("src/wildcache.cpp")
+        .file("src/wildstanding.cpp")
+        .file("src/wildsession.cpp")
+        .file("src/wildshard.cpp")
+        .file("src/wildservice.cpp")
+        .file("src/wildpipeline.cpp")
+        .file("src/wildsplice.cpp")
+        .file("src/wildbitsink.cpp")
+        .file("src/wildcompiled.cpp")
+        .file("src/wildresource.cpp")
+        .file("src/wildtiered.cpp")
         .compile("fastwildcompare");
 }
\ No newline at end of file
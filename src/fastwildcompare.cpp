@@ -31,6 +31,31 @@
 #define COMPARE_WILD         1
 #define COMPARE_TAME         1
 #define COMPARE_EMPTY        1
+#define TEST_ENGINES         1
+
+#if defined(TEST_ENGINES)
+#include "wildpatternset.h"
+#include "wildbytecode.h"
+#include "wildhybrid.h"
+#include "wildparallel.h"
+#include "wilddfa.h"
+#include "wildfnmatch.h"
+#include "wildlike.h"
+#include "wildtoken.h"
+#include "wildpacked.h"
+#include "wildcorpus.h"
+#include "wildcache.h"
+#include "wildstanding.h"
+#include "wildsession.h"
+#include "wildshard.h"
+#include "wildservice.h"
+#include "wildpipeline.h"
+#include "wildsplice.h"
+#include "wildbitsink.h"
+#include "wildcompiled.h"
+#include "wildresource.h"
+#include "wildtiered.h"
+#endif
 
 // Compares two text strings.  Accepts '?' as a single-character wildcard.  
 // For each '*' wildcard, seeks out a matching sequence of any characters 
@@ -800,6 +825,53 @@ int main(void)
 	testwild();
 #endif
 
+#if defined(TEST_ENGINES)
+	testpatternset();
+	testbytecode();
+	testhybrid();
+	testparallel();
+	testdfa();
+	testfnmatch();
+	testlike();
+	testtoken();
+	testpacked();
+	testcorpus();
+	testcache();
+	teststanding();
+	testsession();
+	testshard();
+	testservice();
+	testpipeline();
+	testsplice();
+	testbitsink();
+	testcompiled();
+	testresource();
+	testtiered();
+#if defined(COMPARE_PERFORMANCE)
+	benchpatternset();
+	benchbytecode();
+	benchhybrid();
+	benchparallel();
+	benchdfa();
+	benchfnmatch();
+	benchlike();
+	benchtoken();
+	benchpacked();
+	benchcorpus();
+	benchcache();
+	benchstanding();
+	benchsession();
+	benchshard();
+	benchservice();
+	benchpipeline();
+	benchsplice();
+	benchbitsink();
+	benchcompiled();
+	benchresource();
+	benchtiered();
+#endif
+#endif
+
 	return 0;
 }
 #endif  // defined(BUILD_A_CPP_EXE)
\ No newline at end of file
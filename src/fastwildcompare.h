@@ -0,0 +1,29 @@
+// FastWildCompare(), and related code: declarations
+//
+// Copyright 2025 Kirk J Krauss.  This is a Derivative Work based on
+// material that is copyright 2018 IBM Corporation and available at
+//
+//  http://developforperformance.com/MatchingWildcards_AnImprovedAlgorithmForBigData.html
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// This file declares the C/C++ routines for matching wildcards, so that
+// the engines built on them (pattern sets and so on) can call them.
+//
+#ifndef FASTWILDCOMPARE_H
+#define FASTWILDCOMPARE_H
+
+extern "C" bool FastWildCompare(char *pWild, char *pTame);
+extern "C" bool FastWildComparePortable(char *strWild, char *strTame);
+
+#endif  // FASTWILDCOMPARE_H
@@ -27,6 +27,8 @@ const COMPARE_WILD: bool = true;
 const COMPARE_TAME: bool = true;
 const COMPARE_EMPTY: bool = true;
 const TEST_UTF8: bool = false;
+const TEST_ENGINES: bool = true;
+const COMPARE_ENGINES: bool = false;
 
 // File=scope variables for accumulating performance data.
 static mut U_RUST_TIME_ASCII: u128 = 0;
@@ -57,6 +59,53 @@ unsafe extern "C" {
     ) -> bool;
 }
 
+// Declarations for the testcases of the C++ engines built on the algorithm 
+// (pattern sets and so on), which run and time themselves.
+unsafe extern "C" {
+    pub fn testpatternset() -> i32;
+    pub fn benchpatternset() -> i32;
+    pub fn testbytecode() -> i32;
+    pub fn benchbytecode() -> i32;
+    pub fn testhybrid() -> i32;
+    pub fn benchhybrid() -> i32;
+    pub fn testparallel() -> i32;
+    pub fn benchparallel() -> i32;
+    pub fn testdfa() -> i32;
+    pub fn benchdfa() -> i32;
+    pub fn testfnmatch() -> i32;
+    pub fn benchfnmatch() -> i32;
+    pub fn testlike() -> i32;
+    pub fn benchlike() -> i32;
+    pub fn testtoken() -> i32;
+    pub fn benchtoken() -> i32;
+    pub fn testpacked() -> i32;
+    pub fn benchpacked() -> i32;
+    pub fn testcorpus() -> i32;
+    pub fn benchcorpus() -> i32;
+    pub fn testcache() -> i32;
+    pub fn benchcache() -> i32;
+    pub fn teststanding() -> i32;
+    pub fn benchstanding() -> i32;
+    pub fn testsession() -> i32;
+    pub fn benchsession() -> i32;
+    pub fn testshard() -> i32;
+    pub fn benchshard() -> i32;
+    pub fn testservice() -> i32;
+    pub fn benchservice() -> i32;
+    pub fn testpipeline() -> i32;
+    pub fn benchpipeline() -> i32;
+    pub fn testsplice() -> i32;
+    pub fn benchsplice() -> i32;
+    pub fn testbitsink() -> i32;
+    pub fn benchbitsink() -> i32;
+    pub fn testcompiled() -> i32;
+    pub fn benchcompiled() -> i32;
+    pub fn testresource() -> i32;
+    pub fn benchresource() -> i32;
+    pub fn testtiered() -> i32;
+    pub fn benchtiered() -> i32;
+}
+
 
 // This function compares a tame/wild string pair via each included routine.
 //
@@ -669,6 +718,62 @@ fn main()
 		test_utf8();
 	}
 
+	if TEST_ENGINES
+	{
+		unsafe
+		{
+			testpatternset();
+			testbytecode();
+			testhybrid();
+			testparallel();
+			testdfa();
+			testfnmatch();
+			testlike();
+			testtoken();
+			testpacked();
+			testcorpus();
+			testcache();
+			teststanding();
+			testsession();
+			testshard();
+			testservice();
+			testpipeline();
+			testsplice();
+			testbitsink();
+			testcompiled();
+			testresource();
+			testtiered();
+		}
+	}
+
+	if COMPARE_ENGINES
+	{
+		unsafe
+		{
+			benchpatternset();
+			benchbytecode();
+			benchhybrid();
+			benchparallel();
+			benchdfa();
+			benchfnmatch();
+			benchlike();
+			benchtoken();
+			benchpacked();
+			benchcorpus();
+			benchcache();
+			benchstanding();
+			benchsession();
+			benchshard();
+			benchservice();
+			benchpipeline();
+			benchsplice();
+			benchbitsink();
+			benchcompiled();
+			benchresource();
+			benchtiered();
+		}
+	}
+
 	if COMPARE_PERFORMANCE
 	{
 		unsafe  // Timings have been accumulated via mutable file-scope data.
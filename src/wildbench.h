@@ -0,0 +1,157 @@
+// Helpers for the performance comparisons of the wildcard matching engines
+//
+// Copyright 2025 Kirk J Krauss.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// The engine benchmarks generate their corpora here, from a fixed seed, so
+// that every run (and every engine) sees the same path-like keys and
+// patterns.
+//
+#ifndef WILDBENCH_H
+#define WILDBENCH_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <string>
+
+// A small xorshift generator.  Deterministic, so runs are comparable.
+//
+struct WildBenchRandom
+{
+	uint64_t uState;
+
+	explicit WildBenchRandom(uint64_t uSeed) : uState(uSeed | 1)
+	{
+	}
+
+	uint32_t Next()
+	{
+		uState ^= uState << 13;
+		uState ^= uState >> 7;
+		uState ^= uState << 17;
+		return (uint32_t) (uState >> 16);
+	}
+
+	uint32_t Below(uint32_t uLimit)
+	{
+		return Next() % uLimit;
+	}
+};
+
+
+// Returns a monotonic timestamp in nanoseconds.
+//
+inline uint64_t WildBenchNanos()
+{
+	return (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+	    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+// A path in the temporary directory.
+//
+inline std::string WildBenchTempPath(const char *pszName)
+{
+	const char *pszDir = getenv("TMPDIR");
+
+#if defined(_WIN32)
+	if (!pszDir)
+	{
+		pszDir = getenv("TEMP");
+	}
+#endif
+
+	return std::string(pszDir ? pszDir : "/tmp") + "/" + pszName;
+}
+
+
+// Makes a path-like key such as "/srv/app17/cache3.log".  Keys made with
+// bUnlisted get an extension that generated patterns never name, so that
+// they rarely match and a lookup has to consider every pattern.
+//
+inline void WildBenchMakeKey(WildBenchRandom &rng, std::string &strKey,
+                             bool bUnlisted = false)
+{
+	static const char *s_rgszWords[] =
+	{
+		"srv", "var", "home", "opt", "data", "logs", "prod", "tmp",
+		"cache", "user", "build", "etc", "lib", "media", "spool", "run"
+	};
+	static const char *s_rgszExts[] =
+	{
+		".log", ".txt", ".tar.gz", ".json", ".parquet", ".csv", ".bin", ".db"
+	};
+	char szNum[16];
+
+	strKey = "/";
+	strKey += s_rgszWords[rng.Below(16)];
+	strKey += "/";
+	strKey += s_rgszWords[rng.Below(16)];
+	snprintf(szNum, sizeof(szNum), "%u", rng.Below(1000));
+	strKey += szNum;
+	strKey += "/";
+	strKey += s_rgszWords[rng.Below(16)];
+	snprintf(szNum, sizeof(szNum), "%u", rng.Below(100000));
+	strKey += szNum;
+	strKey += bUnlisted ? ".idx" : s_rgszExts[rng.Below(8)];
+}
+
+
+// Makes a pattern by wildcarding parts of a generated key.  Most patterns
+// keep a literal head, the way real rule sets do; some start with '*'.
+//
+inline void WildBenchMakePattern(WildBenchRandom &rng, std::string &strWild)
+{
+	std::string strKey;
+	size_t      iCut;
+
+	WildBenchMakeKey(rng, strKey);
+
+	switch (rng.Below(8))
+	{
+	case 0:
+		// Leading '*' with a literal suffix: "*.tar.gz".
+		strWild = "*" + strKey.substr(strKey.rfind('.'));
+		break;
+
+	case 1:
+		// Anchored directory with any file name: "/srv/app17/*".
+		strWild = strKey.substr(0, strKey.rfind('/') + 1) + "*";
+		break;
+
+	case 2:
+		// A '?' in place of a digit or letter.
+		iCut = 1 + rng.Below((uint32_t) strKey.size() - 1);
+		strWild = strKey;
+		strWild[iCut] = '?';
+		break;
+
+	case 3:
+		// Middle wildcard: "/srv/*.log".
+		strWild = strKey.substr(0, strKey.find('/', 1) + 1) + "*" +
+		          strKey.substr(strKey.rfind('.'));
+		break;
+
+	default:
+		// Prefix of a key, reaching into its second directory, then '*'.
+		iCut = strKey.find('/', 1) + 2;
+		iCut += rng.Below((uint32_t) (strKey.size() - iCut));
+		strWild = strKey.substr(0, iCut) + "*";
+		break;
+	}
+}
+
+#endif  // WILDBENCH_H
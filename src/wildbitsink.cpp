@@ -0,0 +1,630 @@
+// WildBitmapSink, and related code
+//
+// Copyright 2025 Kirk J Krauss.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// This file provides the bitmap sink and its streaming copy.  It also
+// includes testcases for correctness and performance.
+//
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define WILD_HAVE_MMAP  1
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <emmintrin.h>
+#define WILD_HAVE_STREAM_STORES  1
+#endif
+
+#include "fastwildcompare.h"
+#include "wilddfa.h"
+#include "wildbitsink.h"
+#include "wildbench.h"
+
+
+// Copies whole cache lines to 64-byte aligned memory without caching
+// them.  Callers fence once after the last.
+//
+static void StreamLines(uint8_t *pDest, const uint64_t *pSource, size_t cb)
+{
+#if defined(WILD_HAVE_STREAM_STORES)
+	const __m128i *pFrom = (const __m128i *) pSource;
+	__m128i       *pTo = (__m128i *) pDest;
+
+	for (size_t i = 0; i < cb / 16; i += 4)
+	{
+		__m128i v0 = _mm_loadu_si128(pFrom + i);
+		__m128i v1 = _mm_loadu_si128(pFrom + i + 1);
+		__m128i v2 = _mm_loadu_si128(pFrom + i + 2);
+		__m128i v3 = _mm_loadu_si128(pFrom + i + 3);
+
+		_mm_stream_si128(pTo + i, v0);
+		_mm_stream_si128(pTo + i + 1, v1);
+		_mm_stream_si128(pTo + i + 2, v2);
+		_mm_stream_si128(pTo + i + 3, v3);
+	}
+#else
+	memcpy(pDest, pSource, cb);
+#endif
+}
+
+
+WildBitmapSink::WildBitmapSink() :
+    m_fd(-1), m_pBase(NULL), m_cbFile(0), m_cPatterns(0), m_cbTile(0),
+    m_cTiles(0), m_cbStride(0), m_cGroupTiles(1), m_cFlushes(0),
+    m_bFlushFailed(false)
+{
+}
+
+
+WildBitmapSink::~WildBitmapSink()
+{
+	Close();
+}
+
+
+bool WildBitmapSink::Open(const char *pszPath, uint32_t cPatterns,
+                          uint64_t cKeys, uint32_t cTileKeys, size_t cbFlush)
+{
+	Close();
+
+	if (cPatterns == 0 || cTileKeys == 0 ||
+	    cTileKeys % WILD_BITS_LINE_KEYS != 0)
+	{
+		return false;
+	}
+
+#if defined(WILD_HAVE_MMAP)
+	m_cPatterns = cPatterns;
+	m_cbTile = cTileKeys / 8;
+	m_cTiles = (cKeys + cTileKeys - 1) / cTileKeys;
+	m_cbStride = (m_cTiles * m_cbTile + WILD_BITS_ALIGN - 1) /
+	             WILD_BITS_ALIGN * WILD_BITS_ALIGN;
+	m_cbFile = WILD_BITS_ALIGN + cPatterns * m_cbStride;
+
+	// Groups start on page boundaries, so that no two share a page: a
+	// group is a multiple of the tiles it takes to end on one.
+	uint64_t cPageTiles = WILD_BITS_ALIGN /
+	                      std::min(m_cbTile & (0 - m_cbTile),
+	                               (uint32_t) WILD_BITS_ALIGN);
+	uint64_t cGroups;
+
+	m_cGroupTiles = std::max((cbFlush + m_cbTile - 1) / m_cbTile,
+	                         (uint64_t) 1);
+	m_cGroupTiles = (m_cGroupTiles + cPageTiles - 1) / cPageTiles *
+	                cPageTiles;
+	cGroups = (m_cTiles + m_cGroupTiles - 1) / m_cGroupTiles;
+	m_rgcGroupDone.reset(new std::atomic<uint64_t>[cGroups]);
+
+	for (uint64_t iGroup = 0; iGroup < cGroups; ++iGroup)
+	{
+		m_rgcGroupDone[iGroup] = 0;
+	}
+
+	m_cFlushes = 0;
+	m_bFlushFailed = false;
+	m_fd = open(pszPath, O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+	if (m_fd < 0)
+	{
+		return false;
+	}
+
+	// Setting the blocks aside up front keeps the file in few extents, and
+	// means that a full disk fails here rather than as a fault mid-sweep.
+	// Where the file system can't, a sparse file will do.
+#if defined(__linux__)
+	bool bSized = fallocate(m_fd, 0, 0, (off_t) m_cbFile) == 0 ||
+	              (errno == EOPNOTSUPP &&
+	               ftruncate(m_fd, (off_t) m_cbFile) == 0);
+#else
+	bool bSized = ftruncate(m_fd, (off_t) m_cbFile) == 0;
+#endif
+	void *pMap = bSized ? mmap(NULL, m_cbFile, PROT_READ | PROT_WRITE,
+	                           MAP_SHARED, m_fd, 0) : MAP_FAILED;
+
+	if (pMap == MAP_FAILED)
+	{
+		close(m_fd);
+		m_fd = -1;
+		return false;
+	}
+
+	m_pBase = (uint8_t *) pMap;
+
+	WildBitmapHeader header;
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.rgchMagic, "WILDBITS", 8);
+	header.uVersion = WILD_BITS_VERSION;
+	header.cPatterns = cPatterns;
+	header.cKeys = cKeys;
+	header.uOffset = WILD_BITS_ALIGN;
+	header.cbStride = m_cbStride;
+	memcpy(m_pBase, &header, sizeof(header));
+	return true;
+#else
+	(void) pszPath;
+	(void) cKeys;
+	return false;
+#endif
+}
+
+
+void WildBitmapSink::WriteTile(uint64_t iTile, uint32_t iPattern,
+                               const uint64_t *rgWords)
+{
+	StreamLines(m_pBase + WILD_BITS_ALIGN + iPattern * m_cbStride +
+	            iTile * m_cbTile, rgWords, m_cbTile);
+}
+
+
+void WildBitmapSink::FinishTile(uint64_t iTile)
+{
+#if defined(WILD_HAVE_STREAM_STORES)
+	// Streaming stores are weakly ordered: they must reach the mapping
+	// before its pages are written back.
+	_mm_sfence();
+#endif
+
+#if defined(WILD_HAVE_MMAP)
+	uint64_t iGroup = iTile / m_cGroupTiles;
+	uint64_t iFirstTile = iGroup * m_cGroupTiles;
+	uint64_t cTiles = std::min(m_cGroupTiles, m_cTiles - iFirstTile);
+
+	if (m_rgcGroupDone[iGroup].fetch_add(1, std::memory_order_acq_rel) + 1 !=
+	    cTiles)
+	{
+		return;
+	}
+
+	uint64_t uFirst = iFirstTile * m_cbTile;
+	uint64_t cb = std::min(cTiles * m_cbTile + WILD_BITS_ALIGN - 1,
+	                       m_cbStride - uFirst) / WILD_BITS_ALIGN *
+	              WILD_BITS_ALIGN;
+
+	for (uint32_t iPattern = 0; iPattern < m_cPatterns; ++iPattern)
+	{
+		uint64_t uOffset = WILD_BITS_ALIGN + iPattern * m_cbStride + uFirst;
+#if defined(__linux__)
+		bool     bStarted = sync_file_range(m_fd, (off_t) uOffset, (off_t) cb,
+		                                    SYNC_FILE_RANGE_WRITE) == 0;
+#else
+		bool     bStarted = msync(m_pBase + uOffset, cb, MS_ASYNC) == 0;
+#endif
+
+		if (!bStarted)
+		{
+			m_bFlushFailed = true;
+		}
+
+		m_cFlushes.fetch_add(1, std::memory_order_relaxed);
+	}
+#else
+	(void) iTile;
+#endif
+}
+
+
+bool WildBitmapSink::Close()
+{
+	bool bOk = !m_bFlushFailed;
+
+#if defined(WILD_HAVE_STREAM_STORES)
+	_mm_sfence();
+#endif
+
+#if defined(WILD_HAVE_MMAP)
+	if (m_pBase)
+	{
+		bOk &= munmap(m_pBase, m_cbFile) == 0;
+	}
+
+	if (m_fd >= 0)
+	{
+		bOk &= close(m_fd) == 0;
+	}
+#endif
+
+	m_pBase = NULL;
+	m_fd = -1;
+	m_cbFile = 0;
+	m_cTiles = 0;
+	m_rgcGroupDone.reset();
+	return bOk;
+}
+
+
+// A bit of a made-up result for a pattern and key.
+//
+static bool TestBit(uint32_t iPattern, uint64_t iKey)
+{
+	uint64_t u = (iKey + 1) * 0x9E3779B97F4A7C15ull ^
+	             iPattern * 0xBF58476D1CE4E5B9ull;
+
+	return ((u >> 29) ^ (u >> 41)) & 1;
+}
+
+
+extern "C" int testbitsink(void)
+{
+	bool bAllPassed = true;
+
+#if defined(WILD_HAVE_MMAP)
+	const std::string strPath = WildBenchTempPath("wildbitsink_test.bits");
+
+	for (uint32_t cTileKeys : {512u, 4096u, 32768u})
+	{
+		// Tiles in a scattered order, the last one partial: each pattern's
+		// bitmap reads back as written, at the offsets the header gives.
+		const uint32_t        cPatterns = 3;
+		const uint64_t        cKeys = 100003;
+		WildBitmapSink        sink;
+		std::vector<uint64_t> rgWords(cTileKeys / 64);
+
+		bAllPassed &= sink.Open(strPath.c_str(), cPatterns, cKeys,
+		                        cTileKeys, WILD_BITS_ALIGN) &&
+		              sink.TileCount() == (cKeys + cTileKeys - 1) / cTileKeys;
+
+		for (uint64_t i = 0; bAllPassed && i < sink.TileCount(); ++i)
+		{
+			uint64_t iTile = i * 7 % sink.TileCount();
+
+			if (sink.TileCount() % 7 == 0)
+			{
+				iTile = i;
+			}
+
+			for (uint32_t iPattern = 0; iPattern < cPatterns; ++iPattern)
+			{
+				std::fill(rgWords.begin(), rgWords.end(), 0);
+
+				for (uint32_t iBit = 0; iBit < cTileKeys; ++iBit)
+				{
+					uint64_t iKey = iTile * cTileKeys + iBit;
+
+					if (iKey < cKeys && TestBit(iPattern, iKey))
+					{
+						rgWords[iBit / 64] |= 1ull << (iBit % 64);
+					}
+				}
+
+				sink.WriteTile(iTile, iPattern, rgWords.data());
+			}
+
+			sink.FinishTile(iTile);
+		}
+
+		// Flushing a page at a time, each page of each bitmap is written
+		// back once its tiles are done.
+		bAllPassed &= sink.FlushCount() == cPatterns *
+		              ((cKeys / 8 + WILD_BITS_ALIGN) / WILD_BITS_ALIGN) &&
+		              sink.Close();
+
+		FILE                *pFile = fopen(strPath.c_str(), "rb");
+		std::vector<uint8_t> rgb;
+		uint8_t              rgbChunk[65536];
+		size_t               cb;
+
+		while (pFile && (cb = fread(rgbChunk, 1, sizeof(rgbChunk), pFile)))
+		{
+			rgb.insert(rgb.end(), rgbChunk, rgbChunk + cb);
+		}
+
+		if (pFile)
+		{
+			fclose(pFile);
+		}
+
+		WildBitmapHeader header;
+
+		bAllPassed &= rgb.size() >= sizeof(header);
+
+		if (!bAllPassed)
+		{
+			break;
+		}
+
+		memcpy(&header, rgb.data(), sizeof(header));
+		bAllPassed &= memcmp(header.rgchMagic, "WILDBITS", 8) == 0 &&
+		              header.uVersion == WILD_BITS_VERSION &&
+		              header.cPatterns == cPatterns && header.cKeys == cKeys &&
+		              header.uOffset % WILD_BITS_ALIGN == 0 &&
+		              header.cbStride % WILD_BITS_ALIGN == 0 &&
+		              rgb.size() == header.uOffset +
+		                            cPatterns * header.cbStride;
+
+		for (uint32_t iPattern = 0; bAllPassed && iPattern < cPatterns;
+		     ++iPattern)
+		{
+			const uint8_t *pBits = rgb.data() + header.uOffset +
+			                       iPattern * header.cbStride;
+
+			for (uint64_t iKey = 0; iKey < cKeys; ++iKey)
+			{
+				bAllPassed &= ((pBits[iKey / 8] >> (iKey % 8)) & 1) ==
+				              TestBit(iPattern, iKey);
+			}
+		}
+	}
+
+	remove(strPath.c_str());
+#endif
+
+	{
+		// Tiles must be whole cache lines.
+		WildBitmapSink sink;
+
+		bAllPassed &= !sink.Open("unused", 1, 1000, 1000) &&
+		              !sink.Open("unused", 0, 1000, 512);
+	}
+
+	if (bAllPassed)
+	{
+		printf("Passed bitmap sink tests\n");
+	}
+	else
+	{
+		printf("Failed bitmap sink tests\n");
+	}
+
+	return 0;
+}
+
+
+// Sweeps patterns over keys a tile at a time, packing each pattern's
+// results for a tile into bits, and passes them to output(), then passes
+// on that the tile is done.
+//
+template <typename Output>
+static void SweepTiles(const std::vector<WildDfa> &rgDfa,
+                           const std::string &strBytes,
+                           const std::vector<uint32_t> &rgOffsets,
+                           uint32_t cTileKeys, Output output)
+{
+	size_t                cKeys = rgOffsets.size() - 1;
+	std::vector<uint8_t>  rgbResult(cTileKeys);
+	std::vector<uint64_t> rgWords(cTileKeys / 64);
+
+	for (size_t iFirst = 0; iFirst < cKeys; iFirst += cTileKeys)
+	{
+		size_t cTile = std::min((size_t) cTileKeys, cKeys - iFirst);
+
+		for (uint32_t iPattern = 0; iPattern < rgDfa.size(); ++iPattern)
+		{
+			rgDfa[iPattern].MatchBatch(strBytes.data(),
+			                           rgOffsets.data() + iFirst, cTile,
+			                           rgbResult.data());
+			std::fill(rgWords.begin(), rgWords.end(), 0);
+
+			for (size_t i = 0; i < cTile; ++i)
+			{
+				rgWords[i / 64] |= (uint64_t) rgbResult[i] << (i % 64);
+			}
+
+			output(iFirst / cTileKeys, iPattern, rgWords.data(), false);
+		}
+
+		output(iFirst / cTileKeys, 0, rgWords.data(), true);
+	}
+}
+
+
+#if defined(WILD_HAVE_MMAP)
+// Waits for a file's data to reach the disk, as a sweep's output must
+// before it's of use.
+//
+static void SyncFile(const std::string &strPath)
+{
+	int fd = open(strPath.c_str(), O_RDONLY);
+
+	if (fd >= 0)
+	{
+		fdatasync(fd);
+		close(fd);
+	}
+}
+#endif
+
+
+extern "C" int benchbitsink(void)
+{
+#if defined(WILD_HAVE_MMAP)
+	const std::string strPath = WildBenchTempPath("wildbitsink_bench.bits");
+	const uint32_t    cTileKeys = WILD_BITS_TILE_KEYS;
+	const size_t      cbTile = cTileKeys / 8;
+
+	{
+		// Output alone: 1 GB of bitmaps, from bits already made, timed to
+		// the file's close and then to its data being on disk.
+		const uint32_t        cPatterns = 256;
+		const uint64_t        cKeys = 32ull << 20;
+		uint64_t              cTiles = cKeys / cTileKeys;
+		std::vector<uint64_t> rgWords(cTileKeys / 64);
+		double                cbAll = (double) cPatterns * cKeys / 8;
+
+		for (size_t i = 0; i < rgWords.size(); ++i)
+		{
+			rgWords[i] = i * 0x9E3779B97F4A7C15ull;
+		}
+
+		printf("Bitmap sink, %u patterns of %llu keys, %.0f MB:\n",
+		       cPatterns, (unsigned long long) cKeys, cbAll / 1e6);
+
+		for (int iWay = 0; iWay < 2; ++iWay)
+		{
+			WildBitmapSink sink;
+			FILE          *pFile = NULL;
+			uint64_t       uStart = WildBenchNanos();
+
+			if (iWay == 0)
+			{
+				pFile = fopen(strPath.c_str(), "wb");
+			}
+			else if (!sink.Open(strPath.c_str(), cPatterns, cKeys,
+			                    cTileKeys))
+			{
+				printf("  couldn't open %s\n", strPath.c_str());
+				return 0;
+			}
+
+			for (uint64_t iTile = 0; iTile < cTiles; ++iTile)
+			{
+				for (uint32_t iPattern = 0; iPattern < cPatterns;
+				     ++iPattern)
+				{
+					if (pFile)
+					{
+						fwrite(rgWords.data(), 1, cbTile, pFile);
+					}
+					else
+					{
+						sink.WriteTile(iTile, iPattern, rgWords.data());
+					}
+				}
+
+				if (!pFile)
+				{
+					sink.FinishTile(iTile);
+				}
+			}
+
+			if (pFile)
+			{
+				fclose(pFile);
+			}
+			else
+			{
+				sink.Close();
+			}
+
+			uint64_t uClosed = WildBenchNanos() - uStart;
+
+			SyncFile(strPath);
+
+			uint64_t uSynced = WildBenchNanos() - uStart;
+
+			printf("  %-10s closed %8.1f ms %7.1f MB/s, on disk %8.1f ms "
+			       "%7.1f MB/s\n", iWay ? "sink" : "fwrite()", uClosed / 1e6,
+			       cbAll * 1e3 / uClosed, uSynced / 1e6,
+			       cbAll * 1e3 / uSynced);
+			remove(strPath.c_str());
+		}
+	}
+
+	// A sweep of DFAs over keys, whose tables and tiles of keys want the
+	// cache that the output would take.  The best of a few runs each.
+	const size_t          cKeys = 1 << 20;
+	const int             cRuns = 3;
+	WildBenchRandom       rng(1220);
+	std::string           strBytes;
+	std::string           strKey;
+	std::vector<uint32_t> rgOffsets(1, 0);
+	std::vector<WildDfa>  rgDfa;
+
+	for (size_t i = 0; i < cKeys; ++i)
+	{
+		WildBenchMakeKey(rng, strKey, rng.Below(4) == 0);
+		strBytes += strKey;
+		rgOffsets.push_back((uint32_t) strBytes.size());
+	}
+
+	while (rgDfa.size() < 64)
+	{
+		std::string strWild;
+
+		WildBenchMakePattern(rng, strWild);
+		rgDfa.emplace_back();
+
+		if (!rgDfa.back().Compile(strWild.c_str()))
+		{
+			rgDfa.pop_back();
+		}
+	}
+
+	printf("  sweep, %zu patterns over %zu keys, %.1f MB of bitmaps:\n",
+	       rgDfa.size(), cKeys, rgDfa.size() * cKeys / 8 / 1e6);
+
+	for (int iWay = 0; iWay < 3; ++iWay)
+	{
+		uint64_t uBest = UINT64_MAX;
+
+		for (int iRun = 0; iRun < cRuns; ++iRun)
+		{
+			WildBitmapSink sink;
+			FILE          *pFile = NULL;
+			uint64_t       uStart = WildBenchNanos();
+
+			if (iWay == 1)
+			{
+				pFile = fopen(strPath.c_str(), "wb");
+			}
+			else if (iWay == 2)
+			{
+				sink.Open(strPath.c_str(), (uint32_t) rgDfa.size(), cKeys,
+				          cTileKeys);
+			}
+
+			SweepTiles(rgDfa, strBytes, rgOffsets, cTileKeys,
+			    [&](uint64_t iTile, uint32_t iPattern,
+			        const uint64_t *rgWords, bool bDone)
+			{
+				if (iWay == 1 && !bDone)
+				{
+					fwrite(rgWords, 1, cbTile, pFile);
+				}
+				else if (iWay == 2 && !bDone)
+				{
+					sink.WriteTile(iTile, iPattern, rgWords);
+				}
+				else if (iWay == 2)
+				{
+					sink.FinishTile(iTile);
+				}
+			});
+
+			if (pFile)
+			{
+				fclose(pFile);
+			}
+
+			sink.Close();
+
+			if (iWay)
+			{
+				SyncFile(strPath);
+				remove(strPath.c_str());
+			}
+
+			uBest = std::min(uBest, WildBenchNanos() - uStart);
+		}
+
+		printf("    %-14s %8.1f ms %8.1f M matches/s\n", iWay == 0 ?
+		       "no output" : iWay == 1 ? "fwrite()" : "sink", uBest / 1e6,
+		       rgDfa.size() * cKeys * 1e3 / uBest);
+	}
+#endif
+
+	return 0;
+}
@@ -0,0 +1,125 @@
+// WildBitmapSink, a result file of per-pattern match bitmaps, written
+// through a mapping with streaming stores
+//
+// Copyright 2025 Kirk J Krauss.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// A sweep of many patterns over many keys yields a bitmap per pattern, a
+// bit per key, which can come to more bytes than the keys themselves.
+// Written with fwrite(), each byte is copied into a stdio buffer and then
+// into the page cache, and both copies pass through the CPU's caches,
+// crowding out the keys and DFA tables that the matchers are using.
+//
+// A WildBitmapSink sets aside the whole file up front, with fallocate()
+// where the file system has it, and maps it.  The file holds a
+// WildBitmapHeader, then each pattern's bitmap, at WILD_BITS_ALIGN-byte
+// aligned offsets cbStride apart, least significant bit first, so that a
+// reader can map it and take a pattern's bitmap as it is.  A sweep goes a
+// tile of keys at a time, and hands over each pattern's bits for the tile
+// from a buffer of its own.  Those are copied into the mapping with
+// non-temporal stores, which go to memory without being cached.
+//
+// Once every tile of a flush group is done, the sink starts writing the
+// group's pages back, without waiting on them: by sync_file_range() on
+// Linux, or msync() with MS_ASYNC elsewhere.  So dirty pages don't pile up
+// for the kernel to write back all at once.  A group is as many tiles as
+// make whole pages and at least cbFlush bytes of each bitmap, since a tile
+// of a bitmap is only a few pages, and starting write-back for each one
+// separately, across hundreds of bitmaps, costs more than the writing.
+// Tiles, and so groups, may be done in any order, and different tiles may
+// be written by different threads at once.
+//
+#ifndef WILDBITSINK_H
+#define WILDBITSINK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+
+#define WILD_BITS_VERSION     1
+#define WILD_BITS_ALIGN       4096       // Header and bitmap alignment
+#define WILD_BITS_LINE_KEYS   512        // Keys per 64-byte cache line
+#define WILD_BITS_TILE_KEYS   (1 << 16)  // Default keys per tile
+#define WILD_BITS_FLUSH       (1 << 20)  // Default bytes of each bitmap
+                                         // written back at once
+
+struct WildBitmapHeader
+{
+	char     rgchMagic[8];   // "WILDBITS"
+	uint32_t uVersion;
+	uint32_t cPatterns;
+	uint64_t cKeys;
+	uint64_t uOffset;        // Of pattern 0's bitmap
+	uint64_t cbStride;       // From one pattern's bitmap to the next
+};
+
+class WildBitmapSink
+{
+public:
+	WildBitmapSink();
+	~WildBitmapSink();
+
+	// Creates, or truncates, a file for cPatterns bitmaps of cKeys bits,
+	// to be written cTileKeys keys at a time, and written back about
+	// cbFlush bytes of each at a time.  cTileKeys must be a multiple of
+	// WILD_BITS_LINE_KEYS.  Returns false if it isn't, or if the file
+	// can't be made, sized, or mapped.
+	bool Open(const char *pszPath, uint32_t cPatterns, uint64_t cKeys,
+	          uint32_t cTileKeys = WILD_BITS_TILE_KEYS,
+	          size_t cbFlush = WILD_BITS_FLUSH);
+
+	// Writes a pattern's bits for a tile: cTileKeys / 64 words, even for
+	// the last tile, whose bits past the last key should be 0.
+	void WriteTile(uint64_t iTile, uint32_t iPattern,
+	               const uint64_t *rgWords);
+
+	// Marks a tile done for every pattern, and starts writing back its
+	// flush group if that's now done.
+	void FinishTile(uint64_t iTile);
+
+	// Unmaps and closes the file.  Returns false if any write-back could
+	// not be started.  The data reaches the disk in the kernel's time, as
+	// with fclose().
+	bool Close();
+
+	uint64_t TileCount() const
+	{
+		return m_cTiles;
+	}
+
+	// Calls made to start write-back.
+	uint64_t FlushCount() const
+	{
+		return m_cFlushes.load(std::memory_order_relaxed);
+	}
+
+private:
+	int                   m_fd;
+	uint8_t              *m_pBase;
+	uint64_t              m_cbFile;
+	uint32_t              m_cPatterns;
+	uint32_t              m_cbTile;
+	uint64_t              m_cTiles;
+	uint64_t              m_cbStride;
+	uint64_t              m_cGroupTiles;   // Tiles per flush group
+	std::unique_ptr<std::atomic<uint64_t>[]> m_rgcGroupDone;
+	std::atomic<uint64_t> m_cFlushes;
+	std::atomic<bool>     m_bFlushFailed;
+};
+
+extern "C" int testbitsink(void);
+extern "C" int benchbitsink(void);
+
+#endif  // WILDBITSINK_H
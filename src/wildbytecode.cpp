@@ -0,0 +1,1130 @@
+// WildProgram: pattern compiler and threaded interpreter, and related code
+//
+// Copyright 2025 Kirk J Krauss.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// This file provides a compiler from wildcard patterns to bytecode, and an
+// interpreter for that bytecode.  With GCC or Clang, the interpreter uses
+// computed-goto threaded dispatch, so that each op jumps straight to the
+// next op's handler.  Other compilers get an equivalent switch loop.  The
+// file also includes testcases for correctness and performance.
+//
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "fastwildcompare.h"
+#include "wildbytecode.h"
+#include "wildbench.h"
+
+#if defined(__GNUC__)
+#define WILD_THREADED_DISPATCH  1
+#endif
+
+// Pattern items, as parsed ahead of code generation.
+//
+enum WildItemKind
+{
+	ITEM_LIT,
+	ITEM_ANY,
+	ITEM_CLASS,
+	ITEM_STAR
+};
+
+struct WildItem
+{
+	WildItemKind kind;
+	uint8_t      ch;       // For ITEM_LIT
+	uint16_t     iClass;   // For ITEM_CLASS
+};
+
+
+// ASCII case folding table, shared by the compiler and the interpreter.
+//
+struct WildFoldTable
+{
+	uint8_t rg[256];
+
+	WildFoldTable()
+	{
+		for (int i = 0; i < 256; ++i)
+		{
+			rg[i] = (uint8_t) ((i >= 'A' && i <= 'Z') ? i + ('a' - 'A') : i);
+		}
+	}
+};
+
+static const WildFoldTable s_fold;
+
+
+static inline void SetClassBit(uint8_t *rgBits, unsigned ch)
+{
+	rgBits[ch >> 3] |= (uint8_t) (1 << (ch & 7));
+}
+
+
+static inline bool InClass(const uint8_t *rgBits, unsigned ch)
+{
+	return (rgBits[ch >> 3] >> (ch & 7)) & 1;
+}
+
+
+// Adds the members of a POSIX character class name, as in "[[:alpha:]]".
+// Returns false for an unknown name.
+//
+static bool AddNamedClass(const char *pName, size_t cbName, uint8_t *rgBits)
+{
+	static const struct
+	{
+		const char *pszName;
+		int       (*pfnIs)(int);
+	}
+	s_rgNamed[] =
+	{
+		{ "alnum", isalnum }, { "alpha", isalpha }, { "blank", isblank },
+		{ "cntrl", iscntrl }, { "digit", isdigit }, { "graph", isgraph },
+		{ "lower", islower }, { "print", isprint }, { "punct", ispunct },
+		{ "space", isspace }, { "upper", isupper }, { "xdigit", isxdigit }
+	};
+
+	for (size_t iNamed = 0; iNamed < sizeof(s_rgNamed) / sizeof(s_rgNamed[0]);
+	     ++iNamed)
+	{
+		if (strlen(s_rgNamed[iNamed].pszName) == cbName &&
+		    !memcmp(s_rgNamed[iNamed].pszName, pName, cbName))
+		{
+			for (int ch = 0; ch < 128; ++ch)
+			{
+				if (s_rgNamed[iNamed].pfnIs(ch))
+				{
+					SetClassBit(rgBits, (unsigned) ch);
+				}
+			}
+
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+// Parses a bracket expression at pWild, which points to '['.  On success,
+// fills rgBits and returns a pointer past the closing ']'.  An unterminated
+// bracket returns NULL, and the '[' is then taken literally.
+//
+static const char *ParseBracket(const char *pWild, unsigned uFlags,
+                                uint8_t *rgBits)
+{
+	const char *p = pWild + 1;
+	bool        bNegate = false;
+	bool        bFirst = true;
+
+	memset(rgBits, 0, 32);
+
+	if (*p == '!' || *p == '^')
+	{
+		bNegate = true;
+		++p;
+	}
+
+	while (*p && (*p != ']' || bFirst))
+	{
+		unsigned chLow;
+
+		bFirst = false;
+
+		if (*p == '[' && p[1] == ':')
+		{
+			const char *pName = p + 2;
+			const char *pClose = strstr(pName, ":]");
+
+			if (pClose && AddNamedClass(pName, (size_t) (pClose - pName),
+			                            rgBits))
+			{
+				p = pClose + 2;
+				continue;
+			}
+		}
+
+		if ((uFlags & WILD_FLAG_ESCAPES) && *p == '\\' && p[1])
+		{
+			++p;
+		}
+
+		chLow = (uint8_t) *p++;
+
+		if (*p == '-' && p[1] && p[1] != ']')
+		{
+			unsigned chHigh;
+
+			++p;
+
+			if ((uFlags & WILD_FLAG_ESCAPES) && *p == '\\' && p[1])
+			{
+				++p;
+			}
+
+			chHigh = (uint8_t) *p++;
+
+			for (unsigned ch = chLow; ch <= chHigh; ++ch)
+			{
+				SetClassBit(rgBits, ch);
+			}
+		}
+		else
+		{
+			SetClassBit(rgBits, chLow);
+		}
+	}
+
+	if (*p != ']')
+	{
+		return NULL;                   // "[abc" is just text.
+	}
+
+	// Fold before negating, so that "[!a]" excludes 'A' as well.
+	if (uFlags & WILD_FLAG_CASEFOLD)
+	{
+		for (unsigned ch = 'a'; ch <= 'z'; ++ch)
+		{
+			if (InClass(rgBits, ch) || InClass(rgBits, ch - ('a' - 'A')))
+			{
+				SetClassBit(rgBits, ch);
+				SetClassBit(rgBits, ch - ('a' - 'A'));
+			}
+		}
+	}
+
+	if (bNegate)
+	{
+		for (int i = 0; i < 32; ++i)
+		{
+			rgBits[i] = (uint8_t) ~rgBits[i];
+		}
+	}
+
+	return p + 1;
+}
+
+
+// Code generation helpers.
+//
+static inline void Emit16(std::pmr::vector<uint8_t> &rgCode, size_t u)
+{
+	rgCode.push_back((uint8_t) (u & 0xFF));
+	rgCode.push_back((uint8_t) (u >> 8));
+}
+
+
+static inline size_t Read16(const uint8_t *p)
+{
+	return (size_t) p[0] | ((size_t) p[1] << 8);
+}
+
+
+// Emits the ops for items [iBegin, iEnd), all within one segment.  With
+// bEndAnchored, the segment must end where the tame string ends, and a
+// trailing literal run is fused with that check as WOP_LIT_END.
+//
+static void EmitItems(std::pmr::vector<uint8_t> &rgCode,
+                      const std::pmr::vector<WildItem> &rgItems,
+                      size_t iBegin, size_t iEnd, bool bEndAnchored)
+{
+	size_t i = iBegin;
+	bool   bFused = false;
+
+	while (i < iEnd)
+	{
+		size_t iRun = i;
+
+		if (rgItems[i].kind == ITEM_LIT)
+		{
+			while (iRun < iEnd && rgItems[iRun].kind == ITEM_LIT &&
+			       iRun - i < 255)
+			{
+				++iRun;
+			}
+
+			if (bEndAnchored && iRun == iEnd)
+			{
+				rgCode.push_back(WOP_LIT_END);
+				rgCode.push_back((uint8_t) (iRun - i));
+				bFused = true;
+			}
+			else if (iRun - i == 1)
+			{
+				rgCode.push_back(WOP_LIT1);
+			}
+			else
+			{
+				rgCode.push_back(WOP_LIT_RUN);
+				rgCode.push_back((uint8_t) (iRun - i));
+			}
+
+			for (; i < iRun; ++i)
+			{
+				rgCode.push_back(rgItems[i].ch);
+			}
+		}
+		else if (rgItems[i].kind == ITEM_ANY)
+		{
+			while (iRun < iEnd && rgItems[iRun].kind == ITEM_ANY &&
+			       iRun - i < 255)
+			{
+				++iRun;
+			}
+
+			rgCode.push_back(WOP_SKIP);
+			rgCode.push_back((uint8_t) (iRun - i));
+			i = iRun;
+		}
+		else
+		{
+			rgCode.push_back(WOP_CLASS);
+			Emit16(rgCode, rgItems[i].iClass);
+			++i;
+		}
+	}
+
+	if (bEndAnchored && !bFused)
+	{
+		rgCode.push_back(WOP_END);
+	}
+}
+
+
+WildProgram::WildProgram(std::pmr::memory_resource *pResource) :
+    m_rgCode(pResource), m_rgClasses(pResource), m_uFlags(0)
+{
+}
+
+
+bool WildProgram::Compile(const char *pWild, unsigned uFlags)
+{
+	std::pmr::vector<WildItem> rgItems(Resource());
+	uint8_t                    rgBits[32];
+	const char                *p = pWild;
+
+	m_rgCode.clear();
+	m_rgClasses.clear();
+	m_uFlags = uFlags;
+
+	// Parse into items, collapsing runs of '*'.
+	while (*p)
+	{
+		WildItem item = { ITEM_LIT, 0, 0 };
+		const char *pNext;
+
+		if (*p == '*')
+		{
+			if (rgItems.empty() || rgItems.back().kind != ITEM_STAR)
+			{
+				item.kind = ITEM_STAR;
+				rgItems.push_back(item);
+			}
+
+			++p;
+			continue;
+		}
+		else if (*p == '?')
+		{
+			item.kind = ITEM_ANY;
+			++p;
+		}
+		else if ((uFlags & WILD_FLAG_BRACKETS) && *p == '[' &&
+		         (pNext = ParseBracket(p, uFlags, rgBits)) != NULL)
+		{
+			size_t cClasses = m_rgClasses.size() / 32;
+			size_t iClass = 0;
+
+			// Identical classes share one bitmap.
+			while (iClass < cClasses &&
+			       memcmp(&m_rgClasses[iClass * 32], rgBits, 32))
+			{
+				++iClass;
+			}
+
+			if (iClass == cClasses)
+			{
+				if (cClasses > 0xFFFF)
+				{
+					m_rgCode.clear();
+					return false;
+				}
+
+				m_rgClasses.insert(m_rgClasses.end(), rgBits, rgBits + 32);
+			}
+
+			item.kind = ITEM_CLASS;
+			item.iClass = (uint16_t) iClass;
+			p = pNext;
+		}
+		else
+		{
+			if ((uFlags & WILD_FLAG_ESCAPES) && *p == '\\' && p[1])
+			{
+				++p;
+			}
+
+			item.ch = (uFlags & WILD_FLAG_CASEFOLD) ?
+			          s_fold.rg[(uint8_t) *p] : (uint8_t) *p;
+			++p;
+		}
+
+		rgItems.push_back(item);
+	}
+
+	// Split into segments at each '*'.  The first segment is anchored at
+	// the start; if there is no '*', it is anchored at the end as well.
+	size_t cItems = rgItems.size();
+	size_t iStar = 0;
+
+	while (iStar < cItems && rgItems[iStar].kind != ITEM_STAR)
+	{
+		++iStar;
+	}
+
+	EmitItems(m_rgCode, rgItems, 0, iStar, iStar == cItems);
+
+	while (iStar < cItems)
+	{
+		size_t iBegin = iStar + 1;
+		size_t iEnd = iBegin;
+
+		while (iEnd < cItems && rgItems[iEnd].kind != ITEM_STAR)
+		{
+			++iEnd;
+		}
+
+		size_t cWidth = iEnd - iBegin;
+
+		if (cWidth > 0xFFFF)
+		{
+			m_rgCode.clear();
+			return false;
+		}
+
+		if (iBegin == cItems)
+		{
+			m_rgCode.push_back(WOP_STAR_END);     // "abc*" matches "abcd".
+		}
+		else if (iEnd == cItems)
+		{
+			size_t iLit = iBegin;
+
+			while (iLit < iEnd && rgItems[iLit].kind == ITEM_LIT)
+			{
+				++iLit;
+			}
+
+			if (iLit == iEnd && cWidth <= 255)
+			{
+				// Superinstruction: "*.tar.gz" is a suffix compare.
+				m_rgCode.push_back(WOP_TAIL_LIT);
+				m_rgCode.push_back((uint8_t) cWidth);
+
+				for (size_t i = iBegin; i < iEnd; ++i)
+				{
+					m_rgCode.push_back(rgItems[i].ch);
+				}
+			}
+			else
+			{
+				m_rgCode.push_back(WOP_STAR_TAIL);
+				Emit16(m_rgCode, cWidth);
+				EmitItems(m_rgCode, rgItems, iBegin, iEnd, true);
+			}
+		}
+		else if (rgItems[iBegin].kind == ITEM_LIT)
+		{
+			// Superinstruction: search for the segment's leading literals.
+			size_t iLit = iBegin;
+
+			while (iLit < iEnd && rgItems[iLit].kind == ITEM_LIT &&
+			       iLit - iBegin < 255)
+			{
+				++iLit;
+			}
+
+			m_rgCode.push_back(WOP_STAR_LIT);
+			Emit16(m_rgCode, cWidth);
+			m_rgCode.push_back((uint8_t) (iLit - iBegin));
+
+			for (size_t i = iBegin; i < iLit; ++i)
+			{
+				m_rgCode.push_back(rgItems[i].ch);
+			}
+
+			EmitItems(m_rgCode, rgItems, iLit, iEnd, false);
+		}
+		else
+		{
+			m_rgCode.push_back(WOP_STAR_SEARCH);
+			Emit16(m_rgCode, cWidth);
+			EmitItems(m_rgCode, rgItems, iBegin, iEnd, false);
+		}
+
+		iStar = iEnd;
+	}
+
+	return true;
+}
+
+
+// Compares n bytes of tame text against literal bytes from the bytecode.
+//
+template <bool bFold>
+static inline bool LiteralsMatch(const uint8_t *pTame, const uint8_t *pLit,
+                                 size_t n)
+{
+	if (!bFold)
+	{
+		return !memcmp(pTame, pLit, n);
+	}
+
+	for (size_t i = 0; i < n; ++i)
+	{
+		if (s_fold.rg[pTame[i]] != pLit[i])
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+// Finds the leftmost place at or after pTame, no later than pLast, where
+// the n literal bytes at pLit appear.  Returns NULL if there is none.
+//
+template <bool bFold>
+static inline const uint8_t *FindLiterals(const uint8_t *pTame,
+                                          const uint8_t *pLast,
+                                          const uint8_t *pLit, size_t n)
+{
+	while (pTame <= pLast)
+	{
+		if (!bFold)
+		{
+			pTame = (const uint8_t *) memchr(pTame, pLit[0],
+			                                 (size_t) (pLast - pTame) + 1);
+
+			if (!pTame)
+			{
+				return NULL;
+			}
+		}
+		else if (s_fold.rg[*pTame] != pLit[0])
+		{
+			++pTame;
+			continue;
+		}
+
+		if (LiteralsMatch<bFold>(pTame + 1, pLit + 1, n - 1))
+		{
+			return pTame;
+		}
+
+		++pTame;
+	}
+
+	return NULL;
+}
+
+
+#if defined(WILD_THREADED_DISPATCH)
+#define WILD_OP(op)   op_##op
+#define WILD_NEXT()   goto *s_rgpOps[*pc]
+#else
+#define WILD_OP(op)   case op
+#define WILD_NEXT()   goto dispatch
+#endif
+
+// Runs a program against tame bytes [pTame, pEnd).  At most one fallback
+// point is kept: the most recent '*' op and the place where its segment
+// was last tried.  A failure within that segment retries it one byte
+// further on.  Earlier segments never need a retry, because each was
+// placed as far left as it could go.
+//
+template <bool bFold>
+static bool RunProgram(const uint8_t *pc, const uint8_t *rgClasses,
+                       const uint8_t *pTame, const uint8_t *pEnd)
+{
+	const uint8_t *pStarOp = NULL;     // Fallback op, if any
+	const uint8_t *pStarTame = NULL;   // Where its segment was tried
+	size_t         n, cWidth;
+
+#if defined(WILD_THREADED_DISPATCH)
+	static void *const s_rgpOps[WOP_COUNT] =
+	{
+		&&op_WOP_LIT1, &&op_WOP_LIT_RUN, &&op_WOP_SKIP, &&op_WOP_CLASS,
+		&&op_WOP_STAR_SEARCH, &&op_WOP_STAR_LIT, &&op_WOP_STAR_TAIL,
+		&&op_WOP_TAIL_LIT, &&op_WOP_LIT_END, &&op_WOP_STAR_END,
+		&&op_WOP_END
+	};
+#endif
+
+	WILD_NEXT();
+
+#if !defined(WILD_THREADED_DISPATCH)
+dispatch:
+	switch (*pc)
+	{
+#endif
+
+	WILD_OP(WOP_LIT1):
+		if (pTame == pEnd ||
+		    (bFold ? s_fold.rg[*pTame] : *pTame) != pc[1])
+		{
+			goto fail;
+		}
+
+		++pTame;
+		pc += 2;
+		WILD_NEXT();
+
+	WILD_OP(WOP_LIT_RUN):
+		n = pc[1];
+
+		if ((size_t) (pEnd - pTame) < n ||
+		    !LiteralsMatch<bFold>(pTame, pc + 2, n))
+		{
+			goto fail;
+		}
+
+		pTame += n;
+		pc += 2 + n;
+		WILD_NEXT();
+
+	WILD_OP(WOP_SKIP):
+		n = pc[1];
+
+		if ((size_t) (pEnd - pTame) < n)
+		{
+			goto fail;
+		}
+
+		pTame += n;
+		pc += 2;
+		WILD_NEXT();
+
+	WILD_OP(WOP_CLASS):
+		if (pTame == pEnd ||
+		    !InClass(rgClasses + 32 * Read16(pc + 1), *pTame))
+		{
+			goto fail;
+		}
+
+		++pTame;
+		pc += 3;
+		WILD_NEXT();
+
+	WILD_OP(WOP_STAR_SEARCH):
+		cWidth = Read16(pc + 1);
+
+		if ((size_t) (pEnd - pTame) < cWidth)
+		{
+			return false;              // "a*bc" doesn't match "ab".
+		}
+
+		pStarOp = pc;
+		pStarTame = pTame;
+		pc += 3;
+		WILD_NEXT();
+
+	WILD_OP(WOP_STAR_LIT):
+		cWidth = Read16(pc + 1);
+		n = pc[3];
+
+		if ((size_t) (pEnd - pTame) < cWidth ||
+		    !(pTame = FindLiterals<bFold>(pTame, pEnd - cWidth, pc + 4, n)))
+		{
+			return false;              // "a*b*c" doesn't match "ab".
+		}
+
+		pStarOp = pc;
+		pStarTame = pTame;
+		pTame += n;
+		pc += 4 + n;
+		WILD_NEXT();
+
+	WILD_OP(WOP_STAR_TAIL):
+		cWidth = Read16(pc + 1);
+
+		if ((size_t) (pEnd - pTame) < cWidth)
+		{
+			return false;              // "*bcd" doesn't match "abc".
+		}
+
+		// The final segment can only sit at the end: nothing to retry.
+		pTame = pEnd - cWidth;
+		pStarOp = NULL;
+		pc += 3;
+		WILD_NEXT();
+
+	WILD_OP(WOP_TAIL_LIT):
+		n = pc[1];
+		return (size_t) (pEnd - pTame) >= n &&
+		       LiteralsMatch<bFold>(pEnd - n, pc + 2, n);
+
+	WILD_OP(WOP_LIT_END):
+		n = pc[1];
+
+		if ((size_t) (pEnd - pTame) != n ||
+		    !LiteralsMatch<bFold>(pTame, pc + 2, n))
+		{
+			goto fail;
+		}
+
+		return true;                   // "abc" matches "abc".
+
+	WILD_OP(WOP_STAR_END):
+		return true;                   // "abc*" matches "abcd".
+
+	WILD_OP(WOP_END):
+		if (pTame != pEnd)
+		{
+			goto fail;
+		}
+
+		return true;
+
+#if !defined(WILD_THREADED_DISPATCH)
+	default:
+		return false;
+	}
+#endif
+
+fail:
+	if (!pStarOp)
+	{
+		return false;
+	}
+
+	// Fall back, but never so far again.
+	pTame = pStarTame + 1;
+	pc = pStarOp;
+	WILD_NEXT();
+}
+
+#undef WILD_OP
+#undef WILD_NEXT
+
+
+bool WildProgram::Match(const char *pTame, size_t cbTame) const
+{
+	if (m_rgCode.empty())
+	{
+		return false;                  // Failed compile.
+	}
+
+	const uint8_t *pStart = (const uint8_t *) pTame;
+
+	if (m_uFlags & WILD_FLAG_CASEFOLD)
+	{
+		return RunProgram<true>(m_rgCode.data(), m_rgClasses.data(),
+		                        pStart, pStart + cbTame);
+	}
+
+	return RunProgram<false>(m_rgCode.data(), m_rgClasses.data(),
+	                         pStart, pStart + cbTame);
+}
+
+
+// C entry points, for callers outside C++.
+//
+extern "C" void *WildProgramCreate(const char *pWild, unsigned uFlags)
+{
+	WildProgram *pProgram = new WildProgram;
+
+	if (!pProgram->Compile(pWild, uFlags))
+	{
+		delete pProgram;
+		return NULL;
+	}
+
+	return pProgram;
+}
+
+
+extern "C" bool WildProgramMatch(void *pProgram, const char *pTame,
+                                 size_t cbTame)
+{
+	return ((WildProgram *) pProgram)->Match(pTame, cbTame);
+}
+
+
+extern "C" void WildProgramDestroy(void *pProgram)
+{
+	delete (WildProgram *) pProgram;
+}
+
+
+// Compiles and runs a pattern with the given flags.
+//
+static bool testprogram(const char *pTame, const char *pWild,
+                        unsigned uFlags, bool bExpectedResult)
+{
+	WildProgram program;
+
+	program.Compile(pWild, uFlags);
+	return program.Match(pTame) == bExpectedResult;
+}
+
+
+// A set of bytecode tests for the features beyond FastWildCompare().  The
+// plain cases are covered by test(), which runs every routine on each of
+// the testwild(), testtame() and testempty() cases.
+//
+extern "C" int testbytecode(void)
+{
+	const unsigned uB = WILD_FLAG_BRACKETS;
+	const unsigned uF = WILD_FLAG_CASEFOLD;
+	const unsigned uE = WILD_FLAG_ESCAPES;
+	bool bAllPassed = true;
+
+	// Bracket classes, ranges and negation.
+	bAllPassed &= testprogram("cat", "[bc]at", uB, true);
+	bAllPassed &= testprogram("hat", "[bc]at", uB, false);
+	bAllPassed &= testprogram("hat", "[!bc]at", uB, true);
+	bAllPassed &= testprogram("bat", "[^bc]at", uB, false);
+	bAllPassed &= testprogram("file7.log", "file[0-9].log", uB, true);
+	bAllPassed &= testprogram("fileA.log", "file[0-9].log", uB, false);
+	bAllPassed &= testprogram("]", "[]]", uB, true);
+	bAllPassed &= testprogram("-", "[a-]", uB, true);
+	bAllPassed &= testprogram("x9", "[[:alpha:]][[:digit:]]", uB, true);
+	bAllPassed &= testprogram("99", "[[:alpha:]][[:digit:]]", uB, false);
+	bAllPassed &= testprogram("[abc", "[abc", uB, true);
+	bAllPassed &= testprogram("b", "[b", uB, false);
+	bAllPassed &= testprogram("[b]", "[b]", 0, true);
+	bAllPassed &= testprogram("xxaby", "*[ab][ab]*", uB, true);
+	bAllPassed &= testprogram("xxacy", "*[ab][ab]*", uB, false);
+	bAllPassed &= testprogram("abcabd", "*[a-c]?d", uB, true);
+	bAllPassed &= testprogram("mississippi", "*s[!is]p*", uB, false);
+	bAllPassed &= testprogram("mississippi", "*i[!s]p*", uB, true);
+	bAllPassed &= testprogram("mississippi", "*s[!s]*p[a-z]", uB, true);
+
+	// Case folding, including classes.
+	bAllPassed &= testprogram("mississippi", "*issip*PI", uF, true);
+	bAllPassed &= testprogram("MISSISSIPPI", "*issip*pi", uF, true);
+	bAllPassed &= testprogram("MISSISSIPPI", "*issip*pi", 0, false);
+	bAllPassed &= testprogram("Report.TXT", "*.txt", uF, true);
+	bAllPassed &= testprogram("Report.TXT", "*.tx", uF, false);
+	bAllPassed &= testprogram("A", "[a]", uB | uF, true);
+	bAllPassed &= testprogram("A", "[!a]", uB | uF, false);
+	bAllPassed &= testprogram("q", "[!a]", uB | uF, true);
+
+	// Escapes.
+	bAllPassed &= testprogram("a*b", "a\\*b", uE, true);
+	bAllPassed &= testprogram("axb", "a\\*b", uE, false);
+	bAllPassed &= testprogram("a?", "*\\?", uE, true);
+	bAllPassed &= testprogram("ab", "*\\?", uE, false);
+	bAllPassed &= testprogram("]", "[\\]]", uB | uE, true);
+	bAllPassed &= testprogram("a\\", "a\\", uE, true);
+
+	// Superinstruction boundaries.
+	bAllPassed &= testprogram("abc", "abc", 0, true);
+	bAllPassed &= testprogram("abcd", "abc", 0, false);
+	bAllPassed &= testprogram("ab", "abc", 0, false);
+	bAllPassed &= testprogram("x.tar.gz", "*.tar.gz", 0, true);
+	bAllPassed &= testprogram(".tar.g", "*.tar.gz", 0, false);
+	bAllPassed &= testprogram("abXcdYef", "ab*cd*ef", 0, true);
+	bAllPassed &= testprogram("abXcdYe", "ab*cd*ef", 0, false);
+	bAllPassed &= testprogram("abcd", "ab*?d", 0, true);
+	bAllPassed &= testprogram("abd", "ab*?d", 0, false);
+
+	// Long literal and '?' runs, split across ops.
+	std::string strLong(600, 'a');
+	std::string strWild = strLong.substr(0, 300) + "*" + strLong.substr(0, 299);
+
+	bAllPassed &= testprogram(strLong.c_str(), strLong.c_str(), 0, true);
+	bAllPassed &= testprogram(strLong.c_str(), strWild.c_str(), 0, true);
+	bAllPassed &= testprogram(strLong.c_str(),
+	                          std::string(600, '?').c_str(), 0, true);
+	bAllPassed &= testprogram(strLong.c_str(),
+	                          std::string(601, '?').c_str(), 0, false);
+
+	// A segment too wide for the bytecode: no program, rather than one
+	// that quietly matches nothing.
+	std::string strWide = "*" + std::string(70000, 'a') + "*";
+	void       *pWide = WildProgramCreate(strWide.c_str(), 0);
+
+	bAllPassed &= pWide == NULL;
+	WildProgramDestroy(pWide);
+
+	// Agreement with FastWildCompare() on generated cases.
+	WildBenchRandom rng(7);
+	std::string     strTame;
+
+	for (int iCase = 0; iCase < 20000; ++iCase)
+	{
+		WildBenchMakePattern(rng, strWild);
+		WildBenchMakeKey(rng, strTame, iCase % 2 != 0);
+
+		if (iCase % 3 == 0)
+		{
+			strTame = strWild;
+
+			for (char &ch : strTame)
+			{
+				if (ch == '*' || ch == '?')
+				{
+					ch = 'x';
+				}
+			}
+		}
+
+		bAllPassed &= testprogram(strTame.c_str(), strWild.c_str(), 0,
+		    FastWildCompare(const_cast<char *>(strWild.c_str()),
+		                    const_cast<char *>(strTame.c_str())));
+	}
+
+	if (bAllPassed)
+	{
+		printf("Passed bytecode tests\n");
+	}
+	else
+	{
+		printf("Failed bytecode tests\n");
+	}
+
+	return 0;
+}
+
+
+// Makes a lowercase copy, for case-insensitive matching via
+// FastWildCompare(), the way a caller without WILD_FLAG_CASEFOLD would.
+//
+static void LowerCopy(const std::string &str, std::string &strLower)
+{
+	strLower = str;
+
+	for (char &ch : strLower)
+	{
+		ch = (char) s_fold.rg[(uint8_t) ch];
+	}
+}
+
+
+// Compares the bytecode interpreter with FastWildCompare(): on plain
+// path-like patterns, on case-insensitive patterns (where the alternative
+// is to lowercase both strings first), and on bracket classes (where the
+// alternative is to expand each class into its alternatives).  Timings
+// for the testwild() corpus are gathered by the Rust test() routine.
+//
+extern "C" int benchbytecode(void)
+{
+	const int       cPatterns = 1000;
+	const int       cKeys = 2000;
+	WildBenchRandom rng(99);
+	std::vector<std::string> rgWild(cPatterns), rgTame(cKeys);
+	std::vector<WildProgram> rgProgram(cPatterns);
+	uint64_t        uHitsFwc = 0, uHitsProgram = 0;
+	uint64_t        uStart;
+
+	for (int i = 0; i < cPatterns; ++i)
+	{
+		WildBenchMakePattern(rng, rgWild[i]);
+		rgProgram[i].Compile(rgWild[i].c_str());
+	}
+
+	for (int i = 0; i < cKeys; ++i)
+	{
+		WildBenchMakeKey(rng, rgTame[i], i % 2 != 0);
+	}
+
+	// Plain patterns.
+	uStart = WildBenchNanos();
+
+	for (int iKey = 0; iKey < cKeys; ++iKey)
+	{
+		for (int i = 0; i < cPatterns; ++i)
+		{
+			uHitsFwc += FastWildCompare(const_cast<char *>(rgWild[i].c_str()),
+			    const_cast<char *>(rgTame[iKey].c_str()));
+		}
+	}
+
+	uint64_t uFwcNanos = WildBenchNanos() - uStart;
+
+	uStart = WildBenchNanos();
+
+	for (int iKey = 0; iKey < cKeys; ++iKey)
+	{
+		for (int i = 0; i < cPatterns; ++i)
+		{
+			uHitsProgram += rgProgram[i].Match(rgTame[iKey].data(),
+			                                   rgTame[iKey].size());
+		}
+	}
+
+	uint64_t uProgramNanos = WildBenchNanos() - uStart;
+
+	printf("Bytecode, plain patterns: FastWildCompare %.1f ns/match, "
+	       "bytecode %.1f ns/match%s\n",
+	       (double) uFwcNanos / ((double) cKeys * cPatterns),
+	       (double) uProgramNanos / ((double) cKeys * cPatterns),
+	       uHitsFwc == uHitsProgram ? "" : " (RESULTS DIFFER)");
+
+	// Case-insensitive patterns: uppercase the keys, fold at match time.
+	std::vector<std::string> rgWildLower(cPatterns);
+
+	for (int i = 0; i < cPatterns; ++i)
+	{
+		rgProgram[i].Compile(rgWild[i].c_str(), WILD_FLAG_CASEFOLD);
+		LowerCopy(rgWild[i], rgWildLower[i]);
+	}
+
+	for (int i = 0; i < cKeys; ++i)
+	{
+		for (char &ch : rgTame[i])
+		{
+			ch = (char) toupper((uint8_t) ch);
+		}
+	}
+
+	std::string strLower;
+
+	uHitsFwc = uHitsProgram = 0;
+	uStart = WildBenchNanos();
+
+	for (int iKey = 0; iKey < cKeys; ++iKey)
+	{
+		LowerCopy(rgTame[iKey], strLower);
+
+		for (int i = 0; i < cPatterns; ++i)
+		{
+			uHitsFwc += FastWildCompare(
+			    const_cast<char *>(rgWildLower[i].c_str()),
+			    const_cast<char *>(strLower.c_str()));
+		}
+	}
+
+	uFwcNanos = WildBenchNanos() - uStart;
+	uStart = WildBenchNanos();
+
+	for (int iKey = 0; iKey < cKeys; ++iKey)
+	{
+		for (int i = 0; i < cPatterns; ++i)
+		{
+			uHitsProgram += rgProgram[i].Match(rgTame[iKey].data(),
+			                                   rgTame[iKey].size());
+		}
+	}
+
+	uProgramNanos = WildBenchNanos() - uStart;
+
+	printf("Bytecode, case-insensitive: lowercase + FastWildCompare "
+	       "%.1f ns/match, bytecode %.1f ns/match%s\n",
+	       (double) uFwcNanos / ((double) cKeys * cPatterns),
+	       (double) uProgramNanos / ((double) cKeys * cPatterns),
+	       uHitsFwc == uHitsProgram ? "" : " (RESULTS DIFFER)");
+
+	// Bracket classes: "*/[lm]*[0-3].[jl]og" style patterns, expanded into
+	// every combination for FastWildCompare().
+	static const char *s_rgszClassWild[] =
+	{
+		"/[dlm]*/*[0-3].[jl]og", "*/cache[0-9]*.[tc]*", "/[sv]*[!0-9]/*.db",
+		"*[0-4][0-4].parquet"
+	};
+	static const char *s_rgszExpanded[][40] =
+	{
+		{ "/d*/*0.jog", "/d*/*1.jog", "/d*/*2.jog", "/d*/*3.jog",
+		  "/d*/*0.log", "/d*/*1.log", "/d*/*2.log", "/d*/*3.log",
+		  "/l*/*0.jog", "/l*/*1.jog", "/l*/*2.jog", "/l*/*3.jog",
+		  "/l*/*0.log", "/l*/*1.log", "/l*/*2.log", "/l*/*3.log",
+		  "/m*/*0.jog", "/m*/*1.jog", "/m*/*2.jog", "/m*/*3.jog",
+		  "/m*/*0.log", "/m*/*1.log", "/m*/*2.log", "/m*/*3.log", NULL },
+		{ "*/cache0*.t*", "*/cache1*.t*", "*/cache2*.t*", "*/cache3*.t*",
+		  "*/cache4*.t*", "*/cache5*.t*", "*/cache6*.t*", "*/cache7*.t*",
+		  "*/cache8*.t*", "*/cache9*.t*", "*/cache0*.c*", "*/cache1*.c*",
+		  "*/cache2*.c*", "*/cache3*.c*", "*/cache4*.c*", "*/cache5*.c*",
+		  "*/cache6*.c*", "*/cache7*.c*", "*/cache8*.c*", "*/cache9*.c*",
+		  NULL },
+		{ "/s*v/*.db", "/s*r/*.db", "/s*c/*.db", "/s*l/*.db", "/s*a/*.db",
+		  "/s*p/*.db", "/s*e/*.db", "/s*n/*.db", "/s*t/*.db", "/s*d/*.db",
+		  "/s*s/*.db", "/s*o/*.db", "/s*h/*.db", "/s*g/*.db", "/s*b/*.db",
+		  "/s*u/*.db", "/s*f/*.db", "/s*i/*.db", "/s*m/*.db", "/v*v/*.db",
+		  "/v*r/*.db", "/v*c/*.db", "/v*l/*.db", "/v*a/*.db", "/v*p/*.db",
+		  "/v*e/*.db", "/v*n/*.db", "/v*t/*.db", "/v*d/*.db", "/v*s/*.db",
+		  "/v*o/*.db", "/v*h/*.db", "/v*g/*.db", "/v*b/*.db", "/v*u/*.db",
+		  "/v*f/*.db", "/v*i/*.db", "/v*m/*.db", NULL },
+		{ "*00.parquet", "*01.parquet", "*02.parquet", "*03.parquet",
+		  "*04.parquet", "*10.parquet", "*11.parquet", "*12.parquet",
+		  "*13.parquet", "*14.parquet", "*20.parquet", "*21.parquet",
+		  "*22.parquet", "*23.parquet", "*24.parquet", "*30.parquet",
+		  "*31.parquet", "*32.parquet", "*33.parquet", "*34.parquet",
+		  "*40.parquet", "*41.parquet", "*42.parquet", "*43.parquet",
+		  "*44.parquet", NULL }
+	};
+	const int cClassWild = 4;
+	WildProgram rgClassProgram[cClassWild];
+	const int cClassKeys = 200000;
+	std::vector<std::string> rgClassTame(cClassKeys);
+
+	for (int i = 0; i < cClassWild; ++i)
+	{
+		rgClassProgram[i].Compile(s_rgszClassWild[i], WILD_FLAG_BRACKETS);
+	}
+
+	for (int i = 0; i < cClassKeys; ++i)
+	{
+		WildBenchMakeKey(rng, rgClassTame[i]);
+	}
+
+	uHitsFwc = uHitsProgram = 0;
+	uStart = WildBenchNanos();
+
+	for (int iKey = 0; iKey < cClassKeys; ++iKey)
+	{
+		for (int i = 0; i < cClassWild; ++i)
+		{
+			for (int iAlt = 0; s_rgszExpanded[i][iAlt]; ++iAlt)
+			{
+				if (FastWildCompare(
+				        const_cast<char *>(s_rgszExpanded[i][iAlt]),
+				        const_cast<char *>(rgClassTame[iKey].c_str())))
+				{
+					++uHitsFwc;
+					break;
+				}
+			}
+		}
+	}
+
+	uFwcNanos = WildBenchNanos() - uStart;
+	uStart = WildBenchNanos();
+
+	for (int iKey = 0; iKey < cClassKeys; ++iKey)
+	{
+		for (int i = 0; i < cClassWild; ++i)
+		{
+			uHitsProgram += rgClassProgram[i].Match(
+			    rgClassTame[iKey].data(), rgClassTame[iKey].size());
+		}
+	}
+
+	uProgramNanos = WildBenchNanos() - uStart;
+
+	printf("Bytecode, bracket classes: expanded FastWildCompare "
+	       "%.1f ns/match, bytecode %.1f ns/match%s\n",
+	       (double) uFwcNanos / ((double) cClassKeys * cClassWild),
+	       (double) uProgramNanos / ((double) cClassKeys * cClassWild),
+	       uHitsFwc == uHitsProgram ? "" : " (RESULTS DIFFER)");
+
+	return 0;
+}
@@ -0,0 +1,113 @@
+// WildProgram, a compiled form of a wildcard pattern
+//
+// Copyright 2025 Kirk J Krauss.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// A pattern is compiled once into compact bytecode, which an interpreter
+// then runs against any number of tame strings.  New features (bracket
+// classes, case folding, escapes) become new opcodes or compile-time
+// choices rather than more branches in the hot loops of FastWildCompare().
+//
+// The bytecode is a sequence of segments.  The first segment is anchored
+// at the start of the tame string.  Each '*' begins a segment that is
+// searched for, leftmost first, with the '*' op kept as the single
+// fallback point, as in FastWildCompare().  A final segment after the last
+// '*' has a fixed width, so it is anchored at the end and never searched.
+//
+// The bytecode, and the items that Compile() parses into, come from the
+// program's memory resource.
+//
+#ifndef WILDBYTECODE_H
+#define WILDBYTECODE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <memory_resource>
+#include <vector>
+
+// Compile flags.  With none of these, a program matches exactly as
+// FastWildCompare() does.
+#define WILD_FLAG_CASEFOLD   0x01   // ASCII letters match either case
+#define WILD_FLAG_BRACKETS   0x02   // "[a-z]" and "[!0-9]" match classes
+#define WILD_FLAG_ESCAPES    0x04   // '\' makes the next character literal
+
+// Opcodes.  Operand layouts are noted as [bytes]; w16 is a little-endian
+// 16-bit width, n8 a byte count followed by n literal bytes.
+//
+enum WildOpcode
+{
+	WOP_LIT1,          // [c]       One literal byte
+	WOP_LIT_RUN,       // [n8 ...]  A run of literal bytes
+	WOP_SKIP,          // [n8]      A run of '?'
+	WOP_CLASS,         // [idx16]   One byte from a class bitmap
+	WOP_STAR_SEARCH,   // [w16]     '*' then a segment of width w
+	WOP_STAR_LIT,      // [w16 n8 ...]  '*' then a segment led by literals
+	WOP_STAR_TAIL,     // [w16]     '*' then the final segment, end-anchored
+	WOP_TAIL_LIT,      // [n8 ...]  '*' then a final all-literal segment
+	WOP_LIT_END,       // [n8 ...]  Literal run, then the end of the string
+	WOP_STAR_END,      // []        Trailing '*': match
+	WOP_END,           // []        End anchor
+	WOP_COUNT
+};
+
+class WildProgram
+{
+public:
+	explicit WildProgram(std::pmr::memory_resource *pResource =
+	                     std::pmr::get_default_resource());
+
+	// Compiles a pattern.  Returns false if a segment is too wide for the
+	// bytecode's 16-bit operands, in which case the program matches nothing.
+	bool Compile(const char *pWild, unsigned uFlags = 0);
+
+	// Matches a tame string of cbTame bytes, which need not be terminated.
+	bool Match(const char *pTame, size_t cbTame) const;
+
+	bool Match(const char *pTame) const
+	{
+		return Match(pTame, strlen(pTame));
+	}
+
+	size_t CodeSize() const
+	{
+		return m_rgCode.size();
+	}
+
+	unsigned Flags() const
+	{
+		return m_uFlags;
+	}
+
+	std::pmr::memory_resource *Resource() const
+	{
+		return m_rgCode.get_allocator().resource();
+	}
+
+private:
+	std::pmr::vector<uint8_t> m_rgCode;      // Opcodes and inline operands
+	std::pmr::vector<uint8_t> m_rgClasses;   // 32-byte bitmaps for WOP_CLASS
+	unsigned                  m_uFlags;
+};
+
+// Returns NULL if the pattern doesn't compile; see Compile().
+extern "C" void *WildProgramCreate(const char *pWild, unsigned uFlags);
+extern "C" bool WildProgramMatch(void *pProgram, const char *pTame,
+                                 size_t cbTame);
+extern "C" void WildProgramDestroy(void *pProgram);
+
+extern "C" int testbytecode(void);
+extern "C" int benchbytecode(void);
+
+#endif  // WILDBYTECODE_H
@@ -0,0 +1,637 @@
+// WildQueryCache, and related code
+//
+// Copyright 2025 Kirk J Krauss.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// This file provides the live corpus and the query cache.  It also
+// includes testcases for correctness and performance.
+//
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <bitset>
+#include <string>
+#include <vector>
+
+#include "fastwildcompare.h"
+#include "wildcache.h"
+#include "wildbench.h"
+
+WildLiveCorpus::WildLiveCorpus(const WildCorpus *pBase) :
+    m_pBase(pBase), m_cBase(pBase ? pBase->Count() : 0), m_rgOffsets(1, 0),
+    m_rgDeletedWords((m_cBase + 63) / 64)
+{
+}
+
+
+uint32_t WildLiveCorpus::Append(const char *pKey, size_t cbKey)
+{
+	uint32_t iKey = (uint32_t) Count();
+
+	m_strBytes.append(pKey, cbKey);
+	m_rgOffsets.push_back((uint32_t) m_strBytes.size());
+
+	if (m_rgDeletedWords.size() * 64 < Count())
+	{
+		m_rgDeletedWords.push_back(0);
+	}
+
+	return iKey;
+}
+
+
+bool WildLiveCorpus::Delete(uint32_t iKey)
+{
+	if (iKey >= Count() || IsDeleted(iKey))
+	{
+		return false;
+	}
+
+	m_rgDeletedWords[iKey / 64] |= (uint64_t) 1 << (iKey % 64);
+	m_rgDeletes.push_back(iKey);
+	return true;
+}
+
+
+const char *WildLiveCorpus::Key(uint32_t iKey, size_t *pcbKey) const
+{
+	if (iKey < m_cBase)
+	{
+		return m_pBase->Key(iKey, pcbKey);
+	}
+
+	iKey -= (uint32_t) m_cBase;
+	*pcbKey = m_rgOffsets[iKey + 1] - m_rgOffsets[iKey];
+	return m_strBytes.data() + m_rgOffsets[iKey];
+}
+
+
+WildQueryCache::WildQueryCache(const WildLiveCorpus &corpus,
+                               size_t cbBudget) :
+    m_corpus(corpus), m_cbBudget(cbBudget), m_cbUsed(0), m_dAge(0),
+    m_cHits(0), m_cMisses(0), m_cEvictions(0), m_cDeltaKeys(0)
+{
+}
+
+
+void WildQueryCache::Clear()
+{
+	m_mapEntries.clear();
+	m_uncached = WildCacheEntry();
+	m_cbUsed = 0;
+	m_dAge = 0;
+}
+
+
+// Matches appended keys iFirst up to iEnd, by number, and sets the bits
+// of those that match.
+//
+void WildQueryCache::MatchAppended(WildCacheEntry &entry, size_t iFirst,
+                                   size_t iEnd)
+{
+	const uint32_t *rgOffsets = m_corpus.AppendedOffsets() +
+	                            (iFirst - m_corpus.BaseCount());
+	size_t          cKeys = iEnd - iFirst;
+
+	m_rgbResult.resize(cKeys);
+
+	if (entry.bDfa)
+	{
+		entry.dfa.MatchBatch(m_corpus.AppendedBytes(), rgOffsets, cKeys,
+		                     m_rgbResult.data());
+	}
+	else if (entry.bCompiled)
+	{
+		for (size_t i = 0; i < cKeys; ++i)
+		{
+			m_rgbResult[i] = entry.compiled.Match(m_corpus.AppendedBytes() +
+			                 rgOffsets[i], rgOffsets[i + 1] - rgOffsets[i]);
+		}
+	}
+	else
+	{
+		for (size_t i = 0; i < cKeys; ++i)
+		{
+			m_rgbResult[i] = entry.program.Match(m_corpus.AppendedBytes() +
+			                 rgOffsets[i], rgOffsets[i + 1] - rgOffsets[i]);
+		}
+	}
+
+	for (size_t i = 0; i < cKeys; ++i)
+	{
+		if (m_rgbResult[i])
+		{
+			entry.rgWords[(iFirst + i) / 64] |=
+			    (uint64_t) 1 << ((iFirst + i) % 64);
+			++entry.cMatches;
+		}
+	}
+}
+
+
+// Computes a pattern's result from scratch: the base corpus through
+// WildCorpusScan(), so that its zone maps and indexes help, then the
+// appended keys, less every deleted key.
+//
+void WildQueryCache::Evaluate(const char *pWild, WildCacheEntry &entry)
+{
+	size_t cKeys = m_corpus.Count();
+
+	// A segment too long for the program's operands still compiles into a
+	// WildCompiledPattern, which gets FastWildCompare()'s results.
+	entry.bDfa = entry.dfa.Compile(pWild);
+	entry.bCompiled = !entry.bDfa && !entry.program.Compile(pWild);
+
+	if (entry.bCompiled)
+	{
+		entry.compiled.Compile(pWild);
+	}
+
+	entry.rgWords.assign((cKeys + 63) / 64, 0);
+	entry.cMatches = 0;
+	entry.dCost = 0;
+
+	if (m_corpus.Base())
+	{
+		const WildCorpus     &base = *m_corpus.Base();
+		std::vector<uint32_t> rgMatches;
+		size_t                cBlocks = WildCorpusScan(base, pWild,
+		                                               rgMatches);
+
+		for (uint32_t iKey : rgMatches)
+		{
+			entry.rgWords[iKey / 64] |= (uint64_t) 1 << (iKey % 64);
+		}
+
+		entry.cMatches = rgMatches.size();
+		entry.dCost += (double) std::min(cBlocks * base.BlockKeys(),
+		                                 base.Count());
+	}
+
+	MatchAppended(entry, m_corpus.BaseCount(), cKeys);
+	entry.dCost += (double) (cKeys - m_corpus.BaseCount()) + 1;
+
+	const std::vector<uint64_t> &rgDeleted = m_corpus.DeletedWords();
+
+	for (size_t i = 0; i < entry.rgWords.size(); ++i)
+	{
+		uint64_t uGone = entry.rgWords[i] & rgDeleted[i];
+
+		entry.cMatches -= std::bitset<64>(uGone).count();
+		entry.rgWords[i] &= ~uGone;
+	}
+
+	entry.cKeys = cKeys;
+	entry.cDeletes = m_corpus.Deletes().size();
+}
+
+
+// Brings a cached result up to date: matches the keys appended since, and
+// clears the bits of keys deleted since.  A key both appended and deleted
+// since is matched, then cleared.
+//
+void WildQueryCache::CatchUp(WildCacheEntry &entry)
+{
+	size_t                       cKeys = m_corpus.Count();
+	const std::vector<uint32_t> &rgDeletes = m_corpus.Deletes();
+
+	if (cKeys > entry.cKeys)
+	{
+		entry.rgWords.resize((cKeys + 63) / 64, 0);
+		MatchAppended(entry, entry.cKeys, cKeys);
+		m_cDeltaKeys += cKeys - entry.cKeys;
+		entry.cKeys = cKeys;
+	}
+
+	for (size_t i = entry.cDeletes; i < rgDeletes.size(); ++i)
+	{
+		uint64_t &uWord = entry.rgWords[rgDeletes[i] / 64];
+		uint64_t  uBit = (uint64_t) 1 << (rgDeletes[i] % 64);
+
+		if (uWord & uBit)
+		{
+			uWord &= ~uBit;
+			--entry.cMatches;
+		}
+	}
+
+	entry.cDeletes = rgDeletes.size();
+}
+
+
+// What an entry takes: its bitmap and matcher, plus bookkeeping.
+//
+size_t WildQueryCache::EntryBytes(const std::string &strWild,
+                                  const WildCacheEntry &entry) const
+{
+	size_t cb = sizeof(WildCacheEntry) + strWild.capacity() +
+	            entry.rgWords.capacity() * sizeof(uint64_t) + 64;
+
+	if (entry.bDfa)
+	{
+		cb += entry.dfa.StateCount() * (entry.dfa.ClassCount() *
+		      sizeof(int32_t) + 1) + 256 * sizeof(int32_t);
+	}
+	else if (entry.bCompiled)
+	{
+		cb += entry.compiled.Spilled() ? strWild.size() : 0;
+	}
+	else
+	{
+		cb += entry.program.CodeSize();
+	}
+
+	return cb;
+}
+
+
+// Evicts the entries with the least priority until the cache is within
+// its budget, sparing the one named strKeep.  GreedyDual-Size: each
+// eviction raises the age to the evicted priority, and an entry's priority
+// is the age when it was last asked for, plus its cost per byte.  If the
+// spared entry alone is over the budget, it's moved out of the cache.
+//
+void WildQueryCache::Evict(const std::string &strKeep)
+{
+	while (m_cbUsed > m_cbBudget)
+	{
+		auto itVictim = m_mapEntries.end();
+
+		for (auto it = m_mapEntries.begin(); it != m_mapEntries.end(); ++it)
+		{
+			if (it->first != strKeep && (itVictim == m_mapEntries.end() ||
+			    it->second.dPriority < itVictim->second.dPriority))
+			{
+				itVictim = it;
+			}
+		}
+
+		if (itVictim == m_mapEntries.end())
+		{
+			break;
+		}
+
+		m_dAge = itVictim->second.dPriority;
+		m_cbUsed -= itVictim->second.cb;
+		m_mapEntries.erase(itVictim);
+		++m_cEvictions;
+	}
+
+	auto it = m_mapEntries.find(strKeep);
+
+	if (m_cbUsed > m_cbBudget && it != m_mapEntries.end())
+	{
+		m_cbUsed -= it->second.cb;
+		m_uncached = std::move(it->second);
+		m_mapEntries.erase(it);
+		++m_cEvictions;
+	}
+}
+
+
+const std::vector<uint64_t> &WildQueryCache::Query(const char *pWild,
+                                                   size_t *pcMatches)
+{
+	std::string strWild(pWild);
+	auto        it = m_mapEntries.find(strWild);
+
+	if (it != m_mapEntries.end())
+	{
+		++m_cHits;
+		m_cbUsed -= it->second.cb;
+		CatchUp(it->second);
+	}
+	else
+	{
+		WildCacheEntry entry;
+
+		++m_cMisses;
+		Evaluate(pWild, entry);
+
+		if (EntryBytes(strWild, entry) > m_cbBudget)
+		{
+			m_uncached = std::move(entry);
+
+			if (pcMatches)
+			{
+				*pcMatches = m_uncached.cMatches;
+			}
+
+			return m_uncached.rgWords;
+		}
+
+		it = m_mapEntries.emplace(strWild, std::move(entry)).first;
+	}
+
+	WildCacheEntry &entry = it->second;
+
+	entry.cb = EntryBytes(strWild, entry);
+	entry.dPriority = m_dAge + entry.dCost / entry.cb;
+	m_cbUsed += entry.cb;
+	Evict(strWild);
+	it = m_mapEntries.find(strWild);
+
+	const WildCacheEntry &result = it != m_mapEntries.end() ? it->second :
+	                               m_uncached;
+
+	if (pcMatches)
+	{
+		*pcMatches = result.cMatches;
+	}
+
+	return result.rgWords;
+}
+
+
+// Matches every live key of a corpus against a pattern, the slow way, as
+// a bitmap like WildQueryCache::Query() returns.
+//
+static std::vector<uint64_t> MatchAll(const WildLiveCorpus &corpus,
+                                      const char *pWild, size_t *pcMatches)
+{
+	std::vector<uint64_t> rgWords((corpus.Count() + 63) / 64);
+	std::string           strKey;
+
+	*pcMatches = 0;
+
+	for (uint32_t iKey = 0; iKey < corpus.Count(); ++iKey)
+	{
+		size_t      cbKey;
+		const char *pKey = corpus.Key(iKey, &cbKey);
+
+		strKey.assign(pKey, cbKey);
+
+		if (!corpus.IsDeleted(iKey) &&
+		    FastWildCompare(const_cast<char *>(pWild),
+		                    const_cast<char *>(strKey.c_str())))
+		{
+			rgWords[iKey / 64] |= (uint64_t) 1 << (iKey % 64);
+			++*pcMatches;
+		}
+	}
+
+	return rgWords;
+}
+
+
+// Appends random keys to a live corpus and deletes random live ones.
+//
+static void Churn(WildLiveCorpus &corpus, WildBenchRandom &rng,
+                  size_t cAppends, size_t cDeletes)
+{
+	std::string strKey;
+
+	for (size_t i = 0; i < cAppends; ++i)
+	{
+		WildBenchMakeKey(rng, strKey, i % 4 == 0);
+		corpus.Append(strKey.data(), strKey.size());
+	}
+
+	for (size_t i = 0; i < cDeletes && corpus.LiveCount(); ++i)
+	{
+		while (!corpus.Delete(rng.Below((uint32_t) corpus.Count())))
+		{
+		}
+	}
+}
+
+
+// A set of cache tests: cached results against matching every live key
+// as keys come and go, with and without a base corpus and with a budget
+// too small for every pattern; and eviction by cost rather than recency.
+//
+extern "C" int testcache(void)
+{
+	std::string              strPath =
+	    WildBenchTempPath("wildcache_test.wcorp");
+	WildBenchRandom          rng(1414);
+	std::vector<std::string> rgKeys(3000);
+	WildCorpusBuilder        builder;
+	WildCorpus               base;
+	bool                     bAllPassed = true;
+
+	for (std::string &strKey : rgKeys)
+	{
+		WildBenchMakeKey(rng, strKey, rng.Below(3) == 0);
+	}
+
+	std::sort(rgKeys.begin(), rgKeys.end());
+
+	for (const std::string &strKey : rgKeys)
+	{
+		builder.Add(strKey.data(), strKey.size());
+	}
+
+	bAllPassed &= builder.Write(strPath.c_str(), WILD_CORPUS_ALL) &&
+	              base.Open(strPath.c_str());
+
+	static const char *s_rgszWild[] =
+	{
+		"/srv/*", "*.log", "*cache1*", "/home/*/etc?*.csv", "*", "",
+		"*.idx", "/var/*/*7.bin", "*spool42*", "/tmp/run?1?/*"
+	};
+	const size_t cWild = sizeof(s_rgszWild) / sizeof(s_rgszWild[0]);
+
+	for (int iBase = 0; iBase < 2; ++iBase)
+	{
+		WildLiveCorpus corpus(iBase ? &base : NULL);
+		WildQueryCache cache(corpus, (size_t) 1 << 30);
+		WildQueryCache small(corpus, 12000);
+
+		for (int iRound = 0; iRound < 20; ++iRound)
+		{
+			Churn(corpus, rng, 1 + rng.Below(300), rng.Below(60));
+
+			for (size_t i = 0; i < cWild; ++i)
+			{
+				const char           *pszWild = s_rgszWild[i];
+				size_t                cExpected, cMatches, cSmall;
+				std::vector<uint64_t> rgExpected = MatchAll(corpus, pszWild,
+				                                            &cExpected);
+
+				bAllPassed &= cache.Query(pszWild, &cMatches) == rgExpected &&
+				              cMatches == cExpected;
+
+				// The small cache sees the patterns in a shifting order.
+				pszWild = s_rgszWild[(i + iRound * 3) % cWild];
+				rgExpected = MatchAll(corpus, pszWild, &cExpected);
+				bAllPassed &= small.Query(pszWild, &cSmall) == rgExpected &&
+				              cSmall == cExpected &&
+				              small.Bytes() <= 12000;
+			}
+		}
+
+		// Only the first round computes results from scratch.
+		bAllPassed &= cache.MissCount() == cWild &&
+		              cache.EntryCount() == cWild &&
+		              cache.DeltaKeyCount() > 0 &&
+		              small.EvictionCount() > 0;
+	}
+
+	// With room for two of three results, the cheap one goes, though the
+	// costly one was asked for longest ago.
+	WildLiveCorpus corpus(&base);
+	WildQueryCache probe(corpus, (size_t) 1 << 30);
+
+	probe.Query("*cache1*");
+	probe.Query("/srv/*");
+
+	WildQueryCache cache(corpus, probe.Bytes() + 64);
+
+	cache.Query("*cache1*");
+	cache.Query("/srv/*");
+	cache.Query("*.log");
+	bAllPassed &= cache.Holds("*cache1*") && !cache.Holds("/srv/*") &&
+	              cache.Holds("*.log") && cache.EvictionCount() == 1;
+
+	// A budget too small for any result still gives right answers.
+	WildQueryCache none(corpus, 0);
+	size_t         cExpected, cMatches;
+
+	bAllPassed &= none.Query("*.log", &cMatches) ==
+	              MatchAll(corpus, "*.log", &cExpected) &&
+	              cMatches == cExpected && none.EntryCount() == 0 &&
+	              none.Bytes() == 0;
+
+	// A segment too long for a WildProgram, in a result computed from
+	// scratch and in one caught up.
+	std::string strLong(70001, 'x');
+	std::string strLongWild = "*" + strLong.substr(1) + "*";
+
+	corpus.Append(strLong.data(), strLong.size());
+	bAllPassed &= none.Query(strLongWild.c_str(), &cMatches) ==
+	              MatchAll(corpus, strLongWild.c_str(), &cExpected) &&
+	              cMatches == cExpected && cMatches == 1;
+	cache.Query(strLongWild.c_str());
+	corpus.Append(strLong.data(), strLong.size());
+	bAllPassed &= cache.Query(strLongWild.c_str(), &cMatches) ==
+	              MatchAll(corpus, strLongWild.c_str(), &cExpected) &&
+	              cMatches == cExpected && cMatches == 2;
+
+	base.Close();
+	remove(strPath.c_str());
+
+	if (bAllPassed)
+	{
+		printf("Passed cache tests\n");
+	}
+	else
+	{
+		printf("Failed cache tests\n");
+	}
+
+	return 0;
+}
+
+
+// Compares repeated dashboard queries over a million-key corpus, with a
+// steady stream of appends and deletes between rounds, computed from
+// scratch each time and through the cache.
+//
+extern "C" int benchcache(void)
+{
+	const size_t             cKeys = 1000000;
+	const int                cRounds = 20;
+	std::string              strPath =
+	    WildBenchTempPath("wildcache_bench.wcorp");
+	WildBenchRandom          rng(1515);
+	std::vector<std::string> rgKeys(cKeys);
+	WildCorpusBuilder        builder;
+	WildCorpus               base;
+
+	for (std::string &strKey : rgKeys)
+	{
+		WildBenchMakeKey(rng, strKey, rng.Below(2) == 0);
+	}
+
+	std::sort(rgKeys.begin(), rgKeys.end());
+
+	for (const std::string &strKey : rgKeys)
+	{
+		builder.Add(strKey.data(), strKey.size());
+	}
+
+	if (!builder.Write(strPath.c_str(), WILD_CORPUS_ALL) ||
+	    !base.Open(strPath.c_str()))
+	{
+		return 0;
+	}
+
+	static const char *s_rgszWild[] =
+	{
+		"/srv/*", "*.parquet", "*cache4242*", "/home/*/etc?*.csv",
+		"*/logs*/*.log", "/data/*"
+	};
+
+	static const size_t s_rgcAppends[] = { 100, 2000, 20000 };
+
+	for (size_t cAppends : s_rgcAppends)
+	{
+		WildLiveCorpus corpus(&base);
+		WildQueryCache cache(corpus, (size_t) 64 << 20);
+		WildQueryCache none(corpus, 0);
+		uint64_t       uCachedNanos = 0;
+		uint64_t       uScratchNanos = 0;
+		uint64_t       uMaxCached = 0;
+		size_t         cQueries = 0;
+		bool           bSame = true;
+
+		for (int iRound = 0; iRound < cRounds; ++iRound)
+		{
+			Churn(corpus, rng, cAppends, cAppends / 10);
+
+			for (const char *pszWild : s_rgszWild)
+			{
+				size_t   cCached, cScratch;
+				uint64_t uStart = WildBenchNanos();
+
+				const std::vector<uint64_t> &rgCached =
+				    cache.Query(pszWild, &cCached);
+
+				uint64_t uNanos = WildBenchNanos() - uStart;
+
+				// The first round fills the cache.
+				if (iRound > 0)
+				{
+					uCachedNanos += uNanos;
+					uMaxCached = std::max(uMaxCached, uNanos);
+					++cQueries;
+				}
+
+				std::vector<uint64_t> rgCopy = rgCached;
+
+				uStart = WildBenchNanos();
+				bSame &= none.Query(pszWild, &cScratch) == rgCopy &&
+				         cScratch == cCached;
+
+				if (iRound > 0)
+				{
+					uScratchNanos += WildBenchNanos() - uStart;
+				}
+			}
+		}
+
+		printf("Cache, %zu keys, %zu appended and %zu deleted per round: "
+		       "from scratch %.2f ms, cached %.3f ms (%.0fx, worst %.3f ms), "
+		       "%.1f MB cached%s\n", cKeys, cAppends, cAppends / 10,
+		       uScratchNanos / 1e6 / cQueries, uCachedNanos / 1e6 / cQueries,
+		       (double) uScratchNanos / (uCachedNanos ? uCachedNanos : 1),
+		       uMaxCached / 1e6, cache.Bytes() / 1e6,
+		       bSame ? "" : " (RESULTS DIFFER)");
+	}
+
+	base.Close();
+	remove(strPath.c_str());
+	return 0;
+}
@@ -0,0 +1,224 @@
+// WildQueryCache, pattern results over a changing key corpus, kept current
+// by matching only the keys that changed
+//
+// Copyright 2025 Kirk J Krauss.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Dashboards run the same few patterns every few seconds over keys that
+// change a little in between.  A WildLiveCorpus is a mapped WildCorpus,
+// or nothing, plus the keys appended since, less those deleted.  Key
+// numbers are handed out in order and never reused, so a cached result
+// stays valid for every key up to the count it was made at.
+//
+// A WildQueryCache maps each pattern to a bitmap of the live keys that
+// match it.  When a pattern comes back, the cache matches only the keys
+// appended since its bitmap was made, with the pattern's compiled DFA,
+// and clears the bits of keys deleted since.  The cache stays within a
+// byte budget.  Entries are evicted GreedyDual-Size style: the one with
+// the least recompute cost per byte goes first, aged so that entries
+// not asked for in a while eventually go too.
+//
+#ifndef WILDCACHE_H
+#define WILDCACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "wildbytecode.h"
+#include "wildcompiled.h"
+#include "wildcorpus.h"
+#include "wilddfa.h"
+
+// A corpus file, if any, with keys appended and deleted since.
+//
+class WildLiveCorpus
+{
+public:
+	// The base corpus, if not NULL, must outlive this.
+	explicit WildLiveCorpus(const WildCorpus *pBase = NULL);
+
+	// Adds a key and returns its number.  Appended keys may take up to
+	// 4 GB in all.
+	uint32_t Append(const char *pKey, size_t cbKey);
+
+	// Deletes a key.  Returns false if there's no such key, or it's
+	// already deleted.
+	bool Delete(uint32_t iKey);
+
+	// Key numbers handed out, whether deleted or not.
+	size_t Count() const
+	{
+		return m_cBase + m_rgOffsets.size() - 1;
+	}
+
+	size_t LiveCount() const
+	{
+		return Count() - m_rgDeletes.size();
+	}
+
+	bool IsDeleted(uint32_t iKey) const
+	{
+		return (m_rgDeletedWords[iKey / 64] >> (iKey % 64)) & 1;
+	}
+
+	const char *Key(uint32_t iKey, size_t *pcbKey) const;
+
+	const WildCorpus *Base() const
+	{
+		return m_pBase;
+	}
+
+	size_t BaseCount() const
+	{
+		return m_cBase;
+	}
+
+	// The appended keys, back to back as WildDfa::MatchBatch() takes
+	// them: key BaseCount() + i is bytes rgOffsets[i] up to
+	// rgOffsets[i + 1].
+	const char *AppendedBytes() const
+	{
+		return m_strBytes.data();
+	}
+
+	const uint32_t *AppendedOffsets() const
+	{
+		return m_rgOffsets.data();
+	}
+
+	// Deleted keys, in the order they were deleted.
+	const std::vector<uint32_t> &Deletes() const
+	{
+		return m_rgDeletes;
+	}
+
+	// One bit per key number, set for deleted keys.
+	const std::vector<uint64_t> &DeletedWords() const
+	{
+		return m_rgDeletedWords;
+	}
+
+private:
+	const WildCorpus     *m_pBase;
+	size_t                m_cBase;
+	std::string           m_strBytes;
+	std::vector<uint32_t> m_rgOffsets;        // Appended keys, plus one
+	std::vector<uint32_t> m_rgDeletes;
+	std::vector<uint64_t> m_rgDeletedWords;
+};
+
+
+class WildQueryCache
+{
+public:
+	// The corpus must outlive the cache.  cbBudget bounds the bytes the
+	// cached results and their matchers take.
+	WildQueryCache(const WildLiveCorpus &corpus, size_t cbBudget);
+
+	// Returns the live keys that match a pattern of '*' and '?' wildcards,
+	// as a bitmap with a bit per key number, least significant first, and
+	// their count in *pcMatches if that's not NULL.  The bitmap stays valid
+	// until the next call.  One cache should be used by one thread at a
+	// time.
+	const std::vector<uint64_t> &Query(const char *pWild,
+	                                   size_t *pcMatches = NULL);
+
+	// Whether a pattern's result is cached.
+	bool Holds(const char *pWild) const
+	{
+		return m_mapEntries.count(pWild) != 0;
+	}
+
+	void Clear();
+
+	size_t Bytes() const
+	{
+		return m_cbUsed;
+	}
+
+	size_t EntryCount() const
+	{
+		return m_mapEntries.size();
+	}
+
+	// Counters, for measuring the cache.
+	uint64_t HitCount() const
+	{
+		return m_cHits;
+	}
+
+	uint64_t MissCount() const
+	{
+		return m_cMisses;
+	}
+
+	uint64_t EvictionCount() const
+	{
+		return m_cEvictions;
+	}
+
+	// Keys matched to bring cached results up to date.
+	uint64_t DeltaKeyCount() const
+	{
+		return m_cDeltaKeys;
+	}
+
+private:
+	// A cached result, good for key numbers below cKeys, with the first
+	// cDeletes deletions applied.  dCost is the number of keys the full
+	// evaluation looked at.  The pattern is matched with the DFA, else the
+	// program, else, if neither compiled, the compiled pattern.
+	struct WildCacheEntry
+	{
+		WildDfa               dfa;
+		WildProgram           program;
+		WildCompiledPattern   compiled;
+		bool                  bDfa;
+		bool                  bCompiled;
+		std::vector<uint64_t> rgWords;
+		size_t                cMatches;
+		size_t                cKeys;
+		size_t                cDeletes;
+		double                dCost;
+		double                dPriority;
+		size_t                cb;
+	};
+
+	void Evaluate(const char *pWild, WildCacheEntry &entry);
+	void CatchUp(WildCacheEntry &entry);
+	void MatchAppended(WildCacheEntry &entry, size_t iFirst, size_t iEnd);
+	size_t EntryBytes(const std::string &strWild,
+	                  const WildCacheEntry &entry) const;
+	void Evict(const std::string &strKeep);
+
+	const WildLiveCorpus                           &m_corpus;
+	std::unordered_map<std::string, WildCacheEntry> m_mapEntries;
+	WildCacheEntry                                  m_uncached;   // Too big
+	std::vector<uint8_t>                            m_rgbResult;
+	size_t                                          m_cbBudget;
+	size_t                                          m_cbUsed;
+	double                                          m_dAge;   // GreedyDual L
+	uint64_t                                        m_cHits;
+	uint64_t                                        m_cMisses;
+	uint64_t                                        m_cEvictions;
+	uint64_t                                        m_cDeltaKeys;
+};
+
+extern "C" int testcache(void);
+extern "C" int benchcache(void);
+
+#endif  // WILDCACHE_H
@@ -0,0 +1,502 @@
+// WildCompiledPattern, and related code
+//
+// Copyright 2025 Kirk J Krauss.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// This file provides the compiled pattern's compiler and matcher.  It
+// also includes testcases for correctness and performance.
+//
+#include <stdio.h>
+#include <string.h>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "fastwildcompare.h"
+#include "wildbytecode.h"
+#include "wildcompiled.h"
+#include "wildbench.h"
+
+
+WildCompiledPattern::WildCompiledPattern(
+    std::pmr::memory_resource *pResource) :
+    m_cSegments(0), m_cbBytes(0), m_bLeadingStar(false),
+    m_bTrailingStar(false), m_bSpilled(false), m_pResource(pResource)
+{
+}
+
+
+// Takes over another pattern's bytes as they are, heap block and all, and
+// leaves it empty.
+//
+WildCompiledPattern::WildCompiledPattern(WildCompiledPattern &&other)
+{
+	memcpy((void *) this, (const void *) &other, sizeof(*this));
+	other.m_bSpilled = false;
+	other.m_cSegments = 0;
+	other.m_cbBytes = 0;
+	other.m_bLeadingStar = false;
+	other.m_bTrailingStar = false;
+}
+
+
+WildCompiledPattern &WildCompiledPattern::operator=(
+    WildCompiledPattern &&other)
+{
+	if (this != &other)
+	{
+		Free();
+		new (this) WildCompiledPattern(std::move(other));
+	}
+
+	return *this;
+}
+
+
+WildCompiledPattern::~WildCompiledPattern()
+{
+	Free();
+}
+
+
+// Releases any spilled block and leaves the pattern empty.
+//
+void WildCompiledPattern::Free()
+{
+	if (m_bSpilled)
+	{
+		m_pResource->deallocate(m_heap.pSegments,
+		                        m_cSegments * sizeof(WildSegmentRef) +
+		                        m_cbBytes, alignof(WildSegmentRef));
+	}
+
+	m_bSpilled = false;
+	m_cSegments = 0;
+	m_cbBytes = 0;
+	m_bLeadingStar = false;
+	m_bTrailingStar = false;
+}
+
+
+// Writes a pattern's segment table and bytes, a segment at a time, in
+// locals, since stores through pBytes could otherwise alias the counts.
+//
+template <typename SegmentRef>
+static void FillSegments(const char *pWild, SegmentRef *rgSegments,
+                         char *pBytes)
+{
+	uint32_t iSegment = 0;
+	uint32_t cbDone = 0;
+
+	for (const char *p = pWild; *p; )
+	{
+		const char *pEnd = p;
+
+		if (*p == '*')
+		{
+			++p;
+			continue;
+		}
+
+		while (*pEnd && *pEnd != '*')
+		{
+			++pEnd;
+		}
+
+		rgSegments[iSegment].uOffset = (decltype(SegmentRef::uOffset)) cbDone;
+		rgSegments[iSegment++].cb = (decltype(SegmentRef::cb)) (pEnd - p);
+		memcpy(pBytes + cbDone, p, pEnd - p);
+		cbDone += (uint32_t) (pEnd - p);
+		p = pEnd;
+	}
+}
+
+
+void WildCompiledPattern::Compile(const char *pWild)
+{
+	uint32_t cSegments = 0;
+	uint32_t cbBytes = 0;
+	size_t   cbWild = 0;
+
+	Free();
+
+	for (; pWild[cbWild]; ++cbWild)
+	{
+		if (pWild[cbWild] != '*')
+		{
+			cSegments += cbWild == 0 || pWild[cbWild - 1] == '*';
+			++cbBytes;
+		}
+	}
+
+	if (cSegments > WILD_SMALL_SEGMENTS || cbBytes > WILD_SMALL_BYTES)
+	{
+		WildSegmentRef *rgSegments = (WildSegmentRef *) m_pResource->allocate(
+		    cSegments * sizeof(WildSegmentRef) + cbBytes,
+		    alignof(WildSegmentRef));
+
+		m_heap.pSegments = rgSegments;
+		m_heap.pBytes = (char *) (rgSegments + cSegments);
+		m_bSpilled = true;
+		FillSegments(pWild, rgSegments, m_heap.pBytes);
+	}
+	else
+	{
+		FillSegments(pWild, m_small.rgSegments, m_small.rgchBytes);
+	}
+
+	m_cSegments = cSegments;
+	m_cbBytes = cbBytes;
+	m_bLeadingStar = cbWild && pWild[0] == '*';
+	m_bTrailingStar = cbWild && pWild[cbWild - 1] == '*';
+}
+
+
+// Whether a segment's bytes match at pTame, '?' matching any byte.
+//
+static inline bool SegmentAt(const char *pTame, const char *pSegment,
+                             size_t cbSegment)
+{
+	for (size_t i = 0; i < cbSegment; ++i)
+	{
+		if (pSegment[i] != pTame[i] && pSegment[i] != '?')
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+// The leftmost start at or after uPos where a segment matches within
+// cbTame bytes, or SIZE_MAX.  Candidates are found by the segment's first
+// byte that isn't '?'.
+//
+static size_t FindSegment(const char *pTame, size_t uPos, size_t cbTame,
+                          const char *pSegment, size_t cbSegment)
+{
+	size_t iLiteral = 0;
+
+	while (iLiteral < cbSegment && pSegment[iLiteral] == '?')
+	{
+		++iLiteral;
+	}
+
+	while (uPos + cbSegment <= cbTame)
+	{
+		if (iLiteral < cbSegment)
+		{
+			const char *pFound = (const char *) memchr(
+			    pTame + uPos + iLiteral, pSegment[iLiteral],
+			    cbTame - cbSegment + 1 - uPos);
+
+			if (pFound == NULL)
+			{
+				break;
+			}
+
+			uPos = pFound - iLiteral - pTame;
+		}
+
+		if (SegmentAt(pTame + uPos, pSegment, cbSegment))
+		{
+			return uPos;
+		}
+
+		++uPos;
+	}
+
+	return SIZE_MAX;
+}
+
+
+bool WildCompiledPattern::Match(const char *pTame, size_t cbTame) const
+{
+	return m_bSpilled ? MatchSegments(m_heap.pSegments, pTame, cbTame) :
+	                    MatchSegments(m_small.rgSegments, pTame, cbTame);
+}
+
+
+// Matches with the inline table or the spilled one, whose entries are
+// wider.
+//
+template <typename SegmentRef>
+bool WildCompiledPattern::MatchSegments(const SegmentRef *rgSegments,
+                                        const char *pTame,
+                                        size_t cbTame) const
+{
+	const char *pBytes = Bytes();
+	uint32_t    iFirst = 0;
+	uint32_t    iEnd = m_cSegments;
+	size_t      uPos = 0;
+
+	if (cbTame < m_cbBytes)
+	{
+		return false;
+	}
+
+	// With no '*' at all, there's one segment, or none, to match exactly.
+	if (!m_bLeadingStar && !m_bTrailingStar && m_cSegments <= 1)
+	{
+		return cbTame == m_cbBytes && SegmentAt(pTame, pBytes, m_cbBytes);
+	}
+
+	if (!m_bLeadingStar)
+	{
+		if (!SegmentAt(pTame, pBytes, rgSegments[0].cb))
+		{
+			return false;
+		}
+
+		uPos = rgSegments[iFirst++].cb;
+	}
+
+	if (!m_bTrailingStar)
+	{
+		const SegmentRef &tail = rgSegments[--iEnd];
+
+		cbTame -= tail.cb;
+
+		if (!SegmentAt(pTame + cbTame, pBytes + tail.uOffset, tail.cb))
+		{
+			return false;
+		}
+	}
+
+	for (uint32_t i = iFirst; i < iEnd; ++i)
+	{
+		uPos = FindSegment(pTame, uPos, cbTame,
+		                   pBytes + rgSegments[i].uOffset, rgSegments[i].cb);
+
+		if (uPos == SIZE_MAX)
+		{
+			return false;
+		}
+
+		uPos += rgSegments[i].cb;
+	}
+
+	return true;
+}
+
+
+// A random pattern or tame string over a few letters, for matching to be
+// close to even odds.
+//
+static void MakeSmallAlphabet(WildBenchRandom &rng, std::string &str,
+                              size_t cbMax, bool bWild)
+{
+	static const char s_rgchWild[] = "ab?*";
+	size_t            cb = rng.Below((uint32_t) cbMax + 1);
+
+	str.clear();
+
+	for (size_t i = 0; i < cb; ++i)
+	{
+		str += bWild ? s_rgchWild[rng.Below(4)] : (char) ('a' + rng.Below(2));
+	}
+}
+
+
+extern "C" int testcompiled(void)
+{
+	bool            bAllPassed = sizeof(WildCompiledPattern) == 128 &&
+	                             alignof(WildCompiledPattern) == 64;
+	WildBenchRandom rng(1230);
+	std::string     strWild;
+	std::string     strTame;
+
+	for (int i = 0; i < 200000; ++i)
+	{
+		// Same results as FastWildCompare(), inline and spilled.
+		if (i % 2)
+		{
+			MakeSmallAlphabet(rng, strWild, i % 3 ? 12 : 80, true);
+			MakeSmallAlphabet(rng, strTame, 24, false);
+		}
+		else
+		{
+			WildBenchMakePattern(rng, strWild);
+			WildBenchMakeKey(rng, strTame, rng.Below(4) == 0);
+		}
+
+		WildCompiledPattern pattern(strWild.c_str());
+		std::string         strCopy(strWild);
+
+		bAllPassed &= pattern.Match(strTame.data(), strTame.size()) ==
+		              FastWildCompare(&strCopy[0], &strTame[0]);
+	}
+
+	{
+		// Short patterns stay inline, long ones spill, and either moves,
+		// by construction, assignment, or a vector growing, and keeps
+		// matching; a moved-from pattern matches as "" does.
+		std::vector<WildCompiledPattern> rgPatterns;
+		std::string                      strLong;
+
+		for (int i = 0; i < 10; ++i)
+		{
+			strLong += "*seg" + std::to_string(i);
+		}
+
+		strLong += "*";
+
+		WildCompiledPattern small("/srv/*/cache?.log");
+		WildCompiledPattern spilled(strLong.c_str());
+
+		bAllPassed &= !small.Spilled() && spilled.Spilled() &&
+		              small.Match("/srv/app/cache1.log") &&
+		              spilled.Match("xseg0seg1seg2seg3seg4seg5seg6seg7seg8"
+		                            "seg9x");
+
+		// The inline table holds WILD_SMALL_BYTES bytes, and a spilled one
+		// segments longer than its narrow entries could.
+		std::string strFull(WILD_SMALL_BYTES, 'f');
+		std::string strHuge(70001, 'h');
+
+		WildCompiledPattern full(("*" + strFull).c_str());
+		WildCompiledPattern over(("*" + strFull + "f").c_str());
+		WildCompiledPattern huge(("*" + strHuge.substr(1) + "*").c_str());
+
+		bAllPassed &= !full.Spilled() && over.Spilled() &&
+		              full.Match(("x" + strFull).c_str()) &&
+		              huge.Match(strHuge.data(), strHuge.size());
+
+		for (int i = 0; i < 100; ++i)
+		{
+			rgPatterns.emplace_back(i % 2 ? "/srv/*/cache?.log" :
+			                        strLong.c_str());
+		}
+
+		WildCompiledPattern moved(std::move(rgPatterns[1]));
+
+		rgPatterns[2] = std::move(rgPatterns[3]);
+		bAllPassed &= moved.Match("/srv/x/cache2.log") &&
+		              rgPatterns[2].Match("/srv/x/cache2.log") &&
+		              rgPatterns[1].Match("") && !rgPatterns[1].Match("x") &&
+		              rgPatterns[98].Match("seg0seg1seg2seg3seg4seg5seg6"
+		                                   "seg7seg8seg9") &&
+		              !rgPatterns[98].Match("seg0seg1seg2seg3seg4seg5seg6"
+		                                    "seg7seg9seg8");
+	}
+
+	{
+		// Edge cases: empty, all stars, all '?'s.
+		bAllPassed &= WildCompiledPattern("").Match("") &&
+		              !WildCompiledPattern("").Match("a") &&
+		              WildCompiledPattern("***").Match("") &&
+		              WildCompiledPattern("*").Match("abc") &&
+		              WildCompiledPattern("*??*").Match("ab") &&
+		              !WildCompiledPattern("*??*").Match("a") &&
+		              WildCompiledPattern("a*a").Match("aa") &&
+		              !WildCompiledPattern("a*a").Match("a");
+	}
+
+	if (bAllPassed)
+	{
+		printf("Passed compiled pattern tests\n");
+	}
+	else
+	{
+		printf("Failed compiled pattern tests\n");
+	}
+
+	return 0;
+}
+
+
+extern "C" int benchcompiled(void)
+{
+	const size_t    cRequests = 200000;
+	WildBenchRandom rng(1231);
+
+	printf("Compiled patterns, compiling and matching once per request, "
+	       "%zu requests:\n", cRequests);
+
+	for (int iLong = 0; iLong < 2; ++iLong)
+	{
+		std::vector<std::string> rgWild(cRequests);
+		std::vector<std::string> rgTame(cRequests);
+		size_t                   cSpilled = 0;
+		size_t                   cbWild = 0;
+
+		for (size_t i = 0; i < cRequests; ++i)
+		{
+			WildBenchMakePattern(rng, rgWild[i]);
+
+			// Long patterns: several of the short ones, joined by '*'.
+			for (int iMore = 0; iLong && iMore < 3; ++iMore)
+			{
+				std::string strMore;
+
+				WildBenchMakePattern(rng, strMore);
+				rgWild[i] += "*" + strMore;
+			}
+
+			WildBenchMakeKey(rng, rgTame[i], rng.Below(4) == 0);
+			cSpilled += WildCompiledPattern(rgWild[i].c_str()).Spilled();
+			cbWild += rgWild[i].size();
+		}
+
+		printf("  %s patterns, %.1f bytes on average, %.1f%% spilled:\n",
+		       iLong ? "long" : "short", (double) cbWild / cRequests,
+		       100.0 * cSpilled / cRequests);
+
+		// WildDfa isn't here: building a DFA takes tens of microseconds or
+		// more, which a pattern matched once doesn't repay.
+		for (int iWay = 0; iWay < 3; ++iWay)
+		{
+			size_t   cMatches = 0;
+			uint64_t uStart = WildBenchNanos();
+
+			for (size_t i = 0; i < cRequests; ++i)
+			{
+				const std::string &strTame = rgTame[i];
+
+				if (iWay == 0)
+				{
+					cMatches += FastWildCompare(&rgWild[i][0],
+					                            (char *) strTame.c_str());
+				}
+				else if (iWay == 1)
+				{
+					WildCompiledPattern pattern(rgWild[i].c_str());
+
+					cMatches += pattern.Match(strTame.data(),
+					                          strTame.size());
+				}
+				else
+				{
+					WildProgram program;
+
+					program.Compile(rgWild[i].c_str());
+					cMatches += program.Match(strTame.data(),
+					                          strTame.size());
+				}
+			}
+
+			uint64_t uNanos = WildBenchNanos() - uStart;
+
+			printf("    %-22s %8.2f ms %7.1f ns/request, %zu matched\n",
+			       iWay == 0 ? "FastWildCompare()" :
+			       iWay == 1 ? "WildCompiledPattern" : "WildProgram",
+			       uNanos / 1e6,
+			       (double) uNanos / cRequests, cMatches);
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,148 @@
+// WildCompiledPattern, a compiled pattern that keeps short patterns in
+// one cache-line-aligned object, with no heap allocation
+//
+// Copyright 2025 Kirk J Krauss.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// A service that compiles each request's pattern, matches it against a
+// key or a few, and drops it, pays for the compile on every request.  A
+// WildProgram or WildDfa puts its tables in vectors, so each compile costs
+// a heap allocation or several, and each match a pointer chase to them.
+//
+// A WildCompiledPattern splits a pattern at its '*'s into segments of
+// literal bytes and '?'s, and keeps a table of where each segment starts
+// and how long it is, along with the segments' bytes.  For a pattern of up
+// to WILD_SMALL_SEGMENTS segments and WILD_SMALL_BYTES bytes other than
+// '*', which covers most patterns under 48 bytes, all of that lives in the
+// object itself: 128 bytes, aligned to a cache line, so that compiling it
+// on the stack allocates nothing and matching it reads two lines.  Longer
+// patterns spill their table and bytes to one block from the pattern's
+// memory resource, the default resource unless one is given.
+//
+// A match checks the first segment at the start of the tame string, if
+// the pattern doesn't start with '*', and the last at the end, if it
+// doesn't end with '*', then finds each middle segment leftmost first, as
+// FastWildCompare() does, with the same results.
+//
+// The object is move-only.  It has no pointers into itself, so it may be
+// moved, or relocated, by copying its bytes; a moved-from pattern matches
+// as an empty one does.  A pattern moved to takes the memory resource of
+// the one moved from, along with any block from it.
+//
+#ifndef WILDCOMPILED_H
+#define WILDCOMPILED_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <memory_resource>
+
+#define WILD_SMALL_SEGMENTS  8    // Segments kept inline
+#define WILD_SMALL_BYTES     48   // Segment bytes kept inline
+
+// Where a segment's bytes start among the pattern's, and how many.
+struct WildSegmentRef
+{
+	uint32_t uOffset;
+	uint32_t cb;
+};
+
+// The same, for the inline table, whose segments can't be long.
+struct WildSmallSegmentRef
+{
+	uint16_t uOffset;
+	uint16_t cb;
+};
+
+class alignas(64) WildCompiledPattern
+{
+public:
+	explicit WildCompiledPattern(std::pmr::memory_resource *pResource =
+	                             std::pmr::get_default_resource());
+
+	explicit WildCompiledPattern(const char *pWild,
+	                             std::pmr::memory_resource *pResource =
+	                             std::pmr::get_default_resource()) :
+	    WildCompiledPattern(pResource)
+	{
+		Compile(pWild);
+	}
+
+	WildCompiledPattern(WildCompiledPattern &&other);
+	WildCompiledPattern &operator=(WildCompiledPattern &&other);
+	WildCompiledPattern(const WildCompiledPattern &) = delete;
+	WildCompiledPattern &operator=(const WildCompiledPattern &) = delete;
+	~WildCompiledPattern();
+
+	// Compiles a pattern of '*' and '?' wildcards, replacing any before.
+	void Compile(const char *pWild);
+
+	// Matches a tame string of cbTame bytes, which need not be terminated.
+	bool Match(const char *pTame, size_t cbTame) const;
+
+	bool Match(const char *pTame) const
+	{
+		return Match(pTame, strlen(pTame));
+	}
+
+	// Whether the pattern's table and bytes are in a block of their own.
+	bool Spilled() const
+	{
+		return m_bSpilled;
+	}
+
+	std::pmr::memory_resource *Resource() const
+	{
+		return m_pResource;
+	}
+
+private:
+	template <typename SegmentRef>
+	bool MatchSegments(const SegmentRef *rgSegments, const char *pTame,
+	                   size_t cbTame) const;
+
+	const char *Bytes() const
+	{
+		return m_bSpilled ? m_heap.pBytes : m_small.rgchBytes;
+	}
+
+	void Free();
+
+	uint32_t m_cSegments;
+	uint32_t m_cbBytes;        // Segment bytes, so the least a match takes
+	bool     m_bLeadingStar;
+	bool     m_bTrailingStar;
+	bool     m_bSpilled;
+	std::pmr::memory_resource *m_pResource;   // For a spilled block
+
+	union
+	{
+		struct
+		{
+			WildSmallSegmentRef rgSegments[WILD_SMALL_SEGMENTS];
+			char                rgchBytes[WILD_SMALL_BYTES];
+		} m_small;
+
+		struct
+		{
+			WildSegmentRef *pSegments;   // One block, segments then bytes
+			char           *pBytes;
+		} m_heap;
+	};
+};
+
+extern "C" int testcompiled(void);
+extern "C" int benchcompiled(void);
+
+#endif  // WILDCOMPILED_H
@@ -0,0 +1,1396 @@
+// WildCorpus, and related code
+//
+// Copyright 2025 Kirk J Krauss.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// This file provides the corpus builder, the reader, and the scanner.  It
+// also includes testcases for correctness and performance, and, built with
+// BUILD_CORPUS_TOOL, a command-line builder:
+//
+//   wildcorpus [-s] [-t] [-r] keys.txt keys.wcorp
+//
+// where -s, -t and -r add signatures, trigram postings and the reversed
+// order.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define WILD_HAVE_MMAP  1
+#endif
+
+#include "fastwildcompare.h"
+#include "wildbytecode.h"
+#include "wildcompiled.h"
+#include "wilddfa.h"
+#include "wildcorpus.h"
+#include "wildbench.h"
+
+//#define BUILD_CORPUS_TOOL  1
+
+static const char s_rgchMagic[8] = { 'W', 'I', 'L', 'D', 'C', 'O', 'R', 'P' };
+
+
+static bool LittleEndian()
+{
+	uint32_t u = 1;
+
+	return *(const uint8_t *) &u == 1;
+}
+
+
+unsigned WildCorpusTrigramBucket(const char *pTrigram)
+{
+	uint32_t u = (uint32_t) (uint8_t) pTrigram[0] |
+	             (uint32_t) (uint8_t) pTrigram[1] << 8 |
+	             (uint32_t) (uint8_t) pTrigram[2] << 16;
+
+	return (u * 0x9E3779B1u) >> 20;
+}
+
+
+void WildCorpusBuilder::Add(const char *pKey, size_t cbKey)
+{
+	m_rgOffsets.push_back((uint32_t) m_strBytes.size());
+	m_strBytes.append(pKey, cbKey);
+}
+
+
+// Appends a section at the next 64-byte boundary.
+//
+static void AppendSection(std::string &strFile, WildCorpusHeader &header,
+                          WildCorpusSectionId id, const void *pData,
+                          size_t cb)
+{
+	strFile.resize((strFile.size() + 63) & ~(size_t) 63, '\0');
+	header.rgSections[id].uOffset = strFile.size();
+	header.rgSections[id].cb = cb;
+	strFile.append((const char *) pData, cb);
+}
+
+
+bool WildCorpusBuilder::Write(const char *pszPath, unsigned uSections) const
+{
+	size_t cKeys = m_rgOffsets.size();
+
+	if (m_strBytes.size() > UINT32_MAX || !LittleEndian())
+	{
+		return false;
+	}
+
+	std::vector<uint32_t> rgOffsets(m_rgOffsets);
+	WildCorpusHeader      header;
+	std::string           strFile;
+
+	rgOffsets.push_back((uint32_t) m_strBytes.size());
+	memset(&header, 0, sizeof(header));
+	memcpy(header.rgchMagic, s_rgchMagic, sizeof(s_rgchMagic));
+	header.uVersion = WILD_CORPUS_VERSION;
+	header.uSections = uSections & WILD_CORPUS_ALL;
+	header.cKeys = cKeys;
+	header.cBlockKeys = WILD_CORPUS_BLOCK_KEYS;
+	header.cBlocks = (uint32_t) ((cKeys + WILD_CORPUS_BLOCK_KEYS - 1) /
+	                             WILD_CORPUS_BLOCK_KEYS);
+
+	// Signatures and zones.
+	std::vector<uint64_t>       rgSignatures(cKeys, 0);
+	std::vector<WildCorpusZone> rgZones(header.cBlocks);
+
+	for (size_t iKey = 0; iKey < cKeys; ++iKey)
+	{
+		const uint8_t  *pKey = (const uint8_t *) m_strBytes.data() +
+		                       rgOffsets[iKey];
+		uint32_t        cbKey = rgOffsets[iKey + 1] - rgOffsets[iKey];
+		WildCorpusZone &zone = rgZones[iKey / WILD_CORPUS_BLOCK_KEYS];
+		uint8_t         rgHead[8] = { 0 };
+
+		for (uint32_t i = 0; i < cbKey; ++i)
+		{
+			rgSignatures[iKey] |= WildCorpusSignatureBit(pKey[i]);
+		}
+
+		memcpy(rgHead, pKey, cbKey < 8 ? cbKey : 8);
+
+		if (iKey % WILD_CORPUS_BLOCK_KEYS == 0)
+		{
+			zone.uMinLen = zone.uMaxLen = cbKey;
+			zone.uSignature = 0;
+			memcpy(zone.rgMinHead, rgHead, 8);
+			memcpy(zone.rgMaxHead, rgHead, 8);
+		}
+
+		zone.uMinLen = std::min(zone.uMinLen, cbKey);
+		zone.uMaxLen = std::max(zone.uMaxLen, cbKey);
+		zone.uSignature |= rgSignatures[iKey];
+
+		if (memcmp(rgHead, zone.rgMinHead, 8) < 0)
+		{
+			memcpy(zone.rgMinHead, rgHead, 8);
+		}
+
+		if (memcmp(rgHead, zone.rgMaxHead, 8) > 0)
+		{
+			memcpy(zone.rgMaxHead, rgHead, 8);
+		}
+	}
+
+	strFile.assign(sizeof(header), '\0');
+	AppendSection(strFile, header, WILD_SECTION_OFFSETS, rgOffsets.data(),
+	              rgOffsets.size() * sizeof(uint32_t));
+	AppendSection(strFile, header, WILD_SECTION_BYTES, m_strBytes.data(),
+	              m_strBytes.size());
+	AppendSection(strFile, header, WILD_SECTION_ZONES, rgZones.data(),
+	              rgZones.size() * sizeof(WildCorpusZone));
+
+	if (uSections & WILD_CORPUS_SIGNATURES)
+	{
+		AppendSection(strFile, header, WILD_SECTION_SIGNATURES,
+		              rgSignatures.data(), cKeys * sizeof(uint64_t));
+	}
+
+	if (uSections & WILD_CORPUS_TRIGRAMS)
+	{
+		// Blocks are visited in order, so each bucket's list comes out
+		// sorted, and a repeat is always the last entry.
+		std::vector<std::vector<uint32_t>> rgrgBuckets(
+		    WILD_CORPUS_TRIGRAM_BUCKETS);
+		std::vector<uint32_t> rgIndex(1, 0), rgBlocks;
+
+		for (size_t iKey = 0; iKey < cKeys; ++iKey)
+		{
+			const char *pKey = m_strBytes.data() + rgOffsets[iKey];
+			uint32_t    cbKey = rgOffsets[iKey + 1] - rgOffsets[iKey];
+			uint32_t    iBlock = (uint32_t) (iKey / WILD_CORPUS_BLOCK_KEYS);
+
+			for (uint32_t i = 0; i + 3 <= cbKey; ++i)
+			{
+				std::vector<uint32_t> &rgBucket =
+				    rgrgBuckets[WildCorpusTrigramBucket(pKey + i)];
+
+				if (rgBucket.empty() || rgBucket.back() != iBlock)
+				{
+					rgBucket.push_back(iBlock);
+				}
+			}
+		}
+
+		for (const std::vector<uint32_t> &rgBucket : rgrgBuckets)
+		{
+			rgBlocks.insert(rgBlocks.end(), rgBucket.begin(), rgBucket.end());
+			rgIndex.push_back((uint32_t) rgBlocks.size());
+		}
+
+		AppendSection(strFile, header, WILD_SECTION_TRIGRAM_INDEX,
+		              rgIndex.data(), rgIndex.size() * sizeof(uint32_t));
+		AppendSection(strFile, header, WILD_SECTION_TRIGRAM_BLOCKS,
+		              rgBlocks.data(), rgBlocks.size() * sizeof(uint32_t));
+	}
+
+	if (uSections & WILD_CORPUS_REVERSED)
+	{
+		std::vector<uint32_t> rgOrder(cKeys);
+		std::vector<uint64_t> rgTails(cKeys);
+		const uint8_t        *pBytes = (const uint8_t *) m_strBytes.data();
+
+		// Each key's last 8 bytes, last first, padded with zeros, order
+		// most pairs of keys the way their whole reversed bytes would.
+		for (size_t i = 0; i < cKeys; ++i)
+		{
+			const uint8_t *p = pBytes + rgOffsets[i + 1];
+			size_t         cb = std::min<size_t>(8, rgOffsets[i + 1] -
+			                                        rgOffsets[i]);
+
+			rgOrder[i] = (uint32_t) i;
+			rgTails[i] = 0;
+
+			for (size_t iByte = 0; iByte < cb; ++iByte)
+			{
+				rgTails[i] |= (uint64_t) *--p << (56 - 8 * iByte);
+			}
+		}
+
+		std::sort(rgOrder.begin(), rgOrder.end(),
+		          [&](uint32_t iA, uint32_t iB)
+		{
+			if (rgTails[iA] != rgTails[iB])
+			{
+				return rgTails[iA] < rgTails[iB];
+			}
+
+			const uint8_t *pA = pBytes + rgOffsets[iA + 1];
+			const uint8_t *pB = pBytes + rgOffsets[iB + 1];
+			const uint8_t *pStartA = pBytes + rgOffsets[iA];
+			const uint8_t *pStartB = pBytes + rgOffsets[iB];
+
+			// Loaded little-endian, 8 bytes that end a key have its last
+			// byte most significant, so words compare as reversed bytes.
+			while (pA - pStartA >= 8 && pB - pStartB >= 8)
+			{
+				uint64_t uA, uB;
+
+				memcpy(&uA, pA - 8, 8);
+				memcpy(&uB, pB - 8, 8);
+
+				if (uA != uB)
+				{
+					return uA < uB;
+				}
+
+				pA -= 8;
+				pB -= 8;
+			}
+
+			while (pA > pStartA && pB > pStartB)
+			{
+				if (*--pA != *--pB)
+				{
+					return *pA < *pB;
+				}
+			}
+
+			return pA - pStartA < pB - pStartB ||
+			       (pA == pStartA && pB == pStartB && iA < iB);
+		});
+
+		AppendSection(strFile, header, WILD_SECTION_REVERSED,
+		              rgOrder.data(), cKeys * sizeof(uint32_t));
+	}
+
+	memcpy(&strFile[0], &header, sizeof(header));
+
+	FILE *pFile = fopen(pszPath, "wb");
+
+	if (!pFile)
+	{
+		return false;
+	}
+
+	bool bWritten = fwrite(strFile.data(), 1, strFile.size(), pFile) ==
+	                strFile.size();
+
+	return fclose(pFile) == 0 && bWritten;
+}
+
+
+WildCorpus::WildCorpus() :
+    m_pBase(NULL), m_cbFile(0), m_pHeader(NULL), m_bMapped(false)
+{
+}
+
+
+WildCorpus::~WildCorpus()
+{
+	Close();
+}
+
+
+void WildCorpus::Close()
+{
+#if defined(WILD_HAVE_MMAP)
+	if (m_bMapped)
+	{
+		munmap((void *) m_pBase, m_cbFile);
+	}
+#endif
+
+	m_rgbCopy.clear();
+	m_pBase = NULL;
+	m_cbFile = 0;
+	m_pHeader = NULL;
+	m_bMapped = false;
+}
+
+
+// Checks that a section lies within the file, is aligned for its element
+// type, and has the expected size, if that's known up front.  An absent
+// optional section passes.
+//
+static bool SectionFits(const WildCorpusHeader &header, size_t cbFile,
+                        WildCorpusSectionId id, bool bPresent,
+                        uint64_t cbExpected)
+{
+	const WildCorpusSection &section = header.rgSections[id];
+
+	if (!bPresent)
+	{
+		return section.uOffset == 0;
+	}
+
+	return section.uOffset >= sizeof(header) && section.uOffset % 8 == 0 &&
+	       section.uOffset <= cbFile && section.cb <= cbFile - section.uOffset &&
+	       (cbExpected == UINT64_MAX || section.cb == cbExpected);
+}
+
+
+bool WildCorpus::Open(const char *pszPath)
+{
+	Close();
+
+	if (!LittleEndian())
+	{
+		return false;
+	}
+
+#if defined(WILD_HAVE_MMAP)
+	int         fd = open(pszPath, O_RDONLY);
+	struct stat st;
+
+	if (fd < 0)
+	{
+		return false;
+	}
+
+	if (fstat(fd, &st) || st.st_size < (off_t) sizeof(WildCorpusHeader))
+	{
+		close(fd);
+		return false;
+	}
+
+	void *pMap = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+	close(fd);
+
+	if (pMap == MAP_FAILED)
+	{
+		return false;
+	}
+
+	m_pBase = (const uint8_t *) pMap;
+	m_cbFile = (size_t) st.st_size;
+	m_bMapped = true;
+#else
+	FILE *pFile = fopen(pszPath, "rb");
+	uint8_t rgbChunk[65536];
+	size_t  cb;
+
+	if (!pFile)
+	{
+		return false;
+	}
+
+	while ((cb = fread(rgbChunk, 1, sizeof(rgbChunk), pFile)) > 0)
+	{
+		m_rgbCopy.insert(m_rgbCopy.end(), rgbChunk, rgbChunk + cb);
+	}
+
+	fclose(pFile);
+
+	if (m_rgbCopy.size() < sizeof(WildCorpusHeader))
+	{
+		Close();
+		return false;
+	}
+
+	m_pBase = m_rgbCopy.data();
+	m_cbFile = m_rgbCopy.size();
+#endif
+
+	const WildCorpusHeader &header = *(const WildCorpusHeader *) m_pBase;
+	uint64_t                cKeys = header.cKeys;
+	unsigned                uSections = header.uSections;
+	bool                    bValid =
+	    !memcmp(header.rgchMagic, s_rgchMagic, sizeof(s_rgchMagic)) &&
+	    header.uVersion == WILD_CORPUS_VERSION &&
+	    !(uSections & ~WILD_CORPUS_ALL) && cKeys < UINT32_MAX &&
+	    header.cBlockKeys > 0 &&
+	    header.cBlocks == (cKeys + header.cBlockKeys - 1) / header.cBlockKeys;
+
+	bValid = bValid &&
+	    SectionFits(header, m_cbFile, WILD_SECTION_OFFSETS, true,
+	                (cKeys + 1) * sizeof(uint32_t)) &&
+	    SectionFits(header, m_cbFile, WILD_SECTION_BYTES, true, UINT64_MAX) &&
+	    SectionFits(header, m_cbFile, WILD_SECTION_ZONES, true,
+	                header.cBlocks * sizeof(WildCorpusZone)) &&
+	    SectionFits(header, m_cbFile, WILD_SECTION_SIGNATURES,
+	                (uSections & WILD_CORPUS_SIGNATURES) != 0,
+	                cKeys * sizeof(uint64_t)) &&
+	    SectionFits(header, m_cbFile, WILD_SECTION_TRIGRAM_INDEX,
+	                (uSections & WILD_CORPUS_TRIGRAMS) != 0,
+	                (WILD_CORPUS_TRIGRAM_BUCKETS + 1) * sizeof(uint32_t)) &&
+	    SectionFits(header, m_cbFile, WILD_SECTION_TRIGRAM_BLOCKS,
+	                (uSections & WILD_CORPUS_TRIGRAMS) != 0, UINT64_MAX) &&
+	    SectionFits(header, m_cbFile, WILD_SECTION_REVERSED,
+	                (uSections & WILD_CORPUS_REVERSED) != 0,
+	                cKeys * sizeof(uint32_t));
+
+	if (!bValid)
+	{
+		Close();
+		return false;
+	}
+
+	m_pHeader = &header;
+
+	// Offsets must climb to the end of the bytes, and postings must stay
+	// within their section and name real blocks, so that no lookup can
+	// stray outside the file.  This is the only pass over the file that
+	// opening makes.
+	const uint32_t *rgOffsets = Offsets();
+
+	bValid = rgOffsets[0] == 0 &&
+	         rgOffsets[cKeys] == header.rgSections[WILD_SECTION_BYTES].cb;
+
+	for (uint64_t i = 0; bValid && i < cKeys; ++i)
+	{
+		bValid = rgOffsets[i] <= rgOffsets[i + 1];
+	}
+
+	if (bValid && (uSections & WILD_CORPUS_TRIGRAMS))
+	{
+		const uint32_t *rgIndex =
+		    (const uint32_t *) Section(WILD_SECTION_TRIGRAM_INDEX);
+		const uint32_t *rgBlocks =
+		    (const uint32_t *) Section(WILD_SECTION_TRIGRAM_BLOCKS);
+		uint64_t        cPostings =
+		    header.rgSections[WILD_SECTION_TRIGRAM_BLOCKS].cb / sizeof(uint32_t);
+
+		bValid = rgIndex[0] == 0 &&
+		         rgIndex[WILD_CORPUS_TRIGRAM_BUCKETS] == cPostings;
+
+		for (unsigned i = 0; bValid && i < WILD_CORPUS_TRIGRAM_BUCKETS; ++i)
+		{
+			bValid = rgIndex[i] <= rgIndex[i + 1];
+		}
+
+		for (uint64_t i = 0; bValid && i < cPostings; ++i)
+		{
+			bValid = rgBlocks[i] < header.cBlocks;
+		}
+	}
+
+	if (bValid && (uSections & WILD_CORPUS_REVERSED))
+	{
+		const uint32_t *rgOrder = ReversedOrder();
+
+		for (uint64_t i = 0; bValid && i < cKeys; ++i)
+		{
+			bValid = rgOrder[i] < cKeys;
+		}
+	}
+
+	if (!bValid)
+	{
+		Close();
+	}
+
+	return bValid;
+}
+
+
+const uint32_t *WildCorpus::TrigramBlocks(unsigned iBucket,
+                                          size_t *pcBlocks) const
+{
+	const uint32_t *rgIndex =
+	    (const uint32_t *) Section(WILD_SECTION_TRIGRAM_INDEX);
+
+	if (!rgIndex || iBucket >= WILD_CORPUS_TRIGRAM_BUCKETS)
+	{
+		*pcBlocks = 0;
+		return NULL;
+	}
+
+	*pcBlocks = rgIndex[iBucket + 1] - rgIndex[iBucket];
+	return (const uint32_t *) Section(WILD_SECTION_TRIGRAM_BLOCKS) +
+	       rgIndex[iBucket];
+}
+
+
+// What a pattern requires of any key that matches it.
+//
+struct WildCorpusQuery
+{
+	uint32_t              uMinLen;      // Non-'*' characters
+	bool                  bStar;        // Else uMinLen is the exact length
+	uint64_t              uSignature;   // Bits of the literal bytes
+	uint8_t               rgHead[8];    // Literal bytes ahead of any wildcard
+	size_t                cbHead;
+	std::string           strTail;      // Literal bytes after any wildcard
+	std::vector<unsigned> rgBuckets;    // Trigrams of the literal runs
+};
+
+
+static void AnalyzePattern(const char *pWild, WildCorpusQuery &query)
+{
+	size_t cchRun = 0;   // Literal bytes just before the current one
+
+	query.uMinLen = 0;
+	query.bStar = false;
+	query.uSignature = 0;
+	query.cbHead = 0;
+	query.strTail.clear();
+	query.rgBuckets.clear();
+
+	for (const char *p = pWild; *p; ++p)
+	{
+		if (*p == '*')
+		{
+			query.bStar = true;
+			query.strTail.clear();
+			cchRun = 0;
+			continue;
+		}
+
+		++query.uMinLen;
+
+		if (*p == '?')
+		{
+			query.strTail.clear();
+			cchRun = 0;
+			continue;
+		}
+
+		query.strTail += *p;
+
+		query.uSignature |= WildCorpusSignatureBit((uint8_t) *p);
+
+		if (query.cbHead == (size_t) (p - pWild) && query.cbHead < 8)
+		{
+			query.rgHead[query.cbHead++] = (uint8_t) *p;
+		}
+
+		if (++cchRun >= 3)
+		{
+			query.rgBuckets.push_back(WildCorpusTrigramBucket(p - 2));
+		}
+	}
+
+	std::sort(query.rgBuckets.begin(), query.rgBuckets.end());
+	query.rgBuckets.erase(std::unique(query.rgBuckets.begin(),
+	                                  query.rgBuckets.end()),
+	                      query.rgBuckets.end());
+}
+
+
+static bool ZoneMayMatch(const WildCorpusZone &zone,
+                         const WildCorpusQuery &query)
+{
+	if (zone.uMaxLen < query.uMinLen ||
+	    (!query.bStar && zone.uMinLen > query.uMinLen) ||
+	    (zone.uSignature & query.uSignature) != query.uSignature)
+	{
+		return false;
+	}
+
+	// Every key of the block has a head between the least and greatest,
+	// so a key that starts with the pattern's head does too, as far as
+	// the head goes.
+	return memcmp(query.rgHead, zone.rgMinHead, query.cbHead) >= 0 &&
+	       memcmp(query.rgHead, zone.rgMaxHead, query.cbHead) <= 0;
+}
+
+
+// Matches the keys of some blocks, appending the numbers of those that
+// match.  With signatures, a block none of whose keys has every literal
+// byte of the pattern is passed over.  Keys are matched with the DFA if
+// there is one, else with pCompiled if there is one, else the program.
+//
+static void ScanBlocks(const WildCorpus &corpus, const WildCorpusQuery &query,
+                       const WildDfa *pDfa, const WildProgram &program,
+                       const WildCompiledPattern *pCompiled,
+                       const uint32_t *rgBlocks, size_t cBlocks,
+                       std::vector<uint32_t> &rgMatches)
+{
+	const uint64_t      *rgSignatures = corpus.Signatures();
+	std::vector<uint8_t> rgbResult(corpus.BlockKeys());
+
+	for (size_t i = 0; i < cBlocks; ++i)
+	{
+		size_t iFirst = (size_t) rgBlocks[i] * corpus.BlockKeys();
+		size_t cKeys = std::min(corpus.BlockKeys(), corpus.Count() - iFirst);
+
+		if (rgSignatures)
+		{
+			size_t iKey = 0;
+
+			while (iKey < cKeys && (rgSignatures[iFirst + iKey] &
+			       query.uSignature) != query.uSignature)
+			{
+				++iKey;
+			}
+
+			if (iKey == cKeys)
+			{
+				continue;
+			}
+		}
+
+		if (pDfa)
+		{
+			pDfa->MatchBatch(corpus.Bytes(), corpus.Offsets() + iFirst, cKeys,
+			                 rgbResult.data());
+		}
+		else
+		{
+			for (size_t iKey = 0; iKey < cKeys; ++iKey)
+			{
+				size_t      cbKey;
+				const char *pKey = corpus.Key(iFirst + iKey, &cbKey);
+
+				rgbResult[iKey] = pCompiled ? pCompiled->Match(pKey, cbKey) :
+				                              program.Match(pKey, cbKey);
+			}
+		}
+
+		for (size_t iKey = 0; iKey < cKeys; ++iKey)
+		{
+			if (rgbResult[iKey])
+			{
+				rgMatches.push_back((uint32_t) (iFirst + iKey));
+			}
+		}
+	}
+}
+
+
+// Compares a key's last bytes with a suffix, backwards, the way the
+// reversed order sorts keys.  A key that ends with the suffix compares
+// equal.
+//
+static int CompareTail(const char *pKey, size_t cbKey, const char *pSuffix,
+                       size_t cbSuffix)
+{
+	const uint8_t *pK = (const uint8_t *) pKey + cbKey;
+	const uint8_t *pS = (const uint8_t *) pSuffix + cbSuffix;
+	size_t         cb = std::min(cbKey, cbSuffix);
+
+	while (cb--)
+	{
+		if (*--pK != *--pS)
+		{
+			return *pK < *pS ? -1 : 1;
+		}
+	}
+
+	return cbKey < cbSuffix ? -1 : 0;
+}
+
+
+size_t WildCorpusSuffixRange(const WildCorpus &corpus, const char *pSuffix,
+                             size_t cbSuffix, size_t *piEnd)
+{
+	const uint32_t *rgOrder = corpus.ReversedOrder();
+
+	*piEnd = 0;
+
+	if (!rgOrder)
+	{
+		return 0;
+	}
+
+	auto below = [&](uint32_t iKey, int iAtMost)
+	{
+		size_t      cbKey;
+		const char *pKey = corpus.Key(iKey, &cbKey);
+
+		return CompareTail(pKey, cbKey, pSuffix, cbSuffix) < iAtMost;
+	};
+
+	// Keys ordered before the suffix compare below 0, and keys that end
+	// with it compare 0.
+	const uint32_t *pFirst = std::partition_point(rgOrder,
+	                         rgOrder + corpus.Count(),
+	                         [&](uint32_t iKey) { return below(iKey, 0); });
+	const uint32_t *pEnd = std::partition_point(pFirst,
+	                       rgOrder + corpus.Count(),
+	                       [&](uint32_t iKey) { return below(iKey, 1); });
+
+	*piEnd = pEnd - rgOrder;
+	return pFirst - rgOrder;
+}
+
+
+// Matches some keys, all of which end with cbTail bytes that the pattern
+// ends with, against the rest of the pattern, appending the numbers of
+// those that match.  The matchers are chosen as in ScanBlocks().
+//
+static void ScanKeys(const WildCorpus &corpus, const WildDfa *pDfa,
+                     const WildProgram &program,
+                     const WildCompiledPattern *pCompiled, size_t cbTail,
+                     const uint32_t *rgKeys, size_t cKeys,
+                     std::vector<uint32_t> &rgMatches)
+{
+	for (size_t i = 0; i < cKeys; ++i)
+	{
+		size_t      cbKey;
+		const char *pKey = corpus.Key(rgKeys[i], &cbKey);
+
+		if (pDfa ? pDfa->Match(pKey, cbKey - cbTail) :
+		    pCompiled ? pCompiled->Match(pKey, cbKey - cbTail) :
+		                program.Match(pKey, cbKey - cbTail))
+		{
+			rgMatches.push_back(rgKeys[i]);
+		}
+	}
+}
+
+
+// Runs a scan over cItems items on cThreads threads.  Each thread takes a
+// contiguous share, so the results come out in order when the shares are
+// joined.
+//
+template <typename Scan>
+static void RunShares(size_t cItems, int cThreads,
+                      std::vector<uint32_t> &rgMatches, Scan scan)
+{
+	if (cThreads < 1)
+	{
+		cThreads = 1;
+	}
+
+	std::vector<std::vector<uint32_t>> rgrgMatches(cThreads);
+	std::vector<std::thread>           rgThreads;
+
+	for (int iThread = 0; iThread < cThreads; ++iThread)
+	{
+		size_t iBegin = cItems * iThread / cThreads;
+		size_t iEnd = cItems * (iThread + 1) / cThreads;
+		auto   run = [&, iThread, iBegin, iEnd]()
+		{
+			scan(iBegin, iEnd, rgrgMatches[iThread]);
+		};
+
+		if (iThread + 1 < cThreads)
+		{
+			rgThreads.emplace_back(run);
+		}
+		else
+		{
+			run();
+		}
+	}
+
+	for (std::thread &thread : rgThreads)
+	{
+		thread.join();
+	}
+
+	for (const std::vector<uint32_t> &rgShare : rgrgMatches)
+	{
+		rgMatches.insert(rgMatches.end(), rgShare.begin(), rgShare.end());
+	}
+}
+
+
+size_t WildCorpusScan(const WildCorpus &corpus, const char *pWild,
+                      std::vector<uint32_t> &rgMatches, int cThreads)
+{
+	WildCorpusQuery       query;
+	std::vector<uint8_t>  rgbCandidate(corpus.BlockCount(), 1);
+	std::vector<uint32_t> rgBlocks;
+
+	rgMatches.clear();
+	AnalyzePattern(pWild, query);
+
+	// A block stays a candidate only if it has every trigram's bucket.
+	if (corpus.Has(WILD_CORPUS_TRIGRAMS))
+	{
+		std::vector<uint8_t> rgbHas(corpus.BlockCount());
+
+		for (unsigned iBucket : query.rgBuckets)
+		{
+			size_t          cPostings;
+			const uint32_t *rgPostings = corpus.TrigramBlocks(iBucket,
+			                                                  &cPostings);
+
+			std::fill(rgbHas.begin(), rgbHas.end(), 0);
+
+			for (size_t i = 0; i < cPostings; ++i)
+			{
+				rgbHas[rgPostings[i]] = 1;
+			}
+
+			for (size_t iBlock = 0; iBlock < rgbHas.size(); ++iBlock)
+			{
+				rgbCandidate[iBlock] &= rgbHas[iBlock];
+			}
+		}
+	}
+
+	for (size_t iBlock = 0; iBlock < corpus.BlockCount(); ++iBlock)
+	{
+		if (rgbCandidate[iBlock] &&
+		    ZoneMayMatch(corpus.Zones()[iBlock], query))
+		{
+			rgBlocks.push_back((uint32_t) iBlock);
+		}
+	}
+
+	// The keys that end with the pattern's literal tail, if the reversed
+	// order can say, and if they're enough fewer than the keys of those
+	// blocks.  A key visited out of order costs a few times one read in
+	// turn from a block.
+	size_t iFirst = 0;
+	size_t iEnd = 0;
+	bool   bSuffix = false;
+
+	if (!query.strTail.empty() && corpus.ReversedOrder())
+	{
+		iFirst = WildCorpusSuffixRange(corpus, query.strTail.data(),
+		                               query.strTail.size(), &iEnd);
+		bSuffix = (iEnd - iFirst) * 4 < rgBlocks.size() * corpus.BlockKeys();
+	}
+
+	// Keys in the range already end with the tail, so only the rest of
+	// the pattern is left to verify, against the rest of each key.
+	std::string         strWild(pWild);
+	WildDfa             dfa;
+	WildProgram         program;
+	WildCompiledPattern compiled;
+
+	if (bSuffix)
+	{
+		strWild.resize(strWild.size() - query.strTail.size());
+	}
+
+	// A segment too long for the program's operands still compiles into a
+	// WildCompiledPattern, which gets FastWildCompare()'s results.
+	bool bDfa = dfa.Compile(strWild.c_str());
+	bool bCompiled = !bDfa && !program.Compile(strWild.c_str());
+
+	if (bCompiled)
+	{
+		compiled.Compile(strWild.c_str());
+	}
+
+	if (!bSuffix)
+	{
+		RunShares(rgBlocks.size(), cThreads, rgMatches,
+		          [&](size_t iBegin, size_t iLimit,
+		              std::vector<uint32_t> &rgShare)
+		{
+			ScanBlocks(corpus, query, bDfa ? &dfa : NULL, program,
+			           bCompiled ? &compiled : NULL, rgBlocks.data() + iBegin,
+			           iLimit - iBegin, rgShare);
+		});
+
+		return rgBlocks.size();
+	}
+
+	std::vector<uint32_t> rgKeys(corpus.ReversedOrder() + iFirst,
+	                             corpus.ReversedOrder() + iEnd);
+	size_t                cBlocks = 0;
+
+	std::sort(rgKeys.begin(), rgKeys.end());
+
+	for (size_t i = 0; i < rgKeys.size(); ++i)
+	{
+		cBlocks += i == 0 || rgKeys[i] / corpus.BlockKeys() !=
+		                     rgKeys[i - 1] / corpus.BlockKeys();
+	}
+
+	// "*.parquet" leaves only '*' to verify, which every key matches.
+	if (!strWild.empty() &&
+	    strWild.find_first_not_of('*') == std::string::npos)
+	{
+		rgMatches.swap(rgKeys);
+		return cBlocks;
+	}
+
+	RunShares(rgKeys.size(), cThreads, rgMatches,
+	          [&](size_t iBegin, size_t iLimit, std::vector<uint32_t> &rgShare)
+	{
+		ScanKeys(corpus, bDfa ? &dfa : NULL, program,
+		         bCompiled ? &compiled : NULL, query.strTail.size(),
+		         rgKeys.data() + iBegin, iLimit - iBegin, rgShare);
+	});
+
+	return cBlocks;
+}
+
+
+// Reads a whole file.  Returns false if it can't be read.
+//
+static bool ReadWholeFile(const char *pszPath, std::string &strText)
+{
+	FILE *pFile = fopen(pszPath, "rb");
+	char  rgchChunk[65536];
+	size_t cb;
+
+	if (!pFile)
+	{
+		return false;
+	}
+
+	strText.clear();
+
+	while ((cb = fread(rgchChunk, 1, sizeof(rgchChunk), pFile)) > 0)
+	{
+		strText.append(rgchChunk, cb);
+	}
+
+	bool bRead = !ferror(pFile);
+
+	fclose(pFile);
+	return bRead;
+}
+
+
+// Finds each newline-terminated key of a text, the way any scan of a
+// newline file has to before matching.  A last key needn't be terminated.
+//
+static void SplitLines(const std::string &strText,
+                       std::vector<uint32_t> &rgOffsets)
+{
+	const char *pStart = strText.data();
+	const char *pEnd = pStart + strText.size();
+	const char *p = pStart;
+
+	rgOffsets.clear();
+
+	while (p < pEnd)
+	{
+		const char *pNewline = (const char *) memchr(p, '\n', pEnd - p);
+
+		rgOffsets.push_back((uint32_t) (p - pStart));
+		p = pNewline ? pNewline + 1 : pEnd;
+	}
+}
+
+
+extern "C" int WildCorpusBuildFile(const char *pszTextPath,
+                                   const char *pszCorpusPath,
+                                   unsigned uSections)
+{
+	std::string           strText;
+	std::vector<uint32_t> rgStarts;
+	WildCorpusBuilder     builder;
+
+	if (!ReadWholeFile(pszTextPath, strText))
+	{
+		return -1;
+	}
+
+	SplitLines(strText, rgStarts);
+
+	for (size_t i = 0; i < rgStarts.size(); ++i)
+	{
+		size_t iEnd = i + 1 < rgStarts.size() ? rgStarts[i + 1] - 1 :
+		              strText.size() - (strText.back() == '\n');
+
+		builder.Add(strText.data() + rgStarts[i], iEnd - rgStarts[i]);
+	}
+
+	return builder.Write(pszCorpusPath, uSections) ? 0 : -1;
+}
+
+
+#if defined(BUILD_CORPUS_TOOL)
+int main(int argc, char **argv)
+{
+	unsigned uSections = 0;
+	int      iArg = 1;
+
+	for (; iArg < argc && argv[iArg][0] == '-'; ++iArg)
+	{
+		for (const char *p = argv[iArg] + 1; *p; ++p)
+		{
+			uSections |= *p == 's' ? WILD_CORPUS_SIGNATURES :
+			             *p == 't' ? WILD_CORPUS_TRIGRAMS :
+			             *p == 'r' ? WILD_CORPUS_REVERSED : 0;
+		}
+	}
+
+	if (argc - iArg != 2)
+	{
+		fprintf(stderr, "Usage: wildcorpus [-s] [-t] [-r] keys.txt "
+		        "keys.wcorp\n");
+		return 2;
+	}
+
+	if (WildCorpusBuildFile(argv[iArg], argv[iArg + 1], uSections))
+	{
+		fprintf(stderr, "Can't build %s from %s\n", argv[iArg + 1],
+		        argv[iArg]);
+		return 1;
+	}
+
+	return 0;
+}
+#endif
+
+
+// A set of corpus tests: round trips through a newline file and the
+// builder, scans with and without optional sections and threads against
+// FastWildCompare(), suffix ranges of the reversed order, and rejection of
+// damaged files.
+//
+extern "C" int testcorpus(void)
+{
+	std::string              strTextPath =
+	    WildBenchTempPath("wildcorpus_test.txt");
+	std::string              strPath =
+	    WildBenchTempPath("wildcorpus_test.wcorp");
+	WildBenchRandom          rng(1212);
+	std::vector<std::string> rgKeys(5000);
+	std::string              strText;
+	WildCorpus               corpus;
+	bool                     bAllPassed = true;
+
+	for (size_t i = 0; i < rgKeys.size(); ++i)
+	{
+		WildBenchMakeKey(rng, rgKeys[i], i % 3 == 0);
+	}
+
+	rgKeys[7].clear();
+	rgKeys[8].assign(300, 'x');
+	rgKeys[9].assign(70001, 'x');
+	std::sort(rgKeys.begin() + 100, rgKeys.end());
+
+	for (const std::string &strKey : rgKeys)
+	{
+		strText += strKey + "\n";
+	}
+
+	FILE *pFile = fopen(strTextPath.c_str(), "wb");
+
+	bAllPassed &= pFile && fwrite(strText.data(), 1, strText.size(), pFile) ==
+	              strText.size();
+
+	if (pFile)
+	{
+		fclose(pFile);
+	}
+
+	// The last pattern's segment is too long for a WildProgram.
+	std::string strLong = "*" + std::string(70000, 'x') + "*";
+	const char *rgszWild[] =
+	{
+		"/srv/*", "*.log", "*cache1*", "/home/*/etc?*.csv", "*", "",
+		"x*x", "/var/*/*.idx", "*spool42*.bin", "/tmp/run?1?/*",
+		"*42.json", "*.idx", "*?.db", "*x", "/srv", strLong.c_str()
+	};
+
+	for (unsigned uSections = 0; uSections <= WILD_CORPUS_ALL; ++uSections)
+	{
+		bAllPassed &= WildCorpusBuildFile(strTextPath.c_str(),
+		                                  strPath.c_str(), uSections) == 0 &&
+		              corpus.Open(strPath.c_str()) &&
+		              corpus.Count() == rgKeys.size();
+
+		if (!corpus.Count())
+		{
+			break;
+		}
+
+		for (size_t i = 0; i < rgKeys.size(); ++i)
+		{
+			size_t      cbKey;
+			const char *pKey = corpus.Key(i, &cbKey);
+
+			bAllPassed &= std::string(pKey, cbKey) == rgKeys[i];
+		}
+
+		bAllPassed &= (corpus.ReversedOrder() != NULL) ==
+		              ((uSections & WILD_CORPUS_REVERSED) != 0);
+
+		for (size_t i = 0; corpus.ReversedOrder() && i + 1 < rgKeys.size();
+		     ++i)
+		{
+			std::string strA = rgKeys[corpus.ReversedOrder()[i]];
+			std::string strB = rgKeys[corpus.ReversedOrder()[i + 1]];
+
+			bAllPassed &= std::string(strA.rbegin(), strA.rend()) <=
+			              std::string(strB.rbegin(), strB.rend());
+		}
+
+		// Each suffix range holds exactly the keys that end with it.
+		static const char *s_rgszSuffix[] = { ".csv", "7.bin", "x", "", "q" };
+
+		for (const char *pszSuffix : s_rgszSuffix)
+		{
+			size_t                iEnd;
+			size_t                iFirst = WildCorpusSuffixRange(corpus,
+			                               pszSuffix, strlen(pszSuffix), &iEnd);
+			size_t                cbSuffix = strlen(pszSuffix);
+			std::vector<uint32_t> rgExpected;
+
+			for (size_t i = 0; corpus.ReversedOrder() && i < rgKeys.size();
+			     ++i)
+			{
+				if (rgKeys[i].size() >= cbSuffix &&
+				    rgKeys[i].compare(rgKeys[i].size() - cbSuffix, cbSuffix,
+				                      pszSuffix) == 0)
+				{
+					rgExpected.push_back((uint32_t) i);
+				}
+			}
+
+			std::vector<uint32_t> rgRange(corpus.ReversedOrder() + iFirst,
+			                              corpus.ReversedOrder() + iEnd);
+
+			std::sort(rgRange.begin(), rgRange.end());
+			bAllPassed &= iFirst <= iEnd && rgRange == rgExpected;
+		}
+
+		for (const char *pszWild : rgszWild)
+		{
+			std::vector<uint32_t> rgExpected, rgMatches;
+
+			for (size_t i = 0; i < rgKeys.size(); ++i)
+			{
+				if (FastWildCompare(const_cast<char *>(pszWild),
+				                    const_cast<char *>(rgKeys[i].c_str())))
+				{
+					rgExpected.push_back((uint32_t) i);
+				}
+			}
+
+			WildCorpusScan(corpus, pszWild, rgMatches, 1 + uSections % 3);
+			bAllPassed &= rgMatches == rgExpected;
+		}
+	}
+
+	// Damage: a bad magic number, another version, and truncation.
+	std::string strFile;
+
+	bAllPassed &= ReadWholeFile(strPath.c_str(), strFile);
+
+	for (int iDamage = 0; iDamage < 3; ++iDamage)
+	{
+		std::string strBad = strFile;
+
+		if (iDamage == 0)
+		{
+			strBad[0] = 'X';
+		}
+		else if (iDamage == 1)
+		{
+			strBad[8] = 2;
+		}
+		else
+		{
+			strBad.resize(strBad.size() - 1);
+		}
+
+		pFile = fopen(strPath.c_str(), "wb");
+
+		if (pFile)
+		{
+			fwrite(strBad.data(), 1, strBad.size(), pFile);
+			fclose(pFile);
+		}
+
+		bAllPassed &= !corpus.Open(strPath.c_str()) && corpus.Count() == 0;
+	}
+
+	remove(strTextPath.c_str());
+	remove(strPath.c_str());
+
+	if (bAllPassed)
+	{
+		printf("Passed corpus tests\n");
+	}
+	else
+	{
+		printf("Failed corpus tests\n");
+	}
+
+	return 0;
+}
+
+
+// Compares end-to-end scans of a million sorted path keys: reading and
+// splitting a newline file and then running the DFA batch matcher over
+// every key, against mapping a corpus file and scanning it, with zone
+// maps, signatures and trigram postings, using the same matcher.  Then
+// measures what the reversed order costs to build and what it saves on
+// suffix-anchored patterns.
+//
+extern "C" int benchcorpus(void)
+{
+	const size_t             cKeys = 1000000;
+	std::string              strTextPath =
+	    WildBenchTempPath("wildcorpus_bench.txt");
+	std::string              strPath =
+	    WildBenchTempPath("wildcorpus_bench.wcorp");
+	WildBenchRandom          rng(1313);
+	std::vector<std::string> rgKeys(cKeys);
+	std::string              strText;
+
+	for (size_t i = 0; i < cKeys; ++i)
+	{
+		WildBenchMakeKey(rng, rgKeys[i], i % 2 == 0);
+	}
+
+	// Object stores list keys in order, and so corpora built from
+	// listings come sorted.
+	std::sort(rgKeys.begin(), rgKeys.end());
+
+	for (const std::string &strKey : rgKeys)
+	{
+		strText += strKey + "\n";
+	}
+
+	FILE *pFile = fopen(strTextPath.c_str(), "wb");
+
+	if (!pFile)
+	{
+		return 0;
+	}
+
+	fwrite(strText.data(), 1, strText.size(), pFile);
+	fclose(pFile);
+
+	uint64_t uStart = WildBenchNanos();
+
+	WildCorpusBuildFile(strTextPath.c_str(), strPath.c_str(), WILD_CORPUS_ALL);
+
+	uint64_t uBuildNanos = WildBenchNanos() - uStart;
+	std::string strCorpus;
+
+	ReadWholeFile(strPath.c_str(), strCorpus);
+	printf("Corpus, %zu keys: newline file %.1f MB, corpus file %.1f MB, "
+	       "built in %.0f ms\n", cKeys, strText.size() / 1e6,
+	       strCorpus.size() / 1e6, uBuildNanos / 1e6);
+
+	static const char *s_rgszWild[] =
+	{
+		"/srv/*", "*.parquet", "*cache4242*", "/home/*/etc?*.csv"
+	};
+
+	for (const char *pszWild : s_rgszWild)
+	{
+		std::vector<uint32_t> rgOffsets, rgMatches;
+		std::vector<uint8_t>  rgbResult;
+		std::string           strNewline;
+		size_t                cHitsText = 0;
+		WildDfa               dfa;
+
+		dfa.Compile(pszWild);
+		uStart = WildBenchNanos();
+
+		// The newline file: read it, split it into keys packed back to
+		// back, as the batch matcher takes them, and match every key.
+		std::vector<uint32_t> rgStarts;
+		std::string           strBytes;
+
+		ReadWholeFile(strTextPath.c_str(), strNewline);
+		SplitLines(strNewline, rgStarts);
+		rgStarts.push_back((uint32_t) strNewline.size() + 1);
+		strBytes.reserve(strNewline.size());
+
+		for (size_t i = 0; i + 1 < rgStarts.size(); ++i)
+		{
+			rgOffsets.push_back((uint32_t) strBytes.size());
+			strBytes.append(strNewline, rgStarts[i],
+			                rgStarts[i + 1] - 1 - rgStarts[i]);
+		}
+
+		rgOffsets.push_back((uint32_t) strBytes.size());
+		rgbResult.resize(rgOffsets.size() - 1);
+		dfa.MatchBatch(strBytes.data(), rgOffsets.data(), rgbResult.size(),
+		               rgbResult.data());
+
+		for (uint8_t bResult : rgbResult)
+		{
+			cHitsText += bResult;
+		}
+
+		uint64_t uTextNanos = WildBenchNanos() - uStart;
+
+		uStart = WildBenchNanos();
+
+		WildCorpus corpus;
+		size_t     cBlocks = 0;
+
+		if (corpus.Open(strPath.c_str()))
+		{
+			cBlocks = WildCorpusScan(corpus, pszWild, rgMatches);
+		}
+
+		uint64_t uCorpusNanos = WildBenchNanos() - uStart;
+
+		printf("  %-20s newline file %.1f ms, corpus %.1f ms (%zu of %zu "
+		       "blocks scanned)%s\n", pszWild, uTextNanos / 1e6,
+		       uCorpusNanos / 1e6, cBlocks, corpus.BlockCount(),
+		       cHitsText == rgMatches.size() ? "" : " (RESULTS DIFFER)");
+	}
+
+	// The same corpus without the reversed order, for what it costs.
+	std::string strForwardPath =
+	    WildBenchTempPath("wildcorpus_bench_fwd.wcorp");
+	std::string strForward;
+
+	uStart = WildBenchNanos();
+	WildCorpusBuildFile(strTextPath.c_str(), strForwardPath.c_str(),
+	                    WILD_CORPUS_ALL & ~WILD_CORPUS_REVERSED);
+
+	uint64_t uForwardNanos = WildBenchNanos() - uStart;
+
+	ReadWholeFile(strForwardPath.c_str(), strForward);
+	printf("Reversed order: %.0f ms more to build (%.0f ms without it), "
+	       "%.1f MB more file\n",
+	       ((double) uBuildNanos - (double) uForwardNanos) / 1e6,
+	       uForwardNanos / 1e6, (strCorpus.size() - strForward.size()) / 1e6);
+
+	static const char *s_rgszSuffix[] =
+	{
+		"*.parquet", "*4242.json", "/var/*?.csv", "*/cache*7.tar.gz"
+	};
+
+	WildCorpus corpus, forward;
+
+	corpus.Open(strPath.c_str());
+	forward.Open(strForwardPath.c_str());
+
+	for (const char *pszWild : s_rgszSuffix)
+	{
+		std::vector<uint32_t> rgForward, rgMatches;
+		size_t                cHits = 0;
+
+		// Every key through FastWildCompare(), as without any index.
+		uStart = WildBenchNanos();
+
+		for (const std::string &strKey : rgKeys)
+		{
+			cHits += FastWildCompare(const_cast<char *>(pszWild),
+			                         const_cast<char *>(strKey.c_str()));
+		}
+
+		uint64_t uFullNanos = WildBenchNanos() - uStart;
+
+		uStart = WildBenchNanos();
+		WildCorpusScan(forward, pszWild, rgForward);
+
+		uint64_t uForwardScanNanos = WildBenchNanos() - uStart;
+
+		uStart = WildBenchNanos();
+		WildCorpusScan(corpus, pszWild, rgMatches);
+
+		uint64_t uSuffixNanos = WildBenchNanos() - uStart;
+
+		printf("  %-20s every key %.1f ms, forward corpus %.1f ms, "
+		       "reversed order %.2f ms (%.0fx), %zu matches%s\n", pszWild,
+		       uFullNanos / 1e6, uForwardScanNanos / 1e6, uSuffixNanos / 1e6,
+		       (double) uFullNanos / (uSuffixNanos ? uSuffixNanos : 1),
+		       rgMatches.size(), cHits == rgMatches.size() &&
+		       rgForward == rgMatches ? "" : " (RESULTS DIFFER)");
+	}
+
+	corpus.Close();
+	forward.Close();
+	remove(strForwardPath.c_str());
+	remove(strTextPath.c_str());
+	remove(strPath.c_str());
+	return 0;
+}
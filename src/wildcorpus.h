@@ -0,0 +1,241 @@
+// WildCorpus, a versioned key-corpus file that can be mapped and scanned
+// without parsing
+//
+// Copyright 2025 Kirk J Krauss.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// A corpus file holds a header, then sections at 64-byte aligned offsets,
+// all little-endian:
+//
+//   offsets     uint32 per key, plus one: key i is bytes [o[i], o[i + 1])
+//   bytes       the keys back to back, as WildDfa::MatchBatch() takes them
+//   zones       a WildCorpusZone per block of WILD_CORPUS_BLOCK_KEYS keys
+//   signatures  optional: a 64-bit set of hashed byte values per key
+//   trigrams    optional: for each of WILD_CORPUS_TRIGRAM_BUCKETS hashed
+//               trigrams, the blocks whose keys contain one
+//   reversed    optional: key numbers in order of their reversed bytes
+//
+// Once the file is mapped, a scan hands the offsets and bytes straight to
+// the matchers.  Zone maps, and trigram postings where present, rule out
+// blocks that no key of which could match, so that those are never read.
+// The forward order serves patterns with a literal head.  For a pattern
+// that ends in literal bytes, such as "*.parquet", the reversed order
+// gives the keys that end with them as one binary-searched range, and only
+// those are verified.
+//
+#ifndef WILDCORPUS_H
+#define WILDCORPUS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#define WILD_CORPUS_VERSION          1
+#define WILD_CORPUS_BLOCK_KEYS       1024   // Keys per zone
+#define WILD_CORPUS_TRIGRAM_BUCKETS  4096
+
+// Optional sections, as builder flags.  Offsets, bytes and zones are
+// always present.
+#define WILD_CORPUS_SIGNATURES  0x01
+#define WILD_CORPUS_TRIGRAMS    0x02
+#define WILD_CORPUS_REVERSED    0x04
+#define WILD_CORPUS_ALL         0x07
+
+enum WildCorpusSectionId
+{
+	WILD_SECTION_OFFSETS,
+	WILD_SECTION_BYTES,
+	WILD_SECTION_ZONES,
+	WILD_SECTION_SIGNATURES,
+	WILD_SECTION_TRIGRAM_INDEX,    // uint32 per bucket, plus one
+	WILD_SECTION_TRIGRAM_BLOCKS,   // uint32 block numbers, by bucket
+	WILD_SECTION_REVERSED,
+	WILD_SECTION_COUNT
+};
+
+struct WildCorpusSection
+{
+	uint64_t uOffset;   // From the start of the file; 0 if absent
+	uint64_t cb;
+};
+
+struct WildCorpusHeader
+{
+	char              rgchMagic[8];   // "WILDCORP"
+	uint32_t          uVersion;
+	uint32_t          uSections;      // WILD_CORPUS_* flags
+	uint64_t          cKeys;
+	uint32_t          cBlockKeys;
+	uint32_t          cBlocks;
+	WildCorpusSection rgSections[WILD_SECTION_COUNT];
+};
+
+// What a block's keys have in common.  Head bytes are the first 8 bytes of
+// the block's least and greatest keys, padded with zeros.
+//
+struct WildCorpusZone
+{
+	uint32_t uMinLen;
+	uint32_t uMaxLen;
+	uint64_t uSignature;    // Union of the keys' signatures
+	uint8_t  rgMinHead[8];
+	uint8_t  rgMaxHead[8];
+};
+
+// The signature bit for a byte value.
+//
+static inline uint64_t WildCorpusSignatureBit(uint8_t ch)
+{
+	return (uint64_t) 1 << ((ch * 0x9E3779B1u) >> 26);
+}
+
+
+// Collects keys and writes a corpus file.
+//
+class WildCorpusBuilder
+{
+public:
+	void Add(const char *pKey, size_t cbKey);
+
+	// Writes the keys with the optional sections named by uSections.
+	// Returns false if the file can't be written or the keys are too many
+	// bytes for 32-bit offsets.
+	bool Write(const char *pszPath, unsigned uSections) const;
+
+	size_t Count() const
+	{
+		return m_rgOffsets.size();
+	}
+
+private:
+	std::string           m_strBytes;
+	std::vector<uint32_t> m_rgOffsets;   // Start of each key
+};
+
+
+// A corpus file, mapped read-only.
+//
+class WildCorpus
+{
+public:
+	WildCorpus();
+	~WildCorpus();
+
+	// Maps a corpus file and checks its header and section bounds.
+	// Returns false for a missing, truncated or foreign file, or another
+	// version.
+	bool Open(const char *pszPath);
+	void Close();
+
+	size_t Count() const
+	{
+		return m_pHeader ? (size_t) m_pHeader->cKeys : 0;
+	}
+
+	bool Has(unsigned uSection) const
+	{
+		return m_pHeader && (m_pHeader->uSections & uSection) != 0;
+	}
+
+	const char *Bytes() const
+	{
+		return (const char *) Section(WILD_SECTION_BYTES);
+	}
+
+	const uint32_t *Offsets() const
+	{
+		return (const uint32_t *) Section(WILD_SECTION_OFFSETS);
+	}
+
+	const char *Key(size_t iKey, size_t *pcbKey) const
+	{
+		*pcbKey = Offsets()[iKey + 1] - Offsets()[iKey];
+		return Bytes() + Offsets()[iKey];
+	}
+
+	size_t BlockCount() const
+	{
+		return m_pHeader ? m_pHeader->cBlocks : 0;
+	}
+
+	size_t BlockKeys() const
+	{
+		return m_pHeader ? m_pHeader->cBlockKeys : 0;
+	}
+
+	const WildCorpusZone *Zones() const
+	{
+		return (const WildCorpusZone *) Section(WILD_SECTION_ZONES);
+	}
+
+	// NULL where the optional section is absent.
+	const uint64_t *Signatures() const
+	{
+		return (const uint64_t *) Section(WILD_SECTION_SIGNATURES);
+	}
+
+	const uint32_t *ReversedOrder() const
+	{
+		return (const uint32_t *) Section(WILD_SECTION_REVERSED);
+	}
+
+	// Returns the blocks that may contain a trigram of the given bucket
+	// (see WildCorpusTrigramBucket()), in ascending order, and their count
+	// in *pcBlocks.  Returns NULL without postings.
+	const uint32_t *TrigramBlocks(unsigned iBucket, size_t *pcBlocks) const;
+
+private:
+	const void *Section(WildCorpusSectionId id) const
+	{
+		return m_pHeader && m_pHeader->rgSections[id].uOffset ?
+		       m_pBase + m_pHeader->rgSections[id].uOffset : NULL;
+	}
+
+	const uint8_t          *m_pBase;
+	size_t                  m_cbFile;
+	const WildCorpusHeader *m_pHeader;   // NULL unless open
+	std::vector<uint8_t>    m_rgbCopy;   // Where mmap() isn't available
+	bool                    m_bMapped;
+};
+
+// The trigram bucket for three bytes.
+unsigned WildCorpusTrigramBucket(const char *pTrigram);
+
+// Finds the keys that end with cbSuffix bytes, by binary search of the
+// reversed order.  Returns the position in ReversedOrder() of the first
+// such key and sets *piEnd past the last.  Returns 0, with *piEnd 0, where
+// the corpus has no reversed order.
+size_t WildCorpusSuffixRange(const WildCorpus &corpus, const char *pSuffix,
+                             size_t cbSuffix, size_t *piEnd);
+
+// Finds the keys of a corpus that match a pattern of '*' and '?'
+// wildcards, in order, using cThreads threads.  Blocks that the zone maps
+// or trigram postings rule out are skipped.  If the pattern ends in
+// literal bytes and the corpus has the reversed order, the keys that end
+// with them are verified instead, when they're fewer than the keys of the
+// blocks left.  Returns the number of blocks read.
+size_t WildCorpusScan(const WildCorpus &corpus, const char *pWild,
+                      std::vector<uint32_t> &rgMatches, int cThreads = 1);
+
+// Builds a corpus file from a file of newline-separated keys.  Returns 0
+// on success.
+extern "C" int WildCorpusBuildFile(const char *pszTextPath,
+                                   const char *pszCorpusPath,
+                                   unsigned uSections);
+
+extern "C" int testcorpus(void);
+extern "C" int benchcorpus(void);
+
+#endif  // WILDCORPUS_H
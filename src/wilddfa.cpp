@@ -0,0 +1,809 @@
+// WildDfa, and related code
+//
+// Copyright 2025 Kirk J Krauss.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// This file provides the DFA compiler and the scalar and vector batch
+// runners.  It also includes testcases for correctness and performance.
+//
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "fastwildcompare.h"
+#include "wilddfa.h"
+#include "wildbench.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define WILD_HAVE_AVX2_TARGET  1
+#endif
+
+
+WildDfa::WildDfa(std::pmr::memory_resource *pResource) :
+    m_rgNext(pResource), m_rgClass(pResource), m_rgAccept(pResource),
+    m_iStart(WILD_DFA_DEAD), m_cClasses(1)
+{
+	m_rgClass.assign(256, 0);
+	m_rgNext.assign(2, WILD_DFA_DEAD);
+	m_rgNext[WILD_DFA_ACCEPT] = WILD_DFA_ACCEPT;
+	m_rgAccept.assign(2, 0);
+	m_rgAccept[WILD_DFA_ACCEPT] = 1;
+}
+
+
+// NFA states are positions in the pattern: position i means that the
+// pattern's first i characters have matched.  A DFA state is a set of them.
+//
+typedef std::pmr::vector<uint64_t> WildPositionSet;
+
+static inline bool HasPosition(const WildPositionSet &set, size_t iPosition)
+{
+	return (set[iPosition / 64] >> (iPosition % 64)) & 1;
+}
+
+static inline void AddPosition(WildPositionSet &set, size_t iPosition)
+{
+	set[iPosition / 64] |= (uint64_t) 1 << (iPosition % 64);
+}
+
+
+bool WildDfa::Compile(const char *pWild)
+{
+	std::pmr::memory_resource *pResource = Resource();
+	std::pmr::string           strWild(pResource);
+
+	// Runs of '*' match the same as one '*'.
+	for (const char *pch = pWild; *pch; ++pch)
+	{
+		if (*pch != '*' || strWild.empty() || strWild.back() != '*')
+		{
+			strWild += *pch;
+		}
+	}
+
+	size_t cchWild = strWild.size();
+	size_t cWords = (cchWild + 1 + 63) / 64;
+	bool   bTrailingStar = cchWild && strWild[cchWild - 1] == '*';
+
+	// Class 0 is every byte that isn't a literal in the pattern.  Each
+	// class keeps one byte of its own for working out its transitions.
+	std::pmr::vector<uint8_t> rgRepresentative(1, 0, pResource);
+
+	m_rgClass.assign(256, 0);
+
+	for (char ch : strWild)
+	{
+		if (ch != '*' && ch != '?' && !m_rgClass[(uint8_t) ch])
+		{
+			m_rgClass[(uint8_t) ch] = (int32_t) rgRepresentative.size();
+			rgRepresentative.push_back((uint8_t) ch);
+		}
+	}
+
+	for (int iByte = 0; iByte < 256; ++iByte)
+	{
+		if (!m_rgClass[iByte])
+		{
+			rgRepresentative[0] = (uint8_t) iByte;
+			break;
+		}
+	}
+
+	m_cClasses = (int32_t) rgRepresentative.size();
+
+	// Rows for the dead and accepting states, which lead only to themselves.
+	m_rgNext.assign(2 * m_cClasses, WILD_DFA_DEAD);
+	m_rgAccept.assign(2, 0);
+	m_rgAccept[WILD_DFA_ACCEPT] = 1;
+
+	for (int32_t iClass = 0; iClass < m_cClasses; ++iClass)
+	{
+		m_rgNext[WILD_DFA_ACCEPT * m_cClasses + iClass] =
+		    WILD_DFA_ACCEPT * m_cClasses;
+	}
+
+	std::pmr::vector<WildPositionSet> rgSets(2, pResource);
+	std::pmr::unordered_map<std::pmr::string, int32_t> mapStates(pResource);
+
+	auto Close = [&](WildPositionSet &set)
+	{
+		for (size_t i = 0; i < cchWild; ++i)
+		{
+			if (strWild[i] == '*' && HasPosition(set, i))
+			{
+				AddPosition(set, i + 1);
+			}
+		}
+	};
+
+	// Returns a set's state number, adding a state if the set is new, or
+	// -1 if there's no room for one.
+	auto Intern = [&](const WildPositionSet &set) -> int32_t
+	{
+		bool bEmpty = true;
+
+		for (uint64_t uWord : set)
+		{
+			bEmpty &= !uWord;
+		}
+
+		if (bEmpty)
+		{
+			return WILD_DFA_DEAD;
+		}
+		else if (bTrailingStar && HasPosition(set, cchWild - 1))
+		{
+			return WILD_DFA_ACCEPT;
+		}
+
+		std::pmr::string strKey((const char *) set.data(), cWords * 8,
+		                        pResource);
+		auto        it = mapStates.find(strKey);
+
+		if (it != mapStates.end())
+		{
+			return it->second;
+		}
+		else if (rgSets.size() >= WILD_DFA_MAX_STATES)
+		{
+			return -1;
+		}
+
+		int32_t iState = (int32_t) rgSets.size();
+
+		rgSets.push_back(set);
+		m_rgAccept.push_back(HasPosition(set, cchWild));
+		m_rgNext.resize(m_rgNext.size() + m_cClasses);
+		mapStates.emplace(strKey, iState);
+		return iState;
+	};
+
+	WildPositionSet setStart(cWords, 0, pResource);
+
+	AddPosition(setStart, 0);
+	Close(setStart);
+	m_iStart = Intern(setStart) * m_cClasses;
+
+	// New states are appended, so this walks the worklist as it grows.
+	for (size_t iState = 2; iState < rgSets.size(); ++iState)
+	{
+		WildPositionSet set(rgSets[iState], pResource);
+
+		for (int32_t iClass = 0; iClass < m_cClasses; ++iClass)
+		{
+			WildPositionSet setNext(cWords, 0, pResource);
+			char            ch = (char) rgRepresentative[iClass];
+
+			for (size_t i = 0; i < cchWild; ++i)
+			{
+				if (!HasPosition(set, i))
+				{
+					continue;
+				}
+				else if (strWild[i] == '*')
+				{
+					AddPosition(setNext, i);
+				}
+				else if (strWild[i] == '?' || strWild[i] == ch)
+				{
+					AddPosition(setNext, i + 1);
+				}
+			}
+
+			Close(setNext);
+
+			int32_t iNext = Intern(setNext);
+
+			if (iNext < 0)
+			{
+				*this = WildDfa(pResource);
+				return false;
+			}
+
+			m_rgNext[iState * m_cClasses + iClass] = iNext * m_cClasses;
+		}
+	}
+
+	return true;
+}
+
+
+bool WildDfa::Match(const char *pTame, size_t cbTame) const
+{
+	const int32_t *rgNext = m_rgNext.data();
+	const int32_t *rgClass = m_rgClass.data();
+	int32_t        iFinal = 2 * m_cClasses;
+	int32_t        iState = m_iStart;
+
+	for (size_t i = 0; i < cbTame && iState >= iFinal; ++i)
+	{
+		iState = rgNext[iState + rgClass[(uint8_t) pTame[i]]];
+	}
+
+	return m_rgAccept[iState / m_cClasses];
+}
+
+
+// What the batch runners need from a WildDfa.
+//
+struct WildDfaTables
+{
+	const int32_t *rgNext;
+	const int32_t *rgClass;
+	const uint8_t *rgAccept;
+	int32_t        iStart;
+	int32_t        cClasses;
+};
+
+
+// Starts a lane on the next tame string that needs any steps, settling
+// empty strings (and every string, if the start state is final) on the
+// spot.  Returns false when the strings run out.
+//
+static bool RefillLane(const WildDfaTables &tables,
+                       const uint32_t *rgOffsets, size_t cKeys,
+                       size_t &iNextKey, uint8_t *rgbResult,
+                       uint32_t &uKey, uint32_t &uPos, uint32_t &uEnd)
+{
+	while (iNextKey < cKeys)
+	{
+		size_t iKey = iNextKey++;
+
+		if (rgOffsets[iKey] == rgOffsets[iKey + 1] ||
+		    tables.iStart < 2 * tables.cClasses)
+		{
+			rgbResult[iKey] =
+			    tables.rgAccept[tables.iStart / tables.cClasses];
+			continue;
+		}
+
+		uKey = (uint32_t) iKey;
+		uPos = rgOffsets[iKey];
+		uEnd = rgOffsets[iKey + 1];
+		return true;
+	}
+
+	return false;
+}
+
+
+#if defined(WILD_HAVE_AVX2_TARGET)
+// Eight lanes.  Tame bytes are gathered as 32-bit words, with addresses
+// clamped so that no load runs past the last string, and shifted down.  A
+// lane is done once its string is used up, where a masked gather leaves
+// its state alone, or once its state is final, where the table leaves it
+// alone.  When half the busy lanes are done, they report and take new
+// strings.  Lanes left idle when the strings run out stay done.
+//
+__attribute__((target("avx2")))
+static void MatchBatchAvx2(const WildDfaTables &tables, const char *pBytes,
+                           const uint32_t *rgOffsets, size_t cKeys,
+                           uint8_t *rgbResult)
+{
+	alignas(32) uint32_t rgKey[8], rgPos[8], rgEnd[8];
+	alignas(32) int32_t  rgState[8];
+	uint32_t             uIdle = 0;
+	size_t               iNextKey = 0;
+	int                  cBusy = 0;
+
+	for (int iLane = 0; iLane < 8; ++iLane)
+	{
+		bool bBusy = RefillLane(tables, rgOffsets, cKeys, iNextKey, rgbResult,
+		                        rgKey[iLane], rgPos[iLane], rgEnd[iLane]);
+
+		rgState[iLane] = bBusy ? tables.iStart : WILD_DFA_DEAD;
+		rgPos[iLane] = bBusy ? rgPos[iLane] : 0;
+		rgEnd[iLane] = bBusy ? rgEnd[iLane] : 0;
+		uIdle |= (uint32_t) !bBusy << iLane;
+		cBusy += bBusy;
+	}
+
+	const __m256i vLimit = _mm256_set1_epi32((int) (rgOffsets[cKeys] - 4));
+	const __m256i vFinal = _mm256_set1_epi32(2 * tables.cClasses);
+	const __m256i vOnes = _mm256_set1_epi32(-1);
+	const __m256i vByteMask = _mm256_set1_epi32(0xFF);
+
+	while (cBusy)
+	{
+		__m256i  vPos = _mm256_load_si256((const __m256i *) rgPos);
+		__m256i  vEnd = _mm256_load_si256((const __m256i *) rgEnd);
+		__m256i  vState = _mm256_load_si256((const __m256i *) rgState);
+		int      cRefill = cBusy < 4 ? cBusy : 4;
+		uint32_t uDone;
+
+		while (true)
+		{
+			__m256i vStopped = _mm256_or_si256(_mm256_cmpeq_epi32(vPos, vEnd),
+			    _mm256_cmpgt_epi32(vFinal, vState));
+
+			uDone = (uint32_t) _mm256_movemask_ps(
+			    _mm256_castsi256_ps(vStopped)) & ~uIdle;
+
+			if (__builtin_popcount(uDone) >= cRefill)
+			{
+				break;
+			}
+
+			// Only the state gather waits on the state; the tame bytes and
+			// their classes depend on positions alone, so they run ahead.
+			__m256i vMoving = _mm256_xor_si256(_mm256_cmpeq_epi32(vPos, vEnd),
+			                                   vOnes);
+			__m256i vAddr = _mm256_min_epu32(vPos, vLimit);
+			__m256i vShift = _mm256_slli_epi32(_mm256_sub_epi32(vPos, vAddr),
+			                                   3);
+			__m256i vByte = _mm256_and_si256(_mm256_srlv_epi32(
+			    _mm256_i32gather_epi32((const int *) pBytes, vAddr, 1),
+			    vShift), vByteMask);
+			__m256i vClass = _mm256_i32gather_epi32(tables.rgClass, vByte, 4);
+
+			vState = _mm256_mask_i32gather_epi32(vState, tables.rgNext,
+			    _mm256_add_epi32(vState, vClass), vMoving, 4);
+			vPos = _mm256_sub_epi32(vPos, vMoving);
+		}
+
+		_mm256_store_si256((__m256i *) rgPos, vPos);
+		_mm256_store_si256((__m256i *) rgState, vState);
+
+		while (uDone)
+		{
+			int iLane = __builtin_ctz(uDone);
+
+			uDone &= uDone - 1;
+			rgbResult[rgKey[iLane]] =
+			    tables.rgAccept[rgState[iLane] / tables.cClasses];
+
+			if (RefillLane(tables, rgOffsets, cKeys, iNextKey, rgbResult,
+			               rgKey[iLane], rgPos[iLane], rgEnd[iLane]))
+			{
+				rgState[iLane] = tables.iStart;
+			}
+			else
+			{
+				rgState[iLane] = WILD_DFA_DEAD;
+				rgPos[iLane] = rgEnd[iLane] = 0;
+				uIdle |= 1u << iLane;
+				--cBusy;
+			}
+		}
+	}
+}
+
+
+// Sixteen lanes, as above, with mask registers for the lane bookkeeping.
+// GCC warns about the undefined pass-through operands that its own AVX-512
+// intrinsics use, so those warnings are off here.
+//
+#if !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+__attribute__((target("avx512f")))
+static void MatchBatchAvx512(const WildDfaTables &tables, const char *pBytes,
+                             const uint32_t *rgOffsets, size_t cKeys,
+                             uint8_t *rgbResult)
+{
+	alignas(64) uint32_t rgKey[16], rgPos[16], rgEnd[16];
+	alignas(64) int32_t  rgState[16];
+	uint32_t             uIdle = 0;
+	size_t               iNextKey = 0;
+	int                  cBusy = 0;
+
+	for (int iLane = 0; iLane < 16; ++iLane)
+	{
+		bool bBusy = RefillLane(tables, rgOffsets, cKeys, iNextKey, rgbResult,
+		                        rgKey[iLane], rgPos[iLane], rgEnd[iLane]);
+
+		rgState[iLane] = bBusy ? tables.iStart : WILD_DFA_DEAD;
+		rgPos[iLane] = bBusy ? rgPos[iLane] : 0;
+		rgEnd[iLane] = bBusy ? rgEnd[iLane] : 0;
+		uIdle |= (uint32_t) !bBusy << iLane;
+		cBusy += bBusy;
+	}
+
+	const __m512i vLimit = _mm512_set1_epi32((int) (rgOffsets[cKeys] - 4));
+	const __m512i vFinal = _mm512_set1_epi32(2 * tables.cClasses);
+	const __m512i vOne = _mm512_set1_epi32(1);
+	const __m512i vByteMask = _mm512_set1_epi32(0xFF);
+
+	while (cBusy)
+	{
+		__m512i  vPos = _mm512_load_si512(rgPos);
+		__m512i  vEnd = _mm512_load_si512(rgEnd);
+		__m512i  vState = _mm512_load_si512(rgState);
+		int      cRefill = cBusy < 8 ? cBusy : 8;
+		uint32_t uDone;
+
+		while (true)
+		{
+			__mmask16 kStopped = _mm512_cmpeq_epi32_mask(vPos, vEnd) |
+			                     _mm512_cmpgt_epi32_mask(vFinal, vState);
+
+			uDone = (uint32_t) kStopped & ~uIdle;
+
+			if (__builtin_popcount(uDone) >= cRefill)
+			{
+				break;
+			}
+
+			__mmask16 kMoving = _mm512_cmpneq_epi32_mask(vPos, vEnd);
+			__m512i   vAddr = _mm512_min_epu32(vPos, vLimit);
+			__m512i   vShift = _mm512_slli_epi32(
+			    _mm512_sub_epi32(vPos, vAddr), 3);
+			__m512i   vByte = _mm512_and_si512(_mm512_srlv_epi32(
+			    _mm512_i32gather_epi32(vAddr, pBytes, 1), vShift),
+			    vByteMask);
+			__m512i   vClass = _mm512_i32gather_epi32(vByte, tables.rgClass,
+			                                          4);
+
+			vState = _mm512_mask_i32gather_epi32(vState, kMoving,
+			    _mm512_add_epi32(vState, vClass), tables.rgNext, 4);
+			vPos = _mm512_mask_add_epi32(vPos, kMoving, vPos, vOne);
+		}
+
+		_mm512_store_si512(rgPos, vPos);
+		_mm512_store_si512(rgState, vState);
+
+		while (uDone)
+		{
+			int iLane = __builtin_ctz(uDone);
+
+			uDone &= uDone - 1;
+			rgbResult[rgKey[iLane]] =
+			    tables.rgAccept[rgState[iLane] / tables.cClasses];
+
+			if (RefillLane(tables, rgOffsets, cKeys, iNextKey, rgbResult,
+			               rgKey[iLane], rgPos[iLane], rgEnd[iLane]))
+			{
+				rgState[iLane] = tables.iStart;
+			}
+			else
+			{
+				rgState[iLane] = WILD_DFA_DEAD;
+				rgPos[iLane] = rgEnd[iLane] = 0;
+				uIdle |= 1u << iLane;
+				--cBusy;
+			}
+		}
+	}
+}
+#if !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif  // defined(WILD_HAVE_AVX2_TARGET)
+
+
+bool WildDfa::HavePath(WildDfaPath path)
+{
+#if defined(WILD_HAVE_AVX2_TARGET)
+	static const bool s_bAvx2 = __builtin_cpu_supports("avx2");
+	static const bool s_bAvx512 = __builtin_cpu_supports("avx512f");
+
+	if (path == WILD_DFA_AVX2)
+	{
+		return s_bAvx2;
+	}
+	else if (path == WILD_DFA_AVX512)
+	{
+		return s_bAvx512;
+	}
+#else
+	if (path == WILD_DFA_AVX2 || path == WILD_DFA_AVX512)
+	{
+		return false;
+	}
+#endif
+
+	return true;
+}
+
+
+void WildDfa::MatchBatch(const char *pBytes, const uint32_t *rgOffsets,
+                         size_t cKeys, uint8_t *rgbResult,
+                         WildDfaPath path) const
+{
+	if (path == WILD_DFA_AUTO || (path == WILD_DFA_AVX512 &&
+	                              !HavePath(WILD_DFA_AVX512)))
+	{
+		path = HavePath(WILD_DFA_AVX512) ? WILD_DFA_AVX512 : WILD_DFA_AVX2;
+	}
+
+	if (path == WILD_DFA_AVX2 && !HavePath(WILD_DFA_AVX2))
+	{
+		path = WILD_DFA_SCALAR;
+	}
+
+	// The gathers load whole words, and index with signed 32-bit offsets.
+	if (!cKeys || rgOffsets[cKeys] < 4 || rgOffsets[cKeys] > INT32_MAX)
+	{
+		path = WILD_DFA_SCALAR;
+	}
+
+#if defined(WILD_HAVE_AVX2_TARGET)
+	WildDfaTables tables =
+	{
+		m_rgNext.data(), m_rgClass.data(), m_rgAccept.data(),
+		m_iStart, m_cClasses
+	};
+
+	if (path == WILD_DFA_AVX512)
+	{
+		MatchBatchAvx512(tables, pBytes, rgOffsets, cKeys, rgbResult);
+		return;
+	}
+	else if (path == WILD_DFA_AVX2)
+	{
+		MatchBatchAvx2(tables, pBytes, rgOffsets, cKeys, rgbResult);
+		return;
+	}
+#endif
+
+	for (size_t iKey = 0; iKey < cKeys; ++iKey)
+	{
+		rgbResult[iKey] = Match(pBytes + rgOffsets[iKey],
+		                        rgOffsets[iKey + 1] - rgOffsets[iKey]);
+	}
+}
+
+
+// Packs strings back to back, the way MatchBatch() takes them.
+//
+static void PackKeys(const std::vector<std::string> &rgKeys,
+                     std::string &strBytes, std::vector<uint32_t> &rgOffsets)
+{
+	strBytes.clear();
+	rgOffsets.assign(1, 0);
+
+	for (const std::string &strKey : rgKeys)
+	{
+		strBytes += strKey;
+		rgOffsets.push_back((uint32_t) strBytes.size());
+	}
+}
+
+
+// A set of DFA tests.  Every batch path must agree with the scalar
+// matcher, and the scalar matcher with FastWildCompare(), on random
+// patterns and strings over a small alphabet, where partial matches and
+// fallbacks are common.
+//
+extern "C" int testdfa(void)
+{
+	static const WildDfaPath s_rgPaths[] =
+	{
+		WILD_DFA_SCALAR, WILD_DFA_AVX2, WILD_DFA_AVX512, WILD_DFA_AUTO
+	};
+	WildBenchRandom rng(606);
+	WildDfa         dfa;
+	bool            bAllPassed = true;
+
+	bAllPassed &= !dfa.Match("") && !dfa.Match("abc");
+	bAllPassed &= dfa.Compile("") && dfa.Match("") && !dfa.Match("a");
+	bAllPassed &= dfa.Compile("***") && dfa.Match("") && dfa.Match("xyz");
+	bAllPassed &= dfa.Compile("a*b?c") && dfa.Match("abxc") &&
+	              dfa.Match("azzbbyc") && !dfa.Match("abc");
+	bAllPassed &= dfa.Compile("*\xff?") && dfa.Match("\xff\xff") &&
+	              !dfa.Match("\xff");
+
+	// "*a" and then n '?' needs about 2^n states.
+	bAllPassed &= !dfa.Compile("*a????????????????") &&
+	              !dfa.Match("abbbbbbbbbbbbbbbb");
+	bAllPassed &= dfa.Compile("*a????????") && dfa.Match("ba12345678");
+
+	for (int iRound = 0; iRound < 300; ++iRound)
+	{
+		std::string              strWild;
+		std::vector<std::string> rgKeys(40);
+		size_t                   cchWild = rng.Below(10);
+
+		for (size_t i = 0; i < cchWild; ++i)
+		{
+			strWild += "ab*?"[rng.Below(4)];
+		}
+
+		for (std::string &strKey : rgKeys)
+		{
+			size_t cchKey = rng.Below(15);
+
+			strKey.clear();
+
+			for (size_t i = 0; i < cchKey; ++i)
+			{
+				strKey += "abc"[rng.Below(3)];
+			}
+		}
+
+		bAllPassed &= dfa.Compile(strWild.c_str());
+
+		std::string           strBytes;
+		std::vector<uint32_t> rgOffsets;
+		std::vector<uint8_t>  rgbResult(rgKeys.size());
+
+		PackKeys(rgKeys, strBytes, rgOffsets);
+
+		for (WildDfaPath path : s_rgPaths)
+		{
+			dfa.MatchBatch(strBytes.data(), rgOffsets.data(), rgKeys.size(),
+			               rgbResult.data(), path);
+
+			for (size_t iKey = 0; iKey < rgKeys.size(); ++iKey)
+			{
+				bool bExpected = FastWildCompare(
+				    const_cast<char *>(strWild.c_str()),
+				    const_cast<char *>(rgKeys[iKey].c_str()));
+
+				bAllPassed &= dfa.Match(rgKeys[iKey].c_str()) == bExpected;
+				bAllPassed &= rgbResult[iKey] == bExpected;
+			}
+		}
+	}
+
+	if (bAllPassed)
+	{
+		printf("Passed DFA tests\n");
+	}
+	else
+	{
+		printf("Failed DFA tests\n");
+	}
+
+	return 0;
+}
+
+
+// Compares, per tame string, FastWildCompare(), the scalar DFA, and the
+// batch runner on each path this CPU supports.
+//
+static void BenchCorpus(const char *szName,
+                        const std::vector<std::string> &rgWild,
+                        const std::vector<std::string> &rgKeys)
+{
+	size_t                cPatterns = rgWild.size(), cKeys = rgKeys.size();
+	std::string           strBytes;
+	std::vector<uint32_t> rgOffsets;
+	std::vector<uint8_t>  rgbResult(cKeys);
+	std::vector<WildDfa>  rgDfa(cPatterns);
+	size_t                cStates = 0;
+
+	for (size_t i = 0; i < cPatterns; ++i)
+	{
+		rgDfa[i].Compile(rgWild[i].c_str());
+		cStates += rgDfa[i].StateCount();
+	}
+
+	PackKeys(rgKeys, strBytes, rgOffsets);
+
+	uint64_t uHitsFwc = 0, uHitsDfa = 0;
+	uint64_t uStart = WildBenchNanos();
+
+	for (size_t i = 0; i < cPatterns; ++i)
+	{
+		for (size_t iKey = 0; iKey < cKeys; ++iKey)
+		{
+			uHitsFwc += FastWildCompare(const_cast<char *>(rgWild[i].c_str()),
+			    const_cast<char *>(rgKeys[iKey].c_str()));
+		}
+	}
+
+	uint64_t uFwcNanos = WildBenchNanos() - uStart;
+
+	uStart = WildBenchNanos();
+
+	for (size_t i = 0; i < cPatterns; ++i)
+	{
+		for (size_t iKey = 0; iKey < cKeys; ++iKey)
+		{
+			uHitsDfa += rgDfa[i].Match(rgKeys[iKey].data(),
+			                           rgKeys[iKey].size());
+		}
+	}
+
+	uint64_t uDfaNanos = WildBenchNanos() - uStart;
+	double   cMatches = (double) cPatterns * cKeys;
+
+	printf("DFA, %s, %zu patterns (%.1f states each) x %zu keys "
+	       "(%.1f bytes each):\n  FastWildCompare %.1f ns/key, "
+	       "scalar DFA %.1f ns/key%s\n", szName, cPatterns,
+	       (double) cStates / cPatterns, cKeys,
+	       (double) strBytes.size() / cKeys, uFwcNanos / cMatches,
+	       uDfaNanos / cMatches,
+	       uHitsFwc == uHitsDfa ? "" : " (RESULTS DIFFER)");
+
+	static const WildDfaPath s_rgPaths[] =
+	{
+		WILD_DFA_SCALAR, WILD_DFA_AVX2, WILD_DFA_AVX512
+	};
+	static const char *s_rgszPaths[] =
+	{
+		"scalar", "AVX2, 8 lanes", "AVX-512, 16 lanes"
+	};
+
+	for (int iPath = 0; iPath < 3; ++iPath)
+	{
+		if (!WildDfa::HavePath(s_rgPaths[iPath]))
+		{
+			continue;
+		}
+
+		uint64_t uHits = 0;
+
+		uStart = WildBenchNanos();
+
+		for (size_t i = 0; i < cPatterns; ++i)
+		{
+			rgDfa[i].MatchBatch(strBytes.data(), rgOffsets.data(), cKeys,
+			                    rgbResult.data(), s_rgPaths[iPath]);
+
+			for (uint8_t bResult : rgbResult)
+			{
+				uHits += bResult;
+			}
+		}
+
+		uint64_t uNanos = WildBenchNanos() - uStart;
+
+		printf("  batch, %s: %.1f ns/key%s\n", s_rgszPaths[iPath],
+		       uNanos / cMatches,
+		       uHits == uHitsFwc ? "" : " (RESULTS DIFFER)");
+	}
+}
+
+
+// Two corpora: generated path rules, most of which a key fails within its
+// first few bytes, and unanchored patterns on longer strings, which every
+// lane has to run to the end.
+//
+extern "C" int benchdfa(void)
+{
+	const int       cPatterns = 200;
+	const int       cKeys = 20000;
+	WildBenchRandom rng(66);
+	std::vector<std::string> rgWild(cPatterns), rgKeys(cKeys);
+	std::string     strKey;
+
+	for (int i = 0; i < cPatterns; ++i)
+	{
+		WildBenchMakePattern(rng, rgWild[i]);
+	}
+
+	for (int i = 0; i < cKeys; ++i)
+	{
+		WildBenchMakeKey(rng, rgKeys[i], i % 4 == 0);
+	}
+
+	BenchCorpus("path rules", rgWild, rgKeys);
+
+	for (int i = 0; i < cPatterns; ++i)
+	{
+		WildBenchMakeKey(rng, strKey);
+		rgWild[i] = "*" + strKey.substr(strKey.rfind('/'), 4) + "*" +
+		            strKey.substr(strKey.rfind('.'));
+	}
+
+	for (int i = 0; i < cKeys; ++i)
+	{
+		rgKeys[i].clear();
+
+		for (int iPart = 0; iPart < 4; ++iPart)
+		{
+			WildBenchMakeKey(rng, strKey, iPart < 3);
+			rgKeys[i] += strKey;
+		}
+	}
+
+	BenchCorpus("unanchored", rgWild, rgKeys);
+	return 0;
+}
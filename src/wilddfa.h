@@ -0,0 +1,111 @@
+// WildDfa, a wildcard pattern compiled to a DFA, with a batch runner that
+// advances many tame strings in lockstep
+//
+// Copyright 2025 Kirk J Krauss.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// A DFA takes exactly one table lookup per tame byte, but each lookup
+// depends on the one before, so one tame string can't keep a core busy.
+// MatchBatch() runs 8 (AVX2) or 16 (AVX-512) tame strings at once, one per
+// vector lane, with gathers for the tame bytes, their byte classes and the
+// next states.  Lanes whose strings are done, or whose states can no longer
+// change the result, are refilled with new strings as they free up.
+//
+// Bytes that the pattern never names as literals share one byte class,
+// so a table row has one entry per distinct literal byte, plus one.  Table
+// entries hold the next state's row offset rather than its number, which
+// saves a multiply per step.  State 0 is dead, and state 1 accepts
+// whatever follows, so "no more steps needed" is one compare.
+//
+// The tables, and the scratch that Compile() builds them with, come from
+// the DFA's memory resource, so that a DFA compiled per request can take
+// its memory from the request's arena.
+//
+#ifndef WILDDFA_H
+#define WILDDFA_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <memory_resource>
+#include <vector>
+
+#define WILD_DFA_MAX_STATES  4096   // Compile() gives up past this
+#define WILD_DFA_DEAD        0      // No match is possible
+#define WILD_DFA_ACCEPT      1      // A match, whatever follows
+
+enum WildDfaPath
+{
+	WILD_DFA_AUTO,       // The widest path this CPU supports
+	WILD_DFA_SCALAR,     // One string at a time
+	WILD_DFA_AVX2,       // 8 lanes
+	WILD_DFA_AVX512      // 16 lanes
+};
+
+class WildDfa
+{
+public:
+	explicit WildDfa(std::pmr::memory_resource *pResource =
+	                 std::pmr::get_default_resource());
+
+	// Compiles a pattern of '*' and '?' wildcards.  Returns false if the
+	// DFA would need more than WILD_DFA_MAX_STATES states, in which case it
+	// matches nothing.
+	bool Compile(const char *pWild);
+
+	// Matches a tame string of cbTame bytes, which need not be terminated.
+	bool Match(const char *pTame, size_t cbTame) const;
+
+	bool Match(const char *pTame) const
+	{
+		return Match(pTame, strlen(pTame));
+	}
+
+	// Matches cKeys tame strings stored back to back: string i is bytes
+	// rgOffsets[i] up to rgOffsets[i + 1] of pBytes.  Stores 1 or 0 for
+	// each in rgbResult.  A path the CPU lacks falls back to a narrower one.
+	void MatchBatch(const char *pBytes, const uint32_t *rgOffsets,
+	                size_t cKeys, uint8_t *rgbResult,
+	                WildDfaPath path = WILD_DFA_AUTO) const;
+
+	size_t StateCount() const
+	{
+		return m_rgAccept.size();
+	}
+
+	size_t ClassCount() const
+	{
+		return (size_t) m_cClasses;
+	}
+
+	std::pmr::memory_resource *Resource() const
+	{
+		return m_rgNext.get_allocator().resource();
+	}
+
+	// Whether MatchBatch() can take a given path on this CPU.
+	static bool HavePath(WildDfaPath path);
+
+private:
+	std::pmr::vector<int32_t> m_rgNext;    // Row offset of the next state
+	std::pmr::vector<int32_t> m_rgClass;   // Byte class per byte value
+	std::pmr::vector<uint8_t> m_rgAccept;  // Whether each state accepts
+	int32_t                   m_iStart;    // Row offset of the start state
+	int32_t                   m_cClasses;
+};
+
+extern "C" int testdfa(void);
+extern "C" int benchdfa(void);
+
+#endif  // WILDDFA_H
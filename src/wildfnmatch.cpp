@@ -0,0 +1,1048 @@
+// WildFnmatch(), and related code
+//
+// Copyright 2025 Kirk J Krauss.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// This file provides the fnmatch() pattern parser, its translation into
+// bytecode, and the matcher.  It also includes testcases for conformance
+// with glibc and for performance.
+//
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#if defined(__GLIBC__)
+#include <fnmatch.h>
+#endif
+
+#include "fastwildcompare.h"
+#include "wildfnmatch.h"
+#include "wildbench.h"
+
+
+// A parsed pattern element.  Brackets become 256-bit sets, with glibc's
+// case folding already applied.
+//
+enum WildFnmatchTokenKind
+{
+	FNM_TOKEN_LIT,
+	FNM_TOKEN_ANY,
+	FNM_TOKEN_STAR,
+	FNM_TOKEN_SET
+};
+
+struct WildFnmatchToken
+{
+	WildFnmatchTokenKind kind;
+	uint8_t              ch;       // For FNM_TOKEN_LIT
+	size_t               iSet;     // For FNM_TOKEN_SET, 32 bytes per set
+	bool                 bEscaped; // For FNM_TOKEN_LIT, written as "\\c"
+};
+
+enum WildFnmatchBracket
+{
+	FNM_BRACKET_SET,               // A valid bracket expression
+	FNM_BRACKET_LITERAL,           // Unterminated: '[' is just text
+	FNM_BRACKET_INVALID            // The pattern can never match
+};
+
+
+static inline unsigned FoldCase(unsigned ch)
+{
+	return (ch >= 'A' && ch <= 'Z') ? ch + ('a' - 'A') : ch;
+}
+
+
+static inline void SetBit(uint8_t *rgBits, unsigned ch)
+{
+	rgBits[ch >> 3] |= (uint8_t) (1 << (ch & 7));
+}
+
+
+static inline bool HasBit(const uint8_t *rgBits, unsigned ch)
+{
+	return (rgBits[ch >> 3] >> (ch & 7)) & 1;
+}
+
+
+// Adds the members of a POSIX character class.  Returns false for an
+// unknown name.
+//
+static bool AddFnmatchClass(const char *pName, size_t cbName,
+                            uint8_t *rgBits)
+{
+	static const struct
+	{
+		const char *pszName;
+		int       (*pfnIs)(int);
+	}
+	s_rgNamed[] =
+	{
+		{ "alnum", isalnum }, { "alpha", isalpha }, { "blank", isblank },
+		{ "cntrl", iscntrl }, { "digit", isdigit }, { "graph", isgraph },
+		{ "lower", islower }, { "print", isprint }, { "punct", ispunct },
+		{ "space", isspace }, { "upper", isupper }, { "xdigit", isxdigit }
+	};
+
+	for (const auto &named : s_rgNamed)
+	{
+		if (strlen(named.pszName) == cbName &&
+		    !memcmp(named.pszName, pName, cbName))
+		{
+			for (int ch = 1; ch < 128; ++ch)
+			{
+				if (named.pfnIs(ch))
+				{
+					SetBit(rgBits, (unsigned) ch);
+				}
+			}
+
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+// Adds the bytes whose values, folded if need be, lie in [chLow, chHigh].
+//
+static void AddRange(uint8_t *rgBits, unsigned chLow, unsigned chHigh,
+                     bool bFold)
+{
+	for (unsigned ch = 1; ch < 256; ++ch)
+	{
+		unsigned chTest = bFold ? FoldCase(ch) : ch;
+
+		if (chTest >= chLow && chTest <= chHigh)
+		{
+			SetBit(rgBits, ch);
+		}
+	}
+}
+
+
+// Reads a one-character collating symbol, "[.c.]", at p.  Returns false
+// if it is unterminated or names anything longer, which glibc rejects.
+//
+static bool ReadCollatingSymbol(const char *&p, unsigned &ch)
+{
+	const char *pClose = p + 2;
+
+	while (*pClose && !(pClose[0] == '.' && pClose[1] == ']'))
+	{
+		++pClose;
+	}
+
+	if (pClose - (p + 2) != 1 || !*pClose)
+	{
+		return false;
+	}
+
+	ch = (uint8_t) p[2];
+	p = pClose + 2;
+	return true;
+}
+
+
+// Reads the high end of a range at p.  Returns false for an ill-formed
+// one.
+//
+static bool ReadRangeEnd(const char *&p, bool bEscapes, unsigned &ch)
+{
+	if (p[0] == '[' && p[1] == '.')
+	{
+		return ReadCollatingSymbol(p, ch);
+	}
+
+	if (bEscapes && *p == '\\')
+	{
+		++p;
+	}
+
+	if (!*p)
+	{
+		return false;
+	}
+
+	ch = (uint8_t) *p++;
+	return true;
+}
+
+
+// Parses a bracket expression at pWild, which points to '['.  Membership
+// follows glibc in the "C" locale.  With WILD_FNM_CASEFOLD, characters and
+// range ends are compared after folding, but classes, "[=c=]" and "[.c.]"
+// test the tame byte as it is.  A "[:" that doesn't start a class name
+// (lowercase letters short of 'z', then ":]") is an ordinary '['.
+//
+static WildFnmatchBracket ParseFnmatchBracket(const char *pWild, int iFlags,
+                                              uint8_t *rgBits,
+                                              const char **ppNext)
+{
+	const char *p = pWild + 1;
+	bool        bEscapes = !(iFlags & WILD_FNM_NOESCAPE);
+	bool        bFold = (iFlags & WILD_FNM_CASEFOLD) != 0;
+	bool        bNegate = false;
+	bool        bFirst = true;
+
+	memset(rgBits, 0, 32);
+
+	if (*p == '!' || *p == '^')
+	{
+		bNegate = true;
+		++p;
+	}
+
+	while (*p != ']' || bFirst)
+	{
+		unsigned chLow, chHigh;
+
+		if (!*p)
+		{
+			return FNM_BRACKET_LITERAL;
+		}
+
+		bFirst = false;
+
+		if (p[0] == '[' && p[1] == ':')
+		{
+			const char *pName = p + 2;
+			const char *pClose = pName;
+
+			while (*pClose >= 'a' && *pClose < 'z')
+			{
+				++pClose;
+			}
+
+			if (pClose[0] == ':' && pClose[1] == ']')
+			{
+				if (!AddFnmatchClass(pName, (size_t) (pClose - pName),
+				                     rgBits))
+				{
+					return FNM_BRACKET_INVALID;
+				}
+
+				p = pClose + 2;
+				continue;
+			}
+		}
+		else if (p[0] == '[' && p[1] == '=')
+		{
+			if (p[2] && p[3] == '=' && p[4] == ']')
+			{
+				SetBit(rgBits, (uint8_t) p[2]);
+				p += 5;
+				continue;
+			}
+		}
+		else if (p[0] == '[' && p[1] == '.')
+		{
+			if (!ReadCollatingSymbol(p, chLow))
+			{
+				return FNM_BRACKET_INVALID;
+			}
+
+			if (p[0] == '-' && p[1] && p[1] != ']')
+			{
+				++p;
+
+				if (!ReadRangeEnd(p, bEscapes, chHigh))
+				{
+					return FNM_BRACKET_INVALID;
+				}
+
+				AddRange(rgBits, chLow, bFold ? FoldCase(chHigh) : chHigh,
+				         bFold);
+			}
+			else if (p[0] == '-' && !p[1])
+			{
+				return FNM_BRACKET_INVALID;
+			}
+			else
+			{
+				SetBit(rgBits, chLow);
+			}
+
+			continue;
+		}
+
+		if (bEscapes && *p == '\\' && !*++p)
+		{
+			return FNM_BRACKET_INVALID;
+		}
+
+		chLow = (uint8_t) *p++;
+
+		if (p[0] == '-' && p[1] && p[1] != ']')
+		{
+			++p;
+
+			if (!ReadRangeEnd(p, bEscapes, chHigh))
+			{
+				return FNM_BRACKET_INVALID;
+			}
+		}
+		else if (p[0] == '-' && !p[1])
+		{
+			return FNM_BRACKET_INVALID;     // glibc reads a range to NUL.
+		}
+		else
+		{
+			chHigh = chLow;
+		}
+
+		if (bFold)
+		{
+			chLow = FoldCase(chLow);
+			chHigh = FoldCase(chHigh);
+		}
+
+		AddRange(rgBits, chLow, chHigh, bFold);
+	}
+
+	if (bNegate)
+	{
+		for (int i = 0; i < 32; ++i)
+		{
+			rgBits[i] = (uint8_t) ~rgBits[i];
+		}
+	}
+
+	rgBits[0] &= (uint8_t) ~1;         // NUL never appears in a C string.
+	*ppNext = p + 1;
+	return FNM_BRACKET_SET;
+}
+
+
+// Returns whether the tokens so far end with a run of '*' and '?' that
+// includes a '*'.  glibc looks past such a run for the next literal, and
+// then searches for it only up to the next '/', so it never finds an
+// escaped '/' there.
+//
+static bool FollowsStar(const std::pmr::vector<WildFnmatchToken> &rgTokens)
+{
+	for (size_t i = rgTokens.size(); i-- > 0; )
+	{
+		if (rgTokens[i].kind == FNM_TOKEN_STAR)
+		{
+			return true;
+		}
+		else if (rgTokens[i].kind != FNM_TOKEN_ANY)
+		{
+			return false;
+		}
+	}
+
+	return false;
+}
+
+
+// Returns the number of '?' in a component that opens with a run of '*'
+// and '?', holding at least one of each, followed by a bracket; or zero.
+// glibc's '*' steps over the '?' first, then tries the bracket at each
+// offset still treating the first one as the start of the component, so
+// under FNM_PERIOD the bracket can't match a '.' there.
+//
+static size_t PeriodShadow(const std::pmr::vector<WildFnmatchToken> &rgTokens,
+                           size_t iBegin, size_t iEnd)
+{
+	size_t cAny = 0;
+	size_t i = iBegin;
+
+	if (i == iEnd || rgTokens[i].kind != FNM_TOKEN_STAR)
+	{
+		return 0;
+	}
+
+	for (; i < iEnd && (rgTokens[i].kind == FNM_TOKEN_STAR ||
+	                    rgTokens[i].kind == FNM_TOKEN_ANY); ++i)
+	{
+		cAny += rgTokens[i].kind == FNM_TOKEN_ANY;
+	}
+
+	return i < iEnd && rgTokens[i].kind == FNM_TOKEN_SET ? cAny : 0;
+}
+
+
+// Appends one byte to a WildProgram pattern as a literal.
+//
+static void AppendLiteral(std::pmr::string &strProgram, uint8_t ch)
+{
+	if (!isalnum(ch))
+	{
+		strProgram += '\\';
+	}
+
+	strProgram += (char) ch;
+}
+
+
+static int CountMembers(const uint8_t *rgBits)
+{
+	int cMembers = 0;
+
+	for (unsigned ch = 1; ch < 256; ++ch)
+	{
+		cMembers += HasBit(rgBits, ch);
+	}
+
+	return cMembers;
+}
+
+
+// Appends a set to a WildProgram pattern, listing its members or, if
+// that's shorter, the members of its complement.  A set of every byte is
+// just '?'.
+//
+static void AppendSet(std::pmr::string &strProgram, const uint8_t *rgBits)
+{
+	int cMembers = CountMembers(rgBits);
+
+	if (cMembers == 255)
+	{
+		strProgram += '?';
+		return;
+	}
+
+	bool bComplement = cMembers > 127;
+
+	strProgram += bComplement ? "[!" : "[";
+
+	for (unsigned ch = 1; ch < 256; ++ch)
+	{
+		if (HasBit(rgBits, ch) != bComplement)
+		{
+			strProgram += '\\';
+			strProgram += (char) ch;
+		}
+	}
+
+	strProgram += ']';
+}
+
+
+WildFnmatchPattern::WildFnmatchPattern(std::pmr::memory_resource *pResource) :
+    m_rgComponents(pResource), m_strWild(pResource), m_iFlags(0),
+    m_bPlain(false), m_bNever(true)
+{
+}
+
+
+bool WildFnmatchPattern::Compile(const char *pWild, int iFlags)
+{
+	m_rgComponents.clear();
+	m_strWild = pWild;
+	m_iFlags = iFlags;
+	m_bPlain = false;
+	m_bNever = true;
+
+	if (iFlags & ~WILD_FNM_SUPPORTED)
+	{
+		return false;
+	}
+
+	bool bEscapes = !(iFlags & WILD_FNM_NOESCAPE);
+
+	// With no brackets, escapes or flags, this is FastWildCompare()'s job.
+	if (!(iFlags & ~WILD_FNM_NOESCAPE) && !strchr(pWild, '[') &&
+	    (!bEscapes || !strchr(pWild, '\\')))
+	{
+		m_bPlain = true;
+		m_bNever = false;
+		return true;
+	}
+
+	std::pmr::vector<WildFnmatchToken> rgTokens(Resource());
+	std::pmr::vector<uint8_t>          rgSets(Resource());
+	const char                        *p = pWild;
+
+	while (*p)
+	{
+		WildFnmatchToken token = { FNM_TOKEN_LIT, 0, 0, false };
+		uint8_t          rgBits[32];
+		const char      *pNext;
+
+		if (*p == '*')
+		{
+			token.kind = FNM_TOKEN_STAR;
+			++p;
+		}
+		else if (*p == '?')
+		{
+			token.kind = FNM_TOKEN_ANY;
+			++p;
+		}
+		else if (*p == '[')
+		{
+			WildFnmatchBracket bracket =
+			    ParseFnmatchBracket(p, iFlags, rgBits, &pNext);
+
+			if (bracket == FNM_BRACKET_INVALID ||
+			    (bracket == FNM_BRACKET_SET && !CountMembers(rgBits)))
+			{
+				return true;           // "[b-a]" matches nothing.
+			}
+			else if (bracket == FNM_BRACKET_SET)
+			{
+				token.kind = FNM_TOKEN_SET;
+				token.iSet = rgSets.size() / 32;
+				rgSets.insert(rgSets.end(), rgBits, rgBits + 32);
+				p = pNext;
+			}
+			else
+			{
+				token.ch = (uint8_t) *p++;
+			}
+		}
+		else
+		{
+			if (bEscapes && *p == '\\')
+			{
+				if (!*++p)
+				{
+					return true;       // A trailing '\' matches nothing.
+				}
+				else if (*p == '/' && (iFlags & WILD_FNM_PATHNAME) &&
+				         FollowsStar(rgTokens))
+				{
+					return true;       // As in glibc, "*\/" matches nothing.
+				}
+
+				token.bEscaped = true;
+			}
+
+			token.ch = (uint8_t) *p++;
+		}
+
+		rgTokens.push_back(token);
+	}
+
+	// Folding can be left to the bytecode if every set already contains
+	// both cases of each letter, which is all that a class can spoil.
+	bool bProgramFold = (iFlags & WILD_FNM_CASEFOLD) != 0;
+
+	for (size_t iSet = 0; iSet < rgSets.size() / 32 && bProgramFold; ++iSet)
+	{
+		for (unsigned ch = 'a'; ch <= 'z'; ++ch)
+		{
+			bProgramFold &= HasBit(&rgSets[iSet * 32], ch) ==
+			                HasBit(&rgSets[iSet * 32], ch - ('a' - 'A'));
+		}
+	}
+
+	// Translate, splitting at each literal '/' under WILD_FNM_PATHNAME.
+	std::pmr::string strProgram(Resource()), strShadow(Resource());
+	bool             bLeadingPeriod = !rgTokens.empty() &&
+	                                  rgTokens[0].kind == FNM_TOKEN_LIT &&
+	                                  rgTokens[0].ch == '.';
+	unsigned         uProgramFlags = WILD_FLAG_BRACKETS | WILD_FLAG_ESCAPES |
+	                                 (bProgramFold ? WILD_FLAG_CASEFOLD : 0);
+	size_t           iComponent = 0;
+
+	for (size_t i = 0; i <= rgTokens.size(); ++i)
+	{
+		if (i == rgTokens.size() ||
+		    ((iFlags & WILD_FNM_PATHNAME) &&
+		     rgTokens[i].kind == FNM_TOKEN_LIT && rgTokens[i].ch == '/'))
+		{
+			m_rgComponents.emplace_back(Resource());
+
+			WildFnmatchComponent &component = m_rgComponents.back();
+
+			component.bLeadingPeriod = bLeadingPeriod;
+
+			if ((iFlags & WILD_FNM_PERIOD) && !bLeadingPeriod)
+			{
+				component.cShadow = PeriodShadow(rgTokens, iComponent, i);
+			}
+
+			if (component.cShadow)
+			{
+				strShadow.assign(1, '?');
+				strShadow += strProgram;
+			}
+
+			if (!component.program.Compile(strProgram.c_str(),
+			                               uProgramFlags) ||
+			    (component.cShadow &&
+			     !component.programShadow.Compile(strShadow.c_str(),
+			                                      uProgramFlags)))
+			{
+				m_rgComponents.clear();
+				return true;
+			}
+
+			if (i == rgTokens.size())
+			{
+				break;
+			}
+
+			// glibc lets a '.' follow an escaped '/' as if mid-component.
+			strProgram.clear();
+			iComponent = i + 1;
+			bLeadingPeriod = rgTokens[i].bEscaped ||
+			                 (i + 1 < rgTokens.size() &&
+			                  rgTokens[i + 1].kind == FNM_TOKEN_LIT &&
+			                  rgTokens[i + 1].ch == '.');
+			continue;
+		}
+
+		const WildFnmatchToken &token = rgTokens[i];
+
+		if (token.kind == FNM_TOKEN_STAR)
+		{
+			strProgram += '*';
+		}
+		else if (token.kind == FNM_TOKEN_ANY)
+		{
+			strProgram += '?';
+		}
+		else if (token.kind == FNM_TOKEN_SET)
+		{
+			AppendSet(strProgram, &rgSets[token.iSet * 32]);
+		}
+		else if ((iFlags & WILD_FNM_CASEFOLD) && !bProgramFold &&
+		         isalpha(token.ch))
+		{
+			uint8_t rgBits[32] = { 0 };
+
+			SetBit(rgBits, FoldCase(token.ch));
+			SetBit(rgBits, FoldCase(token.ch) - ('a' - 'A'));
+			AppendSet(strProgram, rgBits);
+		}
+		else
+		{
+			AppendLiteral(strProgram, token.ch);
+		}
+	}
+
+	m_bNever = false;
+	return true;
+}
+
+
+// Matches one component, or the whole string without WILD_FNM_PATHNAME.
+//
+bool WildFnmatchPattern::MatchComponent(size_t iComponent, const char *pTame,
+                                        size_t cbTame) const
+{
+	const WildFnmatchComponent &component = m_rgComponents[iComponent];
+
+	if ((m_iFlags & WILD_FNM_PERIOD) && cbTame && *pTame == '.' &&
+	    !component.bLeadingPeriod)
+	{
+		return false;
+	}
+	else if (component.cShadow && cbTame > component.cShadow &&
+	         pTame[component.cShadow] == '.')
+	{
+		// The '*' must take at least one byte; see PeriodShadow().
+		return component.programShadow.Match(pTame, cbTame);
+	}
+
+	return component.program.Match(pTame, cbTame);
+}
+
+
+int WildFnmatchPattern::Match(const char *pTame) const
+{
+	if (m_bNever)
+	{
+		return WILD_FNM_NOMATCH;
+	}
+	else if (m_bPlain)
+	{
+		return FastWildCompare(const_cast<char *>(m_strWild.c_str()),
+		                       const_cast<char *>(pTame)) ?
+		       0 : WILD_FNM_NOMATCH;
+	}
+
+	if (!(m_iFlags & WILD_FNM_PATHNAME))
+	{
+		size_t cbTame = strlen(pTame);
+
+		if (m_iFlags & WILD_FNM_LEADING_DIR)
+		{
+			for (size_t i = 0; i < cbTame; ++i)
+			{
+				if (pTame[i] == '/' && MatchComponent(0, pTame, i))
+				{
+					return 0;
+				}
+			}
+		}
+
+		return MatchComponent(0, pTame, cbTame) ? 0 : WILD_FNM_NOMATCH;
+	}
+
+	const char *p = pTame;
+
+	for (size_t iComponent = 0; iComponent < m_rgComponents.size();
+	     ++iComponent)
+	{
+		const char *pSlash = strchr(p, '/');
+		size_t      cb = pSlash ? (size_t) (pSlash - p) : strlen(p);
+
+		if (!MatchComponent(iComponent, p, cb))
+		{
+			return WILD_FNM_NOMATCH;
+		}
+		else if (!pSlash)
+		{
+			return iComponent + 1 == m_rgComponents.size() ?
+			       0 : WILD_FNM_NOMATCH;
+		}
+
+		p = pSlash + 1;
+	}
+
+	// The pattern is used up, and a '/' and more of the string follow.
+	return (m_iFlags & WILD_FNM_LEADING_DIR) ? 0 : WILD_FNM_NOMATCH;
+}
+
+
+// A per-thread cache of compiled patterns, replaced round-robin.  The
+// entry that matched last time is checked first, since callers usually
+// test a run of strings against one pattern.
+//
+struct WildFnmatchCache
+{
+	WildFnmatchPattern rgPattern[WILD_FNM_CACHE_SIZE];
+	std::string        rgstrWild[WILD_FNM_CACHE_SIZE];
+	int                rgiFlags[WILD_FNM_CACHE_SIZE];
+	bool               rgbValid[WILD_FNM_CACHE_SIZE];
+	size_t             iNext;
+	size_t             iLast;
+
+	WildFnmatchCache() : rgiFlags(), rgbValid(), iNext(0), iLast(0)
+	{
+	}
+
+	bool Holds(size_t i, const char *pWild, int iFlags) const
+	{
+		return rgbValid[i] && rgiFlags[i] == iFlags &&
+		       !strcmp(rgstrWild[i].c_str(), pWild);
+	}
+};
+
+
+extern "C" int WildFnmatch(const char *pWild, const char *pTame, int iFlags)
+{
+	static thread_local WildFnmatchCache s_cache;
+
+	if (iFlags & ~WILD_FNM_SUPPORTED)
+	{
+		return -1;
+	}
+
+	if (s_cache.Holds(s_cache.iLast, pWild, iFlags))
+	{
+		return s_cache.rgPattern[s_cache.iLast].Match(pTame);
+	}
+
+	for (size_t i = 0; i < WILD_FNM_CACHE_SIZE; ++i)
+	{
+		if (s_cache.Holds(i, pWild, iFlags))
+		{
+			s_cache.iLast = i;
+			return s_cache.rgPattern[i].Match(pTame);
+		}
+	}
+
+	size_t i = s_cache.iNext;
+
+	s_cache.iNext = (i + 1) % WILD_FNM_CACHE_SIZE;
+	s_cache.iLast = i;
+	s_cache.rgPattern[i].Compile(pWild, iFlags);
+	s_cache.rgstrWild[i] = pWild;
+	s_cache.rgiFlags[i] = iFlags;
+	s_cache.rgbValid[i] = true;
+	return s_cache.rgPattern[i].Match(pTame);
+}
+
+
+// Cases whose glibc results are recorded here, so that they're checked
+// even where glibc isn't available.
+//
+static const struct
+{
+	const char *pszWild;
+	const char *pszTame;
+	int         iFlags;
+	int         iResult;
+}
+s_rgFnmatchCases[] =
+{
+	{ "\\", "\\", 0, 1 },
+	{ "a\\", "a", 0, 1 },
+	{ "a\\", "a\\", WILD_FNM_NOESCAPE, 0 },
+	{ "\\*", "*", 0, 0 },
+	{ "\\*", "\\*", WILD_FNM_NOESCAPE, 0 },
+	{ "[/]", "/", WILD_FNM_PATHNAME, 1 },
+	{ "a[/]b", "a/b", 0, 0 },
+	{ "a[b/c]d", "abd", WILD_FNM_PATHNAME, 0 },
+	{ "a[b/c]d", "a/d", WILD_FNM_PATHNAME, 1 },
+	{ "[a/", "[a/", WILD_FNM_PATHNAME, 0 },
+	{ "a\\/b", "a/b", WILD_FNM_PATHNAME, 0 },
+	{ "*/b", "a/b", WILD_FNM_PATHNAME, 0 },
+	{ "*b", "a/b", WILD_FNM_PATHNAME, 1 },
+	{ "[Z-a]", "_", 0, 0 },
+	{ "[Z-a]", "_", WILD_FNM_CASEFOLD, 1 },
+	{ "[A-Z]", "q", WILD_FNM_CASEFOLD, 0 },
+	{ "[[:upper:]]", "a", WILD_FNM_CASEFOLD, 1 },
+	{ "[!a]", "A", WILD_FNM_CASEFOLD, 1 },
+	{ "[[:foo:]]", "a", 0, 1 },
+	{ "[[.a.]]", "a", 0, 0 },
+	{ "[[=a=]b]", "b", 0, 0 },
+	{ "[[.a.]-c]", "b", 0, 0 },
+	{ "[[.space.]]", " ", 0, 1 },
+	{ "[a-[:alpha:]]", "b", 0, 1 },
+	{ "[[:alpha:]-z]", "-", 0, 0 },
+	{ "[[:alpha:]", "a", 0, 1 },
+	{ "[a\\]]", "]", 0, 0 },
+	{ "[\\a]", "\\", WILD_FNM_NOESCAPE, 0 },
+	{ "[!]a]", "b", 0, 0 },
+	{ "[]-a]", "_", 0, 0 },
+	{ "[a-c-e]", "d", 0, 1 },
+	{ "[a-c-e]", "-", 0, 0 },
+	{ "[c-a]", "b", 0, 1 },
+	{ "[]", "[]", 0, 0 },
+	{ "[^a]", "b", 0, 0 },
+	{ "[\x80-\xff]", "\x90", 0, 0 },
+	{ "[.]a", ".a", WILD_FNM_PERIOD, 1 },
+	{ "\\.a", ".a", WILD_FNM_PERIOD, 0 },
+	{ "*", "a/.b", WILD_FNM_PERIOD, 0 },
+	{ "a/*", "a/.b", WILD_FNM_PERIOD | WILD_FNM_PATHNAME, 1 },
+	{ "a*/.*", "a/.b", WILD_FNM_PERIOD | WILD_FNM_PATHNAME, 0 },
+	{ "?", ".", WILD_FNM_PERIOD, 1 },
+	{ "*??[.]*", "*-.--", 0x1F, 1 },
+	{ "*?[!a]", "/.", WILD_FNM_PERIOD | WILD_FNM_CASEFOLD, 1 },
+	{ "*?[!a]", "b.", 0, 0 },
+	{ "*?[.]", "ab.", WILD_FNM_PERIOD, 0 },
+	{ "a/*?[.]", "a/b.", WILD_FNM_PERIOD | WILD_FNM_PATHNAME, 1 },
+	{ "\\/*", "/.a", WILD_FNM_PERIOD | WILD_FNM_PATHNAME, 0 },
+	{ "/*", "/.a", WILD_FNM_PERIOD | WILD_FNM_PATHNAME, 1 },
+	{ "a", "a/b", WILD_FNM_LEADING_DIR, 0 },
+	{ "a?b", "a/b", WILD_FNM_LEADING_DIR, 0 },
+	{ "a*", "ab/c", WILD_FNM_LEADING_DIR | WILD_FNM_PATHNAME, 0 },
+	{ "a/b", "a", WILD_FNM_LEADING_DIR | WILD_FNM_PATHNAME, 1 },
+	{ "*/", "a/", WILD_FNM_LEADING_DIR | WILD_FNM_PATHNAME, 0 }
+};
+
+
+// A set of fnmatch() conformance tests: the recorded cases, and, with
+// glibc, random patterns and strings over an alphabet of the characters
+// that matter, under every combination of flags.
+//
+extern "C" int testfnmatch(void)
+{
+	bool bAllPassed = true;
+
+	for (const auto &test : s_rgFnmatchCases)
+	{
+		bAllPassed &= WildFnmatch(test.pszWild, test.pszTame, test.iFlags) ==
+		              test.iResult;
+	}
+
+	bAllPassed &= WildFnmatch("a", "a", 1 << 5) == -1;
+
+#if defined(__GLIBC__)
+	static const char s_szWildChars[] = "aAb./*?[]!^-\\:";
+	static const char s_szTameChars[] = "aAbB./[]-\\";
+	WildBenchRandom   rng(707);
+	WildFnmatchPattern pattern;
+
+	for (int iRound = 0; iRound < 20000; ++iRound)
+	{
+		std::string strWild, strTame;
+		size_t      cchWild = rng.Below(9);
+		size_t      cchTame = rng.Below(9);
+		int         iFlags = (int) rng.Below(WILD_FNM_SUPPORTED + 1);
+
+		for (size_t i = 0; i < cchWild; ++i)
+		{
+			strWild += s_szWildChars[rng.Below(sizeof(s_szWildChars) - 1)];
+		}
+
+		for (size_t i = 0; i < cchTame; ++i)
+		{
+			strTame += s_szTameChars[rng.Below(sizeof(s_szTameChars) - 1)];
+		}
+
+		int iExpected = fnmatch(strWild.c_str(), strTame.c_str(), iFlags);
+
+		pattern.Compile(strWild.c_str(), iFlags);
+
+		if (pattern.Match(strTame.c_str()) != (iExpected ? 1 : 0))
+		{
+			printf("fnmatch(\"%s\", \"%s\", %d) = %d\n", strWild.c_str(),
+			       strTame.c_str(), iFlags, iExpected);
+			bAllPassed = false;
+		}
+	}
+#endif
+
+	if (bAllPassed)
+	{
+		printf("Passed fnmatch tests\n");
+	}
+	else
+	{
+		printf("Failed fnmatch tests\n");
+	}
+
+	return 0;
+}
+
+
+// Times glibc's fnmatch(), the one-shot WildFnmatch(), and precompiled
+// patterns on one corpus, pattern by pattern, the way a directory listing
+// gets filtered.
+//
+static void BenchFnmatchCorpus(const char *szName,
+                               const std::vector<std::string> &rgWild,
+                               const std::vector<std::string> &rgKeys,
+                               int iFlags)
+{
+	size_t   cPatterns = rgWild.size(), cKeys = rgKeys.size();
+	double   cMatches = (double) cPatterns * cKeys;
+	uint64_t uHitsOneShot = 0, uHitsCompiled = 0;
+	uint64_t uStart;
+	std::vector<WildFnmatchPattern> rgPattern(cPatterns);
+
+	printf("fnmatch, %s, %zu patterns x %zu keys, flags 0x%x:\n", szName,
+	       cPatterns, cKeys, iFlags);
+
+#if defined(__GLIBC__)
+	uint64_t uHitsGlibc = 0;
+
+	uStart = WildBenchNanos();
+
+	for (size_t i = 0; i < cPatterns; ++i)
+	{
+		for (size_t iKey = 0; iKey < cKeys; ++iKey)
+		{
+			uHitsGlibc += !fnmatch(rgWild[i].c_str(), rgKeys[iKey].c_str(),
+			                       iFlags);
+		}
+	}
+
+	printf("  glibc fnmatch()       %.1f ns/key\n",
+	       (WildBenchNanos() - uStart) / cMatches);
+#endif
+
+	uStart = WildBenchNanos();
+
+	for (size_t i = 0; i < cPatterns; ++i)
+	{
+		for (size_t iKey = 0; iKey < cKeys; ++iKey)
+		{
+			uHitsOneShot += !WildFnmatch(rgWild[i].c_str(),
+			                             rgKeys[iKey].c_str(), iFlags);
+		}
+	}
+
+	printf("  WildFnmatch()         %.1f ns/key\n",
+	       (WildBenchNanos() - uStart) / cMatches);
+
+	uStart = WildBenchNanos();
+
+	for (size_t i = 0; i < cPatterns; ++i)
+	{
+		rgPattern[i].Compile(rgWild[i].c_str(), iFlags);
+
+		for (size_t iKey = 0; iKey < cKeys; ++iKey)
+		{
+			uHitsCompiled += !rgPattern[i].Match(rgKeys[iKey].c_str());
+		}
+	}
+
+	printf("  WildFnmatchPattern    %.1f ns/key%s\n",
+	       (WildBenchNanos() - uStart) / cMatches,
+	       uHitsOneShot == uHitsCompiled
+#if defined(__GLIBC__)
+	       && uHitsGlibc == uHitsCompiled
+#endif
+	       ? "" : " (RESULTS DIFFER)");
+}
+
+
+// Three corpora: generated path rules as they are, the same rules with
+// digits turned into ranges and directories into per-component stars under
+// FNM_PATHNAME, and the bracketed rules again, upper-cased, under
+// FNM_CASEFOLD.
+//
+extern "C" int benchfnmatch(void)
+{
+	const int       cPatterns = 200;
+	const int       cKeys = 5000;
+	WildBenchRandom rng(77);
+	std::vector<std::string> rgWild(cPatterns), rgKeys(cKeys);
+
+	for (int i = 0; i < cPatterns; ++i)
+	{
+		WildBenchMakePattern(rng, rgWild[i]);
+	}
+
+	for (int i = 0; i < cKeys; ++i)
+	{
+		WildBenchMakeKey(rng, rgKeys[i], i % 4 == 0);
+	}
+
+	BenchFnmatchCorpus("plain", rgWild, rgKeys, 0);
+
+	for (std::string &strWild : rgWild)
+	{
+		std::string strBracketed;
+		size_t      iSlash = strWild.find('/', 1);
+
+		for (size_t i = 0; i < strWild.size(); ++i)
+		{
+			if (isdigit((unsigned char) strWild[i]))
+			{
+				strBracketed += "[0-9]";
+			}
+			else if (i == iSlash && strWild.find('/', i + 1) !=
+			         std::string::npos)
+			{
+				// "/srv/app17/" becomes "/srv/*/".
+				strBracketed += "/*";
+				i = strWild.find('/', i + 1) - 1;
+			}
+			else
+			{
+				strBracketed += strWild[i];
+			}
+		}
+
+		strWild = strBracketed;
+	}
+
+	BenchFnmatchCorpus("brackets", rgWild, rgKeys, WILD_FNM_PATHNAME);
+
+	for (std::string &strWild : rgWild)
+	{
+		for (char &ch : strWild)
+		{
+			ch = (char) toupper((unsigned char) ch);
+		}
+	}
+
+	BenchFnmatchCorpus("case-folded brackets", rgWild, rgKeys,
+	                   WILD_FNM_PATHNAME | WILD_FNM_CASEFOLD);
+	return 0;
+}
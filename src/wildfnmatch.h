@@ -0,0 +1,106 @@
+// WildFnmatch(), an fnmatch(3)-compatible entry point built on the
+// compiled-pattern path
+//
+// Copyright 2025 Kirk J Krauss.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// WildFnmatch() takes the same arguments and flags as glibc's fnmatch(),
+// and aims to return the same results in the "C" locale, quirks included:
+// under FNM_PERIOD, glibc's "*?[...]" rejects a '.' where the '*' would be
+// empty, and a '.' after an escaped '/' isn't leading.  The tests compare
+// against glibc on random patterns.  A pattern is parsed once, with
+// glibc's rules for bracket expressions, escapes and case folding.  It
+// is then translated into WildProgram bytecode, one program per path
+// component when WILD_FNM_PATHNAME is set.  Patterns that use no
+// brackets, escapes or flags go straight to FastWildCompare().  The
+// one-shot entry point keeps a small per-thread cache of compiled
+// patterns, since callers tend to test many strings against each one.
+//
+#ifndef WILDFNMATCH_H
+#define WILDFNMATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#include "wildbytecode.h"
+
+// Flag values and the no-match result are the same as in glibc's
+// <fnmatch.h>, so callers can pass FNM_* flags through unchanged.
+#define WILD_FNM_NOMATCH       1
+#define WILD_FNM_PATHNAME      (1 << 0)  // '*', '?' and brackets skip '/'
+#define WILD_FNM_NOESCAPE      (1 << 1)  // '\' is an ordinary character
+#define WILD_FNM_PERIOD        (1 << 2)  // A leading '.' must be literal
+#define WILD_FNM_LEADING_DIR   (1 << 3)  // Match a prefix followed by '/'
+#define WILD_FNM_CASEFOLD      (1 << 4)  // ASCII letters match either case
+#define WILD_FNM_SUPPORTED     0x1F      // FNM_EXTMATCH is not supported
+
+#define WILD_FNM_CACHE_SIZE    8         // Compiled patterns per thread
+
+class WildFnmatchPattern
+{
+public:
+	explicit WildFnmatchPattern(std::pmr::memory_resource *pResource =
+	                            std::pmr::get_default_resource());
+
+	// Compiles a pattern for a set of flags.  Returns false for flags
+	// outside WILD_FNM_SUPPORTED, in which case the pattern matches nothing.
+	// A malformed pattern that glibc never matches (an unknown class name,
+	// a trailing '\') compiles, and likewise matches nothing.
+	bool Compile(const char *pWild, int iFlags);
+
+	// Returns 0 on a match and WILD_FNM_NOMATCH otherwise, as fnmatch()
+	// does.
+	int Match(const char *pTame) const;
+
+	std::pmr::memory_resource *Resource() const
+	{
+		return m_strWild.get_allocator().resource();
+	}
+
+private:
+	struct WildFnmatchComponent
+	{
+		explicit WildFnmatchComponent(std::pmr::memory_resource *pResource) :
+		    program(pResource), bLeadingPeriod(false), cShadow(0),
+		    programShadow(pResource)
+		{
+		}
+
+		WildProgram program;
+		bool        bLeadingPeriod;   // May start with '.'; see Compile()
+		size_t      cShadow;          // See PeriodShadow()
+		WildProgram programShadow;    // Used when that byte is a '.'
+	};
+
+	bool MatchComponent(size_t iComponent, const char *pTame,
+	                    size_t cbTame) const;
+
+	std::pmr::vector<WildFnmatchComponent> m_rgComponents;
+	std::pmr::string                       m_strWild;  // For the plain path
+	int                                    m_iFlags;
+	bool                                   m_bPlain;   // Just FastWildCompare()
+	bool                                   m_bNever;   // Matches nothing
+};
+
+// Returns 0 if the tame string matches the pattern, WILD_FNM_NOMATCH if
+// not, and -1 for unsupported flags.
+extern "C" int WildFnmatch(const char *pWild, const char *pTame, int iFlags);
+
+extern "C" int testfnmatch(void);
+extern "C" int benchfnmatch(void);
+
+#endif  // WILDFNMATCH_H
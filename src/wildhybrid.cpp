@@ -0,0 +1,619 @@
+// HybridWildCompare(), WildLinearCompare(), and related code
+//
+// Copyright 2025 Kirk J Krauss.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// This file provides a linear-time wildcard matching engine, and a hybrid
+// routine that runs the greedy FastWildCompare() algorithm until its
+// fallbacks get expensive, then hands off to the linear-time engine.  It
+// also includes testcases for correctness and performance.
+//
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "fastwildcompare.h"
+#include "wildhybrid.h"
+#include "wildbench.h"
+
+
+// Finds the leftmost place in pTame where the cbSeg-byte segment at pSeg
+// (literals and '?', no '*') matches.  Returns a pointer just past that
+// match, or NULL.  This is a shift-and search: bit i of each state word is
+// set when the segment's first i + 1 bytes match the text just scanned, so
+// every tame byte costs a shift and an AND per 64 segment bytes, with no
+// backing up.
+//
+static const char *FindSegment(const char *pSeg, size_t cbSeg,
+                               const char *pTame)
+{
+	if (cbSeg <= 64)
+	{
+		uint64_t rgMask[256];
+		uint64_t uAny = 0;
+		uint64_t uState = 0;
+		uint64_t uDone = (uint64_t) 1 << (cbSeg - 1);
+
+		for (size_t i = 0; i < cbSeg; ++i)
+		{
+			if (pSeg[i] == '?')
+			{
+				uAny |= (uint64_t) 1 << i;
+			}
+		}
+
+		for (int ch = 0; ch < 256; ++ch)
+		{
+			rgMask[ch] = uAny;
+		}
+
+		for (size_t i = 0; i < cbSeg; ++i)
+		{
+			rgMask[(uint8_t) pSeg[i]] |= (uint64_t) 1 << i;
+		}
+
+		for (; *pTame; ++pTame)
+		{
+			uState = ((uState << 1) | 1) & rgMask[(uint8_t) *pTame];
+
+			if (uState & uDone)
+			{
+				return pTame + 1;
+			}
+		}
+
+		return NULL;
+	}
+
+	// Longer segments carry the shift across several words.
+	size_t cWords = (cbSeg + 63) / 64;
+	std::vector<uint64_t> rgMask(256 * cWords, 0);
+	std::vector<uint64_t> rgState(cWords, 0);
+	uint64_t uDone = (uint64_t) 1 << ((cbSeg - 1) % 64);
+
+	for (size_t i = 0; i < cbSeg; ++i)
+	{
+		uint64_t uBit = (uint64_t) 1 << (i % 64);
+
+		if (pSeg[i] == '?')
+		{
+			for (int ch = 0; ch < 256; ++ch)
+			{
+				rgMask[ch * cWords + i / 64] |= uBit;
+			}
+		}
+		else
+		{
+			rgMask[(uint8_t) pSeg[i] * cWords + i / 64] |= uBit;
+		}
+	}
+
+	for (; *pTame; ++pTame)
+	{
+		const uint64_t *pMask = &rgMask[(uint8_t) *pTame * cWords];
+		uint64_t        uCarry = 1;
+
+		for (size_t iWord = 0; iWord < cWords; ++iWord)
+		{
+			uint64_t uNextCarry = rgState[iWord] >> 63;
+
+			rgState[iWord] = ((rgState[iWord] << 1) | uCarry) & pMask[iWord];
+			uCarry = uNextCarry;
+		}
+
+		if (rgState[cWords - 1] & uDone)
+		{
+			return pTame + 1;
+		}
+	}
+
+	return NULL;
+}
+
+
+// Compares cbSeg bytes of pTame with a segment of literals and '?'.
+//
+static bool SegmentMatches(const char *pSeg, size_t cbSeg, const char *pTame)
+{
+	for (size_t i = 0; i < cbSeg; ++i)
+	{
+		if (pSeg[i] != pTame[i] && pSeg[i] != '?')
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+// Matches pWild against pTame as though pWild were preceded by '*'.  Each
+// segment between '*' wildcards is placed at its leftmost match, found by
+// FindSegment(), which is safe because segments have fixed widths: a later
+// placement never leaves more room for what follows.  The last segment, if
+// the pattern doesn't end with '*', can only sit at the end.
+//
+static bool MatchAfterStar(const char *pWild, const char *pTame)
+{
+	do
+	{
+		while (*pWild == '*')
+		{
+			++pWild;
+		}
+
+		if (!*pWild)
+		{
+			return true;               // "ab*c*" matches "abcd".
+		}
+
+		const char *pSegEnd = pWild;
+
+		while (*pSegEnd && *pSegEnd != '*')
+		{
+			++pSegEnd;
+		}
+
+		size_t cbSeg = (size_t) (pSegEnd - pWild);
+
+		if (!*pSegEnd)
+		{
+			size_t cbTame = strlen(pTame);
+
+			return cbTame >= cbSeg &&  // "*bc" matches "abc".
+			       SegmentMatches(pWild, cbSeg, pTame + cbTame - cbSeg);
+		}
+
+		pTame = FindSegment(pWild, cbSeg, pTame);
+
+		if (!pTame)
+		{
+			return false;              // "*a*b*c" doesn't match "ab".
+		}
+
+		pWild = pSegEnd;
+	} while (true);
+}
+
+
+// Linear-time counterpart of FastWildCompare().  The part of the pattern
+// ahead of the first '*' is compared in place; the rest goes segment by
+// segment.
+//
+extern "C" bool WildLinearCompare(const char *pWild, const char *pTame)
+{
+	while (*pWild != '*')
+	{
+		if (!*pWild)
+		{
+			return !*pTame;            // "abc" matches "abc".
+		}
+
+		if (!*pTame || (*pWild != *pTame && *pWild != '?'))
+		{
+			return false;              // "abc" doesn't match "abd".
+		}
+
+		++pWild;
+		++pTame;
+	}
+
+	return MatchAfterStar(pWild, pTame);
+}
+
+
+// FastWildCompare(), with accounting for the bytes that each fallback
+// throws away.  When they exceed uRatio per byte consumed, plus uSlack,
+// the remainder of the match goes to the linear-time engine.  The hand-off
+// needs no translation beyond the fallback positions themselves: the most
+// recent '*' segment has just failed at pTameSequence, so what remains is
+// that segment, and everything after it, preceded by '*', against the
+// tame string from pTameSequence + 1.
+//
+bool HybridWildCompareEx(const char *pWild, const char *pTame,
+                         uint32_t uRatio, uint32_t uSlack,
+                         bool *pbHandedOff)
+{
+	const char *pTameStart = pTame;
+	const char *pWildSequence;  // Points to prospective wild string match
+	const char *pTameSequence;  // Points to prospective tame string match
+	uint64_t    uDiscarded = 0; // Tame bytes re-scanned due to fallbacks
+
+	if (pbHandedOff)
+	{
+		*pbHandedOff = false;
+	}
+
+	// Find a first wildcard, if one exists, and the beginning of any
+	// prospectively matching sequence after it.
+	do
+	{
+		// Check for the end from the start.  Get out fast, if possible.
+		if (!*pTame)
+		{
+			if (*pWild)
+			{
+				while (*(pWild++) == '*')
+				{
+					if (!(*pWild))
+					{
+						return true;   // "ab" matches "ab*".
+					}
+				}
+
+				return false;          // "abcd" doesn't match "abc".
+			}
+			else
+			{
+				return true;           // "abc" matches "abc".
+			}
+		}
+		else if (*pWild == '*')
+		{
+			// Got wild: set up for the second loop and skip on down there.
+			while (*(++pWild) == '*')
+			{
+				continue;
+			}
+
+			if (!*pWild)
+			{
+				return true;           // "abc*" matches "abcd".
+			}
+
+			// Search for the next prospective match.
+			if (*pWild != '?')
+			{
+				while (*pWild != *pTame)
+				{
+					if (!*(++pTame))
+					{
+						return false;  // "a*bc" doesn't match "ab".
+					}
+				}
+			}
+
+			// Keep fallback positions for retry in case of incomplete match.
+			pWildSequence = pWild;
+			pTameSequence = pTame;
+			break;
+		}
+		else if (*pWild != *pTame && *pWild != '?')
+		{
+			return false;              // "abc" doesn't match "abd".
+		}
+
+		++pWild;                       // Everything's a match, so far.
+		++pTame;
+	} while (true);
+
+	// Find any further wildcards and any further matching sequences.
+	do
+	{
+		if (*pWild == '*')
+		{
+			// Got wild again.
+			while (*(++pWild) == '*')
+			{
+				continue;
+			}
+
+			if (!*pWild)
+			{
+				return true;           // "ab*c*" matches "abcd".
+			}
+
+			if (!*pTame)
+			{
+				return false;          // "*bcd*" doesn't match "abc".
+			}
+
+			// Search for the next prospective match.
+			if (*pWild != '?')
+			{
+				while (*pWild != *pTame)
+				{
+					if (!*(++pTame))
+					{
+						return false;  // "a*b*c" doesn't match "ab".
+					}
+				}
+			}
+
+			// Keep the new fallback positions.
+			pWildSequence = pWild;
+			pTameSequence = pTame;
+		}
+		else if (*pWild != *pTame && *pWild != '?')
+		{
+			// The equivalent portion of the upper loop is really simple.
+			if (!*pTame)
+			{
+				return false;          // "*bcd" doesn't match "abc".
+			}
+
+			// Count what this fallback throws away, and hand off once the
+			// greedy approach stops paying its way.
+			uDiscarded += (uint64_t) (pTame - pTameSequence);
+
+			if (uDiscarded > (uint64_t) uRatio *
+			    (uint64_t) (pTameSequence - pTameStart) + uSlack)
+			{
+				if (pbHandedOff)
+				{
+					*pbHandedOff = true;
+				}
+
+				return MatchAfterStar(pWildSequence, pTameSequence + 1);
+			}
+
+			// A fine time for questions.
+			while (*pWildSequence == '?')
+			{
+				++pWildSequence;
+				++pTameSequence;
+			}
+
+			pWild = pWildSequence;
+
+			// Fall back, but never so far again.
+			while (*pWild != *(++pTameSequence))
+			{
+				if (!*pTameSequence)
+				{
+					return false;      // "*a*b" doesn't match "ac".
+				}
+			}
+
+			pTame = pTameSequence;
+		}
+
+		// Another check for the end, at the end.
+		if (!*pTame)
+		{
+			if (!*pWild)
+			{
+				return true;           // "*bc" matches "abc".
+			}
+			else
+			{
+				return false;          // "*bc" doesn't match "abcd".
+			}
+		}
+
+		++pWild;                       // Everything's still a match.
+		++pTame;
+	} while (true);
+}
+
+
+extern "C" bool HybridWildCompare(char *pWild, char *pTame)
+{
+	return HybridWildCompareEx(pWild, pTame, WILD_HYBRID_RATIO,
+	                           WILD_HYBRID_SLACK, NULL);
+}
+
+
+// Checks the linear-time engine, and the hybrid with a hand-off forced at
+// the first fallback, against FastWildCompare().
+//
+static bool testhybridpair(const char *pTame, const char *pWild)
+{
+	bool bExpected = FastWildCompare(const_cast<char *>(pWild),
+	                                 const_cast<char *>(pTame));
+
+	return WildLinearCompare(pWild, pTame) == bExpected &&
+	       HybridWildCompareEx(pWild, pTame, 0, 0, NULL) == bExpected &&
+	       HybridWildCompare(const_cast<char *>(pWild),
+	                         const_cast<char *>(pTame)) == bExpected;
+}
+
+
+// A set of hybrid and linear-time engine tests.  The testwild() cases
+// exercise the default thresholds through test(); these force hand-offs
+// at every possible fallback, including fallbacks within '?' runs and
+// within segments longer than one 64-bit state word.
+//
+extern "C" int testhybrid(void)
+{
+	static const char *s_rgszPairs[][2] =
+	{
+		{ "caaab", "*a?b" }, { "aaaaa", "*aa?" }, { "abcccd", "*ccd" },
+		{ "mississipissippi", "*issip*ss*" }, { "mississippi", "*sip*" },
+		{ "xyxyxyzyxyz", "xy*z*xyz" }, { "xyxyxyxyz", "xy*xyz" },
+		{ "ababac", "*abac*" }, { "a12b12", "*12*23" },
+		{ "a12b12", "*12*12*" }, { "abcd", "?**?c?" },
+		{ "abcd", "?**?d?" }, { "abcde", "?*b*?*d*?" },
+		{ "aaabbaabbaab", "*aabbaa*a*" }, { "abc", "*????" },
+		{ "abcd", "*??*??" }, { "abcd", "*???*??" }, { "", "*" },
+		{ "", "*?" }, { "a", "*" }, { "aXbXc", "*X?X*" }
+	};
+	bool bAllPassed = true;
+
+	for (size_t i = 0; i < sizeof(s_rgszPairs) / sizeof(s_rgszPairs[0]); ++i)
+	{
+		bAllPassed &= testhybridpair(s_rgszPairs[i][0], s_rgszPairs[i][1]);
+	}
+
+	// Adversarial shapes, short and long.
+	std::string strRun(5000, 'a');
+	std::string strSeg(100, 'a');
+
+	bAllPassed &= testhybridpair(strRun.c_str(), ("*" + strSeg + "b").c_str());
+	bAllPassed &= testhybridpair((strRun + "b").c_str(),
+	                             ("*" + strSeg + "b").c_str());
+	bAllPassed &= testhybridpair((strRun + "b").c_str(),
+	                             ("*" + strSeg + "?").c_str());
+	bAllPassed &= testhybridpair((strRun + "b").c_str(),
+	                             ("*a?" + strSeg + "b*").c_str());
+	bAllPassed &= testhybridpair((strRun + "ba").c_str(),
+	                             ("*" + strSeg + "b*a*b").c_str());
+
+	// Generated cases, with random small alphabets to force fallbacks.
+	WildBenchRandom rng(2025);
+	std::string     strWild, strTame;
+
+	for (int iCase = 0; iCase < 50000; ++iCase)
+	{
+		size_t cbTame = rng.Below(24);
+		size_t cbWild = rng.Below(10);
+
+		strTame.clear();
+		strWild.clear();
+
+		for (size_t i = 0; i < cbTame; ++i)
+		{
+			strTame += (char) ('a' + rng.Below(2));
+		}
+
+		for (size_t i = 0; i < cbWild; ++i)
+		{
+			static const char s_rgchWild[] = "ab*?aa";
+
+			strWild += s_rgchWild[rng.Below(6)];
+		}
+
+		bAllPassed &= testhybridpair(strTame.c_str(), strWild.c_str());
+	}
+
+	if (bAllPassed)
+	{
+		printf("Passed hybrid tests\n");
+	}
+	else
+	{
+		printf("Failed hybrid tests\n");
+	}
+
+	return 0;
+}
+
+
+// Times FastWildCompare(), the linear-time engine and the hybrid on an
+// adversarial corpus (long runs that defeat each fallback) and a normal
+// one (generated path-like patterns and keys).
+//
+extern "C" int benchhybrid(void)
+{
+	struct BenchCorpus
+	{
+		const char              *pszName;
+		std::vector<std::string> rgWild;
+		std::vector<std::string> rgTame;
+		int                      cReps;
+	};
+	BenchCorpus     rgCorpus[2];
+	WildBenchRandom rng(11);
+	std::string     str;
+
+	rgCorpus[0].pszName = "adversarial";
+	rgCorpus[0].cReps = 20;
+
+	for (int cbSeg = 8; cbSeg <= 128; cbSeg *= 2)
+	{
+		std::string strSeg(cbSeg, 'a');
+
+		rgCorpus[0].rgWild.push_back("*" + strSeg + "b");
+		rgCorpus[0].rgWild.push_back("*" + strSeg + "?b*c");
+		rgCorpus[0].rgWild.push_back("x*" + strSeg.substr(1) + "?*b");
+	}
+
+	for (int cbTame = 1000; cbTame <= 16000; cbTame *= 4)
+	{
+		rgCorpus[0].rgTame.push_back(std::string(cbTame, 'a'));
+		rgCorpus[0].rgTame.push_back("x" + std::string(cbTame, 'a') + "bc");
+	}
+
+	rgCorpus[1].pszName = "normal";
+	rgCorpus[1].cReps = 1;
+
+	for (int i = 0; i < 1000; ++i)
+	{
+		WildBenchMakePattern(rng, str);
+		rgCorpus[1].rgWild.push_back(str);
+	}
+
+	for (int i = 0; i < 2000; ++i)
+	{
+		WildBenchMakeKey(rng, str, i % 2 != 0);
+		rgCorpus[1].rgTame.push_back(str);
+	}
+
+	for (int iCorpus = 0; iCorpus < 2; ++iCorpus)
+	{
+		BenchCorpus &corpus = rgCorpus[iCorpus];
+		uint64_t     rgNanos[3] = { 0, 0, 0 };
+		uint64_t     rgWorst[3] = { 0, 0, 0 };
+		uint64_t     rgHits[3] = { 0, 0, 0 };
+
+		for (int iEngine = 0; iEngine < 3; ++iEngine)
+		{
+			for (const std::string &strTame : corpus.rgTame)
+			{
+				for (const std::string &strWild : corpus.rgWild)
+				{
+					char    *pWild = const_cast<char *>(strWild.c_str());
+					char    *pTame = const_cast<char *>(strTame.c_str());
+					uint64_t uStart = WildBenchNanos();
+
+					for (int iRep = 0; iRep < corpus.cReps; ++iRep)
+					{
+						bool bMatch;
+
+						if (iEngine == 0)
+						{
+							bMatch = FastWildCompare(pWild, pTame);
+						}
+						else if (iEngine == 1)
+						{
+							bMatch = WildLinearCompare(pWild, pTame);
+						}
+						else
+						{
+							bMatch = HybridWildCompare(pWild, pTame);
+						}
+
+						rgHits[iEngine] += bMatch;
+					}
+
+					uint64_t uNanos = WildBenchNanos() - uStart;
+
+					rgNanos[iEngine] += uNanos;
+
+					if (uNanos / corpus.cReps > rgWorst[iEngine])
+					{
+						rgWorst[iEngine] = uNanos / corpus.cReps;
+					}
+				}
+			}
+		}
+
+		double dCalls = (double) corpus.rgTame.size() * corpus.rgWild.size() *
+		                corpus.cReps;
+
+		printf("Hybrid, %s corpus: "
+		       "FastWildCompare %.1f ns/match (worst %.1f us), "
+		       "linear %.1f ns/match (worst %.1f us), "
+		       "hybrid %.1f ns/match (worst %.1f us)%s\n",
+		       corpus.pszName,
+		       rgNanos[0] / dCalls, rgWorst[0] / 1000.0,
+		       rgNanos[1] / dCalls, rgWorst[1] / 1000.0,
+		       rgNanos[2] / dCalls, rgWorst[2] / 1000.0,
+		       rgHits[0] == rgHits[1] && rgHits[0] == rgHits[2] ?
+		           "" : " (RESULTS DIFFER)");
+	}
+
+	return 0;
+}
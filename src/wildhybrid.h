@@ -0,0 +1,52 @@
+// HybridWildCompare(), a FastWildCompare() with bounded worst-case latency
+//
+// Copyright 2025 Kirk J Krauss.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// FastWildCompare() falls back whenever a prospective match after a '*'
+// turns out to be incomplete.  For most inputs that costs little, but
+// inputs like "*aaaaaaaab" against a long run of 'a' make each fallback
+// re-scan nearly a whole segment.  HybridWildCompare() runs the same
+// greedy algorithm while counting the bytes that fallbacks discard.  Once
+// that count gets out of proportion to the bytes consumed for good, it
+// hands the rest of the match to WildLinearCompare(), whose bit-parallel
+// segment search takes time linear in the tame string's length.
+//
+#ifndef WILDHYBRID_H
+#define WILDHYBRID_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define WILD_HYBRID_RATIO    4    // Discarded bytes allowed per byte consumed
+#define WILD_HYBRID_SLACK    64   // Discarded bytes allowed up front
+
+// Linear-time matching of NUL-terminated strings.  Same results as
+// FastWildCompare().
+extern "C" bool WildLinearCompare(const char *pWild, const char *pTame);
+
+// Greedy matching with a hand-off to WildLinearCompare() when fallbacks
+// explode.  Same results as FastWildCompare().
+extern "C" bool HybridWildCompare(char *pWild, char *pTame);
+
+// As above, with explicit thresholds, and reporting whether the match was
+// handed off.
+bool HybridWildCompareEx(const char *pWild, const char *pTame,
+                         uint32_t uRatio, uint32_t uSlack,
+                         bool *pbHandedOff);
+
+extern "C" int testhybrid(void);
+extern "C" int benchhybrid(void);
+
+#endif  // WILDHYBRID_H
@@ -0,0 +1,783 @@
+// WildLikePattern, and related code
+//
+// Copyright 2025 Kirk J Krauss.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// This file provides the LIKE front end, its shape-specialized matchers,
+// and column evaluation.  It also includes testcases for correctness and
+// performance.
+//
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define WILD_HAVE_AVX2_TARGET  1
+#endif
+
+#include "fastwildcompare.h"
+#include "wildlike.h"
+#include "wildbench.h"
+
+#define WILD_LIKE_BLOCK_ROWS   4096   // Rows per MatchColumn() pass
+
+
+static inline uint8_t LikeFold(uint8_t ch)
+{
+	return (uint8_t) (ch - 'A') < 26 ? (uint8_t) (ch + 32) : ch;
+}
+
+
+// Compares n tame bytes with literal bytes, which are already lowercase
+// when bFold is set.
+//
+static inline bool LikeLiteralsMatch(const uint8_t *pTame,
+                                     const uint8_t *pLit, size_t n,
+                                     bool bFold)
+{
+	if (!bFold)
+	{
+		return !memcmp(pTame, pLit, n);
+	}
+
+	for (size_t i = 0; i < n; ++i)
+	{
+		if (LikeFold(pTame[i]) != pLit[i])
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+// Finds the leftmost place in [p, pEnd) where all n literal bytes appear.
+// Returns NULL if there is none.
+//
+static const uint8_t *FindLiteralScalar(const uint8_t *p,
+                                        const uint8_t *pEnd,
+                                        const uint8_t *pLit, size_t n,
+                                        bool bFold)
+{
+	if ((size_t) (pEnd - p) < n)
+	{
+		return NULL;
+	}
+
+	const uint8_t *pLast = pEnd - n;
+
+	while (p <= pLast)
+	{
+		if (!bFold)
+		{
+			p = (const uint8_t *) memchr(p, pLit[0], (size_t) (pLast - p) + 1);
+
+			if (!p)
+			{
+				return NULL;
+			}
+		}
+		else if (LikeFold(*p) != pLit[0])
+		{
+			++p;
+			continue;
+		}
+
+		if (LikeLiteralsMatch(p + 1, pLit + 1, n - 1, bFold))
+		{
+			return p;
+		}
+
+		++p;
+	}
+
+	return NULL;
+}
+
+
+#if defined(WILD_HAVE_AVX2_TARGET)
+// Tests 32 starting places at a time: those whose first byte matches the
+// literal's first byte and whose n-th byte matches its last byte are
+// candidates, and only those are compared in full.  For ILIKE, each end
+// byte matches either case.  Stops where fewer than n + 31 bytes remain,
+// leaving p for the scalar search to pick up.
+//
+__attribute__((target("avx2")))
+static const uint8_t *FindLiteralAvx2(const uint8_t *&p, const uint8_t *pEnd,
+                                      const uint8_t *pLit, size_t n,
+                                      bool bFold)
+{
+	uint8_t chFirst = pLit[0], chLast = pLit[n - 1];
+	__m256i vFirst = _mm256_set1_epi8((char) chFirst);
+	__m256i vLast = _mm256_set1_epi8((char) chLast);
+	__m256i vFirstAlt = vFirst, vLastAlt = vLast;
+
+	if (bFold && chFirst >= 'a' && chFirst <= 'z')
+	{
+		vFirstAlt = _mm256_set1_epi8((char) (chFirst - 32));
+	}
+
+	if (bFold && chLast >= 'a' && chLast <= 'z')
+	{
+		vLastAlt = _mm256_set1_epi8((char) (chLast - 32));
+	}
+
+	while ((size_t) (pEnd - p) >= n + 31)
+	{
+		__m256i  vHead = _mm256_loadu_si256((const __m256i *) p);
+		__m256i  vTail = _mm256_loadu_si256((const __m256i *) (p + n - 1));
+		__m256i  vCandidates = _mm256_and_si256(
+		    _mm256_or_si256(_mm256_cmpeq_epi8(vHead, vFirst),
+		                    _mm256_cmpeq_epi8(vHead, vFirstAlt)),
+		    _mm256_or_si256(_mm256_cmpeq_epi8(vTail, vLast),
+		                    _mm256_cmpeq_epi8(vTail, vLastAlt)));
+		uint32_t uMask = (uint32_t) _mm256_movemask_epi8(vCandidates);
+
+		while (uMask)
+		{
+			const uint8_t *pCandidate = p + __builtin_ctz(uMask);
+
+			if (LikeLiteralsMatch(pCandidate, pLit, n, bFold))
+			{
+				return pCandidate;
+			}
+
+			uMask &= uMask - 1;
+		}
+
+		p += 32;
+	}
+
+	return NULL;
+}
+#endif  // defined(WILD_HAVE_AVX2_TARGET)
+
+
+static const uint8_t *FindLiteral(const uint8_t *p, const uint8_t *pEnd,
+                                  const uint8_t *pLit, size_t n, bool bFold)
+{
+#if defined(WILD_HAVE_AVX2_TARGET)
+	static const bool s_bAvx2 = __builtin_cpu_supports("avx2");
+
+	if (s_bAvx2)
+	{
+		const uint8_t *pFound = FindLiteralAvx2(p, pEnd, pLit, n, bFold);
+
+		if (pFound)
+		{
+			return pFound;
+		}
+	}
+#endif
+
+	return FindLiteralScalar(p, pEnd, pLit, n, bFold);
+}
+
+
+WildLikePattern::WildLikePattern(std::pmr::memory_resource *pResource) :
+    m_program(pResource), m_strLit(pResource), m_shape(WILD_LIKE_NONE),
+    m_bFold(false)
+{
+}
+
+
+// Reads the pattern once, writing the bytecode translation and a shape
+// string in which each run of literals is 'L', each run of '%' is '%' and
+// each '_' is '_'.  The shape string picks the matcher.
+//
+bool WildLikePattern::Compile(const char *pLike, char chEscape,
+                              bool bCaseInsensitive)
+{
+	std::pmr::string strProgram(Resource()), strShape(Resource());
+
+	m_shape = WILD_LIKE_NONE;
+	m_bFold = bCaseInsensitive;
+	m_strLit.clear();
+
+	for (const char *p = pLike; *p; ++p)
+	{
+		if (chEscape && *p == chEscape)
+		{
+			if (!*++p)
+			{
+				return false;
+			}
+		}
+		else if (*p == '%')
+		{
+			if (strShape.empty() || strShape.back() != '%')
+			{
+				strProgram += '*';
+				strShape += '%';
+			}
+
+			continue;
+		}
+		else if (*p == '_')
+		{
+			strProgram += '?';
+			strShape += '_';
+			continue;
+		}
+
+		// A literal byte.
+		if (*p == '*' || *p == '?' || *p == '\\')
+		{
+			strProgram += '\\';
+		}
+
+		strProgram += *p;
+		m_strLit += m_bFold ? (char) LikeFold((uint8_t) *p) : *p;
+
+		if (strShape.empty() || strShape.back() != 'L')
+		{
+			strShape += 'L';
+		}
+	}
+
+	if (strShape.empty() || strShape == "L")
+	{
+		m_shape = WILD_LIKE_EXACT;
+	}
+	else if (strShape == "%")
+	{
+		m_shape = WILD_LIKE_ALL;
+	}
+	else if (strShape == "L%")
+	{
+		m_shape = WILD_LIKE_PREFIX;
+	}
+	else if (strShape == "%L")
+	{
+		m_shape = WILD_LIKE_SUFFIX;
+	}
+	else if (strShape == "%L%")
+	{
+		m_shape = WILD_LIKE_CONTAINS;
+	}
+	else if (m_program.Compile(strProgram.c_str(), WILD_FLAG_ESCAPES |
+	                           (m_bFold ? WILD_FLAG_CASEFOLD : 0)))
+	{
+		m_shape = WILD_LIKE_GENERAL;
+	}
+	else
+	{
+		return false;
+	}
+
+	return true;
+}
+
+
+bool WildLikePattern::Match(const char *pTame, size_t cbTame) const
+{
+	const uint8_t *p = (const uint8_t *) pTame;
+	const uint8_t *pLit = (const uint8_t *) m_strLit.data();
+	size_t         n = m_strLit.size();
+
+	switch (m_shape)
+	{
+	case WILD_LIKE_ALL:
+		return true;
+
+	case WILD_LIKE_EXACT:
+		return cbTame == n && LikeLiteralsMatch(p, pLit, n, m_bFold);
+
+	case WILD_LIKE_PREFIX:
+		return cbTame >= n && LikeLiteralsMatch(p, pLit, n, m_bFold);
+
+	case WILD_LIKE_SUFFIX:
+		return cbTame >= n &&
+		       LikeLiteralsMatch(p + cbTame - n, pLit, n, m_bFold);
+
+	case WILD_LIKE_CONTAINS:
+		return FindLiteral(p, p + cbTame, pLit, n, m_bFold) != NULL;
+
+	case WILD_LIKE_GENERAL:
+		return m_program.Match(pTame, cbTame);
+
+	default:
+		return false;
+	}
+}
+
+
+// Searches the bytes of cRows consecutive rows as one string.  Each
+// occurrence that lies within a single row marks that row, and the search
+// resumes at the next row.  One that straddles rows is skipped.
+//
+size_t WildLikePattern::SearchColumn(const char *pBytes,
+                                     const uint32_t *rgOffsets, size_t cRows,
+                                     uint64_t *rgWords) const
+{
+	const uint8_t *pBase = (const uint8_t *) pBytes;
+	const uint8_t *p = pBase + rgOffsets[0];
+	const uint8_t *pEnd = pBase + rgOffsets[cRows];
+	const uint8_t *pLit = (const uint8_t *) m_strLit.data();
+	size_t         n = m_strLit.size();
+	size_t         iRow = 0, cHits = 0;
+
+	while ((p = FindLiteral(p, pEnd, pLit, n, m_bFold)) != NULL)
+	{
+		size_t iPos = (size_t) (p - pBase);
+
+		while (rgOffsets[iRow + 1] <= iPos)
+		{
+			++iRow;
+		}
+
+		if (iPos + n > rgOffsets[iRow + 1])
+		{
+			++p;
+			continue;
+		}
+
+		rgWords[iRow / 64] |= 1ull << (iRow % 64);
+		++cHits;
+
+		if (++iRow == cRows)
+		{
+			break;
+		}
+
+		p = pBase + rgOffsets[iRow];
+	}
+
+	return cHits;
+}
+
+
+size_t WildLikePattern::MatchColumn(const char *pBytes,
+                                    const uint32_t *rgOffsets, size_t cRows,
+                                    const uint8_t *pValidity,
+                                    uint8_t *rgResultBits) const
+{
+	uint64_t rgWords[WILD_LIKE_BLOCK_ROWS / 64];
+	size_t   cHits = 0;
+
+	for (size_t iBlock = 0; iBlock < cRows; iBlock += WILD_LIKE_BLOCK_ROWS)
+	{
+		size_t cBlockRows = cRows - iBlock < WILD_LIKE_BLOCK_ROWS ?
+		                    cRows - iBlock : WILD_LIKE_BLOCK_ROWS;
+		size_t cBlockBytes = (cBlockRows + 7) / 8;
+
+		memset(rgWords, 0, sizeof(rgWords));
+
+		if (m_shape == WILD_LIKE_CONTAINS)
+		{
+			SearchColumn(pBytes, rgOffsets + iBlock, cBlockRows, rgWords);
+		}
+		else if (m_shape != WILD_LIKE_NONE)
+		{
+			for (size_t iRow = 0; iRow < cBlockRows; ++iRow)
+			{
+				uint32_t uBegin = rgOffsets[iBlock + iRow];
+				uint32_t uEnd = rgOffsets[iBlock + iRow + 1];
+
+				if (Match(pBytes + uBegin, uEnd - uBegin))
+				{
+					rgWords[iRow / 64] |= 1ull << (iRow % 64);
+				}
+			}
+		}
+
+		// Rows are a multiple of 8 into the column at each block, so the
+		// block's bits start on a byte boundary.
+		uint8_t *pOut = rgResultBits + iBlock / 8;
+
+		for (size_t iByte = 0; iByte < cBlockBytes; ++iByte)
+		{
+			uint8_t bBits = (uint8_t) (rgWords[iByte / 8] >> (iByte % 8 * 8));
+
+			if (pValidity)
+			{
+				bBits &= pValidity[iBlock / 8 + iByte];
+			}
+
+			cHits += __builtin_popcount(bBits);
+
+			if (iByte == cBlockBytes - 1 && cBlockRows % 8)
+			{
+				// Leave the bits past the last row alone.
+				uint8_t bKeep = (uint8_t) (0xFF << (cBlockRows % 8));
+
+				bBits = (uint8_t) ((pOut[iByte] & bKeep) | bBits);
+			}
+
+			pOut[iByte] = bBits;
+		}
+	}
+
+	return cHits;
+}
+
+
+// A plain recursive LIKE matcher, for checking the others against.
+//
+static bool ReferenceLike(const char *pLike, const char *pTame,
+                          char chEscape, bool bFold)
+{
+	while (*pLike)
+	{
+		if (*pLike == '%' && !(chEscape && *pLike == chEscape))
+		{
+			do
+			{
+				if (ReferenceLike(pLike + 1, pTame, chEscape, bFold))
+				{
+					return true;
+				}
+			} while (*pTame++);
+
+			return false;
+		}
+
+		if (!*pTame)
+		{
+			return false;
+		}
+
+		if (*pLike == '_' && !(chEscape && *pLike == chEscape))
+		{
+			++pLike;
+			++pTame;
+			continue;
+		}
+
+		if (chEscape && *pLike == chEscape)
+		{
+			++pLike;
+		}
+
+		if (bFold ? LikeFold((uint8_t) *pLike) != LikeFold((uint8_t) *pTame) :
+		            *pLike != *pTame)
+		{
+			return false;
+		}
+
+		++pLike;
+		++pTame;
+	}
+
+	return !*pTame;
+}
+
+
+// A set of LIKE tests: shapes, escapes, random patterns against the
+// reference matcher, and column evaluation against row-by-row matching,
+// with NULL rows and rows long enough for the vector search.
+//
+extern "C" int testlike(void)
+{
+	static const struct
+	{
+		const char   *pszLike;
+		char          chEscape;
+		WildLikeShape shape;
+	}
+	s_rgShapes[] =
+	{
+		{ "", '\0', WILD_LIKE_EXACT },
+		{ "abc", '\0', WILD_LIKE_EXACT },
+		{ "%%", '\0', WILD_LIKE_ALL },
+		{ "abc%%", '\0', WILD_LIKE_PREFIX },
+		{ "%abc", '\0', WILD_LIKE_SUFFIX },
+		{ "%a!%c%", '!', WILD_LIKE_CONTAINS },
+		{ "%a%c%", '!', WILD_LIKE_GENERAL },
+		{ "a_c", '\0', WILD_LIKE_GENERAL },
+		{ "a!_c", '!', WILD_LIKE_EXACT },
+		{ "ab!", '!', WILD_LIKE_NONE }
+	};
+	WildLikePattern like;
+	bool            bAllPassed = true;
+
+	for (const auto &test : s_rgShapes)
+	{
+		like.Compile(test.pszLike, test.chEscape);
+		bAllPassed &= like.Shape() == test.shape;
+	}
+
+	bAllPassed &= like.Compile("a*b?\\", '\0') && like.Match("a*b?\\") &&
+	              !like.Match("axbc\\");
+	bAllPassed &= like.Compile("_%%", '%') && like.Match("x%") &&
+	              !like.Match("x");
+
+	// Random patterns.  The escape character varies, including '%'.
+	static const char s_szLikeChars[] = "aAb%_!\\";
+	static const char s_szTameChars[] = "aAbB%_!\\";
+	static const char s_rgchEscapes[] = { '\0', '!', '\\', '%' };
+	WildBenchRandom   rng(808);
+
+	for (int iRound = 0; iRound < 200000; ++iRound)
+	{
+		std::string strLike, strTame;
+		size_t      cchLike = rng.Below(8);
+		size_t      cchTame = rng.Below(iRound % 4 ? 10 : 90);
+		char        chEscape = s_rgchEscapes[rng.Below(4)];
+		bool        bFold = rng.Below(2);
+
+		for (size_t i = 0; i < cchLike; ++i)
+		{
+			strLike += s_szLikeChars[rng.Below(sizeof(s_szLikeChars) - 1)];
+		}
+
+		for (size_t i = 0; i < cchTame; ++i)
+		{
+			strTame += s_szTameChars[rng.Below(sizeof(s_szTameChars) - 1)];
+		}
+
+		if (!like.Compile(strLike.c_str(), chEscape, bFold))
+		{
+			bAllPassed &= like.Shape() == WILD_LIKE_NONE;
+			continue;
+		}
+
+		if (like.Match(strTame.data(), strTame.size()) !=
+		    ReferenceLike(strLike.c_str(), strTame.c_str(), chEscape, bFold))
+		{
+			printf("'%s' LIKE '%s' ESCAPE '%c'%s\n", strTame.c_str(),
+			       strLike.c_str(), chEscape, bFold ? " (ILIKE)" : "");
+			bAllPassed = false;
+		}
+	}
+
+	// Columns, with a block boundary and a partial last byte.
+	const size_t          cRows = 10003;
+	std::string           strBytes;
+	std::vector<uint32_t> rgOffsets(1, 0);
+	std::vector<uint8_t>  rgValidity((cRows + 7) / 8), rgResult(cRows / 8 + 2);
+	static const char    *s_rgszLikes[] =
+	{
+		"%ab%", "%AB%", "%aab_%", "a%", "%b", "ab", "%", "%a_b%a%"
+	};
+
+	for (size_t iRow = 0; iRow < cRows; ++iRow)
+	{
+		size_t cch = rng.Below(iRow % 8 ? 6 : 70);
+
+		for (size_t i = 0; i < cch; ++i)
+		{
+			strBytes += "abAB"[rng.Below(4)];
+		}
+
+		rgOffsets.push_back((uint32_t) strBytes.size());
+
+		if (rng.Below(10))
+		{
+			rgValidity[iRow / 8] |= (uint8_t) (1 << (iRow % 8));
+		}
+	}
+
+	for (const char *pszLike : s_rgszLikes)
+	{
+		for (int iFold = 0; iFold < 2; ++iFold)
+		{
+			size_t cExpected = 0;
+
+			like.Compile(pszLike, '\0', iFold != 0);
+			rgResult.back() = 0xA5;
+
+			size_t cHits = like.MatchColumn(strBytes.data(), rgOffsets.data(),
+			                                cRows, rgValidity.data(),
+			                                rgResult.data());
+
+			for (size_t iRow = 0; iRow < cRows; ++iRow)
+			{
+				bool bExpected = (rgValidity[iRow / 8] >> (iRow % 8) & 1) &&
+				                 like.Match(strBytes.data() + rgOffsets[iRow],
+				                     rgOffsets[iRow + 1] - rgOffsets[iRow]);
+
+				cExpected += bExpected;
+				bAllPassed &= ((rgResult[iRow / 8] >> (iRow % 8) & 1) != 0) ==
+				              bExpected;
+			}
+
+			bAllPassed &= cHits == cExpected && rgResult.back() == 0xA5;
+		}
+	}
+
+	if (bAllPassed)
+	{
+		printf("Passed LIKE tests\n");
+	}
+	else
+	{
+		printf("Failed LIKE tests\n");
+	}
+
+	return 0;
+}
+
+
+// Makes a TPC-H-style p_name: five distinct words from the 92 colors that
+// dbgen uses, separated by spaces.
+//
+static void MakePartName(WildBenchRandom &rng, std::string &strName)
+{
+	static const char *s_rgszColors[] =
+	{
+		"almond", "antique", "aquamarine", "azure", "beige", "bisque",
+		"black", "blanched", "blue", "blush", "brown", "burlywood",
+		"burnished", "chartreuse", "chiffon", "chocolate", "coral",
+		"cornflower", "cornsilk", "cream", "cyan", "dark", "deep", "dim",
+		"dodger", "drab", "firebrick", "floral", "forest", "frosted",
+		"gainsboro", "ghost", "goldenrod", "green", "grey", "honeydew",
+		"hot", "indian", "ivory", "khaki", "lace", "lavender", "lawn",
+		"lemon", "light", "lime", "linen", "magenta", "maroon", "medium",
+		"metallic", "midnight", "mint", "misty", "moccasin", "navajo",
+		"navy", "olive", "orange", "orchid", "pale", "papaya", "peach",
+		"peru", "pink", "plum", "powder", "puff", "purple", "red", "rose",
+		"rosy", "royal", "saddle", "salmon", "sandy", "seashell", "sienna",
+		"sky", "slate", "smoke", "snow", "spring", "steel", "tan",
+		"thistle", "tomato", "turquoise", "violet", "wheat", "white",
+		"yellow"
+	};
+	uint32_t rgiWord[5];
+
+	strName.clear();
+
+	for (int i = 0; i < 5; ++i)
+	{
+		bool bRepeat;
+
+		do
+		{
+			rgiWord[i] = rng.Below(92);
+			bRepeat = false;
+
+			for (int j = 0; j < i; ++j)
+			{
+				bRepeat |= rgiWord[j] == rgiWord[i];
+			}
+		} while (bRepeat);
+
+		if (i)
+		{
+			strName += ' ';
+		}
+
+		strName += s_rgszColors[rgiWord[i]];
+	}
+}
+
+
+// Measures rows per second for TPC-H-style p_name predicates, as a row
+// loop over FastWildCompare() on terminated copies, as a row loop over
+// plain bytecode, and as one MatchColumn() call.
+//
+extern "C" int benchlike(void)
+{
+	const size_t          cRows = 1000000;
+	const int             cPasses = 5;
+	WildBenchRandom       rng(88);
+	std::string           strBytes, strName;
+	std::vector<uint32_t> rgOffsets(1, 0);
+	std::vector<uint8_t>  rgValidity((cRows + 7) / 8, 0xFF);
+	std::vector<uint8_t>  rgResult((cRows + 7) / 8);
+
+	for (size_t iRow = 0; iRow < cRows; ++iRow)
+	{
+		MakePartName(rng, strName);
+		strBytes += strName;
+		rgOffsets.push_back((uint32_t) strBytes.size());
+	}
+
+	static const struct
+	{
+		const char *pszLike;
+		const char *pszWild;   // The same predicate for FastWildCompare()
+		bool        bFold;
+	}
+	s_rgPredicates[] =
+	{
+		{ "%green%", "*green*", false },
+		{ "forest%", "forest*", false },
+		{ "%chocolate", "*chocolate", false },
+		{ "%green%blue%", "*green*blue*", false },
+		{ "%GREEN%", "*green*", true }
+	};
+
+	printf("LIKE, %zu TPC-H p_name rows (%.1f bytes each), Mrows/s:\n",
+	       cRows, (double) strBytes.size() / cRows);
+
+	for (const auto &predicate : s_rgPredicates)
+	{
+		WildLikePattern like;
+		WildProgram     program;
+		std::string     strRow;
+		size_t          cHitsFwc = 0, cHitsProgram = 0, cHitsColumn = 0;
+		uint64_t        uStart;
+
+		like.Compile(predicate.pszLike, '\0', predicate.bFold);
+		program.Compile(predicate.pszWild,
+		                predicate.bFold ? WILD_FLAG_CASEFOLD : 0);
+
+		uStart = WildBenchNanos();
+
+		for (int iPass = 0; iPass < cPasses; ++iPass)
+		{
+			for (size_t iRow = 0; iRow < cRows; ++iRow)
+			{
+				strRow.assign(strBytes, rgOffsets[iRow],
+				              rgOffsets[iRow + 1] - rgOffsets[iRow]);
+				cHitsFwc += FastWildCompare(
+				    const_cast<char *>(predicate.pszWild),
+				    const_cast<char *>(strRow.c_str()));
+			}
+		}
+
+		double dFwcNanos = (double) (WildBenchNanos() - uStart);
+
+		uStart = WildBenchNanos();
+
+		for (int iPass = 0; iPass < cPasses; ++iPass)
+		{
+			for (size_t iRow = 0; iRow < cRows; ++iRow)
+			{
+				cHitsProgram += program.Match(
+				    strBytes.data() + rgOffsets[iRow],
+				    rgOffsets[iRow + 1] - rgOffsets[iRow]);
+			}
+		}
+
+		double dProgramNanos = (double) (WildBenchNanos() - uStart);
+
+		uStart = WildBenchNanos();
+
+		for (int iPass = 0; iPass < cPasses; ++iPass)
+		{
+			cHitsColumn += like.MatchColumn(strBytes.data(), rgOffsets.data(),
+			                                cRows, rgValidity.data(),
+			                                rgResult.data());
+		}
+
+		double dColumnNanos = (double) (WildBenchNanos() - uStart);
+		double cMatches = (double) cRows * cPasses * 1000.0;
+
+		// The generated names are all lowercase, so FastWildCompare() needs
+		// no folding to agree with ILIKE here.
+		printf("  %-14s %s: rows %.1f, bytecode rows %.1f, "
+		       "column %.1f (%.2f%% match)%s\n", predicate.pszLike,
+		       predicate.bFold ? "ILIKE" : " LIKE", cMatches / dFwcNanos,
+		       cMatches / dProgramNanos, cMatches / dColumnNanos,
+		       100.0 * cHitsColumn / cPasses / cRows,
+		       cHitsFwc == cHitsColumn && cHitsProgram == cHitsColumn ?
+		       "" : " (RESULTS DIFFER)");
+	}
+
+	return 0;
+}
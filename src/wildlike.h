@@ -0,0 +1,107 @@
+// WildLikePattern, a SQL LIKE / ILIKE predicate compiled for columnar
+// evaluation
+//
+// Copyright 2025 Kirk J Krauss.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// In LIKE, '%' matches any run of bytes and '_' matches one byte.  An
+// ESCAPE character makes the character after it literal.  ILIKE folds
+// ASCII letters; other bytes, including UTF-8 sequences, compare exactly,
+// and '_' matches one byte rather than one code point.
+//
+// Most predicates in real queries take one of a few shapes: 'abc',
+// 'abc%', '%abc' or '%abc%'.  Those are matched with compares and a
+// literal search, which has an AVX2 path.  Any other pattern is
+// translated into WildProgram bytecode.  A column of strings stored back
+// to back, as in Arrow, is evaluated in one call.  For the '%abc%' shape,
+// that call searches the column's bytes as a whole rather than row by row,
+// since rows are usually shorter than a vector.
+//
+#ifndef WILDLIKE_H
+#define WILDLIKE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <memory_resource>
+#include <string>
+
+#include "wildbytecode.h"
+
+enum WildLikeShape
+{
+	WILD_LIKE_NONE,       // Matches nothing
+	WILD_LIKE_ALL,        // '%'
+	WILD_LIKE_EXACT,      // 'abc'
+	WILD_LIKE_PREFIX,     // 'abc%'
+	WILD_LIKE_SUFFIX,     // '%abc'
+	WILD_LIKE_CONTAINS,   // '%abc%'
+	WILD_LIKE_GENERAL     // Anything else, run as bytecode
+};
+
+class WildLikePattern
+{
+public:
+	explicit WildLikePattern(std::pmr::memory_resource *pResource =
+	                         std::pmr::get_default_resource());
+
+	// Compiles a LIKE pattern.  chEscape is the ESCAPE character, or '\0'
+	// for none.  Returns false if the pattern ends in an escape character,
+	// which SQL treats as an error, or is too long for the bytecode; either
+	// way, the pattern then matches nothing.
+	bool Compile(const char *pLike, char chEscape = '\0',
+	             bool bCaseInsensitive = false);
+
+	// Matches a string of cbTame bytes, which need not be terminated.
+	bool Match(const char *pTame, size_t cbTame) const;
+
+	bool Match(const char *pTame) const
+	{
+		return Match(pTame, strlen(pTame));
+	}
+
+	// Evaluates a column of cRows strings: row i is bytes rgOffsets[i] up
+	// to rgOffsets[i + 1] of pBytes.  pValidity, if not NULL, has a bit per
+	// row, least significant first, set for rows that aren't NULL.  Sets
+	// the same bits of rgResultBits for rows that match, clearing those of
+	// rows that don't match or are NULL, as a WHERE clause would.  Returns
+	// the number of matching rows.
+	size_t MatchColumn(const char *pBytes, const uint32_t *rgOffsets,
+	                   size_t cRows, const uint8_t *pValidity,
+	                   uint8_t *rgResultBits) const;
+
+	WildLikeShape Shape() const
+	{
+		return m_shape;
+	}
+
+	std::pmr::memory_resource *Resource() const
+	{
+		return m_strLit.get_allocator().resource();
+	}
+
+private:
+	size_t SearchColumn(const char *pBytes, const uint32_t *rgOffsets,
+	                    size_t cRows, uint64_t *rgWords) const;
+
+	WildProgram      m_program;   // For WILD_LIKE_GENERAL
+	std::pmr::string m_strLit;    // The literal, lowercased for ILIKE
+	WildLikeShape    m_shape;
+	bool             m_bFold;
+};
+
+extern "C" int testlike(void);
+extern "C" int benchlike(void);
+
+#endif  // WILDLIKE_H
@@ -0,0 +1,610 @@
+// WildPackedPattern, and related code
+//
+// Copyright 2025 Kirk J Krauss.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// This file provides packing, unpacking, and matching of packed keys.  It
+// also includes testcases for correctness and performance.
+//
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "fastwildcompare.h"
+#include "wildpacked.h"
+#include "wildbench.h"
+
+static const char *s_rgszAlphabets[] =
+{
+	"0123456789abcdef",
+	"abcdefghijklmnopqrstuvwxyz234567"
+};
+
+static const unsigned s_rguBits[] = { 4, 5 };
+
+// Symbols per chunk: as many as fit in 57 bits, so that a chunk starting
+// at any bit of a byte fits in one 64-bit load.
+static const unsigned s_rgcChunkSymbols[] = { 14, 11 };
+
+
+// Symbol values by character, per alphabet, with -1 for characters
+// outside it.  Letters of either case map to the same symbol.
+//
+struct WildPackedTables
+{
+	int8_t rg[2][256];
+
+	WildPackedTables()
+	{
+		memset(rg, -1, sizeof(rg));
+
+		for (int iAlphabet = 0; iAlphabet < 2; ++iAlphabet)
+		{
+			const char *pszSymbols = s_rgszAlphabets[iAlphabet];
+
+			for (int iSymbol = 0; pszSymbols[iSymbol]; ++iSymbol)
+			{
+				uint8_t ch = (uint8_t) pszSymbols[iSymbol];
+
+				rg[iAlphabet][ch] = (int8_t) iSymbol;
+
+				if (ch >= 'a' && ch <= 'z')
+				{
+					rg[iAlphabet][ch - ('a' - 'A')] = (int8_t) iSymbol;
+				}
+			}
+		}
+	}
+};
+
+static const WildPackedTables s_tables;
+
+
+// Loads 64 bits starting at bit uBit of a packed key, reading no further
+// than cbPacked bytes in.  Bits past the end read as zero.
+//
+static inline uint64_t LoadBits(const uint8_t *pPacked, size_t cbPacked,
+                                size_t uBit)
+{
+	size_t   iByte = uBit >> 3;
+	uint64_t u = 0;
+
+	if (iByte + 8 <= cbPacked)
+	{
+		memcpy(&u, pPacked + iByte, 8);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+		u = __builtin_bswap64(u);
+#endif
+	}
+	else
+	{
+		for (size_t i = 0; iByte + i < cbPacked; ++i)
+		{
+			u |= (uint64_t) pPacked[iByte + i] << (8 * i);
+		}
+	}
+
+	return u >> (uBit & 7);
+}
+
+
+size_t WildPackedBytes(WildPackedAlphabet alphabet, size_t cSymbols)
+{
+	return (cSymbols * s_rguBits[alphabet] + 7) / 8;
+}
+
+
+bool WildPack(WildPackedAlphabet alphabet, const char *pText, size_t cch,
+              uint8_t *pPacked)
+{
+	unsigned uBits = s_rguBits[alphabet];
+
+	memset(pPacked, 0, WildPackedBytes(alphabet, cch));
+
+	for (size_t i = 0; i < cch; ++i)
+	{
+		int    iSymbol = s_tables.rg[alphabet][(uint8_t) pText[i]];
+		size_t uBit = i * uBits;
+
+		if (iSymbol < 0)
+		{
+			return false;
+		}
+
+		// A symbol may straddle two bytes.
+		pPacked[uBit >> 3] |= (uint8_t) (iSymbol << (uBit & 7));
+
+		if ((uBit & 7) + uBits > 8)
+		{
+			pPacked[(uBit >> 3) + 1] |= (uint8_t) (iSymbol >> (8 - (uBit & 7)));
+		}
+	}
+
+	return true;
+}
+
+
+void WildUnpack(WildPackedAlphabet alphabet, const uint8_t *pPacked,
+                size_t cSymbols, char *pText)
+{
+	unsigned    uBits = s_rguBits[alphabet];
+	unsigned    uMask = (1u << uBits) - 1;
+	const char *pszSymbols = s_rgszAlphabets[alphabet];
+	uint32_t    uAccum = 0;
+	unsigned    cAccum = 0;
+
+	for (size_t i = 0; i < cSymbols; ++i)
+	{
+		if (cAccum < uBits)
+		{
+			uAccum |= (uint32_t) *pPacked++ << cAccum;
+			cAccum += 8;
+		}
+
+		pText[i] = pszSymbols[uAccum & uMask];
+		uAccum >>= uBits;
+		cAccum -= uBits;
+	}
+}
+
+
+WildPackedPattern::WildPackedPattern(std::pmr::memory_resource *pResource) :
+    m_rgValue(pResource), m_rgMask(pResource), m_rgRuns(pResource),
+    m_rgProbes(pResource), m_uLowBits(0), m_uTopBits(0), m_uBits(4),
+    m_cChunkSymbols(14), m_alphabet(WILD_PACKED_HEX), m_bStar(false),
+    m_bNever(true)
+{
+}
+
+
+bool WildPackedPattern::Compile(const char *pWild, WildPackedAlphabet alphabet)
+{
+	m_rgValue.clear();
+	m_rgMask.clear();
+	m_rgRuns.clear();
+	m_rgProbes.clear();
+	m_uBits = s_rguBits[alphabet];
+	m_cChunkSymbols = s_rgcChunkSymbols[alphabet];
+	m_alphabet = alphabet;
+	m_bStar = false;
+	m_bNever = true;
+	m_uLowBits = m_uTopBits = 0;
+
+	for (unsigned i = 0; i + m_uBits <= 64; i += m_uBits)
+	{
+		m_uLowBits |= (uint64_t) ((1u << (m_uBits - 1)) - 1) << i;
+		m_uTopBits |= (uint64_t) 1 << (i + m_uBits - 1);
+	}
+
+	const char *p = pWild;
+
+	while (true)
+	{
+		// One run, up to the next '*' or the end.
+		WildPackedRun run =
+		{
+			(uint32_t) m_rgValue.size(), 0, (uint32_t) m_rgProbes.size(), 0
+		};
+
+		for (; *p && *p != '*'; ++p, ++run.cSymbols)
+		{
+			unsigned iInChunk = run.cSymbols % m_cChunkSymbols;
+
+			if (!iInChunk)
+			{
+				m_rgValue.push_back(0);
+				m_rgMask.push_back(0);
+			}
+
+			if (*p != '?')
+			{
+				int iSymbol = s_tables.rg[alphabet][(uint8_t) *p];
+
+				if (iSymbol < 0)
+				{
+					return false;
+				}
+
+				m_rgValue.back() |= (uint64_t) iSymbol << (iInChunk * m_uBits);
+				m_rgMask.back() |= (uint64_t) ((1u << m_uBits) - 1) <<
+				                   (iInChunk * m_uBits);
+
+				if (run.cSymbols < m_cChunkSymbols)
+				{
+					WildPackedProbe probe = { 0, run.cSymbols };
+
+					for (unsigned i = 0; i + m_uBits <= 64; i += m_uBits)
+					{
+						probe.uRepeated |= (uint64_t) iSymbol << i;
+					}
+
+					m_rgProbes.push_back(probe);
+					++run.cProbes;
+				}
+			}
+		}
+
+		m_rgRuns.push_back(run);
+
+		if (!*p)
+		{
+			break;
+		}
+
+		m_bStar = true;
+
+		while (*p == '*')
+		{
+			++p;
+		}
+	}
+
+	m_bNever = false;
+	return true;
+}
+
+
+inline bool WildPackedPattern::RunAt(const WildPackedRun &run,
+                                     const uint8_t *pPacked, size_t cbPacked,
+                                     size_t iSymbol) const
+{
+	const uint64_t *pValue = m_rgValue.data() + run.iChunk;
+	const uint64_t *pMask = m_rgMask.data() + run.iChunk;
+
+	for (size_t iDone = 0; iDone < run.cSymbols; iDone += m_cChunkSymbols)
+	{
+		uint64_t u = LoadBits(pPacked, cbPacked, (iSymbol + iDone) * m_uBits);
+
+		if ((u ^ *pValue++) & *pMask++)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+// Finds the leftmost place at or after iSymbol, and no later than iLast,
+// where a run fits.  Each load covers several starting places.  For each
+// probe symbol, the places where it appears are found at once, as the
+// fields of the XOR that are zero; shifting each probe's result back by
+// its place in the run and ANDing them leaves the places where the whole
+// first chunk fits.  A longer run is compared in full only there.  Returns
+// SIZE_MAX if there is none.  The symbol width is a template parameter so
+// that dividing by it costs no more than a shift or a multiply.
+//
+template <unsigned uBits>
+size_t WildPackedPattern::FindRun(const WildPackedRun &run,
+                                  const uint8_t *pPacked, size_t cbPacked,
+                                  size_t iSymbol, size_t iLast) const
+{
+	const size_t           cChunkSymbols = 57 / uBits;
+	const WildPackedProbe *rgProbes = m_rgProbes.data() + run.iProbe;
+	size_t                 cFirst = run.cSymbols < cChunkSymbols ?
+	                                run.cSymbols : cChunkSymbols;
+	size_t                 cPlaces = cChunkSymbols - cFirst + 1;
+
+	while (iSymbol <= iLast)
+	{
+		uint64_t u = LoadBits(pPacked, cbPacked, iSymbol * uBits);
+		uint64_t uFits = m_uTopBits;
+
+		if (iLast - iSymbol + 1 < cPlaces)
+		{
+			uFits &= ((uint64_t) 1 << ((iLast - iSymbol + 1) * uBits)) - 1;
+		}
+		else if (cPlaces * uBits < 64)
+		{
+			uFits &= ((uint64_t) 1 << (cPlaces * uBits)) - 1;
+		}
+
+		for (uint32_t i = 0; i < run.cProbes && uFits; ++i)
+		{
+			uint64_t x = u ^ rgProbes[i].uRepeated;
+			uint64_t uZero = ~(((x & m_uLowBits) + m_uLowBits) | x) &
+			                 m_uTopBits;
+
+			uFits &= uZero >> (rgProbes[i].iSymbol * uBits);
+		}
+
+		while (uFits)
+		{
+			size_t iFit = iSymbol + __builtin_ctzll(uFits) / uBits;
+
+			if (run.cSymbols <= cChunkSymbols ||
+			    RunAt(run, pPacked, cbPacked, iFit))
+			{
+				return iFit;
+			}
+
+			uFits &= uFits - 1;
+		}
+
+		iSymbol += cPlaces;
+	}
+
+	return SIZE_MAX;
+}
+
+
+// The head is anchored at the start and the tail at the end.  Each middle
+// run is placed at its leftmost fit, which is always safe when every
+// run has a fixed width.
+//
+bool WildPackedPattern::Match(const uint8_t *pPacked, size_t cSymbols) const
+{
+	if (m_bNever)
+	{
+		return false;
+	}
+
+	size_t               cbPacked = WildPackedBytes(m_alphabet, cSymbols);
+	const WildPackedRun &head = m_rgRuns.front();
+
+	if (!m_bStar)
+	{
+		return cSymbols == head.cSymbols &&
+		       RunAt(head, pPacked, cbPacked, 0);
+	}
+
+	const WildPackedRun &tail = m_rgRuns.back();
+
+	if (cSymbols < head.cSymbols + tail.cSymbols ||
+	    !RunAt(head, pPacked, cbPacked, 0) ||
+	    !RunAt(tail, pPacked, cbPacked, cSymbols - tail.cSymbols))
+	{
+		return false;
+	}
+
+	size_t iSymbol = head.cSymbols, iEnd = cSymbols - tail.cSymbols;
+
+	for (size_t iRun = 1; iRun + 1 < m_rgRuns.size(); ++iRun)
+	{
+		const WildPackedRun &run = m_rgRuns[iRun];
+
+		if (iSymbol + run.cSymbols > iEnd)
+		{
+			return false;
+		}
+
+		iSymbol = m_uBits == 4 ?
+		          FindRun<4>(run, pPacked, cbPacked, iSymbol,
+		                     iEnd - run.cSymbols) :
+		          FindRun<5>(run, pPacked, cbPacked, iSymbol,
+		                     iEnd - run.cSymbols);
+
+		if (iSymbol == SIZE_MAX)
+		{
+			return false;
+		}
+
+		iSymbol += run.cSymbols;
+	}
+
+	return true;
+}
+
+
+// A set of packed-key tests: round trips, then random keys and patterns,
+// long enough to span several chunks, against FastWildCompare() on the
+// expanded keys.
+//
+extern "C" int testpacked(void)
+{
+	WildBenchRandom   rng(1010);
+	WildPackedPattern pattern;
+	uint8_t           rgPacked[64];
+	char              szText[128];
+	bool              bAllPassed = true;
+
+	bAllPassed &= WildPack(WILD_PACKED_HEX, "0fA9", 4, rgPacked) &&
+	              rgPacked[0] == 0xF0 && rgPacked[1] == 0x9A;
+	bAllPassed &= !WildPack(WILD_PACKED_BASE32, "ab1", 3, rgPacked);
+	bAllPassed &= !pattern.Compile("ab*g", WILD_PACKED_HEX) &&
+	              !pattern.Match(rgPacked, 2);
+
+	// Patterns with no literal runs, and so no probes.
+	static const char *s_rgszNoProbes[] = { "", "*", "?", "?*", "*?*", "??" };
+
+	for (const char *pszWild : s_rgszNoProbes)
+	{
+		for (size_t cchTame = 0; cchTame < 4; ++cchTame)
+		{
+			std::string strTame(cchTame, 'a');
+
+			WildPack(WILD_PACKED_HEX, strTame.data(), cchTame, rgPacked);
+			bAllPassed &= pattern.Compile(pszWild, WILD_PACKED_HEX) &&
+			              pattern.Match(rgPacked, cchTame) ==
+			              FastWildCompare(const_cast<char *>(pszWild),
+			                  const_cast<char *>(strTame.c_str()));
+		}
+	}
+
+	for (int iAlphabet = 0; iAlphabet < 2; ++iAlphabet)
+	{
+		WildPackedAlphabet alphabet = (WildPackedAlphabet) iAlphabet;
+		const char        *pszSymbols = s_rgszAlphabets[iAlphabet];
+
+		for (int iRound = 0; iRound < 100000; ++iRound)
+		{
+			// A small share of the alphabet, so that runs recur.
+			std::string strTame, strWild;
+			size_t      cchTame = rng.Below(iRound % 2 ? 12 : 90);
+			size_t      cchWild = rng.Below(iRound % 3 ? 8 : 40);
+
+			for (size_t i = 0; i < cchTame; ++i)
+			{
+				strTame += pszSymbols[rng.Below(3)];
+			}
+
+			for (size_t i = 0; i < cchWild; ++i)
+			{
+				uint32_t uPick = rng.Below(8);
+
+				strWild += uPick == 0 ? '*' : uPick == 1 ? '?' :
+				           pszSymbols[rng.Below(3)];
+			}
+
+			// Sometimes, a pattern that's mostly a copy of the key.
+			if (iRound % 5 == 0 && cchTame)
+			{
+				strWild = strTame;
+				strWild[rng.Below((uint32_t) cchTame)] = '*';
+				strWild[rng.Below((uint32_t) cchTame)] = '?';
+			}
+
+			WildPack(alphabet, strTame.data(), cchTame, rgPacked);
+			WildUnpack(alphabet, rgPacked, cchTame, szText);
+			bAllPassed &= !memcmp(szText, strTame.data(), cchTame);
+			pattern.Compile(strWild.c_str(), alphabet);
+
+			if (pattern.Match(rgPacked, cchTame) !=
+			    FastWildCompare(const_cast<char *>(strWild.c_str()),
+			                    const_cast<char *>(strTame.c_str())))
+			{
+				printf("Packed match of \"%s\" against \"%s\" is wrong\n",
+				       strWild.c_str(), strTame.c_str());
+				bAllPassed = false;
+			}
+		}
+	}
+
+	if (bAllPassed)
+	{
+		printf("Passed packed-key tests\n");
+	}
+	else
+	{
+		printf("Failed packed-key tests\n");
+	}
+
+	return 0;
+}
+
+
+// Times one pattern three ways over the same keys: FastWildCompare() on
+// keys stored as ASCII, FastWildCompare() after expanding each packed key,
+// and matching the packed keys directly.
+//
+static void BenchPackedPattern(WildPackedAlphabet alphabet,
+                               const char *pszWild, const std::string &strAscii,
+                               const std::vector<uint8_t> &rgPacked,
+                               size_t cKeys, size_t cSymbols)
+{
+	size_t            cbAscii = cSymbols + 1;
+	size_t            cbPacked = WildPackedBytes(alphabet, cSymbols);
+	char              szKey[128];
+	WildPackedPattern pattern;
+	uint64_t          uHitsAscii = 0, uHitsExpand = 0, uHitsPacked = 0;
+	uint64_t          uStart;
+
+	pattern.Compile(pszWild, alphabet);
+	uStart = WildBenchNanos();
+
+	for (size_t i = 0; i < cKeys; ++i)
+	{
+		uHitsAscii += FastWildCompare(const_cast<char *>(pszWild),
+		    const_cast<char *>(strAscii.data() + i * cbAscii));
+	}
+
+	double dAsciiNanos = (double) (WildBenchNanos() - uStart);
+
+	uStart = WildBenchNanos();
+
+	for (size_t i = 0; i < cKeys; ++i)
+	{
+		WildUnpack(alphabet, rgPacked.data() + i * cbPacked, cSymbols, szKey);
+		szKey[cSymbols] = '\0';
+		uHitsExpand += FastWildCompare(const_cast<char *>(pszWild), szKey);
+	}
+
+	double dExpandNanos = (double) (WildBenchNanos() - uStart);
+
+	uStart = WildBenchNanos();
+
+	for (size_t i = 0; i < cKeys; ++i)
+	{
+		uHitsPacked += pattern.Match(rgPacked.data() + i * cbPacked, cSymbols);
+	}
+
+	double dPackedNanos = (double) (WildBenchNanos() - uStart);
+
+	printf("  %-12s ASCII %.1f ns/key, expand+match %.1f ns/key, "
+	       "packed %.1f ns/key (%.2f GB/s of packed keys)%s\n", pszWild,
+	       dAsciiNanos / cKeys, dExpandNanos / cKeys, dPackedNanos / cKeys,
+	       (double) cbPacked * cKeys / dPackedNanos,
+	       uHitsAscii == uHitsPacked && uHitsExpand == uHitsPacked ?
+	       "" : " (RESULTS DIFFER)");
+}
+
+
+// 40-symbol hex hashes (as from SHA-1) and 26-symbol base32 IDs, a
+// million of each, matched against prefix, suffix, infix and '?' rules.
+//
+extern "C" int benchpacked(void)
+{
+	static const struct
+	{
+		WildPackedAlphabet alphabet;
+		size_t             cSymbols;
+		const char        *rgszWild[4];
+	}
+	s_rgCorpora[] =
+	{
+		{ WILD_PACKED_HEX, 40, { "dead*", "*c0ffee", "*5e5e*", "??00??ff*" } },
+		{ WILD_PACKED_BASE32, 26, { "mzx*", "*q7", "*kk2*", "a?b?c*" } }
+	};
+	const size_t    cKeys = 1000000;
+	WildBenchRandom rng(1111);
+
+	for (const auto &corpus : s_rgCorpora)
+	{
+		const char          *pszSymbols = s_rgszAlphabets[corpus.alphabet];
+		size_t               cbPacked = WildPackedBytes(corpus.alphabet,
+		                                                corpus.cSymbols);
+		std::string          strAscii, strKey;
+		std::vector<uint8_t> rgPacked(cKeys * cbPacked);
+
+		for (size_t i = 0; i < cKeys; ++i)
+		{
+			strKey.clear();
+
+			for (size_t iSymbol = 0; iSymbol < corpus.cSymbols; ++iSymbol)
+			{
+				strKey += pszSymbols[rng.Below(1u << s_rguBits[corpus.alphabet])];
+			}
+
+			strAscii += strKey;
+			strAscii += '\0';
+			WildPack(corpus.alphabet, strKey.data(), corpus.cSymbols,
+			         &rgPacked[i * cbPacked]);
+		}
+
+		printf("Packed keys, %zu %s keys of %zu symbols: %zu bytes each "
+		       "packed, %zu as ASCII\n", cKeys,
+		       corpus.alphabet == WILD_PACKED_HEX ? "hex" : "base32",
+		       corpus.cSymbols, cbPacked, corpus.cSymbols + 1);
+
+		for (const char *pszWild : corpus.rgszWild)
+		{
+			BenchPackedPattern(corpus.alphabet, pszWild, strAscii, rgPacked,
+			                   cKeys, corpus.cSymbols);
+		}
+	}
+
+	return 0;
+}
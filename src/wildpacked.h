@@ -0,0 +1,117 @@
+// WildPackedPattern, wildcard matching on keys packed 4 or 5 bits per
+// symbol
+//
+// Copyright 2025 Kirk J Krauss.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Hex hashes and base32 IDs take half or five eighths of the memory when
+// stored as packed symbols rather than ASCII.  WildPackedPattern matches
+// such keys without expanding them.  The pattern is translated into the
+// packed alphabet once: each run between '*' wildcards becomes a string
+// of bits with a mask, zero where a '?' is, in chunks that fit one 64-bit
+// load at any symbol offset.  Placing a run at a symbol position is then
+// one load, XOR and AND per chunk.
+//
+// Symbol i of a packed key occupies bits i * w up to (i + 1) * w, counting
+// from the least significant bit of the first byte, where w is 4 or 5.
+// Letters in keys and patterns may be of either case.
+//
+#ifndef WILDPACKED_H
+#define WILDPACKED_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <memory_resource>
+#include <vector>
+
+enum WildPackedAlphabet
+{
+	WILD_PACKED_HEX,      // "0123456789abcdef", 4 bits
+	WILD_PACKED_BASE32    // "abcdefghijklmnopqrstuvwxyz234567" (RFC 4648), 5 bits
+};
+
+// Bytes needed for cSymbols packed symbols.
+size_t WildPackedBytes(WildPackedAlphabet alphabet, size_t cSymbols);
+
+// Packs cch characters.  Returns false if one is outside the alphabet.
+bool WildPack(WildPackedAlphabet alphabet, const char *pText, size_t cch,
+              uint8_t *pPacked);
+
+// Expands cSymbols packed symbols into lowercase characters, without a
+// terminating NUL.
+void WildUnpack(WildPackedAlphabet alphabet, const uint8_t *pPacked,
+                size_t cSymbols, char *pText);
+
+class WildPackedPattern
+{
+public:
+	explicit WildPackedPattern(std::pmr::memory_resource *pResource =
+	                           std::pmr::get_default_resource());
+
+	// Compiles a pattern of '*', '?' and alphabet characters.  Returns
+	// false if a character is outside the alphabet, in which case the
+	// pattern matches nothing.
+	bool Compile(const char *pWild, WildPackedAlphabet alphabet);
+
+	// Matches a key of cSymbols symbols packed in the same alphabet.  The
+	// key takes WildPackedBytes() bytes, and nothing past them is read.
+	bool Match(const uint8_t *pPacked, size_t cSymbols) const;
+
+	std::pmr::memory_resource *Resource() const
+	{
+		return m_rgValue.get_allocator().resource();
+	}
+
+private:
+	// A run of symbols between '*' wildcards, as chunks in m_rgValue and
+	// m_rgMask starting at iChunk.  The literal symbols of its first chunk
+	// are also kept as probes, for searching many places at once.
+	struct WildPackedRun
+	{
+		uint32_t iChunk;
+		uint32_t cSymbols;
+		uint32_t iProbe;
+		uint32_t cProbes;
+	};
+
+	// A symbol repeated across a word, and its place in the run.
+	struct WildPackedProbe
+	{
+		uint64_t uRepeated;
+		uint32_t iSymbol;
+	};
+
+	bool RunAt(const WildPackedRun &run, const uint8_t *pPacked,
+	           size_t cbPacked, size_t iSymbol) const;
+	template <unsigned uBits>
+	size_t FindRun(const WildPackedRun &run, const uint8_t *pPacked,
+	               size_t cbPacked, size_t iSymbol, size_t iLast) const;
+
+	std::pmr::vector<uint64_t>        m_rgValue;
+	std::pmr::vector<uint64_t>        m_rgMask;
+	std::pmr::vector<WildPackedRun>   m_rgRuns;   // Head, middle runs, tail
+	std::pmr::vector<WildPackedProbe> m_rgProbes;
+	uint64_t                          m_uLowBits; // Each symbol's low bits
+	uint64_t                          m_uTopBits; // Each symbol's top bit
+	unsigned                          m_uBits;    // Bits per symbol
+	unsigned                          m_cChunkSymbols;
+	WildPackedAlphabet                m_alphabet;
+	bool                              m_bStar;    // Else the head is the whole
+	bool                              m_bNever;
+};
+
+extern "C" int testpacked(void);
+extern "C" int benchpacked(void);
+
+#endif  // WILDPACKED_H
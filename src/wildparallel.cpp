@@ -0,0 +1,487 @@
+// WildParallelSet, and related code
+//
+// Copyright 2025 Kirk J Krauss.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// This file provides pattern-parallel matching: one tame string, one
+// pattern set, several cores.  It also includes testcases for correctness
+// and performance.
+//
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "fastwildcompare.h"
+#include "wildparallel.h"
+#include "wildbench.h"
+
+
+bool WildPinThread(int iCpu)
+{
+#if defined(__linux__)
+	cpu_set_t cpuset;
+
+	CPU_ZERO(&cpuset);
+	CPU_SET(iCpu, &cpuset);
+	return !pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+#else
+	(void) iCpu;
+	return false;
+#endif
+}
+
+
+std::vector<int> WildAllowedCpus()
+{
+	std::vector<int> rgCpus;
+
+#if defined(__linux__)
+	cpu_set_t cpuset;
+
+	CPU_ZERO(&cpuset);
+
+	if (!sched_getaffinity(0, sizeof(cpuset), &cpuset))
+	{
+		for (int iCpu = 0; iCpu < CPU_SETSIZE; ++iCpu)
+		{
+			if (CPU_ISSET(iCpu, &cpuset))
+			{
+				rgCpus.push_back(iCpu);
+			}
+		}
+	}
+#endif
+
+	if (rgCpus.empty())
+	{
+		unsigned cCpus = std::max(1u, std::thread::hardware_concurrency());
+
+		for (unsigned iCpu = 0; iCpu < cCpus; ++iCpu)
+		{
+			rgCpus.push_back((int) iCpu);
+		}
+	}
+
+	return rgCpus;
+}
+
+
+// Waits for an atomic count to drop to zero: spinning first, then
+// yielding, in case the threads being waited for share this core.
+//
+static void WaitForZero(const std::atomic<int> &count, int cSpinLimit)
+{
+	int cSpins = 0;
+
+	while (count.load(std::memory_order_acquire) > 0)
+	{
+		if (++cSpins < cSpinLimit)
+		{
+			WildCpuRelax();
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+
+// Splits the set's groups into contiguous shards of about equal static
+// cost.  Contiguity keeps pattern indexes ordered across shards, so the
+// first match overall is the first match of the lowest shard that has one.
+// The workers are started and, if asked, pinned before this returns, so
+// PinFailures() is final from then on.
+//
+WildParallelSet::WildParallelSet(const WildPatternSet &set, int cShards,
+                                 bool bPin) :
+    m_set(set), m_cSpinLimit(WILD_SPIN_LIMIT), m_pTame(NULL), m_cbTame(0),
+    m_mode(WILD_MATCH_FIRST), m_uGeneration(0), m_cPending(0),
+    m_iFoundShard(INT_MAX), m_cSleepers(0), m_cPinFailures(0),
+    m_bStop(false)
+{
+	size_t                cGroups = set.GroupCount();
+	std::vector<uint64_t> rgGroupCost(cGroups, 0);
+	uint64_t              uTotalCost = 0;
+
+	std::vector<int>      rgCpus = WildAllowedCpus();
+	size_t                cCpus = rgCpus.size();
+
+	if (cShards < 1)
+	{
+		cShards = 1;
+	}
+
+	// Spinning only pays when every shard has a core to itself.  Otherwise
+	// a spinning thread holds the core that another shard is waiting for.
+	if ((size_t) cShards > cCpus)
+	{
+		m_cSpinLimit = 0;
+	}
+
+	for (int iPattern = 0; iPattern < set.Count(); ++iPattern)
+	{
+		rgGroupCost[iPattern / WILD_GROUP_LANES] += set.Cost(iPattern);
+		uTotalCost += set.Cost(iPattern);
+	}
+
+	m_rgShards.reset(new WildShard[cShards]);
+	m_rgShardCost.assign(cShards, 0);
+
+	size_t   iGroup = 0;
+	uint64_t uSoFar = 0;
+
+	for (int iShard = 0; iShard < cShards; ++iShard)
+	{
+		uint64_t uTarget = uTotalCost * (iShard + 1) / cShards;
+
+		m_rgShards[iShard].iGroupBegin = iGroup;
+
+		while (iGroup < cGroups &&
+		       (uSoFar + rgGroupCost[iGroup] / 2 <= uTarget ||
+		        iShard == cShards - 1))
+		{
+			uSoFar += rgGroupCost[iGroup];
+			m_rgShardCost[iShard] += rgGroupCost[iGroup];
+			++iGroup;
+		}
+
+		m_rgShards[iShard].iGroupEnd = iGroup;
+		m_rgShards[iShard].iResult = -1;
+	}
+
+	// Shard 0 runs on the calling thread.  Each worker checks in once it
+	// has tried to pin itself.
+	m_cPending.store(cShards - 1);
+
+	for (int iShard = 1; iShard < cShards; ++iShard)
+	{
+		int iCpu = rgCpus[iShard % cCpus];
+
+		m_rgThreads.emplace_back([this, iShard, bPin, iCpu]()
+		{
+			if (bPin && !WildPinThread(iCpu))
+			{
+				m_cPinFailures.fetch_add(1, std::memory_order_relaxed);
+			}
+
+			m_cPending.fetch_sub(1, std::memory_order_release);
+			WorkerMain(iShard);
+		});
+	}
+
+	WaitForZero(m_cPending, m_cSpinLimit);
+}
+
+
+WildParallelSet::~WildParallelSet()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		m_bStop.store(true);
+		m_cvWake.notify_all();
+	}
+
+	for (std::thread &thread : m_rgThreads)
+	{
+		thread.join();
+	}
+}
+
+
+// Evaluates one shard, a chunk of groups at a time, quitting early once a
+// match elsewhere makes this shard's result moot.
+//
+void WildParallelSet::RunShard(int iShard)
+{
+	WildShard &shard = m_rgShards[iShard];
+
+	shard.iResult = -1;
+	shard.memo.Reset(m_pTame, m_cbTame);
+
+	for (size_t iGroup = shard.iGroupBegin; iGroup < shard.iGroupEnd;
+	     iGroup += WILD_SHARD_CHUNK)
+	{
+		int iFoundShard = m_iFoundShard.load(std::memory_order_relaxed);
+
+		if (m_mode == WILD_MATCH_ANY ? iFoundShard != INT_MAX :
+		                               iFoundShard < iShard)
+		{
+			return;
+		}
+
+		int iPattern = m_set.MatchFirstInGroups(m_pTame, m_cbTame, iGroup,
+		    std::min(iGroup + WILD_SHARD_CHUNK, shard.iGroupEnd), shard.memo);
+
+		if (iPattern >= 0)
+		{
+			shard.iResult = iPattern;
+
+			// Record the lowest shard with a match.
+			while (iFoundShard > iShard &&
+			       !m_iFoundShard.compare_exchange_weak(iFoundShard, iShard))
+			{
+				continue;
+			}
+
+			return;
+		}
+	}
+}
+
+
+// A worker waits for each new generation, runs its shard, and checks in.
+// It spins for a while first, since lookups often come back to back, and
+// then sleeps until the next fork.
+//
+void WildParallelSet::WorkerMain(int iShard)
+{
+	uint32_t uSeen = 0;
+
+	while (true)
+	{
+		uint32_t uGeneration;
+		int      cSpins = 0;
+
+		while ((uGeneration = m_uGeneration.load(std::memory_order_acquire))
+		       == uSeen)
+		{
+			if (m_bStop.load(std::memory_order_relaxed))
+			{
+				return;
+			}
+
+			if (++cSpins < m_cSpinLimit)
+			{
+				WildCpuRelax();
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(m_mutex);
+
+			m_cSleepers.fetch_add(1);
+			m_cvWake.wait(lock, [this, uSeen]()
+			{
+				return m_uGeneration.load() != uSeen || m_bStop.load();
+			});
+			m_cSleepers.fetch_sub(1);
+			cSpins = 0;
+		}
+
+		uSeen = uGeneration;
+		RunShard(iShard);
+		m_cPending.fetch_sub(1, std::memory_order_release);
+	}
+}
+
+
+int WildParallelSet::Match(const char *pTame, size_t cbTame,
+                           WildMatchMode mode)
+{
+	int cShards = ShardCount();
+
+	m_pTame = pTame;
+	m_cbTame = cbTame;
+	m_mode = mode;
+	m_iFoundShard.store(INT_MAX, std::memory_order_relaxed);
+
+	if (cShards > 1)
+	{
+		// Fork: the generation bump publishes the lookup to the workers.
+		m_cPending.store(cShards - 1, std::memory_order_relaxed);
+		m_uGeneration.fetch_add(1);
+
+		if (m_cSleepers.load() > 0)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			m_cvWake.notify_all();
+		}
+	}
+
+	RunShard(0);
+
+	// Join.
+	WaitForZero(m_cPending, m_cSpinLimit);
+
+	int iFoundShard = m_iFoundShard.load(std::memory_order_relaxed);
+
+	return iFoundShard == INT_MAX ? -1 : m_rgShards[iFoundShard].iResult;
+}
+
+
+// A set of pattern-parallel tests.  First-match results must agree with
+// the single-threaded set for every shard count, and any-match results
+// must be genuine matches.
+//
+extern "C" int testparallel(void)
+{
+	WildBenchRandom rng(505);
+	WildPatternSet  set;
+	std::string     str;
+	std::vector<std::string> rgKeys(1000);
+	bool            bAllPassed = true;
+
+	for (int i = 0; i < 5000; ++i)
+	{
+		WildBenchMakePattern(rng, str);
+		set.Add(str.c_str());
+	}
+
+	set.Build();
+
+	for (size_t i = 0; i < rgKeys.size(); ++i)
+	{
+		WildBenchMakeKey(rng, rgKeys[i], i % 3 == 0);
+	}
+
+	static const int s_rgcShards[] = { 1, 2, 3, 7, 16, 200 };
+
+	for (int cShards : s_rgcShards)
+	{
+		WildParallelSet parallel(set, cShards, false);
+		uint64_t        uCost = 0;
+
+		for (int iShard = 0; iShard < parallel.ShardCount(); ++iShard)
+		{
+			uCost += parallel.ShardCost(iShard);
+		}
+
+		bAllPassed &= parallel.ShardCount() == cShards && uCost > 0;
+		bAllPassed &= parallel.PinFailures() == 0;
+
+		for (const std::string &strKey : rgKeys)
+		{
+			int iFirst = set.MatchFirst(strKey.c_str());
+			int iAny = parallel.Match(strKey.c_str(), strKey.size(),
+			                          WILD_MATCH_ANY);
+
+			bAllPassed &= parallel.Match(strKey.c_str(), strKey.size(),
+			                             WILD_MATCH_FIRST) == iFirst;
+			bAllPassed &= (iAny >= 0) == (iFirst >= 0);
+			bAllPassed &= iAny < 0 || FastWildCompare(
+			    const_cast<char *>(set.Pattern(iAny)),
+			    const_cast<char *>(strKey.c_str()));
+		}
+	}
+
+	// Pinning uses only CPUs in the affinity mask, so on Linux every
+	// worker pins; elsewhere pinning isn't supported and every worker
+	// counts a failure.
+	std::vector<int> rgCpus = WildAllowedCpus();
+
+	bAllPassed &= !rgCpus.empty();
+
+	{
+		WildParallelSet parallel(set, 5);
+		int             iFirst = set.MatchFirst(rgKeys[0].c_str());
+
+#if defined(__linux__)
+		bAllPassed &= parallel.PinFailures() == 0;
+#else
+		bAllPassed &= parallel.PinFailures() == 4;
+#endif
+		bAllPassed &= parallel.Match(rgKeys[0].c_str(), rgKeys[0].size(),
+		                             WILD_MATCH_FIRST) == iFirst;
+	}
+
+	if (bAllPassed)
+	{
+		printf("Passed pattern-parallel tests\n");
+	}
+	else
+	{
+		printf("Failed pattern-parallel tests\n");
+	}
+
+	return 0;
+}
+
+
+// Measures single-key latency on a 1M-pattern set at 1 to 16 shards.  Most
+// keys match nothing, so every shard has its whole range to evaluate.
+//
+extern "C" int benchparallel(void)
+{
+	const int       cPatterns = 1000000;
+	const int       cKeys = 200;
+	WildBenchRandom rng(77);
+	WildPatternSet  set;
+	std::string     str;
+	std::vector<std::string> rgKeys(cKeys);
+
+	for (int i = 0; i < cPatterns; ++i)
+	{
+		WildBenchMakePattern(rng, str);
+		set.Add(str.c_str());
+	}
+
+	set.Build();
+
+	for (int i = 0; i < cKeys; ++i)
+	{
+		WildBenchMakeKey(rng, rgKeys[i], i % 8 != 0);
+	}
+
+	printf("Pattern-parallel, %d patterns, %u hardware threads\n",
+	       cPatterns, std::thread::hardware_concurrency());
+
+	for (int cShards = 1; cShards <= 16; cShards *= 2)
+	{
+		WildParallelSet       parallel(set, cShards);
+		std::vector<uint64_t> rgNanos(cKeys);
+		uint64_t              uMaxCost = 0, uTotalCost = 0;
+
+		for (int iShard = 0; iShard < cShards; ++iShard)
+		{
+			uMaxCost = std::max(uMaxCost, parallel.ShardCost(iShard));
+			uTotalCost += parallel.ShardCost(iShard);
+		}
+
+		for (int iKey = 0; iKey < cKeys; ++iKey)
+		{
+			uint64_t uStart = WildBenchNanos();
+
+			parallel.Match(rgKeys[iKey].c_str(), rgKeys[iKey].size(),
+			               WILD_MATCH_FIRST);
+			rgNanos[iKey] = WildBenchNanos() - uStart;
+		}
+
+		std::sort(rgNanos.begin(), rgNanos.end());
+
+		uint64_t uSum = 0;
+
+		for (uint64_t uNanos : rgNanos)
+		{
+			uSum += uNanos;
+		}
+
+		printf("  %2d shards: mean %.1f us, p50 %.1f us, p99 %.1f us, "
+		       "largest shard %.1f%% of total cost\n", cShards,
+		       uSum / 1000.0 / cKeys, rgNanos[cKeys / 2] / 1000.0,
+		       rgNanos[cKeys * 99 / 100] / 1000.0,
+		       100.0 * uMaxCost / (uTotalCost ? uTotalCost : 1));
+	}
+
+	return 0;
+}
@@ -0,0 +1,146 @@
+// WildParallelSet, for matching one string against a pattern set on
+// several cores at once
+//
+// Copyright 2025 Kirk J Krauss.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Batching many tame strings across threads helps throughput, but not the
+// latency of a single lookup.  A WildParallelSet splits a built pattern
+// set into shards of contiguous groups, balanced by the set's static cost
+// estimates, and evaluates one tame string on every shard at once.  The
+// calling thread runs shard 0; worker threads, pinned in turn to the CPUs
+// in the process's affinity mask, run the others.  A fork/join barrier
+// built on a generation counter releases the workers, which spin briefly
+// before sleeping, so back-to-back lookups don't pay for a wakeup.
+//
+#ifndef WILDPARALLEL_H
+#define WILDPARALLEL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "wildpatternset.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#define WILD_SPIN_LIMIT      20000  // Spins before a worker sleeps
+#define WILD_SHARD_CHUNK     16     // Groups between checks for early exit
+
+// Tells the CPU that this is a spin-wait loop.
+//
+static inline void WildCpuRelax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+	_mm_pause();
+#else
+	std::this_thread::yield();
+#endif
+}
+
+
+// Pins the calling thread to one CPU, where the platform allows.  Returns
+// false if pinning isn't supported or fails.
+//
+bool WildPinThread(int iCpu);
+
+
+// Returns the CPUs this process may run on, from its affinity mask where
+// the platform has one, or else CPUs 0 through hardware_concurrency() - 1.
+// Never empty.
+//
+std::vector<int> WildAllowedCpus();
+
+
+enum WildMatchMode
+{
+	WILD_MATCH_FIRST,    // Lowest matching pattern index
+	WILD_MATCH_ANY       // Any matching pattern index, soonest found
+};
+
+
+class WildParallelSet
+{
+public:
+	// Shards a set that has already been built.  The set must outlive
+	// this object and must not change while it exists.
+	WildParallelSet(const WildPatternSet &set, int cShards, bool bPin = true);
+	~WildParallelSet();
+
+	// Returns a matching pattern index per mode, or -1.  Not reentrant:
+	// one lookup at a time per WildParallelSet.
+	int Match(const char *pTame, size_t cbTame, WildMatchMode mode);
+
+	int ShardCount() const
+	{
+		return (int) m_rgShardCost.size();
+	}
+
+	// Sum of the static costs of the patterns in a shard.
+	uint64_t ShardCost(int iShard) const
+	{
+		return m_rgShardCost[iShard];
+	}
+
+	// Number of worker threads that asked to be pinned and couldn't be.
+	int PinFailures() const
+	{
+		return m_cPinFailures.load(std::memory_order_relaxed);
+	}
+
+private:
+	// Per-shard state, on its own cache lines.
+	struct alignas(64) WildShard
+	{
+		size_t          iGroupBegin;
+		size_t          iGroupEnd;
+		int             iResult;
+		WildSegmentMemo memo;
+	};
+
+	void RunShard(int iShard);
+	void WorkerMain(int iShard);
+
+	const WildPatternSet                &m_set;
+	int                                  m_cSpinLimit;  // 0 if oversubscribed
+	std::vector<uint64_t>                m_rgShardCost;
+	std::unique_ptr<WildShard[]>         m_rgShards;
+	std::vector<std::thread>             m_rgThreads;
+
+	// The lookup in progress.
+	const char                          *m_pTame;
+	size_t                               m_cbTame;
+	WildMatchMode                        m_mode;
+
+	alignas(64) std::atomic<uint32_t>    m_uGeneration;  // Fork
+	alignas(64) std::atomic<int>         m_cPending;     // Join
+	alignas(64) std::atomic<int>         m_iFoundShard;  // For early exit
+	std::atomic<int>                     m_cSleepers;
+	std::atomic<int>                     m_cPinFailures;
+	std::atomic<bool>                    m_bStop;
+	std::mutex                           m_mutex;
+	std::condition_variable              m_cvWake;
+};
+
+extern "C" int testparallel(void);
+extern "C" int benchparallel(void);
+
+#endif  // WILDPARALLEL_H
@@ -0,0 +1,1077 @@
+// WildPatternSet, and related code
+//
+// Copyright 2025 Kirk J Krauss.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// This file provides a set of wildcard patterns that one tame string can be
+// matched against, with a vectorized filter that rejects most patterns
+// before they are matched, and hash-consed segments whose positions in the
+// tame string are searched for once and shared.  It also includes
+// testcases for correctness and performance.
+//
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "fastwildcompare.h"
+#include "wildpatternset.h"
+#include "wildbench.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define WILD_HAVE_AVX2_TARGET  1
+#endif
+
+
+WildPatternSet::WildPatternSet(std::pmr::memory_resource *pResource) :
+    m_rgText(pResource), m_rgOffsets(pResource), m_rgGroups(pResource),
+    m_rgShapes(pResource), m_rgSegIds(pResource), m_rgSegOffsets(pResource),
+    m_rgSegLens(pResource)
+{
+}
+
+
+// Adds a pattern.  Its text is copied, NUL terminator included, so that
+// FastWildCompare() can be handed a pointer into the set.
+//
+int WildPatternSet::Add(const char *pWild)
+{
+	size_t cbWild = strlen(pWild);
+
+	m_rgOffsets.push_back((uint32_t) m_rgText.size());
+	m_rgText.insert(m_rgText.end(), pWild, pWild + cbWild + 1);
+	return (int) m_rgOffsets.size() - 1;
+}
+
+
+// Compares cbSeg bytes of pTame with a run of literals and '?'.
+//
+static inline bool SegmentAt(const char *pSeg, size_t cbSeg,
+                             const char *pTame)
+{
+	for (size_t i = 0; i < cbSeg; ++i)
+	{
+		if (pSeg[i] != pTame[i] && pSeg[i] != '?')
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+// Finds the leftmost start, at or after uPos, of a segment in the tame
+// string, or returns SIZE_MAX.  Candidate positions examined are added to
+// *pcbScanned.
+//
+static size_t SearchSegment(const char *pSeg, size_t cbSeg,
+                            const char *pTame, size_t cbTame, size_t uPos,
+                            uint64_t *pcbScanned)
+{
+	if (cbTame < cbSeg || uPos > cbTame - cbSeg)
+	{
+		return SIZE_MAX;
+	}
+
+	size_t uLast = cbTame - cbSeg;
+	size_t uStart = uPos;
+
+	while (uPos <= uLast)
+	{
+		if (pSeg[0] != '?')
+		{
+			const char *p = (const char *) memchr(pTame + uPos, pSeg[0],
+			                                      uLast - uPos + 1);
+
+			if (!p)
+			{
+				uPos = uLast + 1;
+				break;
+			}
+
+			uPos = (size_t) (p - pTame);
+		}
+
+		if (SegmentAt(pSeg, cbSeg, pTame + uPos))
+		{
+			*pcbScanned += uPos - uStart + 1;
+			return uPos;
+		}
+
+		++uPos;
+	}
+
+	*pcbScanned += uPos - uStart;
+	return SIZE_MAX;
+}
+
+
+WildSegmentMemo::WildSegmentMemo(std::pmr::memory_resource *pResource) :
+    m_pTame(NULL), m_cbTame(0), m_uGeneration(1), m_rgStamp(pResource),
+    m_rgCursor(pResource), m_rgPositions(pResource), m_cbScanned(0),
+    m_bShare(true)
+{
+}
+
+
+void WildSegmentMemo::Reset(const char *pTame, size_t cbTame)
+{
+	m_pTame = pTame;
+	m_cbTame = cbTame;
+
+	// Generation stamps make this O(1): stale entries are recognized and
+	// cleared when next touched.
+	if (!++m_uGeneration)
+	{
+		std::fill(m_rgStamp.begin(), m_rgStamp.end(), 0);
+		m_uGeneration = 1;
+	}
+}
+
+
+size_t WildSegmentMemo::Find(const WildPatternSet &set, uint32_t iSegment,
+                             size_t uPos)
+{
+	const char *pSeg = &set.m_rgText[set.m_rgSegOffsets[iSegment]];
+	size_t      cbSeg = set.m_rgSegLens[iSegment];
+
+	if (!m_bShare)
+	{
+		return SearchSegment(pSeg, cbSeg, m_pTame, m_cbTame, uPos,
+		                     &m_cbScanned);
+	}
+
+	if (m_rgStamp.size() < set.SegmentCount())
+	{
+		m_rgStamp.resize(set.SegmentCount(), 0);
+		m_rgCursor.resize(set.SegmentCount(), 0);
+		m_rgPositions.resize(set.SegmentCount());
+	}
+
+	std::pmr::vector<uint32_t> &rgPositions = m_rgPositions[iSegment];
+
+	if (m_rgStamp[iSegment] != m_uGeneration)
+	{
+		m_rgStamp[iSegment] = m_uGeneration;
+		m_rgCursor[iSegment] = 0;
+		rgPositions.clear();
+	}
+
+	// Every occurrence that starts before the cursor is already listed.
+	std::pmr::vector<uint32_t>::iterator it = std::lower_bound(
+	    rgPositions.begin(), rgPositions.end(), (uint32_t) uPos);
+
+	if (it != rgPositions.end())
+	{
+		return *it;
+	}
+
+	while (true)
+	{
+		size_t uFound = SearchSegment(pSeg, cbSeg, m_pTame, m_cbTame,
+		                              m_rgCursor[iSegment], &m_cbScanned);
+
+		if (uFound == SIZE_MAX)
+		{
+			m_rgCursor[iSegment] = m_cbTame + 1;
+			return SIZE_MAX;
+		}
+
+		rgPositions.push_back((uint32_t) uFound);
+		m_rgCursor[iSegment] = uFound + 1;
+
+		if (uFound >= uPos)
+		{
+			return uFound;
+		}
+	}
+}
+
+
+// Returns true if the group filter has a literal byte to check for this
+// pattern, ahead of its first '*' or after its last.
+//
+static bool HasFilterLiteral(const char *pWild, size_t cbWild)
+{
+	for (size_t i = 0; i < cbWild && i < WILD_HEAD_BYTES &&
+	     pWild[i] != '*'; ++i)
+	{
+		if (pWild[i] != '?')
+		{
+			return true;
+		}
+	}
+
+	for (size_t i = 0; i < cbWild && i < WILD_TAIL_BYTES &&
+	     pWild[cbWild - 1 - i] != '*'; ++i)
+	{
+		if (pWild[cbWild - 1 - i] != '?')
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+// Derives each pattern's filter features and stores them lane-wise, then
+// decomposes each pattern into segments, hash-consing the middle ones.
+//
+void WildPatternSet::Build()
+{
+	size_t cPatterns = m_rgOffsets.size();
+
+	m_rgGroups.assign((cPatterns + WILD_GROUP_LANES - 1) / WILD_GROUP_LANES,
+	                  WildPatternGroup());
+
+	for (size_t iGroup = 0; iGroup < m_rgGroups.size(); ++iGroup)
+	{
+		WildPatternGroup &group = m_rgGroups[iGroup];
+
+		memset(&group, 0, sizeof(group));
+
+		for (size_t iLane = 0; iLane < WILD_GROUP_LANES; ++iLane)
+		{
+			size_t iPattern = iGroup * WILD_GROUP_LANES + iLane;
+
+			if (iPattern >= cPatterns)
+			{
+				// An empty lane: no length is both >= min and <= max.
+				group.rgMinLen[iLane] = UINT32_MAX;
+				group.rgMaxLen[iLane] = 0;
+				continue;
+			}
+
+			const char *pWild = Pattern((int) iPattern);
+			uint32_t    uMinLen = 0;
+			bool        bStar = false;
+
+			for (const char *p = pWild; *p; ++p)
+			{
+				size_t iHead = (size_t) (p - pWild);
+
+				if (*p == '*')
+				{
+					bStar = true;
+					continue;
+				}
+
+				// Literals ahead of the first '*' sit at a fixed offset.
+				// A literal there also guarantees that any surviving
+				// tame string is long enough to have a byte at that
+				// offset, thanks to the minimum length check.
+				if (!bStar && iHead < WILD_HEAD_BYTES && *p != '?')
+				{
+					group.rgHead[iHead][iLane] = (uint8_t) *p;
+					group.rgMask[iHead][iLane] = 0xFF;
+				}
+
+				++uMinLen;
+			}
+
+			// Literals after the last '*' sit at a fixed offset from the
+			// end, and the same minimum length argument applies.
+			size_t cbWild = strlen(pWild);
+
+			for (size_t iTail = 0; iTail < WILD_TAIL_BYTES &&
+			     iTail < cbWild; ++iTail)
+			{
+				char ch = pWild[cbWild - 1 - iTail];
+
+				if (ch == '*')
+				{
+					break;
+				}
+
+				if (ch != '?')
+				{
+					group.rgTail[iTail][iLane] = (uint8_t) ch;
+					group.rgTailMask[iTail][iLane] = 0xFF;
+				}
+			}
+
+			group.rgMinLen[iLane] = uMinLen;
+			group.rgMaxLen[iLane] = bStar ? UINT32_MAX : uMinLen;
+		}
+	}
+
+	std::pmr::unordered_map<std::pmr::string, uint32_t> mapSegments(
+	    Resource());
+
+	m_rgShapes.assign(cPatterns, WildPatternShape());
+	m_rgSegIds.clear();
+	m_rgSegOffsets.clear();
+	m_rgSegLens.clear();
+
+	for (size_t iPattern = 0; iPattern < cPatterns; ++iPattern)
+	{
+		WildPatternShape &shape = m_rgShapes[iPattern];
+		const char       *pWild = Pattern((int) iPattern);
+		size_t            cbWild = strlen(pWild);
+		size_t            i = 0;
+
+		while (i < cbWild && pWild[i] != '*')
+		{
+			++i;
+		}
+
+		shape.uWildLen = (uint32_t) cbWild;
+		shape.uPrefixLen = (uint32_t) i;
+		shape.uTailLen = 0;
+		shape.iFirstSegment = (uint32_t) m_rgSegIds.size();
+		shape.cSegments = 0;
+		shape.bStar = i < cbWild;
+
+		while (i < cbWild)
+		{
+			while (i < cbWild && pWild[i] == '*')
+			{
+				++i;
+			}
+
+			size_t iBegin = i;
+
+			while (i < cbWild && pWild[i] != '*')
+			{
+				++i;
+			}
+
+			if (i == cbWild)
+			{
+				shape.uTailLen = (uint32_t) (i - iBegin);
+				break;
+			}
+
+			std::pmr::string strSeg(pWild + iBegin, i - iBegin, Resource());
+			auto             it = mapSegments.find(strSeg);
+			uint32_t iSegment;
+
+			if (it == mapSegments.end())
+			{
+				iSegment = (uint32_t) m_rgSegOffsets.size();
+				mapSegments.emplace(strSeg, iSegment);
+				m_rgSegOffsets.push_back(m_rgOffsets[iPattern] +
+				                         (uint32_t) iBegin);
+				m_rgSegLens.push_back((uint32_t) (i - iBegin));
+			}
+			else
+			{
+				iSegment = it->second;
+			}
+
+			m_rgSegIds.push_back(iSegment);
+			++shape.cSegments;
+		}
+
+		// Every pattern costs its share of a group filter.  One with no
+		// literal byte for the filter to check survives it for nearly
+		// every tame string, and then costs a segment-by-segment match.
+		shape.uCost = 1;
+
+		if (!HasFilterLiteral(pWild, cbWild))
+		{
+			shape.uCost += 16 + (uint32_t) cbWild + 8 * shape.cSegments;
+		}
+	}
+}
+
+
+// Matches the anchored prefix, then each middle segment at its leftmost
+// position after the last, then the tail at the end.  Leftmost placement
+// is safe because segments have fixed widths, as in FastWildCompare().
+//
+bool WildPatternSet::MatchPattern(int iPattern, const char *pTame,
+                                  size_t cbTame, WildSegmentMemo &memo) const
+{
+	const WildPatternShape &shape = m_rgShapes[iPattern];
+	const char             *pWild = Pattern(iPattern);
+	size_t                  uPos = shape.uPrefixLen;
+
+	if (cbTame < uPos || !SegmentAt(pWild, uPos, pTame))
+	{
+		return false;                  // "abc" doesn't match "abd".
+	}
+
+	if (!shape.bStar)
+	{
+		return cbTame == uPos;         // "abc" matches "abc".
+	}
+
+	for (uint32_t i = 0; i < shape.cSegments; ++i)
+	{
+		uint32_t iSegment = m_rgSegIds[shape.iFirstSegment + i];
+
+		uPos = memo.Find(*this, iSegment, uPos);
+
+		if (uPos == SIZE_MAX)
+		{
+			return false;              // "a*b*c" doesn't match "ab".
+		}
+
+		uPos += m_rgSegLens[iSegment];
+	}
+
+	return cbTame - uPos >= shape.uTailLen &&
+	       SegmentAt(pWild + shape.uWildLen - shape.uTailLen,
+	                 shape.uTailLen, pTame + cbTame - shape.uTailLen);
+}
+
+
+// Portable filter for one group.
+//
+static uint32_t FilterGroupScalar(const WildPatternGroup *pGroup,
+                                  const uint8_t *rgKeyHead,
+                                  const uint8_t *rgKeyTail, uint32_t cbKey)
+{
+	uint32_t uSurvivors = 0;
+
+	for (int iLane = 0; iLane < WILD_GROUP_LANES; ++iLane)
+	{
+		bool bSurvives = cbKey >= pGroup->rgMinLen[iLane] &&
+		                 cbKey <= pGroup->rgMaxLen[iLane];
+
+		for (int iHead = 0; bSurvives && iHead < WILD_HEAD_BYTES; ++iHead)
+		{
+			bSurvives = (rgKeyHead[iHead] & pGroup->rgMask[iHead][iLane]) ==
+			            pGroup->rgHead[iHead][iLane];
+		}
+
+		for (int iTail = 0; bSurvives && iTail < WILD_TAIL_BYTES; ++iTail)
+		{
+			bSurvives = (rgKeyTail[iTail] & pGroup->rgTailMask[iTail][iLane]) ==
+			            pGroup->rgTail[iTail][iLane];
+		}
+
+		uSurvivors |= (uint32_t) bSurvives << iLane;
+	}
+
+	return uSurvivors;
+}
+
+
+#if defined(WILD_HAVE_AVX2_TARGET)
+// AVX2 filter for one group: one byte compare per head or tail position
+// covers all 32 lanes, and four unsigned min/max compares cover the length
+// bounds.
+//
+__attribute__((target("avx2")))
+static uint32_t FilterGroupAvx2(const WildPatternGroup *pGroup,
+                                const uint8_t *rgKeyHead,
+                                const uint8_t *rgKeyTail, uint32_t cbKey)
+{
+	__m256i vSurvivors = _mm256_set1_epi8(-1);
+
+	for (int iHead = 0; iHead < WILD_HEAD_BYTES; ++iHead)
+	{
+		__m256i vKey = _mm256_set1_epi8((char) rgKeyHead[iHead]);
+		__m256i vMask = _mm256_load_si256(
+		    (const __m256i *) pGroup->rgMask[iHead]);
+		__m256i vHead = _mm256_load_si256(
+		    (const __m256i *) pGroup->rgHead[iHead]);
+
+		vSurvivors = _mm256_and_si256(vSurvivors, _mm256_cmpeq_epi8(
+		    _mm256_and_si256(vKey, vMask), vHead));
+	}
+
+	for (int iTail = 0; iTail < WILD_TAIL_BYTES; ++iTail)
+	{
+		__m256i vKey = _mm256_set1_epi8((char) rgKeyTail[iTail]);
+		__m256i vMask = _mm256_load_si256(
+		    (const __m256i *) pGroup->rgTailMask[iTail]);
+		__m256i vTail = _mm256_load_si256(
+		    (const __m256i *) pGroup->rgTail[iTail]);
+
+		vSurvivors = _mm256_and_si256(vSurvivors, _mm256_cmpeq_epi8(
+		    _mm256_and_si256(vKey, vMask), vTail));
+	}
+
+	uint32_t uSurvivors = (uint32_t) _mm256_movemask_epi8(vSurvivors);
+
+	if (!uSurvivors)
+	{
+		return 0;                      // The common case, we hope.
+	}
+
+	__m256i  vLen = _mm256_set1_epi32((int) cbKey);
+	uint32_t uLenOk = 0;
+
+	for (int iQuarter = 0; iQuarter < WILD_GROUP_LANES / 8; ++iQuarter)
+	{
+		__m256i vMin = _mm256_load_si256(
+		    (const __m256i *) &pGroup->rgMinLen[iQuarter * 8]);
+		__m256i vMax = _mm256_load_si256(
+		    (const __m256i *) &pGroup->rgMaxLen[iQuarter * 8]);
+		__m256i vOk = _mm256_and_si256(
+		    _mm256_cmpeq_epi32(_mm256_max_epu32(vLen, vMin), vLen),
+		    _mm256_cmpeq_epi32(_mm256_min_epu32(vLen, vMax), vLen));
+
+		uLenOk |= (uint32_t) _mm256_movemask_ps(
+		    _mm256_castsi256_ps(vOk)) << (iQuarter * 8);
+	}
+
+	return uSurvivors & uLenOk;
+}
+
+
+static bool HaveAvx2()
+{
+	static const bool s_bAvx2 = __builtin_cpu_supports("avx2");
+	return s_bAvx2;
+}
+#endif  // defined(WILD_HAVE_AVX2_TARGET)
+
+
+// Gathers the tame string's leading and trailing bytes, zero-padded.
+// Padding never survives a literal compare wrongly, because a literal at
+// that offset implies a minimum length that the tame string does not have.
+//
+struct WildKeyEnds
+{
+	uint8_t rgHead[WILD_HEAD_BYTES];
+	uint8_t rgTail[WILD_TAIL_BYTES];
+};
+
+static inline void GetKeyEnds(const char *pTame, size_t cbTame,
+                              WildKeyEnds &ends)
+{
+	for (size_t iHead = 0; iHead < WILD_HEAD_BYTES; ++iHead)
+	{
+		ends.rgHead[iHead] = iHead < cbTame ? (uint8_t) pTame[iHead] : 0;
+	}
+
+	for (size_t iTail = 0; iTail < WILD_TAIL_BYTES; ++iTail)
+	{
+		ends.rgTail[iTail] = iTail < cbTame ?
+		                     (uint8_t) pTame[cbTame - 1 - iTail] : 0;
+	}
+}
+
+
+static inline uint32_t FilterGroupDispatch(const WildPatternGroup *pGroup,
+                                           const WildKeyEnds &ends,
+                                           uint32_t cbKey)
+{
+#if defined(WILD_HAVE_AVX2_TARGET)
+	if (HaveAvx2())
+	{
+		return FilterGroupAvx2(pGroup, ends.rgHead, ends.rgTail, cbKey);
+	}
+#endif
+
+	return FilterGroupScalar(pGroup, ends.rgHead, ends.rgTail, cbKey);
+}
+
+
+uint32_t WildPatternSet::FilterGroup(size_t iGroup, const char *pTame,
+                                     size_t cbTame) const
+{
+	WildKeyEnds ends;
+
+	GetKeyEnds(pTame, cbTame, ends);
+	return FilterGroupDispatch(&m_rgGroups[iGroup], ends, (uint32_t) cbTame);
+}
+
+
+int WildPatternSet::MatchFirstInGroups(const char *pTame, size_t cbTame,
+                                       size_t iGroupBegin, size_t iGroupEnd,
+                                       WildSegmentMemo &memo) const
+{
+	WildKeyEnds ends;
+
+	GetKeyEnds(pTame, cbTame, ends);
+
+	for (size_t iGroup = iGroupBegin; iGroup < iGroupEnd; ++iGroup)
+	{
+		uint32_t uSurvivors = FilterGroupDispatch(
+		    &m_rgGroups[iGroup], ends, (uint32_t) cbTame);
+
+		// Lanes come out lowest first, so the first full match found is
+		// the lowest-indexed one.
+		while (uSurvivors)
+		{
+			int iLane = WildLowestBit(uSurvivors);
+			int iPattern = (int) (iGroup * WILD_GROUP_LANES) + iLane;
+
+			if (MatchPattern(iPattern, pTame, cbTame, memo))
+			{
+				return iPattern;
+			}
+
+			uSurvivors &= uSurvivors - 1;
+		}
+	}
+
+	return -1;
+}
+
+
+int WildPatternSet::MatchFirst(const char *pTame) const
+{
+	WildSegmentMemo memo(Resource());
+
+	return MatchFirst(pTame, memo);
+}
+
+
+int WildPatternSet::MatchFirst(const char *pTame, WildSegmentMemo &memo) const
+{
+	size_t cbTame = strlen(pTame);
+
+	memo.Reset(pTame, cbTame);
+	return MatchFirstInGroups(pTame, cbTame, 0, m_rgGroups.size(), memo);
+}
+
+
+bool WildPatternSet::MatchAny(const char *pTame) const
+{
+	return MatchFirst(pTame) >= 0;
+}
+
+
+bool WildPatternSet::MatchAny(const char *pTame, WildSegmentMemo &memo) const
+{
+	return MatchFirst(pTame, memo) >= 0;
+}
+
+
+void WildPatternSet::MatchAll(const char *pTame, size_t cbTame,
+                              std::vector<int> &rgMatches,
+                              WildSegmentMemo &memo) const
+{
+	MatchAllInto(pTame, cbTame, rgMatches, memo);
+}
+
+
+void WildPatternSet::MatchAll(const char *pTame, size_t cbTame,
+                              std::pmr::vector<int> &rgMatches,
+                              WildSegmentMemo &memo) const
+{
+	MatchAllInto(pTame, cbTame, rgMatches, memo);
+}
+
+
+template <class Matches>
+void WildPatternSet::MatchAllInto(const char *pTame, size_t cbTame,
+                                  Matches &rgMatches,
+                                  WildSegmentMemo &memo) const
+{
+	WildKeyEnds ends;
+
+	GetKeyEnds(pTame, cbTame, ends);
+
+	for (size_t iGroup = 0; iGroup < m_rgGroups.size(); ++iGroup)
+	{
+		uint32_t uSurvivors = FilterGroupDispatch(
+		    &m_rgGroups[iGroup], ends, (uint32_t) cbTame);
+
+		while (uSurvivors)
+		{
+			int iPattern = (int) (iGroup * WILD_GROUP_LANES) +
+			               WildLowestBit(uSurvivors);
+
+			if (MatchPattern(iPattern, pTame, cbTame, memo))
+			{
+				rgMatches.push_back(iPattern);
+			}
+
+			uSurvivors &= uSurvivors - 1;
+		}
+	}
+}
+
+
+// The straightforward alternative: FastWildCompare() on each pattern.
+//
+static int MatchFirstByLoop(const WildPatternSet &set, const char *pTame)
+{
+	for (int iPattern = 0; iPattern < set.Count(); ++iPattern)
+	{
+		if (FastWildCompare(const_cast<char *>(set.Pattern(iPattern)),
+		                    const_cast<char *>(pTame)))
+		{
+			return iPattern;
+		}
+	}
+
+	return -1;
+}
+
+
+// A set of pattern set tests.  Every key's first match must agree with the
+// per-pattern loop, including keys shorter than the filtered head.
+//
+extern "C" int testpatternset(void)
+{
+	static const char *s_rgszWild[] =
+	{
+		"Hi*", "ab*d", "*ccd", "*issip*ss*", "xxxx*zzy*fffff", "xxx*zzy*f",
+		"xy*z*xyz", "*sip*", "mi*sip*", "*abac*", "a*zz*", "*12*23",
+		"a12b", "*12*12*", "*a?b", "*aa?", "a*b", "a*aar", "bL?h",
+		"bLa?", "?LaH", "?b*??", "?a*??", "??", "*?", "abc", "a", "",
+		"????", "ab?d", "abcd*", "abce", "*", "/srv/*", "/srv/app1?/*.log"
+	};
+	static const char *s_rgszTame[] =
+	{
+		"Hi", "abc", "abcccd", "mississipissippi", "xxxxzzzzzzzzyf",
+		"mississippi", "ababac", "aaazz", "a12b12", "caaab", "aaaaa",
+		"a*abab", "a*ar", "bLah", "bLaH", "abcd", "ab", "a", "", "abd",
+		"abce", "/srv/app17/cache3.log", "/srv/app17/cache3.txt", "xyz"
+	};
+	const int cWild = (int) (sizeof(s_rgszWild) / sizeof(s_rgszWild[0]));
+	const int cTame = (int) (sizeof(s_rgszTame) / sizeof(s_rgszTame[0]));
+	bool bAllPassed = true;
+
+	// Try each suffix of the pattern list, so every pattern gets a turn at
+	// being first and the lanes land in different group positions.
+	for (int iFirst = 0; iFirst < cWild; ++iFirst)
+	{
+		WildPatternSet set;
+
+		for (int iWild = iFirst; iWild < cWild; ++iWild)
+		{
+			set.Add(s_rgszWild[iWild]);
+		}
+
+		set.Build();
+
+		for (int iTame = 0; iTame < cTame; ++iTame)
+		{
+			int iExpected = MatchFirstByLoop(set, s_rgszTame[iTame]);
+
+			bAllPassed &= set.MatchFirst(s_rgszTame[iTame]) == iExpected;
+			bAllPassed &= set.MatchAny(s_rgszTame[iTame]) == (iExpected >= 0);
+		}
+	}
+
+	// Spans of several groups, with generated patterns and keys.
+	WildBenchRandom rng(12345);
+	WildPatternSet  set;
+	std::string     str;
+
+	for (int iWild = 0; iWild < 1000; ++iWild)
+	{
+		WildBenchMakePattern(rng, str);
+		set.Add(str.c_str());
+	}
+
+	set.Build();
+
+	WildSegmentMemo  memoAll;
+	std::vector<int> rgMatches;
+
+	for (int iTame = 0; iTame < 2000; ++iTame)
+	{
+		WildBenchMakeKey(rng, str);
+		bAllPassed &= set.MatchFirst(str.c_str()) ==
+		              MatchFirstByLoop(set, str.c_str());
+
+		// Every match, for some of the keys.
+		if (iTame % 8 == 0)
+		{
+			std::vector<int> rgExpected;
+
+			for (int iWild = 0; iWild < set.Count(); ++iWild)
+			{
+				if (FastWildCompare(const_cast<char *>(set.Pattern(iWild)),
+				                    const_cast<char *>(str.c_str())))
+				{
+					rgExpected.push_back(iWild);
+				}
+			}
+
+			rgMatches.clear();
+			memoAll.Reset(str.c_str(), str.size());
+			set.MatchAll(str.c_str(), str.size(), rgMatches, memoAll);
+			bAllPassed &= rgMatches == rgExpected;
+		}
+	}
+
+	// Shared segments: every pattern, through the memo with and without
+	// sharing, agrees with FastWildCompare() on every key.
+	static const char *s_rgszShared[] =
+	{
+		"*/prod/*", "*/prod/*.tar.gz", "*.tar.gz", "a*/prod/*b",
+		"*ab*ab*ab*", "*ab*", "*?b*ab*", "x*ab*?", "*/prod/*/prod/*",
+		"*aa*aa*", "*a*a*a*a*", "*", "**prod**"
+	};
+	static const char *s_rgszSharedTame[] =
+	{
+		"/srv/prod/x.tar.gz", "a/prod/b", "abababab", "aaaa", "aaaaa", "",
+		"x/prod/y/prod/z", "xab", "xabz", "prod", "ab", "bab"
+	};
+	WildPatternSet  setShared;
+	WildSegmentMemo memo, memoUnshared;
+
+	for (const char *pWild : s_rgszShared)
+	{
+		setShared.Add(pWild);
+	}
+
+	setShared.Build();
+	bAllPassed &= setShared.SegmentCount() == 6;
+	memoUnshared.SetSharing(false);
+
+	for (const char *pTame : s_rgszSharedTame)
+	{
+		size_t cbTame = strlen(pTame);
+
+		memo.Reset(pTame, cbTame);
+		memoUnshared.Reset(pTame, cbTame);
+
+		for (int iWild = 0; iWild < setShared.Count(); ++iWild)
+		{
+			bool bExpected = FastWildCompare(
+			    const_cast<char *>(setShared.Pattern(iWild)),
+			    const_cast<char *>(pTame));
+
+			bAllPassed &= setShared.MatchPattern(iWild, pTame, cbTame,
+			                                     memo) == bExpected;
+			bAllPassed &= setShared.MatchPattern(iWild, pTame, cbTame,
+			                                     memoUnshared) == bExpected;
+		}
+	}
+
+	// An empty set matches nothing.
+	WildPatternSet setEmpty;
+
+	setEmpty.Build();
+	bAllPassed &= setEmpty.MatchFirst("abc") == -1;
+
+	if (bAllPassed)
+	{
+		printf("Passed pattern set tests\n");
+	}
+	else
+	{
+		printf("Failed pattern set tests\n");
+	}
+
+	return 0;
+}
+
+
+// Makes a rule-set style pattern from a few recurring pieces: directory
+// names, tenant ids and extensions, as in "*/prod/*tenant-042*.tar.gz".
+//
+static void MakeSharedPattern(WildBenchRandom &rng, std::string &strWild)
+{
+	static const char *s_rgszDirs[] =
+	{
+		"/prod/", "/staging/", "/dev/", "/archive/", "/backup/", "/tmp/",
+		"/logs/", "/cache/"
+	};
+	static const char *s_rgszExts[] =
+	{
+		".log", ".tar.gz", ".json", ".parquet"
+	};
+	char szTenant[32];
+
+	snprintf(szTenant, sizeof(szTenant), "tenant-%03u", rng.Below(500));
+
+	switch (rng.Below(4))
+	{
+	case 0:
+		strWild = std::string("*") + s_rgszDirs[rng.Below(8)] + "*" +
+		          s_rgszExts[rng.Below(4)];
+		break;
+
+	case 1:
+		strWild = std::string("*") + szTenant + "*" +
+		          s_rgszDirs[rng.Below(8)] + "*";
+		break;
+
+	case 2:
+		strWild = std::string("*") + s_rgszDirs[rng.Below(8)] + "*" +
+		          szTenant + "*" + s_rgszExts[rng.Below(4)];
+		break;
+
+	default:
+		strWild = std::string("*") + szTenant + "*" +
+		          s_rgszDirs[rng.Below(8)] + "*" + s_rgszDirs[rng.Below(8)] +
+		          "*";
+		break;
+	}
+}
+
+
+// Makes a key that the shared-segment patterns might match.
+//
+static void MakeSharedKey(WildBenchRandom &rng, std::string &strKey)
+{
+	static const char *s_rgszParts[] =
+	{
+		"prod", "staging", "dev", "archive", "backup", "tmp", "logs",
+		"cache", "data", "srv"
+	};
+	static const char *s_rgszExts[] =
+	{
+		".log", ".tar.gz", ".json", ".parquet", ".csv"
+	};
+	char szTenant[32];
+
+	snprintf(szTenant, sizeof(szTenant), "tenant-%03u", rng.Below(2000));
+	strKey = "/";
+	strKey += s_rgszParts[rng.Below(10)];
+	strKey += "/";
+	strKey += szTenant;
+	strKey += "/";
+	strKey += s_rgszParts[rng.Below(10)];
+	strKey += "/";
+	strKey += s_rgszParts[rng.Below(10)];
+	strKey += "/file";
+	strKey += s_rgszExts[rng.Below(5)];
+}
+
+
+// Compares bytes scanned per key, and time per key, with and without
+// shared segment positions, on a set whose patterns keep reusing the same
+// few dozen directory, tenant and extension segments.  Every key is
+// matched against every pattern, as when collecting all matches.
+//
+static void BenchSharedSegments()
+{
+	const int       cPatterns = 100000;
+	const int       cKeys = 200;
+	WildBenchRandom rng(4242);
+	WildPatternSet  set;
+	std::string     str;
+	std::vector<std::string> rgKeys(cKeys);
+
+	for (int i = 0; i < cPatterns; ++i)
+	{
+		MakeSharedPattern(rng, str);
+		set.Add(str.c_str());
+	}
+
+	set.Build();
+
+	for (int i = 0; i < cKeys; ++i)
+	{
+		MakeSharedKey(rng, rgKeys[i]);
+	}
+
+	for (int iShare = 0; iShare < 2; ++iShare)
+	{
+		WildSegmentMemo memo;
+		uint64_t        uHits = 0;
+		uint64_t        uStart = WildBenchNanos();
+
+		memo.SetSharing(iShare != 0);
+
+		for (int iKey = 0; iKey < cKeys; ++iKey)
+		{
+			const char *pTame = rgKeys[iKey].c_str();
+			size_t      cbTame = rgKeys[iKey].size();
+
+			memo.Reset(pTame, cbTame);
+
+			for (int iWild = 0; iWild < cPatterns; ++iWild)
+			{
+				uHits += set.MatchPattern(iWild, pTame, cbTame, memo);
+			}
+		}
+
+		uint64_t uNanos = WildBenchNanos() - uStart;
+
+		printf("Shared segments, %d patterns (%zu distinct segments), "
+		       "sharing %s: %.0f bytes scanned/key, %.1f us/key, "
+		       "%llu matches\n", cPatterns, set.SegmentCount(),
+		       iShare ? "on" : "off",
+		       (double) memo.BytesScanned() / cKeys,
+		       uNanos / 1000.0 / cKeys, (unsigned long long) uHits);
+	}
+}
+
+
+// Compares the per-pattern FastWildCompare() loop against the filtered set,
+// at 10K, 100K and 1M patterns.  Keys are path-like, as in real rule sets,
+// and three in four of them match no pattern.
+//
+extern "C" int benchpatternset(void)
+{
+	static const int s_rgcPatterns[] = { 10000, 100000, 1000000 };
+
+	for (int iSize = 0; iSize < 3; ++iSize)
+	{
+		int             cPatterns = s_rgcPatterns[iSize];
+		int             cKeys = 20000000 / cPatterns;
+		WildBenchRandom rng(42);
+		WildPatternSet  set;
+		std::string     str;
+		std::vector<std::string> rgKeys(cKeys);
+		uint64_t        uLoopHits = 0, uSetHits = 0;
+		uint64_t        uSurvivors = 0;
+
+		for (int iWild = 0; iWild < cPatterns; ++iWild)
+		{
+			WildBenchMakePattern(rng, str);
+			set.Add(str.c_str());
+		}
+
+		set.Build();
+
+		for (int iKey = 0; iKey < cKeys; ++iKey)
+		{
+			WildBenchMakeKey(rng, rgKeys[iKey], iKey % 4 != 0);
+		}
+
+		uint64_t uStart = WildBenchNanos();
+
+		for (int iKey = 0; iKey < cKeys; ++iKey)
+		{
+			uLoopHits += MatchFirstByLoop(set, rgKeys[iKey].c_str()) + 1;
+		}
+
+		uint64_t uLoopNanos = WildBenchNanos() - uStart;
+
+		WildSegmentMemo memo;
+
+		uStart = WildBenchNanos();
+
+		for (int iKey = 0; iKey < cKeys; ++iKey)
+		{
+			uSetHits += set.MatchFirst(rgKeys[iKey].c_str(), memo) + 1;
+		}
+
+		uint64_t uSetNanos = WildBenchNanos() - uStart;
+
+		// Survivor rate, measured separately so it doesn't skew timings.
+		for (int iKey = 0; iKey < cKeys && iKey < 100; ++iKey)
+		{
+			for (size_t iGroup = 0; iGroup < set.GroupCount(); ++iGroup)
+			{
+				uSurvivors += WildBitCount(set.FilterGroup(
+				    iGroup, rgKeys[iKey].c_str(), rgKeys[iKey].size()));
+			}
+		}
+
+		printf("Pattern set, %d patterns x %d keys: "
+		       "FastWildCompare loop %.1f us/key, "
+		       "filtered set %.1f us/key, "
+		       "%.2f%% of patterns survive the filter%s\n",
+		       cPatterns, cKeys, uLoopNanos / 1000.0 / cKeys,
+		       uSetNanos / 1000.0 / cKeys,
+		       100.0 * uSurvivors / ((double) cPatterns *
+		                             (cKeys < 100 ? cKeys : 100)),
+		       uLoopHits == uSetHits ? "" : " (RESULTS DIFFER)");
+	}
+
+	BenchSharedSegments();
+	return 0;
+}
@@ -0,0 +1,256 @@
+// WildPatternSet, for matching one string against many wildcard patterns
+//
+// Copyright 2025 Kirk J Krauss.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// A pattern set holds many wildcard patterns and answers "which pattern, if
+// any, matches this tame string?"  Each pattern's leading and trailing
+// literal bytes and its minimum and maximum matchable lengths are kept in
+// transposed (SoA) groups of WILD_GROUP_LANES patterns, so that a whole
+// group can be ruled out by a few vector compares.
+//
+// Patterns that survive that filter are matched segment by segment.  The
+// segments between '*' wildcards are hash-consed when the set is built, so
+// that "*/prod/*" appearing in a thousand patterns is one segment.  For
+// each tame string, a WildSegmentMemo records where each segment occurs,
+// searching for it at most once, and every pattern that uses the segment
+// consumes those positions.
+//
+// A set, and a memo, take their memory from the resource they're made
+// with, as does Build() for its scratch, so that a set built per request
+// or per shard can come from a monotonic or pooled resource.
+//
+#ifndef WILDPATTERNSET_H
+#define WILDPATTERNSET_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <memory_resource>
+#include <vector>
+
+class WildPatternSet;
+
+// Index of the lowest set bit; uMask must be nonzero.
+//
+static inline int WildLowestBit(uint32_t uMask)
+{
+#if defined(__GNUC__)
+	return __builtin_ctz(uMask);
+#else
+	int iBit = 0;
+
+	while (!(uMask & 1))
+	{
+		uMask >>= 1;
+		++iBit;
+	}
+
+	return iBit;
+#endif
+}
+
+
+// Number of set bits.
+//
+static inline int WildBitCount(uint32_t uMask)
+{
+	int cBits = 0;
+
+	for (; uMask; uMask &= uMask - 1)
+	{
+		++cBits;
+	}
+
+	return cBits;
+}
+
+
+#define WILD_HEAD_BYTES      8    // Leading pattern bytes kept per lane
+#define WILD_TAIL_BYTES      4    // Trailing pattern bytes kept per lane
+#define WILD_GROUP_LANES     32   // Patterns per transposed group
+
+// Filter features for a group of patterns, stored lane-wise.  A lane's
+// head byte is compared against the tame string's byte under its mask,
+// which is zero for '?' and for anything at or after the first '*'.  Tail
+// bytes work the same way, counting back from the end of both strings, so
+// that patterns such as "*.tar.gz" get filtered too.
+//
+struct alignas(64) WildPatternGroup
+{
+	uint8_t  rgHead[WILD_HEAD_BYTES][WILD_GROUP_LANES];
+	uint8_t  rgMask[WILD_HEAD_BYTES][WILD_GROUP_LANES];
+	uint8_t  rgTail[WILD_TAIL_BYTES][WILD_GROUP_LANES];
+	uint8_t  rgTailMask[WILD_TAIL_BYTES][WILD_GROUP_LANES];
+	uint32_t rgMinLen[WILD_GROUP_LANES];
+	uint32_t rgMaxLen[WILD_GROUP_LANES];
+};
+
+// How a pattern decomposes into an anchored prefix, shared middle
+// segments, and an end-anchored tail.
+//
+struct WildPatternShape
+{
+	uint32_t uWildLen;       // Bytes in the whole pattern
+	uint32_t uPrefixLen;     // Bytes ahead of the first '*'
+	uint32_t uTailLen;       // Bytes after the last '*'
+	uint32_t iFirstSegment;  // Index into the set's segment id list
+	uint32_t cSegments;      // Middle segments, in order
+	uint32_t uCost;          // Static estimate of the work to match it
+	bool     bStar;          // False if the pattern has no '*' at all
+};
+
+
+// Per-tame-string record of where each distinct segment occurs.  Segment
+// positions are found lazily, left to right, and kept, so no byte of the
+// tame string is examined twice for the same segment.  A memo may be
+// reused for any number of tame strings, but by one thread at a time.
+//
+class WildSegmentMemo
+{
+public:
+	explicit WildSegmentMemo(std::pmr::memory_resource *pResource =
+	                         std::pmr::get_default_resource());
+
+	// Starts over with a new tame string.
+	void Reset(const char *pTame, size_t cbTame);
+
+	// Returns the leftmost start of segment iSegment at or after uPos, or
+	// SIZE_MAX if there is none.
+	size_t Find(const WildPatternSet &set, uint32_t iSegment, size_t uPos);
+
+	// With sharing off, every Find() searches afresh, as it would without
+	// hash-consing.  For comparison only.
+	void SetSharing(bool bShare)
+	{
+		m_bShare = bShare;
+	}
+
+	// Candidate positions examined by segment searches since construction.
+	uint64_t BytesScanned() const
+	{
+		return m_cbScanned;
+	}
+
+private:
+	const char                *m_pTame;
+	size_t                     m_cbTame;
+	uint32_t                   m_uGeneration;  // Bumped per Reset()
+	std::pmr::vector<uint32_t> m_rgStamp;      // Generation per segment
+	std::pmr::vector<size_t>   m_rgCursor;     // Scanned up to here
+	std::pmr::vector<std::pmr::vector<uint32_t>> m_rgPositions;  // Found
+	uint64_t                   m_cbScanned;
+	bool                       m_bShare;
+};
+
+
+class WildPatternSet
+{
+	friend class WildSegmentMemo;
+
+public:
+	explicit WildPatternSet(std::pmr::memory_resource *pResource =
+	                        std::pmr::get_default_resource());
+
+	// Adds a pattern and returns its index.  Indexes are assigned in order
+	// of addition, and "first match" means the lowest matching index.
+	int Add(const char *pWild);
+
+	// Lays out the transposed groups.  Call after the last Add().
+	void Build();
+
+	// Returns the lowest index of a pattern matching pTame, or -1.  A
+	// memo is made for the call from the set's resource.  Callers that
+	// match many strings can pass a memo of their own instead, to keep
+	// the segment tables it allocates from one call to the next.
+	int MatchFirst(const char *pTame) const;
+	int MatchFirst(const char *pTame, WildSegmentMemo &memo) const;
+
+	// Returns true if any pattern matches pTame.
+	bool MatchAny(const char *pTame) const;
+	bool MatchAny(const char *pTame, WildSegmentMemo &memo) const;
+
+	// Same as MatchFirst(), restricted to groups [iGroupBegin, iGroupEnd),
+	// with segment positions kept in a memo already Reset() for pTame.
+	int MatchFirstInGroups(const char *pTame, size_t cbTame,
+	                       size_t iGroupBegin, size_t iGroupEnd,
+	                       WildSegmentMemo &memo) const;
+
+	// Appends the index of every pattern that matches a tame string of
+	// cbTame bytes to rgMatches, lowest first, with segment positions kept
+	// in a memo already Reset() for it.
+	void MatchAll(const char *pTame, size_t cbTame,
+	              std::vector<int> &rgMatches, WildSegmentMemo &memo) const;
+
+	void MatchAll(const char *pTame, size_t cbTame,
+	              std::pmr::vector<int> &rgMatches,
+	              WildSegmentMemo &memo) const;
+
+	// Matches one pattern, via its shape and the memo.
+	bool MatchPattern(int iPattern, const char *pTame, size_t cbTame,
+	                  WildSegmentMemo &memo) const;
+
+	// Bitmask of the lanes in a group that survive the head, tail and
+	// length filter.
+	uint32_t FilterGroup(size_t iGroup, const char *pTame,
+	                     size_t cbTame) const;
+
+	int Count() const
+	{
+		return (int) m_rgOffsets.size();
+	}
+
+	size_t GroupCount() const
+	{
+		return m_rgGroups.size();
+	}
+
+	size_t SegmentCount() const
+	{
+		return m_rgSegOffsets.size();
+	}
+
+	// Static estimate of the work a pattern adds to each lookup.
+	uint32_t Cost(int iPattern) const
+	{
+		return m_rgShapes[iPattern].uCost;
+	}
+
+	const char *Pattern(int iPattern) const
+	{
+		return &m_rgText[m_rgOffsets[iPattern]];
+	}
+
+	std::pmr::memory_resource *Resource() const
+	{
+		return m_rgText.get_allocator().resource();
+	}
+
+private:
+	template <class Matches>
+	void MatchAllInto(const char *pTame, size_t cbTame, Matches &rgMatches,
+	                  WildSegmentMemo &memo) const;
+
+	std::pmr::vector<char>             m_rgText;     // NUL-terminated
+	std::pmr::vector<uint32_t>         m_rgOffsets;  // Where each starts
+	std::pmr::vector<WildPatternGroup> m_rgGroups;   // Transposed filters
+	std::pmr::vector<WildPatternShape> m_rgShapes;   // Decompositions
+	std::pmr::vector<uint32_t>         m_rgSegIds;   // Middle segments
+	std::pmr::vector<uint32_t>         m_rgSegOffsets;  // Distinct segment
+	std::pmr::vector<uint32_t>         m_rgSegLens;     // text, in m_rgText
+};
+
+extern "C" int testpatternset(void);
+extern "C" int benchpatternset(void);
+
+#endif  // WILDPATTERNSET_H
@@ -0,0 +1,766 @@
+// WildPipeline, and related code
+//
+// Copyright 2025 Kirk J Krauss.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// This file provides the pipeline's stages and the queue waits between
+// them.  It also includes testcases for correctness and performance.
+//
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "fastwildcompare.h"
+#include "wildparallel.h"
+#include "wildpipeline.h"
+#include "wildbench.h"
+
+#define WILD_PIPE_SPINS   64   // Idle polls spent pausing before yielding
+
+
+static uint64_t SteadyNanos()
+{
+	return (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+	    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+// Waits out one idle poll: pausing at first, then yielding, since the
+// stage being waited on may need this thread's core.
+//
+static void PipeBackoff(uint32_t cIdle)
+{
+	if (cIdle < WILD_PIPE_SPINS)
+	{
+		WildCpuRelax();
+	}
+	else
+	{
+		std::this_thread::yield();
+	}
+}
+
+
+// Takes the next buffer from a stage's input, waiting for one if need be,
+// and notes the queue's depth and any stall.
+//
+static WildPipeBuffer *PipePop(WildSpscQueue<WildPipeBuffer *> &queue,
+                               WildPipeStats &stats)
+{
+	WildPipeBuffer *pBuffer = NULL;
+	uint32_t        cIdle = 0;
+
+	while (!queue.TryPop(pBuffer))
+	{
+		stats.cStalls += cIdle == 0;
+		PipeBackoff(cIdle++);
+	}
+
+	size_t cDepth = queue.Depth() + 1;
+
+	stats.cDepthSum += cDepth;
+	stats.cMaxDepth = std::max(stats.cMaxDepth, cDepth);
+	return pBuffer;
+}
+
+
+// Passes a buffer to the next stage, waiting for room if need be.
+//
+static void PipePush(WildSpscQueue<WildPipeBuffer *> &queue,
+                     WildPipeBuffer *pBuffer, WildPipeStats &stats)
+{
+	uint32_t cIdle = 0;
+
+	while (!queue.TryPush(pBuffer))
+	{
+		stats.cStalls += cIdle == 0;
+		PipeBackoff(cIdle++);
+	}
+}
+
+
+// Sets up a pipeline of the configured stages and buffers, with at least
+// one matcher and one buffer.
+//
+WildPipeline::WildPipeline(const WildPipeConfig &config,
+                           const WildPipeSource &source,
+                           const WildPipeMatch &match,
+                           const WildPipeSink &sink) :
+    m_config(config), m_source(source), m_match(match), m_sink(sink)
+{
+	m_config.cMatchers = std::max(m_config.cMatchers, 1);
+	m_config.cbBuffer = std::max(m_config.cbBuffer, (size_t) 1);
+	m_config.cBuffers = std::max(m_config.cBuffers, (size_t) 1);
+	m_config.cQueue = std::max(m_config.cQueue, (size_t) 1);
+
+	for (size_t i = 0; i < m_config.cBuffers; ++i)
+	{
+		m_rgBuffers.emplace_back(new WildPipeBuffer());
+
+		// Room for a NUL after a last line that has no newline.
+		m_rgBuffers.back()->rgch.resize(m_config.cbBuffer + 1);
+		m_rgBuffers.back()->cb = 0;
+	}
+
+	m_rgStats.assign(m_config.cMatchers + 3, WildPipeStats());
+}
+
+
+const WildPipeStats &WildPipeline::Stats(int iStage) const
+{
+	return m_rgStats[iStage];
+}
+
+
+// Fills buffers from the source, each up to its last newline, carrying
+// what follows into the next buffer.  A buffer with no newline at all
+// goes as it is, splitting a line too long for it.
+//
+void WildPipeline::ReadStage()
+{
+	WildPipeStats    &stats = m_rgStats[WILD_PIPE_READER];
+	std::vector<char> rgchCarry;
+	bool              bEnd = false;
+
+	while (!bEnd)
+	{
+		WildPipeBuffer *pBuffer = PipePop(*m_pFree, stats);
+		uint64_t        uStart = SteadyNanos();
+		char           *pch = pBuffer->rgch.data();
+		size_t          cb = rgchCarry.size();
+
+		if (cb)
+		{
+			memcpy(pch, rgchCarry.data(), cb);
+			rgchCarry.clear();
+		}
+
+		while (cb < m_config.cbBuffer)
+		{
+			size_t cbRead = m_source(pch + cb, m_config.cbBuffer - cb);
+
+			if (cbRead == 0)
+			{
+				bEnd = true;
+				break;
+			}
+
+			cb += cbRead;
+		}
+
+		if (!bEnd)
+		{
+			size_t cbKeep = cb;
+
+			while (cbKeep && pch[cbKeep - 1] != '\n')
+			{
+				--cbKeep;
+			}
+
+			if (cbKeep)
+			{
+				rgchCarry.assign(pch + cbKeep, pch + cb);
+				cb = cbKeep;
+			}
+		}
+
+		pBuffer->cb = cb;
+		stats.uBusyNanos += SteadyNanos() - uStart;
+
+		if (cb)
+		{
+			++stats.cBuffers;
+			stats.cbBytes += cb;
+			PipePush(*m_pRead, pBuffer, stats);
+		}
+	}
+
+	PipePush(*m_pRead, NULL, stats);
+}
+
+
+// Ends each line with a NUL in place of its newline, notes where each
+// starts, and hands buffers to the matchers in turn.
+//
+void WildPipeline::SplitStage()
+{
+	WildPipeStats &stats = m_rgStats[WILD_PIPE_SPLITTER];
+	size_t         iMatcher = 0;
+
+	for (;;)
+	{
+		WildPipeBuffer *pBuffer = PipePop(*m_pRead, stats);
+
+		if (pBuffer == NULL)
+		{
+			break;
+		}
+
+		uint64_t uStart = SteadyNanos();
+		char    *pch = pBuffer->rgch.data();
+		char    *pchEnd = pch + pBuffer->cb;
+		char    *pchLine = pch;
+
+		pBuffer->rgLines.clear();
+		pBuffer->rgLines.push_back(0);
+
+		while (pchLine < pchEnd)
+		{
+			char *pchNewline = (char *) memchr(pchLine, '\n',
+			                                   pchEnd - pchLine);
+
+			if (pchNewline == NULL)
+			{
+				pchNewline = pchEnd;
+			}
+
+			*pchNewline = '\0';
+			pchLine = pchNewline + 1;
+			pBuffer->rgLines.push_back((uint32_t) (pchLine - pch));
+		}
+
+		pBuffer->rgbMatch.resize(pBuffer->rgLines.size() - 1);
+		++stats.cBuffers;
+		stats.cLines += pBuffer->rgbMatch.size();
+		stats.cbBytes += pBuffer->cb;
+		stats.uBusyNanos += SteadyNanos() - uStart;
+		PipePush(*m_rgToMatch[iMatcher], pBuffer, stats);
+		iMatcher = (iMatcher + 1) % m_rgToMatch.size();
+	}
+
+	for (std::unique_ptr<WildPipeQueue> &pQueue : m_rgToMatch)
+	{
+		PipePush(*pQueue, NULL, stats);
+	}
+}
+
+
+// Matches each line of each buffer that comes this matcher's way.
+//
+void WildPipeline::MatchStage(int iMatcher)
+{
+	WildPipeStats &stats = m_rgStats[WILD_PIPE_MATCHER + iMatcher];
+	WildPipeMatch  match(m_match);
+
+	for (;;)
+	{
+		WildPipeBuffer *pBuffer = PipePop(*m_rgToMatch[iMatcher], stats);
+
+		if (pBuffer == NULL)
+		{
+			break;
+		}
+
+		uint64_t    uStart = SteadyNanos();
+		const char *pch = pBuffer->rgch.data();
+		size_t      cLines = pBuffer->rgbMatch.size();
+
+		for (size_t iLine = 0; iLine < cLines; ++iLine)
+		{
+			uint32_t iStart = pBuffer->rgLines[iLine];
+
+			pBuffer->rgbMatch[iLine] = match(pch + iStart,
+			    pBuffer->rgLines[iLine + 1] - iStart - 1);
+		}
+
+		++stats.cBuffers;
+		stats.cLines += cLines;
+		stats.cbBytes += pBuffer->cb;
+		stats.uBusyNanos += SteadyNanos() - uStart;
+		PipePush(*m_rgMatched[iMatcher], pBuffer, stats);
+	}
+
+	PipePush(*m_rgMatched[iMatcher], NULL, stats);
+}
+
+
+// Takes buffers back from the matchers in the turn they went out, passes
+// each run of matching lines to the sink with their newlines restored,
+// and returns the buffers to the reader.  Returns the lines matched.
+//
+uint64_t WildPipeline::WriteStage()
+{
+	WildPipeStats &stats = m_rgStats.back();
+	size_t         iMatcher = 0;
+	uint64_t       cMatched = 0;
+
+	for (;;)
+	{
+		WildPipeBuffer *pBuffer = PipePop(*m_rgMatched[iMatcher], stats);
+
+		if (pBuffer == NULL)
+		{
+			break;
+		}
+
+		uint64_t uStart = SteadyNanos();
+		char    *pch = pBuffer->rgch.data();
+		size_t   cLines = pBuffer->rgbMatch.size();
+		size_t   iLine = 0;
+
+		while (iLine < cLines)
+		{
+			if (!pBuffer->rgbMatch[iLine])
+			{
+				++iLine;
+				continue;
+			}
+
+			uint32_t iStart = pBuffer->rgLines[iLine];
+
+			while (iLine < cLines && pBuffer->rgbMatch[iLine])
+			{
+				pch[pBuffer->rgLines[++iLine] - 1] = '\n';
+				++cMatched;
+				++stats.cLines;
+			}
+
+			stats.cbBytes += pBuffer->rgLines[iLine] - iStart;
+			m_sink(pch + iStart, pBuffer->rgLines[iLine] - iStart);
+		}
+
+		++stats.cBuffers;
+		stats.uBusyNanos += SteadyNanos() - uStart;
+		PipePush(*m_pFree, pBuffer, stats);
+		iMatcher = (iMatcher + 1) % m_rgMatched.size();
+	}
+
+	return cMatched;
+}
+
+
+// Starts the reader, the splitter, and the matchers on threads of their
+// own, writes on this one, and waits for the rest to finish.
+//
+uint64_t WildPipeline::Run()
+{
+	std::vector<std::thread> rgThreads;
+
+	m_rgStats.assign(m_rgStats.size(), WildPipeStats());
+	m_pFree.reset(new WildPipeQueue(m_rgBuffers.size()));
+	m_pRead.reset(new WildPipeQueue(m_config.cQueue));
+	m_rgToMatch.clear();
+	m_rgMatched.clear();
+
+	for (std::unique_ptr<WildPipeBuffer> &pBuffer : m_rgBuffers)
+	{
+		m_pFree->TryPush(pBuffer.get());
+	}
+
+	for (int i = 0; i < m_config.cMatchers; ++i)
+	{
+		m_rgToMatch.emplace_back(new WildPipeQueue(m_config.cQueue));
+		m_rgMatched.emplace_back(new WildPipeQueue(m_config.cQueue));
+	}
+
+	rgThreads.emplace_back(&WildPipeline::ReadStage, this);
+	rgThreads.emplace_back(&WildPipeline::SplitStage, this);
+
+	for (int i = 0; i < m_config.cMatchers; ++i)
+	{
+		rgThreads.emplace_back(&WildPipeline::MatchStage, this, i);
+	}
+
+	uint64_t cMatched = WriteStage();
+
+	for (std::thread &thread : rgThreads)
+	{
+		thread.join();
+	}
+
+	return cMatched;
+}
+
+
+// Expected output: the lines of strText that match, each with a newline.
+//
+static std::string FilterLines(const std::string &strText,
+                               const WildPipeMatch &match)
+{
+	std::string strOut;
+	size_t      iLine = 0;
+
+	while (iLine < strText.size())
+	{
+		size_t iEnd = strText.find('\n', iLine);
+
+		if (iEnd == std::string::npos)
+		{
+			iEnd = strText.size();
+		}
+
+		std::string strLine = strText.substr(iLine, iEnd - iLine);
+
+		if (match(strLine.c_str(), strLine.size()))
+		{
+			strOut += strLine + "\n";
+		}
+
+		iLine = iEnd + 1;
+	}
+
+	return strOut;
+}
+
+
+extern "C" int testpipeline(void)
+{
+	bool bAllPassed = true;
+
+	{
+		// The queue holds a power of 2, and keeps its order between two
+		// threads.
+		WildSpscQueue<uint32_t> queue(5);
+		uint32_t                u = 0;
+		bool                    bInOrder = true;
+
+		for (uint32_t i = 0; i < 8; ++i)
+		{
+			bAllPassed &= queue.TryPush(i);
+		}
+
+		bAllPassed &= queue.Capacity() == 8 && !queue.TryPush(8) &&
+		              queue.Depth() == 8;
+
+		for (uint32_t i = 0; i < 8; ++i)
+		{
+			bAllPassed &= queue.TryPop(u) && u == i;
+		}
+
+		bAllPassed &= !queue.TryPop(u);
+
+		std::thread producer([&]()
+		{
+			for (uint32_t i = 0; i < 200000; ++i)
+			{
+				while (!queue.TryPush(i))
+				{
+					std::this_thread::yield();
+				}
+			}
+		});
+
+		for (uint32_t i = 0; i < 200000; ++i)
+		{
+			while (!queue.TryPop(u))
+			{
+				std::this_thread::yield();
+			}
+
+			bInOrder &= u == i;
+		}
+
+		producer.join();
+		bAllPassed &= bInOrder;
+	}
+
+	WildBenchRandom rng(1200);
+	std::string     strText;
+	std::string     strKey;
+	WildPipeMatch   match = [](const char *pLine, size_t)
+	{
+		return FastWildCompare((char *) "*s*o*", (char *) pLine);
+	};
+
+	for (int i = 0; i < 3000; ++i)
+	{
+		if (rng.Below(10) == 0)
+		{
+			strKey.clear();
+		}
+		else
+		{
+			WildBenchMakeKey(rng, strKey, rng.Below(4) == 0);
+		}
+
+		strText += strKey + "\n";
+	}
+
+	strText += "last/line/so/unterminated";
+
+	for (int cMatchers = 1; cMatchers <= 3; ++cMatchers)
+	{
+		for (size_t cbBuffer : {200, 4096})
+		{
+			// Sources that hand over a few bytes at a time, into small
+			// buffers and short queues, with lines shorter than a buffer:
+			// the output is the lines that match, in order.
+			WildPipeConfig config = {cMatchers, cbBuffer, 4, 2};
+			size_t         iRead = 0;
+			std::string    strOut;
+			WildPipeline   pipeline(config, [&](char *p, size_t cb)
+			{
+				cb = std::min(cb, std::min((size_t) 1 + rng.Below(300),
+				                           strText.size() - iRead));
+				memcpy(p, strText.data() + iRead, cb);
+				iRead += cb;
+				return cb;
+			}, match, [&](const char *p, size_t cb)
+			{
+				strOut.append(p, cb);
+			});
+			std::string    strExpected = FilterLines(strText, match);
+			uint64_t       cMatched = pipeline.Run();
+			uint64_t       cMatcherLines = 0;
+
+			for (int i = 0; i < cMatchers; ++i)
+			{
+				cMatcherLines +=
+				    pipeline.Stats(WILD_PIPE_MATCHER + i).cLines;
+			}
+
+			bAllPassed &= strOut == strExpected &&
+			    cMatched == (uint64_t) std::count(strOut.begin(),
+			                                      strOut.end(), '\n') &&
+			    pipeline.StageCount() == cMatchers + 3 &&
+			    pipeline.Stats(WILD_PIPE_READER).cbBytes == strText.size() &&
+			    pipeline.Stats(WILD_PIPE_SPLITTER).cLines == 3001 &&
+			    cMatcherLines == 3001 &&
+			    pipeline.Stats(pipeline.StageCount() - 1).cLines == cMatched;
+
+			// Run again, on the same buffers: the same output.
+			iRead = 0;
+			strOut.clear();
+			bAllPassed &= pipeline.Run() == cMatched && strOut == strExpected;
+		}
+	}
+
+	{
+		// Lines longer than a buffer go in pieces, each its own line.
+		std::string    strLong(1000, 'x');
+		WildPipeConfig config = {2, 64, 3, 1};
+		size_t         iRead = 0;
+		std::string    strOut;
+		WildPipeline   pipeline(config, [&](char *p, size_t cb)
+		{
+			cb = std::min(cb, strLong.size() - iRead);
+			memcpy(p, strLong.data() + iRead, cb);
+			iRead += cb;
+			return cb;
+		}, [](const char *, size_t)
+		{
+			return true;
+		}, [&](const char *p, size_t cb)
+		{
+			strOut.append(p, cb);
+		});
+
+		bAllPassed &= pipeline.Run() == 16 && strOut.size() == 1016 &&
+		              std::count(strOut.begin(), strOut.end(), 'x') == 1000;
+	}
+
+	if (bAllPassed)
+	{
+		printf("Passed pipeline tests\n");
+	}
+	else
+	{
+		printf("Failed pipeline tests\n");
+	}
+
+	return 0;
+}
+
+
+static void PrintPipeStats(const WildPipeline &pipeline, uint64_t uNanos)
+{
+	for (int iStage = 0; iStage < pipeline.StageCount(); ++iStage)
+	{
+		const WildPipeStats &stats = pipeline.Stats(iStage);
+		char                 szName[32];
+
+		if (iStage == WILD_PIPE_READER)
+		{
+			snprintf(szName, sizeof szName, "reader");
+		}
+		else if (iStage == WILD_PIPE_SPLITTER)
+		{
+			snprintf(szName, sizeof szName, "splitter");
+		}
+		else if (iStage == pipeline.StageCount() - 1)
+		{
+			snprintf(szName, sizeof szName, "writer");
+		}
+		else
+		{
+			snprintf(szName, sizeof szName, "matcher %d",
+			         iStage - WILD_PIPE_MATCHER);
+		}
+
+		printf("    %-10s %6llu buffers %8.1f MB/s busy, %3.0f%% busy, "
+		       "%6llu stalls, queue avg %4.1f max %2zu\n", szName,
+		       (unsigned long long) stats.cBuffers,
+		       stats.uBusyNanos ? stats.cbBytes * 1e3 / stats.uBusyNanos :
+		       0.0, stats.uBusyNanos * 100.0 / uNanos,
+		       (unsigned long long) stats.cStalls, stats.cBuffers ?
+		       (double) stats.cDepthSum / stats.cBuffers : 0.0,
+		       stats.cMaxDepth);
+	}
+}
+
+
+extern "C" int benchpipeline(void)
+{
+	const size_t             cLines = 1000000;
+	const size_t             cbBuffer = 64 << 10;
+	const std::string        strPath =
+	    WildBenchTempPath("wildpipeline_bench.txt");
+	WildBenchRandom          rng(1201);
+	std::vector<std::string> rgstrWild(8);
+	std::string              strKey;
+	size_t                   cbFile = 0;
+	FILE                    *pFile = fopen(strPath.c_str(), "wb");
+
+	if (pFile == NULL)
+	{
+		printf("Pipeline: couldn't write %s\n", strPath.c_str());
+		return 0;
+	}
+
+	for (size_t i = 0; i < cLines; ++i)
+	{
+		WildBenchMakeKey(rng, strKey, rng.Below(4) == 0);
+		strKey += '\n';
+		fwrite(strKey.data(), 1, strKey.size(), pFile);
+		cbFile += strKey.size();
+	}
+
+	fclose(pFile);
+
+	for (std::string &strWild : rgstrWild)
+	{
+		WildBenchMakePattern(rng, strWild);
+	}
+
+	WildPipeMatch match = [&](const char *pLine, size_t)
+	{
+		for (std::string &strWild : rgstrWild)
+		{
+			if (FastWildCompare((char *) strWild.c_str(), (char *) pLine))
+			{
+				return true;
+			}
+		}
+
+		return false;
+	};
+	size_t        cbOut = 0;
+	WildPipeSink  sink = [&](const char *, size_t cb)
+	{
+		cbOut += cb;
+	};
+
+	printf("Pipeline, %zu lines, %.1f MB, %u CPUs, %zu patterns:\n", cLines,
+	       cbFile / 1e6, std::thread::hardware_concurrency(),
+	       rgstrWild.size());
+
+	{
+		// The hand-wired loop: read, split, match, and write, in turn.
+		std::vector<char> rgch(cbBuffer + 1);
+		size_t            cbHeld = 0;
+		uint64_t          cMatched = 0;
+		uint64_t          uStart = WildBenchNanos();
+
+		pFile = fopen(strPath.c_str(), "rb");
+		cbOut = 0;
+
+		for (;;)
+		{
+			size_t cbRead = fread(rgch.data() + cbHeld, 1,
+			                      cbBuffer - cbHeld, pFile);
+			size_t cb = cbHeld + cbRead;
+			char  *pchLine = rgch.data();
+			char  *pchEnd = pchLine + cb;
+
+			if (cb == 0)
+			{
+				break;
+			}
+
+			for (;;)
+			{
+				char *pchNewline = (char *) memchr(pchLine, '\n',
+				                                   pchEnd - pchLine);
+
+				if (pchNewline == NULL)
+				{
+					if (cbRead)
+					{
+						break;
+					}
+
+					pchNewline = pchEnd;
+				}
+
+				*pchNewline = '\0';
+
+				if (match(pchLine, pchNewline - pchLine))
+				{
+					*pchNewline = '\n';
+					sink(pchLine, pchNewline + 1 - pchLine);
+					++cMatched;
+				}
+
+				pchLine = pchNewline + 1;
+
+				if (pchLine >= pchEnd)
+				{
+					break;
+				}
+			}
+
+			cbHeld = pchLine < pchEnd ? pchEnd - pchLine : 0;
+			memmove(rgch.data(), pchLine, cbHeld);
+		}
+
+		fclose(pFile);
+
+		uint64_t uNanos = WildBenchNanos() - uStart;
+
+		printf("  single loop   %8.2f ms %8.1f MB/s, %llu matched, "
+		       "%zu bytes out\n", uNanos / 1e6, cbFile * 1e3 / uNanos,
+		       (unsigned long long) cMatched, cbOut);
+	}
+
+	for (int cMatchers : {1, 2, 4})
+	{
+		WildPipeConfig config = {cMatchers, cbBuffer,
+		                         (size_t) 2 * cMatchers + 4, 4};
+
+		pFile = fopen(strPath.c_str(), "rb");
+		cbOut = 0;
+
+		WildPipeline pipeline(config, [&](char *p, size_t cb)
+		{
+			return fread(p, 1, cb, pFile);
+		}, match, sink);
+		uint64_t     uStart = WildBenchNanos();
+		uint64_t     cMatched = pipeline.Run();
+		uint64_t     uNanos = WildBenchNanos() - uStart;
+
+		fclose(pFile);
+		printf("  %d matcher%s    %8.2f ms %8.1f MB/s, %llu matched, "
+		       "%zu bytes out\n", cMatchers, cMatchers > 1 ? "s" : " ",
+		       uNanos / 1e6, cbFile * 1e3 / uNanos,
+		       (unsigned long long) cMatched, cbOut);
+		PrintPipeStats(pipeline, uNanos);
+	}
+
+	remove(strPath.c_str());
+	return 0;
+}
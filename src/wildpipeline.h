@@ -0,0 +1,230 @@
+// WildPipeline, a streaming reader, splitter, matcher and writer pipeline
+// joined by bounded single-producer single-consumer queues
+//
+// Copyright 2025 Kirk J Krauss.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// A log filter reads text, splits it into lines, matches each line, and
+// writes out those that match.  Done in one loop, a slow read holds up
+// matching and a slow write holds up reading.  A WildPipeline runs each of
+// those as a stage on a thread of its own, with any number of matchers,
+// and the stages pass buffers along rather than copy them.
+//
+// Buffers come from a fixed pool.  The reader fills one from a source,
+// ending it at its last newline and carrying the partial line after that
+// into the next one, so no line is split across buffers unless it's
+// longer than a whole buffer.  The splitter ends each line with a NUL in
+// place of its newline, so a matcher can hand lines straight to
+// FastWildCompare(), and notes where each starts.  Buffers go to the
+// matchers in turn, and the writer takes them back from the matchers in
+// the same turn, so lines come out in the order they went in.  The writer
+// passes the matching lines to a sink, each with its newline, and returns
+// the buffer to the reader.
+//
+// Each pair of stages is joined by a WildSpscQueue of buffer pointers,
+// which has one thread pushing and one popping, and needs no lock: the
+// producer owns the tail index and the consumer the head, each on its own
+// cache line.  A stage that finds its input empty or its output full
+// spins briefly and then yields, and counts a stall.  Since the pool is
+// fixed and the queues bounded, a slow stage makes the ones ahead of it
+// wait rather than pile up buffers.
+//
+// The chain of stages is fixed: one reader, one splitter, cMatchers
+// matchers and one writer.  What plugs in is what each end does: the
+// source the reader fills from, the test each matcher applies, and the
+// sink the writer hands lines to.  That covers the log filters this is
+// for.  A chain of arbitrary stages would need a stage interface and a
+// buffer layout each stage agrees on, and it would lose the fixed
+// in-order hand-off between the matchers and the writer.
+//
+#ifndef WILDPIPELINE_H
+#define WILDPIPELINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+template <typename T>
+class WildSpscQueue
+{
+public:
+	// Holds up to cCapacity items, rounded up to a power of 2.
+	explicit WildSpscQueue(size_t cCapacity) :
+	    m_uHead(0), m_uTailSeen(0), m_uTail(0), m_uHeadSeen(0)
+	{
+		size_t cSlots = 1;
+
+		while (cSlots < cCapacity)
+		{
+			cSlots *= 2;
+		}
+
+		m_rgItems.resize(cSlots);
+		m_uMask = cSlots - 1;
+	}
+
+	// Called by the producer only.  Returns false if the queue is full.
+	bool TryPush(const T &item)
+	{
+		size_t uTail = m_uTail.load(std::memory_order_relaxed);
+
+		if (uTail - m_uHeadSeen > m_uMask)
+		{
+			m_uHeadSeen = m_uHead.load(std::memory_order_acquire);
+
+			if (uTail - m_uHeadSeen > m_uMask)
+			{
+				return false;
+			}
+		}
+
+		m_rgItems[uTail & m_uMask] = item;
+		m_uTail.store(uTail + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Called by the consumer only.  Returns false if the queue is empty.
+	bool TryPop(T &item)
+	{
+		size_t uHead = m_uHead.load(std::memory_order_relaxed);
+
+		if (uHead == m_uTailSeen)
+		{
+			m_uTailSeen = m_uTail.load(std::memory_order_acquire);
+
+			if (uHead == m_uTailSeen)
+			{
+				return false;
+			}
+		}
+
+		item = m_rgItems[uHead & m_uMask];
+		m_uHead.store(uHead + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Items queued, as of some moment while the call was under way.
+	size_t Depth() const
+	{
+		return m_uTail.load(std::memory_order_acquire) -
+		       m_uHead.load(std::memory_order_acquire);
+	}
+
+	size_t Capacity() const
+	{
+		return m_uMask + 1;
+	}
+
+private:
+	std::vector<T>                  m_rgItems;
+	size_t                          m_uMask;
+	alignas(64) std::atomic<size_t> m_uHead;      // The consumer's
+	size_t                          m_uTailSeen;  // The consumer's copy
+	alignas(64) std::atomic<size_t> m_uTail;      // The producer's
+	size_t                          m_uHeadSeen;  // The producer's copy
+};
+
+
+// A buffer, as passed from stage to stage.
+struct WildPipeBuffer
+{
+	std::vector<char>     rgch;        // Lines, NUL-terminated once split
+	size_t                cb;          // Bytes in use
+	std::vector<uint32_t> rgLines;     // Where each line starts, plus the end
+	std::vector<uint8_t>  rgbMatch;    // Whether each line matched
+};
+
+struct WildPipeStats
+{
+	uint64_t cBuffers;
+	uint64_t cLines;
+	uint64_t cbBytes;
+	uint64_t uBusyNanos;   // Time spent on buffers, not waiting
+	uint64_t cStalls;      // Waits on an empty input or a full output
+	uint64_t cDepthSum;    // Input queue depth, summed per buffer taken
+	size_t   cMaxDepth;    // Deepest the input queue was found
+};
+
+// Fills up to cb bytes, and returns how many, or 0 at the end.
+typedef std::function<size_t(char *p, size_t cb)> WildPipeSource;
+
+// Matches one NUL-terminated line of cbLine bytes.  Each matcher stage has
+// a copy of its own.
+typedef std::function<bool(const char *pLine, size_t cbLine)> WildPipeMatch;
+
+// Takes bytes of matching lines.
+typedef std::function<void(const char *p, size_t cb)> WildPipeSink;
+
+struct WildPipeConfig
+{
+	int    cMatchers;      // Matcher stages, run in parallel
+	size_t cbBuffer;       // Bytes per buffer, the longest line unsplit
+	size_t cBuffers;       // Buffers in the pool
+	size_t cQueue;         // Buffers each queue holds
+};
+
+enum WildPipeStage
+{
+	WILD_PIPE_READER,
+	WILD_PIPE_SPLITTER,
+	WILD_PIPE_MATCHER      // Then one per matcher, then the writer
+};
+
+class WildPipeline
+{
+public:
+	WildPipeline(const WildPipeConfig &config, const WildPipeSource &source,
+	             const WildPipeMatch &match, const WildPipeSink &sink);
+
+	// Runs every stage until the source is drained and every matching line
+	// written, with the writer on the calling thread.  Returns the number
+	// of lines that matched.
+	uint64_t Run();
+
+	// A stage's counters from the last Run().  Matcher i is
+	// WILD_PIPE_MATCHER + i, and the writer is StageCount() - 1.
+	const WildPipeStats &Stats(int iStage) const;
+
+	int StageCount() const
+	{
+		return (int) m_rgStats.size();
+	}
+
+private:
+	void ReadStage();
+	void SplitStage();
+	void MatchStage(int iMatcher);
+	uint64_t WriteStage();
+
+	typedef WildSpscQueue<WildPipeBuffer *> WildPipeQueue;
+
+	WildPipeConfig                              m_config;
+	WildPipeSource                              m_source;
+	WildPipeMatch                               m_match;
+	WildPipeSink                                m_sink;
+	std::vector<std::unique_ptr<WildPipeBuffer>> m_rgBuffers;
+	std::unique_ptr<WildPipeQueue>              m_pFree;     // Writer to reader
+	std::unique_ptr<WildPipeQueue>              m_pRead;     // To the splitter
+	std::vector<std::unique_ptr<WildPipeQueue>> m_rgToMatch;
+	std::vector<std::unique_ptr<WildPipeQueue>> m_rgMatched;
+	std::vector<WildPipeStats>                  m_rgStats;
+};
+
+extern "C" int testpipeline(void);
+extern "C" int benchpipeline(void);
+
+#endif  // WILDPIPELINE_H
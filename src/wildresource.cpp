@@ -0,0 +1,486 @@
+// WildCountingResource, and related code
+//
+// Copyright 2025 Kirk J Krauss.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// This file provides the counting resource.  It also includes testcases
+// for the engines' use of memory resources, and a comparison of the
+// default heap with per-request and per-shard resources.
+//
+#include <stdio.h>
+#include <string.h>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "fastwildcompare.h"
+#include "wildbytecode.h"
+#include "wildcompiled.h"
+#include "wilddfa.h"
+#include "wildfnmatch.h"
+#include "wildlike.h"
+#include "wildpacked.h"
+#include "wildpatternset.h"
+#include "wildresource.h"
+#include "wildbench.h"
+
+
+WildCountingResource::WildCountingResource(
+    std::pmr::memory_resource *pUpstream) :
+    m_pUpstream(pUpstream), m_cAllocations(0), m_cbOutstanding(0),
+    m_cbPeak(0)
+{
+}
+
+
+void *WildCountingResource::do_allocate(size_t cb, size_t cbAlign)
+{
+	void *p = m_pUpstream->allocate(cb, cbAlign);
+
+	++m_cAllocations;
+	m_cbOutstanding += cb;
+
+	if (m_cbPeak < m_cbOutstanding)
+	{
+		m_cbPeak = m_cbOutstanding;
+	}
+
+	return p;
+}
+
+
+void WildCountingResource::do_deallocate(void *p, size_t cb, size_t cbAlign)
+{
+	m_pUpstream->deallocate(p, cb, cbAlign);
+	m_cbOutstanding -= cb;
+}
+
+
+bool WildCountingResource::do_is_equal(
+    const std::pmr::memory_resource &other) const noexcept
+{
+	return this == &other;
+}
+
+
+// Every engine, made with a counting resource, must match as
+// FastWildCompare() does, give back all it took, and take nothing from the
+// default resource, which is set to one that refuses every allocation.
+//
+extern "C" int testresource(void)
+{
+	const size_t              cPatterns = 200;
+	const size_t              cKeys = 500;
+	bool                      bAllPassed = true;
+	size_t                    cSpilled = 0;
+	WildBenchRandom           rng(1240);
+	std::vector<std::string>  rgWild(cPatterns);
+	std::vector<std::string>  rgKeys(cKeys);
+	std::vector<uint8_t>      rgbExpected(cPatterns * cKeys);
+
+	for (size_t i = 0; i < cPatterns; ++i)
+	{
+		WildBenchMakePattern(rng, rgWild[i]);
+
+		// Some long enough for a compiled pattern to spill.
+		for (int iMore = 0; i % 8 == 0 && iMore < 3; ++iMore)
+		{
+			std::string strMore;
+
+			WildBenchMakePattern(rng, strMore);
+			rgWild[i] += "*" + strMore;
+		}
+	}
+
+	for (size_t i = 0; i < cKeys; ++i)
+	{
+		WildBenchMakeKey(rng, rgKeys[i], i % 4 == 0);
+	}
+
+	for (size_t iPattern = 0; iPattern < cPatterns; ++iPattern)
+	{
+		for (size_t iKey = 0; iKey < cKeys; ++iKey)
+		{
+			std::string strWild(rgWild[iPattern]);
+			std::string strTame(rgKeys[iKey]);
+
+			rgbExpected[iPattern * cKeys + iKey] =
+			    FastWildCompare(&strWild[0], &strTame[0]);
+		}
+	}
+
+	WildCountingResource       counting;
+	std::pmr::memory_resource *pDefault =
+	    std::pmr::set_default_resource(std::pmr::null_memory_resource());
+
+	try
+	{
+		WildPatternSet        set(&counting);
+		WildSegmentMemo       memo(&counting);
+		std::pmr::vector<int> rgMatches(&counting);
+
+		for (size_t iPattern = 0; iPattern < cPatterns; ++iPattern)
+		{
+			set.Add(rgWild[iPattern].c_str());
+		}
+
+		set.Build();
+
+		for (size_t iKey = 0; iKey < cKeys; ++iKey)
+		{
+			const std::string &strTame = rgKeys[iKey];
+			size_t             iMatch = 0;
+
+			rgMatches.clear();
+			memo.Reset(strTame.data(), strTame.size());
+			set.MatchAll(strTame.data(), strTame.size(), rgMatches, memo);
+
+			for (size_t iPattern = 0; iPattern < cPatterns; ++iPattern)
+			{
+				bool bMatched = iMatch < rgMatches.size() &&
+				                rgMatches[iMatch] == (int) iPattern;
+
+				iMatch += bMatched;
+				bAllPassed &= bMatched ==
+				              (bool) rgbExpected[iPattern * cKeys + iKey];
+			}
+
+			// With and without a memo of the caller's.
+			int iFirst = rgMatches.empty() ? -1 : rgMatches[0];
+
+			bAllPassed &= set.MatchFirst(strTame.c_str()) == iFirst &&
+			              set.MatchFirst(strTame.c_str(), memo) == iFirst &&
+			              set.MatchAny(strTame.c_str()) == (iFirst >= 0) &&
+			              set.MatchAny(strTame.c_str(), memo) ==
+			              (iFirst >= 0);
+		}
+
+		for (size_t iPattern = 0; iPattern < cPatterns; ++iPattern)
+		{
+			const char         *pWild = rgWild[iPattern].c_str();
+			WildDfa             dfa(&counting);
+			WildProgram         program(&counting);
+			WildCompiledPattern pattern(pWild, &counting);
+			bool                bDfa = dfa.Compile(pWild);
+
+			program.Compile(pWild);
+			cSpilled += pattern.Spilled();
+			bAllPassed &= dfa.Resource() == &counting &&
+			              program.Resource() == &counting;
+
+			for (size_t iKey = 0; iKey < cKeys; ++iKey)
+			{
+				const std::string &strTame = rgKeys[iKey];
+				bool bExpected = rgbExpected[iPattern * cKeys + iKey];
+
+				bAllPassed &= (!bDfa || dfa.Match(strTame.data(),
+				                                  strTame.size()) ==
+				                        bExpected) &&
+				              program.Match(strTame.data(),
+				                            strTame.size()) == bExpected &&
+				              pattern.Match(strTame.data(),
+				                            strTame.size()) == bExpected;
+			}
+		}
+
+		// LIKE patterns, with an ESCAPE character of '!'.
+		static const struct
+		{
+			const char *pszLike;
+			const char *pszTame;
+			bool        bExpected;
+		}
+		s_rgLike[] =
+		{
+			{ "abc", "abc", true },          { "a_c%", "abcd", true },
+			{ "%b_d", "abcd", true },        { "%x%", "abc", false },
+			{ "ab%cd%ef", "abXcdYef", true }, { "50!%%", "50%off", true },
+			{ "a_%_b", "ab", false }
+		};
+
+		for (const auto &test : s_rgLike)
+		{
+			WildLikePattern like(&counting);
+
+			bAllPassed &= like.Compile(test.pszLike, '!') &&
+			              like.Resource() == &counting &&
+			              like.Match(test.pszTame) == test.bExpected;
+		}
+
+		// fnmatch() patterns, split into components under
+		// WILD_FNM_PATHNAME.
+		static const struct
+		{
+			const char *pszWild;
+			const char *pszTame;
+			int         iFlags;
+			int         iExpected;
+		}
+		s_rgFnmatch[] =
+		{
+			{ "src/*.[ch]", "src/main.c",
+			  WILD_FNM_PATHNAME | WILD_FNM_PERIOD, 0 },
+			{ "src/*.[ch]", "src/.x.c",
+			  WILD_FNM_PATHNAME | WILD_FNM_PERIOD, WILD_FNM_NOMATCH },
+			{ "*/[a-c]*", "x/bcd", WILD_FNM_PATHNAME, 0 },
+			{ "*/[a-c]*", "x/y/bcd", WILD_FNM_PATHNAME, WILD_FNM_NOMATCH },
+			{ "[[:digit:]]*", "7up", 0, 0 },
+			{ "[[:digit:]]*", "up7", 0, WILD_FNM_NOMATCH },
+			{ "*\\*", "a*", 0, 0 },
+			{ "*?[.b]", "a.", WILD_FNM_PERIOD, WILD_FNM_NOMATCH },
+			{ "*?[.b]", "ab.", WILD_FNM_PERIOD, 0 }
+		};
+
+		for (const auto &test : s_rgFnmatch)
+		{
+			WildFnmatchPattern pattern(&counting);
+
+			bAllPassed &= pattern.Compile(test.pszWild, test.iFlags) &&
+			              pattern.Resource() == &counting &&
+			              pattern.Match(test.pszTame) == test.iExpected;
+		}
+
+		// Packed patterns, over hexadecimal keys.
+		static const char *s_rgszHexWild[] =
+		{
+			"*dead*", "ab?d*", "*0f", "c0ffee", "*1*2*3*", "?*??"
+		};
+		static const char *s_rgszHexKeys[] =
+		{
+			"deadbeef", "abcd", "ab0d1", "120f", "c0ffee", "0123", "f"
+		};
+
+		for (const char *pszWild : s_rgszHexWild)
+		{
+			WildPackedPattern packed(&counting);
+
+			bAllPassed &= packed.Compile(pszWild, WILD_PACKED_HEX) &&
+			              packed.Resource() == &counting;
+
+			for (const char *pszKey : s_rgszHexKeys)
+			{
+				size_t               cchKey = strlen(pszKey);
+				std::vector<uint8_t> rgPacked(
+				    WildPackedBytes(WILD_PACKED_HEX, cchKey));
+
+				bool bExpected = FastWildCompare(const_cast<char *>(pszWild),
+				                                 const_cast<char *>(pszKey));
+
+				WildPack(WILD_PACKED_HEX, pszKey, cchKey, rgPacked.data());
+				bAllPassed &= packed.Match(rgPacked.data(), cchKey) ==
+				              bExpected;
+			}
+		}
+	}
+	catch (const std::bad_alloc &)
+	{
+		bAllPassed = false;
+	}
+
+	std::pmr::set_default_resource(pDefault);
+	bAllPassed &= cSpilled > 0 && counting.AllocationCount() > 0 &&
+	              counting.Bytes() == 0;
+
+	if (bAllPassed)
+	{
+		printf("Passed memory resource tests\n");
+	}
+	else
+	{
+		printf("Failed memory resource tests\n");
+	}
+
+	return 0;
+}
+
+
+// Patterns and keys for the batch comparison, with the keys packed back to
+// back as WildDfa::MatchBatch() takes them.
+//
+struct WildResourceWork
+{
+	std::vector<std::string> rgWild;
+	std::string              strBytes;
+	std::vector<uint32_t>    rgOffsets;
+};
+
+#define WILD_RESOURCE_SET_PATTERNS      64
+#define WILD_RESOURCE_DFA_PATTERNS      2
+#define WILD_RESOURCE_PROGRAM_PATTERNS  32
+#define WILD_RESOURCE_KEYS              256   // Per request
+#define WILD_RESOURCE_PROGRAM_KEYS      32    // Per program
+
+
+// One request's work for an engine, with all of its memory from pResource:
+// a pattern set built and matched against every key, a few DFAs compiled
+// and batch-matched, or programs compiled and each matched against a few
+// keys.  Returns the number of matches.
+//
+static size_t RunRequest(int iEngine, std::pmr::memory_resource *pResource,
+                         const WildResourceWork &work, size_t iFirstPattern,
+                         size_t iFirstKey)
+{
+	const char     *pBytes = work.strBytes.data();
+	const uint32_t *rgOffsets = work.rgOffsets.data() + iFirstKey;
+	size_t          cPool = work.rgWild.size();
+	size_t          cMatches = 0;
+
+	if (iEngine == 0)
+	{
+		WildPatternSet        set(pResource);
+		WildSegmentMemo       memo(pResource);
+		std::pmr::vector<int> rgMatches(pResource);
+
+		for (size_t i = 0; i < WILD_RESOURCE_SET_PATTERNS; ++i)
+		{
+			set.Add(work.rgWild[(iFirstPattern + i) % cPool].c_str());
+		}
+
+		set.Build();
+
+		for (size_t iKey = 0; iKey < WILD_RESOURCE_KEYS; ++iKey)
+		{
+			const char *pTame = pBytes + rgOffsets[iKey];
+			size_t      cbTame = rgOffsets[iKey + 1] - rgOffsets[iKey];
+
+			memo.Reset(pTame, cbTame);
+			set.MatchAll(pTame, cbTame, rgMatches, memo);
+		}
+
+		cMatches = rgMatches.size();
+	}
+	else if (iEngine == 1)
+	{
+		for (size_t i = 0; i < WILD_RESOURCE_DFA_PATTERNS; ++i)
+		{
+			WildDfa                   dfa(pResource);
+			std::pmr::vector<uint8_t> rgbResult(WILD_RESOURCE_KEYS, 0,
+			                                    pResource);
+
+			if (dfa.Compile(work.rgWild[(iFirstPattern + i) %
+			                            cPool].c_str()))
+			{
+				dfa.MatchBatch(pBytes, rgOffsets, WILD_RESOURCE_KEYS,
+				               rgbResult.data());
+			}
+
+			for (uint8_t bResult : rgbResult)
+			{
+				cMatches += bResult;
+			}
+		}
+	}
+	else
+	{
+		std::pmr::vector<WildProgram> rgPrograms(pResource);
+
+		rgPrograms.reserve(WILD_RESOURCE_PROGRAM_PATTERNS);
+
+		for (size_t i = 0; i < WILD_RESOURCE_PROGRAM_PATTERNS; ++i)
+		{
+			rgPrograms.emplace_back(pResource);
+			rgPrograms.back().Compile(
+			    work.rgWild[(iFirstPattern + i) % cPool].c_str());
+
+			for (size_t iKey = 0; iKey < WILD_RESOURCE_PROGRAM_KEYS; ++iKey)
+			{
+				size_t iAt = (i * WILD_RESOURCE_PROGRAM_KEYS + iKey) %
+				             WILD_RESOURCE_KEYS;
+
+				cMatches += rgPrograms.back().Match(
+				    pBytes + rgOffsets[iAt],
+				    rgOffsets[iAt + 1] - rgOffsets[iAt]);
+			}
+		}
+	}
+
+	return cMatches;
+}
+
+
+// Runs the same requests with the engines' memory from the heap, from a
+// monotonic buffer released after each request, and from a pool kept
+// across requests, as a shard would keep one.
+//
+extern "C" int benchresource(void)
+{
+	const size_t      cRequests = 2000;
+	const size_t      cPoolPatterns = 4096;
+	const size_t      cPoolKeys = 1 << 16;
+	WildBenchRandom   rng(1241);
+	WildResourceWork  work;
+	std::vector<char> rgchArena(1 << 20);
+	std::string       strKey;
+
+	work.rgWild.resize(cPoolPatterns);
+
+	for (std::string &strWild : work.rgWild)
+	{
+		WildBenchMakePattern(rng, strWild);
+	}
+
+	for (size_t i = 0; i < cPoolKeys; ++i)
+	{
+		WildBenchMakeKey(rng, strKey, rng.Below(4) == 0);
+		work.rgOffsets.push_back((uint32_t) work.strBytes.size());
+		work.strBytes += strKey;
+	}
+
+	work.rgOffsets.push_back((uint32_t) work.strBytes.size());
+
+	printf("Memory resources, %zu requests, %d keys each:\n", cRequests,
+	       WILD_RESOURCE_KEYS);
+
+	for (int iEngine = 0; iEngine < 3; ++iEngine)
+	{
+		printf("  %s:\n", iEngine == 0 ? "WildPatternSet, 64 patterns" :
+		       iEngine == 1 ? "WildDfa, 2 patterns" :
+		       "WildProgram, 32 patterns");
+
+		for (int iResource = 0; iResource < 3; ++iResource)
+		{
+			WildCountingResource                upstream;
+			std::pmr::unsynchronized_pool_resource pool(&upstream);
+			WildBenchRandom                     rngRequests(1242);
+			size_t                              cMatches = 0;
+			uint64_t                            uStart = WildBenchNanos();
+
+			for (size_t iRequest = 0; iRequest < cRequests; ++iRequest)
+			{
+				std::pmr::monotonic_buffer_resource arena(
+				    rgchArena.data(), rgchArena.size(), &upstream);
+				std::pmr::memory_resource *pResource =
+				    iResource == 0 ? (std::pmr::memory_resource *) &upstream :
+				    iResource == 1 ? (std::pmr::memory_resource *) &arena :
+				    (std::pmr::memory_resource *) &pool;
+
+				cMatches += RunRequest(iEngine, pResource, work,
+				    rngRequests.Below(cPoolPatterns),
+				    rngRequests.Below(cPoolKeys - WILD_RESOURCE_KEYS));
+			}
+
+			uint64_t uNanos = WildBenchNanos() - uStart;
+
+			printf("    %-20s %8.2f ms %9.1f ns/request, %7.1f heap "
+			       "calls/request, %zu matched\n",
+			       iResource == 0 ? "Heap" :
+			       iResource == 1 ? "Monotonic, 1 MB" : "Pool, kept",
+			       uNanos / 1e6, (double) uNanos / cRequests,
+			       (double) upstream.AllocationCount() / cRequests,
+			       cMatches);
+		}
+	}
+
+	return 0;
+}
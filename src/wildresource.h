@@ -0,0 +1,104 @@
+// WildCountingResource, a memory resource that counts what the engines
+// take from it
+//
+// Copyright 2025 Kirk J Krauss.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// The engines that allocate as they compile and match (WildPatternSet and
+// its WildSegmentMemo, WildTieredSet, WildDfa, WildProgram,
+// WildCompiledPattern once it spills, WildPackedPattern, WildLikePattern
+// and WildFnmatchPattern) each take a std::pmr::memory_resource when
+// they're made, and take all their memory from it, scratch included.  A
+// matcher that runs each request in an arena can hand them a
+// monotonic_buffer_resource over the request's buffer, and a shard can
+// hand them a pool of its own, so that none of them touches the global
+// heap or contends for its locks.  Copies made by copy construction go to
+// the default resource, as with any pmr container.
+//
+// The rest stay on the global heap, since none of them fits a per-request
+// arena:
+//
+// - HybridWildCompare() is a plain function with no object to hold a
+//   resource, and allocates only for a segment wider than 64 bytes.
+// - WildFnmatch() keeps its compiled patterns in a per-thread cache that
+//   outlives any request.
+// - The token dictionary and token patterns live as long as the key
+//   store, and a pattern's per-component results grow with the dictionary.
+// - WildCorpus keeps its keys in a mapping of its file, and
+//   WildCorpusScan() fills its results in shares on its own threads.
+// - The standing queries' postings grow for their lifetime, and compaction
+//   gives memory back, which an arena wouldn't.
+// - The search session frees its oldest results as the user types.
+// - The parallel set's segment memos grow on its worker threads at once,
+//   which the arena resources aren't safe for.
+// - The query cache and the matching service outlive any request.
+// - The shard map and coordinator hold each shard's bounds and keys for
+//   as long as the shards are served.
+// - The pipeline's buffer pool is allocated once and reused for the
+//   whole run, on several threads.
+// - The range writer reuses one gather list and one read window for the
+//   life of its output.
+// - The bitmap sink's tiles live in a mapping of its output file.
+//
+// A WildCountingResource passes allocations on to another resource and
+// counts them, to show how many calls and bytes an engine takes, and that
+// it gives them all back.  It's meant for one thread at a time, as the
+// monotonic and unsynchronized pool resources are.
+//
+#ifndef WILDRESOURCE_H
+#define WILDRESOURCE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <memory_resource>
+
+class WildCountingResource : public std::pmr::memory_resource
+{
+public:
+	explicit WildCountingResource(std::pmr::memory_resource *pUpstream =
+	                              std::pmr::new_delete_resource());
+
+	// Allocations made since construction.
+	uint64_t AllocationCount() const
+	{
+		return m_cAllocations;
+	}
+
+	// Bytes allocated and not yet given back.
+	size_t Bytes() const
+	{
+		return m_cbOutstanding;
+	}
+
+	size_t PeakBytes() const
+	{
+		return m_cbPeak;
+	}
+
+private:
+	void *do_allocate(size_t cb, size_t cbAlign) override;
+	void do_deallocate(void *p, size_t cb, size_t cbAlign) override;
+	bool do_is_equal(const std::pmr::memory_resource &other) const
+	    noexcept override;
+
+	std::pmr::memory_resource *m_pUpstream;
+	uint64_t                   m_cAllocations;
+	size_t                     m_cbOutstanding;
+	size_t                     m_cbPeak;
+};
+
+extern "C" int testresource(void);
+extern "C" int benchresource(void);
+
+#endif  // WILDRESOURCE_H
@@ -0,0 +1,1536 @@
+// WildMatchService, and related code
+//
+// Copyright 2025 Kirk J Krauss.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// This file provides the multi-tenant matching service and its scheduler.
+// It also includes testcases for correctness and performance.
+//
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <time.h>
+#endif
+
+#include "fastwildcompare.h"
+#include "wildparallel.h"
+#include "wildservice.h"
+#include "wildbench.h"
+
+#define WILD_SERVICE_STRIDE   4   // Pattern groups between budget checks
+
+// CPU time the calling thread has used, where the platform tells, or else
+// the time gone by.
+//
+static uint64_t ThreadCpuNanos()
+{
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+	timespec ts;
+
+	if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0)
+	{
+		return (uint64_t) ts.tv_sec * 1000000000 + (uint64_t) ts.tv_nsec;
+	}
+#endif
+
+	return (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+	    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+static uint64_t SteadyNanos()
+{
+	return (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+	    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+// Bytes a built set takes, near enough to hold it to a limit.
+//
+static size_t SetBytes(const WildPatternSet &set, size_t cbText)
+{
+	return cbText + set.GroupCount() * sizeof(WildPatternGroup) +
+	       (size_t) set.Count() * (sizeof(WildPatternShape) +
+	                               2 * sizeof(uint32_t)) +
+	       set.SegmentCount() * 2 * sizeof(uint32_t);
+}
+
+
+// Finds the first pattern a key matches, a few groups at a time, and gives
+// up once the steps taken pass the budget.  Adds the steps to *pcSteps.
+//
+static int MatchWithinBudget(const WildPatternSet &set, const char *pKey,
+                             size_t cbKey, uint64_t cStepBudget,
+                             WildSegmentMemo &memo, uint64_t *pcSteps)
+{
+	size_t   cGroups = set.GroupCount();
+	uint64_t cbStart = memo.BytesScanned();
+	uint64_t cSteps = 0;
+	int      iResult = WILD_SERVICE_NO_MATCH;
+
+	memo.Reset(pKey, cbKey);
+
+	for (size_t iGroup = 0; iGroup < cGroups; iGroup += WILD_SERVICE_STRIDE)
+	{
+		size_t iEnd = std::min(cGroups, iGroup + WILD_SERVICE_STRIDE);
+		int    iPattern = set.MatchFirstInGroups(pKey, cbKey, iGroup, iEnd,
+		                                         memo);
+
+		cSteps = memo.BytesScanned() - cbStart + iEnd;
+
+		if (iPattern >= 0)
+		{
+			iResult = iPattern;
+			break;
+		}
+
+		if (cStepBudget && cSteps > cStepBudget && iEnd < cGroups)
+		{
+			iResult = WILD_SERVICE_OVER_BUDGET;
+			break;
+		}
+	}
+
+	*pcSteps += cSteps;
+	return iResult;
+}
+
+
+WildMatchService::WildMatchService(int cThreads,
+                                   const WildPollPolicy *pPoll) :
+    m_cTenants(0), m_rgSlots(new WildServiceSlot[WILD_SERVICE_SLOTS]),
+    m_cQueued(0), m_cReadySlots(0), m_uSequence(0), m_cBusy(0), m_dPass(0),
+    m_bPoll(pPoll != NULL), m_bFair(true), m_bStop(false)
+{
+	cThreads = std::max(cThreads, 1);
+	memset(&m_poll, 0, sizeof(m_poll));
+
+	if (pPoll)
+	{
+		m_poll = *pPoll;
+	}
+
+	// Tenants never move, so MatchOne() can find them without the lock.
+	m_rgTenants.reserve(WILD_SERVICE_TENANTS);
+
+	for (int iSlot = 0; iSlot < WILD_SERVICE_SLOTS; ++iSlot)
+	{
+		m_rgSlots[iSlot].uState.store(WILD_SLOT_FREE);
+	}
+
+	for (int iThread = 0; iThread < cThreads; ++iThread)
+	{
+		if (m_bPoll)
+		{
+			m_rgThreads.emplace_back(&WildMatchService::PollLoop, this,
+			                         iThread, cThreads);
+		}
+		else
+		{
+			m_rgThreads.emplace_back(&WildMatchService::WorkerLoop, this);
+		}
+	}
+}
+
+
+WildMatchService::~WildMatchService()
+{
+	Drain();
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		m_bStop = true;
+	}
+
+	m_cvWork.notify_all();
+
+	for (std::thread &thread : m_rgThreads)
+	{
+		thread.join();
+	}
+}
+
+
+int WildMatchService::AddTenant(const WildTenantLimits &limits)
+{
+	std::unique_ptr<WildTenant> pTenant(new WildTenant());
+	std::shared_ptr<WildPatternSet> pSet(new WildPatternSet());
+
+	pSet->Build();
+	pTenant->limits = limits;
+	pTenant->limits.dWeight = limits.dWeight > 0 ? limits.dWeight : 1;
+	memset(&pTenant->stats, 0, sizeof(pTenant->stats));
+	pTenant->pSet = pSet;
+	pTenant->cbPatterns = 0;
+	pTenant->cBusy = 0;
+	pTenant->dPass = 0;
+	pTenant->dKeyNanos = 0;
+	pTenant->cInlineKeys = 0;
+	pTenant->cInlineMatched = 0;
+	pTenant->cInlineOverBudget = 0;
+	pTenant->cInlineSteps = 0;
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (m_rgTenants.size() == WILD_SERVICE_TENANTS)
+	{
+		return -1;
+	}
+
+	m_rgTenants.push_back(std::move(pTenant));
+	m_cTenants.store((int) m_rgTenants.size(), std::memory_order_release);
+	return (int) m_rgTenants.size() - 1;
+}
+
+
+bool WildMatchService::SetPatterns(int iTenant,
+                                   const std::vector<std::string> &rgWild)
+{
+	std::shared_ptr<WildPatternSet> pSet(new WildPatternSet());
+	size_t                          cbText = 0;
+
+	// The set is built outside the lock, so that other tenants' slices
+	// aren't held up.
+	for (const std::string &strWild : rgWild)
+	{
+		pSet->Add(strWild.c_str());
+		cbText += strWild.size() + 1;
+	}
+
+	pSet->Build();
+
+	size_t                      cbPatterns = SetBytes(*pSet, cbText);
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (iTenant < 0 || (size_t) iTenant >= m_rgTenants.size())
+	{
+		return false;
+	}
+
+	WildTenant &tenant = *m_rgTenants[iTenant];
+
+	if (tenant.limits.cbMemory && cbPatterns + tenant.stats.cbMemory -
+	    tenant.cbPatterns > tenant.limits.cbMemory)
+	{
+		++tenant.stats.cRejected;
+		return false;
+	}
+
+	tenant.stats.cbMemory += cbPatterns - tenant.cbPatterns;
+	tenant.cbPatterns = cbPatterns;
+	std::atomic_store(&tenant.pSet,
+	                  std::shared_ptr<const WildPatternSet>(pSet));
+	return true;
+}
+
+
+// Orders the interactive heap: a batch due later, or, due at the same
+// time, submitted later, goes below.
+//
+bool WildMatchService::DueLater(const WildServiceBatch *pA,
+                                const WildServiceBatch *pB)
+{
+	return pA->uDeadlineNanos != pB->uDeadlineNanos ?
+	       pA->uDeadlineNanos > pB->uDeadlineNanos :
+	       pA->uSequence > pB->uSequence;
+}
+
+
+bool WildMatchService::Submit(int iTenant, std::vector<std::string> &&rgKeys,
+                              const WildServiceDone &done,
+                              const WildJobOptions *pOptions)
+{
+	std::unique_ptr<WildServiceBatch> pBatch(new WildServiceBatch());
+	size_t                            cbBatch = rgKeys.size() *
+	                                            (sizeof(std::string) +
+	                                             sizeof(int));
+
+	for (const std::string &strKey : rgKeys)
+	{
+		cbBatch += strKey.size();
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		if (iTenant < 0 || (size_t) iTenant >= m_rgTenants.size())
+		{
+			return false;
+		}
+
+		WildTenant &tenant = *m_rgTenants[iTenant];
+
+		if (tenant.limits.cbMemory &&
+		    tenant.stats.cbMemory + cbBatch > tenant.limits.cbMemory)
+		{
+			++tenant.stats.cRejected;
+			return false;
+		}
+
+		pBatch->rgKeys = std::move(rgKeys);
+		pBatch->rgResults.resize(pBatch->rgKeys.size());
+		pBatch->pSet = tenant.pSet;
+		pBatch->done = done;
+		pBatch->iNext = 0;
+		pBatch->cRunning = 0;
+		pBatch->cbMemory = cbBatch;
+		pBatch->uSequence = m_uSequence++;
+		pBatch->uSubmitNanos = SteadyNanos();
+		pBatch->uDeadlineNanos = pOptions && pOptions->uDeadlineNanos ?
+		    pBatch->uSubmitNanos + pOptions->uDeadlineNanos : UINT64_MAX;
+		pBatch->iTenant = iTenant;
+		pBatch->lane = pOptions ? pOptions->lane : WILD_LANE_BULK;
+		pBatch->bDropLate = pOptions && pOptions->bDropLate;
+		pBatch->bMissed = false;
+
+		// A tenant coming back from idle starts level with the others.
+		if (tenant.cBusy == 0)
+		{
+			tenant.dPass = std::max(tenant.dPass, m_dPass);
+		}
+
+		tenant.stats.cbMemory += cbBatch;
+
+		if (pBatch->lane == WILD_LANE_INTERACTIVE)
+		{
+			m_rgInteractive.push_back(pBatch.release());
+			std::push_heap(m_rgInteractive.begin(), m_rgInteractive.end(),
+			               DueLater);
+		}
+		else
+		{
+			tenant.queue.push_back(pBatch.release());
+		}
+
+		++m_cQueued;
+		++tenant.cBusy;
+		++m_cBusy;
+	}
+
+	m_cvWork.notify_one();
+	return true;
+}
+
+
+void WildMatchService::Drain()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	m_cvIdle.wait(lock, [this]()
+	{
+		return m_cBusy == 0;
+	});
+}
+
+
+WildTenantStats WildMatchService::Stats(int iTenant) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	WildTenantStats             stats;
+
+	if (iTenant < 0 || (size_t) iTenant >= m_rgTenants.size())
+	{
+		memset(&stats, 0, sizeof(stats));
+		return stats;
+	}
+
+	const WildTenant &tenant = *m_rgTenants[iTenant];
+	uint64_t          cInline = tenant.cInlineKeys.load();
+
+	stats = tenant.stats;
+	stats.cInline = cInline;
+	stats.cKeys += cInline;
+	stats.cMatched += tenant.cInlineMatched.load();
+	stats.cOverBudget += tenant.cInlineOverBudget.load();
+	stats.cSteps += tenant.cInlineSteps.load();
+	return stats;
+}
+
+
+void WildMatchService::SetFair(bool bFair)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_bFair = bFair;
+}
+
+
+// Returns the tenant whose slice goes next, or -1 if no keys are waiting:
+// the least charged, or, with fairness off, the one whose batch came in
+// first.  Called with the lock held.
+//
+int WildMatchService::PickTenant() const
+{
+	int iPicked = -1;
+
+	for (size_t iTenant = 0; iTenant < m_rgTenants.size(); ++iTenant)
+	{
+		const WildTenant &tenant = *m_rgTenants[iTenant];
+
+		if (tenant.queue.empty())
+		{
+			continue;
+		}
+
+		if (iPicked < 0)
+		{
+			iPicked = (int) iTenant;
+			continue;
+		}
+
+		const WildTenant &picked = *m_rgTenants[iPicked];
+
+		if (m_bFair ? tenant.dPass < picked.dPass :
+		    tenant.queue.front()->uSequence < picked.queue.front()->uSequence)
+		{
+			iPicked = (int) iTenant;
+		}
+	}
+
+	return iPicked;
+}
+
+
+// Takes a batch out of its lane once its last keys have gone out.
+//
+void WildMatchService::Unqueue(WildServiceBatch *pBatch)
+{
+	if (pBatch->lane == WILD_LANE_INTERACTIVE)
+	{
+		std::pop_heap(m_rgInteractive.begin(), m_rgInteractive.end(),
+		              DueLater);
+		m_rgInteractive.pop_back();
+	}
+	else
+	{
+		m_rgTenants[pBatch->iTenant]->queue.pop_front();
+	}
+
+	--m_cQueued;
+}
+
+
+// Returns the batch whose keys go out next, or NULL if none are waiting:
+// the interactive batch due soonest, or else the oldest bulk batch of the
+// tenant whose turn it is.  A batch found past its deadline is dropped or
+// moved to the bulk lane first.  Called with the lock held, which it may
+// let go of to finish a dropped batch.
+//
+WildMatchService::WildServiceBatch *WildMatchService::PickBatch(
+    std::unique_lock<std::mutex> &lock)
+{
+	for (;;)
+	{
+		WildServiceBatch *pBatch;
+
+		if (!m_rgInteractive.empty())
+		{
+			pBatch = m_rgInteractive.front();
+		}
+		else
+		{
+			int iTenant = PickTenant();
+
+			if (iTenant < 0)
+			{
+				return NULL;
+			}
+
+			pBatch = m_rgTenants[iTenant]->queue.front();
+		}
+
+		if (pBatch->bMissed || pBatch->uDeadlineNanos == UINT64_MAX ||
+		    SteadyNanos() <= pBatch->uDeadlineNanos)
+		{
+			return pBatch;
+		}
+
+		pBatch->bMissed = true;
+
+		if (!pBatch->bDropLate)
+		{
+			if (pBatch->lane == WILD_LANE_INTERACTIVE)
+			{
+				Unqueue(pBatch);
+				pBatch->lane = WILD_LANE_BULK;
+				m_rgTenants[pBatch->iTenant]->queue.push_back(pBatch);
+				++m_cQueued;
+			}
+
+			continue;
+		}
+
+		WildTenant &tenant = *m_rgTenants[pBatch->iTenant];
+
+		Unqueue(pBatch);
+		tenant.stats.cExpired += pBatch->rgKeys.size() - pBatch->iNext;
+		std::fill(pBatch->rgResults.begin() + pBatch->iNext,
+		          pBatch->rgResults.end(), WILD_SERVICE_EXPIRED);
+		pBatch->iNext = pBatch->rgKeys.size();
+
+		if (pBatch->cRunning == 0)
+		{
+			FinishBatch(lock, pBatch);
+		}
+	}
+}
+
+
+// Counts a batch done, calls its done(), and frees it.  Called with the
+// lock held, which it lets go of around done().
+//
+void WildMatchService::FinishBatch(std::unique_lock<std::mutex> &lock,
+                                   WildServiceBatch *pBatch)
+{
+	WildTenant &tenant = *m_rgTenants[pBatch->iTenant];
+	uint64_t    uNow = SteadyNanos();
+
+	tenant.stats.cBatches++;
+	tenant.stats.cMissed += pBatch->bMissed ||
+	                        uNow > pBatch->uDeadlineNanos;
+	tenant.stats.uLatencyNanos += uNow - pBatch->uSubmitNanos;
+	tenant.stats.cbMemory -= pBatch->cbMemory;
+	lock.unlock();
+
+	if (pBatch->done)
+	{
+		pBatch->done(pBatch->rgResults);
+	}
+
+	delete pBatch;
+	lock.lock();
+	--tenant.cBusy;
+
+	if (--m_cBusy == 0)
+	{
+		m_cvIdle.notify_all();
+	}
+}
+
+
+// Takes the next slice of keys waiting, runs it, and returns true, or
+// returns false if no keys are waiting.  Called with the lock held, which
+// it lets go of while matching.
+//
+bool WildMatchService::RunSlice(std::unique_lock<std::mutex> &lock,
+                                WildSegmentMemo &memo)
+{
+	WildServiceBatch *pBatch = PickBatch(lock);
+
+	if (!pBatch)
+	{
+		return false;
+	}
+
+	// Takes the next slice of the batch, one key if there's no telling yet
+	// what its tenant's keys cost, and charges the tenant what the slice
+	// should cost.
+	WildTenant &tenant = *m_rgTenants[pBatch->iTenant];
+	size_t      cTake = 1;
+
+	if (tenant.dKeyNanos > 0)
+	{
+		cTake = (size_t) std::min((double) WILD_SERVICE_SLICE,
+		    std::max(1.0, WILD_SERVICE_SLICE_NANOS / tenant.dKeyNanos));
+	}
+
+	size_t iBegin = pBatch->iNext;
+	size_t iEnd = std::min(pBatch->rgKeys.size(), iBegin + cTake);
+	double dEstimate = tenant.dKeyNanos * (iEnd - iBegin);
+
+	pBatch->iNext = iEnd;
+	++pBatch->cRunning;
+
+	if (iEnd == pBatch->rgKeys.size())
+	{
+		Unqueue(pBatch);
+	}
+
+	m_dPass = std::max(m_dPass, tenant.dPass);
+	tenant.dPass += dEstimate / tenant.limits.dWeight;
+
+	uint64_t cStepBudget = tenant.limits.cStepBudget;
+
+	lock.unlock();
+
+	uint64_t uStart = ThreadCpuNanos();
+	uint64_t cSteps = 0;
+	uint64_t cMatched = 0;
+	uint64_t cOverBudget = 0;
+
+	for (size_t iKey = iBegin; iKey < iEnd; ++iKey)
+	{
+		const std::string &strKey = pBatch->rgKeys[iKey];
+		int                iResult = MatchWithinBudget(*pBatch->pSet,
+		                             strKey.data(), strKey.size(),
+		                             cStepBudget, memo, &cSteps);
+
+		pBatch->rgResults[iKey] = iResult;
+		cMatched += iResult >= 0;
+		cOverBudget += iResult == WILD_SERVICE_OVER_BUDGET;
+	}
+
+	uint64_t uNanos = ThreadCpuNanos() - uStart;
+
+	lock.lock();
+	tenant.dPass += (uNanos - dEstimate) / tenant.limits.dWeight;
+
+	if (iEnd > iBegin)
+	{
+		double dKeyNanos = (double) uNanos / (iEnd - iBegin);
+
+		tenant.dKeyNanos = tenant.dKeyNanos > 0 ?
+		                   (tenant.dKeyNanos * 7 + dKeyNanos) / 8 : dKeyNanos;
+	}
+
+	tenant.stats.cKeys += iEnd - iBegin;
+	tenant.stats.cMatched += cMatched;
+	tenant.stats.cOverBudget += cOverBudget;
+	tenant.stats.cSteps += cSteps;
+	tenant.stats.uCpuNanos += uNanos;
+
+	if (--pBatch->cRunning == 0 && pBatch->iNext == pBatch->rgKeys.size())
+	{
+		FinishBatch(lock, pBatch);
+	}
+
+	return true;
+}
+
+
+// Matches the key in a slot for its tenant, and counts it.
+//
+void WildMatchService::ServeSlot(WildServiceSlot &slot, WildSegmentMemo &memo)
+{
+	WildTenant &tenant = *m_rgTenants[slot.iTenant];
+	uint64_t    cSteps = 0;
+
+	slot.iResult = MatchWithinBudget(*slot.pSet, slot.pKey, slot.cbKey,
+	                                 tenant.limits.cStepBudget, memo, &cSteps);
+	tenant.cInlineKeys.fetch_add(1, std::memory_order_relaxed);
+	tenant.cInlineSteps.fetch_add(cSteps, std::memory_order_relaxed);
+
+	if (slot.iResult >= 0)
+	{
+		tenant.cInlineMatched.fetch_add(1, std::memory_order_relaxed);
+	}
+	else if (slot.iResult == WILD_SERVICE_OVER_BUDGET)
+	{
+		tenant.cInlineOverBudget.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+
+// A blocking worker sleeps until a slot is ready or a batch is queued.
+//
+void WildMatchService::WorkerLoop()
+{
+	WildSegmentMemo              memo;
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	for (;;)
+	{
+		m_cvWork.wait(lock, [&]()
+		{
+			return m_bStop || m_cReadySlots > 0 || m_cQueued > 0;
+		});
+
+		if (m_cReadySlots == 0)
+		{
+			if (!RunSlice(lock, memo) && m_bStop)
+			{
+				return;
+			}
+
+			continue;
+		}
+
+		WildServiceSlot *pSlot = &m_rgSlots[0];
+
+		while (pSlot->uState.load(std::memory_order_relaxed) !=
+		       WILD_SLOT_READY)
+		{
+			++pSlot;
+		}
+
+		pSlot->uState.store(WILD_SLOT_TAKEN, std::memory_order_relaxed);
+		--m_cReadySlots;
+		lock.unlock();
+		ServeSlot(*pSlot, memo);
+		lock.lock();
+		pSlot->uState.store(WILD_SLOT_DONE, std::memory_order_relaxed);
+		pSlot->cvDone.notify_one();
+	}
+}
+
+
+// Waits out one idle poll, by the policy: pausing, then yielding, then
+// sleeping.
+//
+static void PollBackoff(const WildPollPolicy &policy, uint32_t cIdle)
+{
+	if (cIdle < policy.cPauses)
+	{
+		WildCpuRelax();
+	}
+	else if (cIdle - policy.cPauses < policy.cYields ||
+	         policy.uSleepMicros == 0)
+	{
+		std::this_thread::yield();
+	}
+	else
+	{
+		std::this_thread::sleep_for(
+		    std::chrono::microseconds(policy.uSleepMicros));
+	}
+}
+
+
+// A polling worker, pinned if the policy says so, watches its own share of
+// the slots, and takes a slice of a batch when there is one.
+//
+void WildMatchService::PollLoop(int iWorker, int cWorkers)
+{
+	WildSegmentMemo memo;
+	uint32_t        cIdle = 0;
+
+	if (m_poll.iFirstCpu >= 0)
+	{
+		unsigned cCpus = std::max(1u, std::thread::hardware_concurrency());
+
+		WildPinThread((int) ((m_poll.iFirstCpu + iWorker) % cCpus));
+	}
+
+	while (!m_bStop.load(std::memory_order_relaxed))
+	{
+		bool bWorked = false;
+
+		for (int iSlot = iWorker; iSlot < WILD_SERVICE_SLOTS;
+		     iSlot += cWorkers)
+		{
+			WildServiceSlot &slot = m_rgSlots[iSlot];
+
+			if (slot.uState.load(std::memory_order_acquire) ==
+			    WILD_SLOT_READY)
+			{
+				ServeSlot(slot, memo);
+				slot.uState.store(WILD_SLOT_DONE, std::memory_order_release);
+				bWorked = true;
+			}
+		}
+
+		if (m_cQueued.load(std::memory_order_relaxed) > 0)
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+
+			bWorked |= RunSlice(lock, memo);
+		}
+
+		if (bWorked)
+		{
+			cIdle = 0;
+		}
+		else
+		{
+			PollBackoff(m_poll, cIdle++);
+		}
+	}
+}
+
+
+int WildMatchService::MatchOne(int iTenant, const char *pKey, size_t cbKey)
+{
+	if (iTenant < 0 || iTenant >= m_cTenants.load(std::memory_order_acquire))
+	{
+		return WILD_SERVICE_NO_TENANT;
+	}
+
+	// Each thread starts from a slot of its own, and moves on only if
+	// another thread has that one.
+	static std::atomic<uint32_t> s_uNextSlot(0);
+	static thread_local uint32_t s_iSlot = s_uNextSlot++ % WILD_SERVICE_SLOTS;
+	uint32_t                     uFree = WILD_SLOT_FREE;
+
+	while (!m_rgSlots[s_iSlot].uState.compare_exchange_weak(uFree,
+	       WILD_SLOT_CLAIMED, std::memory_order_acquire))
+	{
+		uFree = WILD_SLOT_FREE;
+		s_iSlot = (s_iSlot + 1) % WILD_SERVICE_SLOTS;
+	}
+
+	WildServiceSlot                       &slot = m_rgSlots[s_iSlot];
+	std::shared_ptr<const WildPatternSet>  pSet =
+	    std::atomic_load(&m_rgTenants[iTenant]->pSet);
+
+	slot.iTenant = iTenant;
+	slot.pSet = pSet.get();
+	slot.pKey = pKey;
+	slot.cbKey = cbKey;
+
+	if (m_bPoll)
+	{
+		uint32_t cIdle = 0;
+
+		slot.uState.store(WILD_SLOT_READY, std::memory_order_release);
+
+		while (slot.uState.load(std::memory_order_acquire) != WILD_SLOT_DONE)
+		{
+			PollBackoff(m_poll, cIdle++);
+		}
+	}
+	else
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		slot.uState.store(WILD_SLOT_READY, std::memory_order_relaxed);
+		++m_cReadySlots;
+		m_cvWork.notify_one();
+		slot.cvDone.wait(lock, [&]()
+		{
+			return slot.uState.load(std::memory_order_relaxed) ==
+			       WILD_SLOT_DONE;
+		});
+	}
+
+	int iResult = slot.iResult;
+
+	slot.uState.store(WILD_SLOT_FREE, std::memory_order_release);
+	return iResult;
+}
+
+
+// The first of a list of patterns that a key matches, or
+// WILD_SERVICE_NO_MATCH.
+//
+static int FirstMatch(const std::vector<std::string> &rgWild,
+                      const std::string &strKey)
+{
+	for (size_t iWild = 0; iWild < rgWild.size(); ++iWild)
+	{
+		if (FastWildCompare(const_cast<char *>(rgWild[iWild].c_str()),
+		                    const_cast<char *>(strKey.c_str())))
+		{
+			return (int) iWild;
+		}
+	}
+
+	return WILD_SERVICE_NO_MATCH;
+}
+
+
+// A set of service tests: each tenant's results against its own patterns
+// only, patterns replaced between batches, step budgets, memory limits,
+// and a batch from a quiet tenant overtaking a backlog from a busy one.
+//
+extern "C" int testservice(void)
+{
+	WildBenchRandom  rng(2020);
+	WildTenantLimits limits = {1, 0, 0};
+	bool             bAllPassed = true;
+
+	{
+		WildMatchService                      service(3);
+		std::vector<std::vector<std::string>> rgrgWild(4);
+		std::vector<int>                      rgiTenant;
+		std::mutex                            mutex;
+		size_t                                cDone = 0;
+		bool                                  bResultsPassed = true;
+
+		for (size_t iTenant = 0; iTenant < rgrgWild.size(); ++iTenant)
+		{
+			rgiTenant.push_back(service.AddTenant(limits));
+
+			for (uint32_t i = 1 + rng.Below(200); i > 0; --i)
+			{
+				std::string strWild;
+
+				WildBenchMakePattern(rng, strWild);
+				rgrgWild[iTenant].push_back(strWild);
+			}
+
+			bAllPassed &= service.SetPatterns(rgiTenant[iTenant],
+			                                  rgrgWild[iTenant]);
+		}
+
+		for (int iBatch = 0; iBatch < 60; ++iBatch)
+		{
+			size_t                   iTenant = rng.Below(4);
+			std::vector<std::string> rgKeys(rng.Below(300));
+			std::vector<int>         rgExpected;
+
+			for (std::string &strKey : rgKeys)
+			{
+				WildBenchMakeKey(rng, strKey, rng.Below(4) == 0);
+				rgExpected.push_back(FirstMatch(rgrgWild[iTenant], strKey));
+			}
+
+			bAllPassed &= service.Submit(rgiTenant[iTenant],
+			              std::move(rgKeys),
+			              [&, rgExpected](const std::vector<int> &rgResults)
+			{
+				// Workers call this, so it keeps to its own flag.
+				std::lock_guard<std::mutex> lock(mutex);
+
+				bResultsPassed &= rgResults == rgExpected;
+				++cDone;
+			});
+
+			if (iBatch == 30)
+			{
+				// Batches already queued keep the patterns they came with.
+				service.Drain();
+				rgrgWild[iTenant].resize(rgrgWild[iTenant].size() / 2);
+				bAllPassed &= service.SetPatterns(rgiTenant[iTenant],
+				                                  rgrgWild[iTenant]);
+			}
+		}
+
+		service.Drain();
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+
+			bAllPassed &= bResultsPassed && cDone == 60;
+		}
+
+		bAllPassed &= !service.Submit(9, {"x"}, NULL) &&
+		              !service.SetPatterns(-1, rgrgWild[0]);
+
+		uint64_t cBatches = 0;
+
+		for (int iTenant : rgiTenant)
+		{
+			WildTenantStats stats = service.Stats(iTenant);
+
+			cBatches += stats.cBatches;
+			bAllPassed &= stats.cOverBudget == 0 && stats.cRejected == 0 &&
+			              stats.cMatched <= stats.cKeys;
+		}
+
+		bAllPassed &= cBatches == 60;
+	}
+
+	{
+		// A budget small enough that keys needing more than the first
+		// groups give up, since no key has a digit before an 'x', and a
+		// memory limit.
+		WildTenantLimits         limitsTight = {1, 40, 128 * 1024};
+		WildMatchService         service(1);
+		int                      iTenant = service.AddTenant(limitsTight);
+		std::vector<std::string> rgWild;
+		std::vector<std::string> rgKeys(100);
+		std::vector<int>         rgExpected;
+		std::vector<int>         rgResults;
+
+		for (int i = 0; i < 600; ++i)
+		{
+			rgWild.push_back("*" + std::to_string(i) + "x*");
+		}
+
+		rgWild.push_back("*");
+		bAllPassed &= service.SetPatterns(iTenant, rgWild);
+
+		for (std::string &strKey : rgKeys)
+		{
+			WildBenchMakeKey(rng, strKey);
+			rgExpected.push_back(FirstMatch(rgWild, strKey));
+		}
+
+		bAllPassed &= service.Submit(iTenant, std::vector<std::string>(rgKeys),
+		              [&](const std::vector<int> &rgDone)
+		{
+			rgResults = rgDone;
+		});
+		service.Drain();
+
+		for (size_t iKey = 0; iKey < rgKeys.size(); ++iKey)
+		{
+			bAllPassed &= rgResults[iKey] == rgExpected[iKey] ||
+			              rgResults[iKey] == WILD_SERVICE_OVER_BUDGET;
+		}
+
+		WildTenantStats stats = service.Stats(iTenant);
+
+		bAllPassed &= stats.cOverBudget == rgKeys.size();
+
+		std::vector<std::string> rgHuge(2000, std::string(40, 'k'));
+
+		bAllPassed &= !service.Submit(iTenant, std::move(rgHuge), NULL);
+		rgWild.resize(20000, "/srv/*/*.log");
+		bAllPassed &= !service.SetPatterns(iTenant, rgWild) &&
+		              service.Stats(iTenant).cRejected == 2 &&
+		              service.Stats(iTenant).cbMemory == stats.cbMemory;
+	}
+
+	for (int iPoll = 0; iPoll < 2; ++iPoll)
+	{
+		// Inline requests from several threads, alongside batches, with
+		// workers that sleep and workers that poll.
+		WildPollPolicy                        policy = {-1, 64, 64, 50};
+		WildMatchService                      service(2,
+		                                              iPoll ? &policy : NULL);
+		std::vector<std::vector<std::string>> rgrgWild(2);
+		std::vector<std::string>              rgKeys(600);
+		std::vector<std::vector<int>>         rgrgExpected(2);
+		std::vector<std::thread>              rgClients;
+		std::atomic<int>                      cWrong(0);
+
+		for (int iTenant = 0; iTenant < 2; ++iTenant)
+		{
+			rgrgWild[iTenant].resize(50 + rng.Below(100));
+
+			for (std::string &strWild : rgrgWild[iTenant])
+			{
+				WildBenchMakePattern(rng, strWild);
+			}
+
+			bAllPassed &= service.AddTenant(limits) == iTenant &&
+			              service.SetPatterns(iTenant, rgrgWild[iTenant]);
+		}
+
+		for (std::string &strKey : rgKeys)
+		{
+			WildBenchMakeKey(rng, strKey, rng.Below(4) == 0);
+			rgrgExpected[0].push_back(FirstMatch(rgrgWild[0], strKey));
+			rgrgExpected[1].push_back(FirstMatch(rgrgWild[1], strKey));
+		}
+
+		for (int iClient = 0; iClient < 3; ++iClient)
+		{
+			rgClients.emplace_back([&, iClient]()
+			{
+				for (size_t iKey = iClient; iKey < rgKeys.size(); iKey += 3)
+				{
+					int iTenant = (int) (iKey + iClient) % 2;
+
+					if (service.MatchOne(iTenant, rgKeys[iKey].data(),
+					                     rgKeys[iKey].size()) !=
+					    rgrgExpected[iTenant][iKey])
+					{
+						++cWrong;
+					}
+				}
+			});
+		}
+
+		for (int iBatch = 0; iBatch < 10; ++iBatch)
+		{
+			service.Submit(iBatch % 2, std::vector<std::string>(rgKeys),
+			               [&, iBatch](const std::vector<int> &rgResults)
+			{
+				cWrong += rgResults != rgrgExpected[iBatch % 2];
+			});
+		}
+
+		for (std::thread &client : rgClients)
+		{
+			client.join();
+		}
+
+		service.Drain();
+
+		WildTenantStats stats0 = service.Stats(0);
+		WildTenantStats stats1 = service.Stats(1);
+
+		bAllPassed &= cWrong == 0 && stats0.cInline + stats1.cInline == 600 &&
+		              stats0.cKeys + stats1.cKeys == 600 + 6000 &&
+		              service.MatchOne(2, "x", 1) == WILD_SERVICE_NO_TENANT;
+	}
+
+	{
+		// On one worker, batches submitted from a done() callback, while
+		// the worker can't pick anything, go out interactive first, soonest
+		// due first, then bulk.  Batches past their deadlines are dropped
+		// or finished in the bulk lane.
+		WildMatchService         service(1);
+		int                      iTenant = service.AddTenant(limits);
+		std::vector<std::string> rgWild(1, "*.log");
+		std::vector<int>         rgOrder;
+		WildJobOptions           rgOptions[] =
+		{
+			{WILD_LANE_INTERACTIVE, 5000000000ull, false},
+			{WILD_LANE_INTERACTIVE, 3000000000ull, false},
+			{WILD_LANE_INTERACTIVE, 4000000000ull, true},
+			{WILD_LANE_INTERACTIVE, 0, false}
+		};
+		WildJobOptions           optionsDrop = {WILD_LANE_BULK, 1, true};
+		WildJobOptions           optionsLate = {WILD_LANE_INTERACTIVE, 1,
+		                                        false};
+		std::vector<int>         rgDropped;
+		std::vector<int>         rgLate;
+
+		service.SetPatterns(iTenant, rgWild);
+		service.Submit(iTenant, {"/a.log"}, [&](const std::vector<int> &)
+		{
+			service.Submit(iTenant, {"/b.log"}, [&](const std::vector<int> &)
+			{
+				rgOrder.push_back(4);
+			});
+
+			for (int i = 0; i < 4; ++i)
+			{
+				service.Submit(iTenant, {"/c.log"},
+				               [&, i](const std::vector<int> &)
+				{
+					rgOrder.push_back(i);
+				}, &rgOptions[i]);
+			}
+
+			service.Submit(iTenant, {"/d.log", "/e.txt"},
+			               [&](const std::vector<int> &rgResults)
+			{
+				rgDropped = rgResults;
+			}, &optionsDrop);
+			service.Submit(iTenant, {"/f.log", "/g.txt"},
+			               [&](const std::vector<int> &rgResults)
+			{
+				rgLate = rgResults;
+			}, &optionsLate);
+		});
+		service.Drain();
+
+		WildTenantStats stats = service.Stats(iTenant);
+
+		bAllPassed &= rgOrder == std::vector<int>({1, 2, 0, 3, 4}) &&
+		              rgDropped == std::vector<int>(2, WILD_SERVICE_EXPIRED) &&
+		              rgLate == std::vector<int>({0, WILD_SERVICE_NO_MATCH}) &&
+		              stats.cMissed == 2 && stats.cExpired == 2;
+	}
+
+	for (int iFair = 0; iFair < 2; ++iFair)
+	{
+		// One worker, a backlog of costly batches from one tenant, then one
+		// small batch from another: fair scheduling takes it soon, and
+		// first-come takes it last.
+		WildMatchService         service(1);
+		int                      iBusy = service.AddTenant(limits);
+		int                      iQuiet = service.AddTenant(limits);
+		std::vector<std::string> rgWild;
+		std::atomic<int>         cDone(0);
+		int                      iQuietDone = -1;
+
+		service.SetFair(iFair != 0);
+
+		for (int i = 0; i < 2000; ++i)
+		{
+			rgWild.push_back("*" + std::to_string(i) + "*q*");
+		}
+
+		service.SetPatterns(iBusy, rgWild);
+		service.SetPatterns(iQuiet, rgWild);
+
+		for (int iBatch = 0; iBatch < 20; ++iBatch)
+		{
+			service.Submit(iBusy, std::vector<std::string>(16,
+			               std::string(200, 'a')),
+			               [&](const std::vector<int> &)
+			{
+				++cDone;
+			});
+		}
+
+		service.Submit(iQuiet, {"q"}, [&](const std::vector<int> &)
+		{
+			iQuietDone = cDone++;
+		});
+		service.Drain();
+		bAllPassed &= iFair ? iQuietDone < 5 : iQuietDone == 20;
+	}
+
+	if (bAllPassed)
+	{
+		printf("Passed service tests\n");
+	}
+	else
+	{
+		printf("Failed service tests\n");
+	}
+
+	return 0;
+}
+
+
+// Runs clients against a service for a while, each submitting a batch and
+// waiting for it, except a hostile one that keeps several costly batches
+// queued.  Appends each well-behaved batch's latency to rguNanos, and
+// returns the keys those batches matched.
+//
+static uint64_t RunServiceLoad(WildMatchService &service,
+                               const std::vector<int> &rgiGood,
+                               const std::vector<std::string> &rgGoodKeys,
+                               int iHostile,
+                               const std::vector<std::string> &rgHostileKeys,
+                               uint64_t uRunNanos,
+                               std::vector<uint64_t> &rguNanos)
+{
+	std::atomic<bool>        bRunning(true);
+	std::atomic<uint64_t>    cKeys(0);
+	std::mutex               mutex;
+	std::vector<std::thread> rgClients;
+
+	for (int iGood : rgiGood)
+	{
+		rgClients.emplace_back([&, iGood]()
+		{
+			WildBenchRandom rng(iGood);
+
+			while (bRunning)
+			{
+				std::vector<std::string> rgKeys(256);
+				std::promise<void>       done;
+				uint64_t                 uStart = WildBenchNanos();
+
+				for (std::string &strKey : rgKeys)
+				{
+					strKey = rgGoodKeys[rng.Below((uint32_t)
+					                              rgGoodKeys.size())];
+				}
+
+				service.Submit(iGood, std::move(rgKeys),
+				               [&](const std::vector<int> &rgResults)
+				{
+					cKeys += rgResults.size();
+					done.set_value();
+				});
+				done.get_future().wait();
+
+				std::lock_guard<std::mutex> lock(mutex);
+
+				rguNanos.push_back(WildBenchNanos() - uStart);
+			}
+		});
+	}
+
+	if (iHostile >= 0)
+	{
+		rgClients.emplace_back([&]()
+		{
+			std::atomic<int> cQueued(0);
+
+			while (bRunning)
+			{
+				if (cQueued >= 4)
+				{
+					std::this_thread::sleep_for(
+					    std::chrono::microseconds(200));
+					continue;
+				}
+
+				++cQueued;
+				service.Submit(iHostile,
+				               std::vector<std::string>(rgHostileKeys),
+				               [&](const std::vector<int> &)
+				{
+					--cQueued;
+				});
+			}
+
+			service.Drain();
+		});
+	}
+
+	std::this_thread::sleep_for(std::chrono::nanoseconds(uRunNanos));
+	bRunning = false;
+
+	for (std::thread &client : rgClients)
+	{
+		client.join();
+	}
+
+	return cKeys;
+}
+
+
+// Runs a bulk sweep, with two large batches kept queued by submitting the
+// next as each is done, while a client submits small batches one at a
+// time, with options if there are any.  Appends each small batch's latency
+// to rguNanos.
+//
+static void RunSweepLoad(WildMatchService &service, int iTenant,
+                         const std::vector<std::string> &rgKeys,
+                         const WildJobOptions *pOptions, size_t cLookups,
+                         std::vector<uint64_t> &rguNanos)
+{
+	std::atomic<bool>                          bRunning(true);
+	std::function<void(const std::vector<int> &)> next;
+	WildBenchRandom                            rng(2222);
+
+	next = [&](const std::vector<int> &)
+	{
+		if (bRunning)
+		{
+			service.Submit(iTenant, std::vector<std::string>(rgKeys), next);
+		}
+	};
+	next(std::vector<int>());
+	next(std::vector<int>());
+
+	for (size_t iLookup = 0; iLookup < cLookups; ++iLookup)
+	{
+		std::vector<std::string> rgLookup(8);
+		std::promise<void>       done;
+
+		for (std::string &strKey : rgLookup)
+		{
+			strKey = rgKeys[rng.Below((uint32_t) rgKeys.size())];
+		}
+
+		uint64_t uStart = WildBenchNanos();
+
+		service.Submit(iTenant, std::move(rgLookup),
+		               [&](const std::vector<int> &)
+		{
+			done.set_value();
+		}, pOptions);
+		done.get_future().wait();
+		rguNanos.push_back(WildBenchNanos() - uStart);
+	}
+
+	bRunning = false;
+	service.Drain();
+}
+
+
+// A load test: three well-behaved tenants alone, then alongside a hostile
+// one whose patterns and keys cost far more per key, with fair scheduling
+// and with first-come scheduling.
+//
+extern "C" int benchservice(void)
+{
+	const int                cGood = 3;
+	const uint64_t           uRunNanos = 1000000000;
+	WildBenchRandom          rng(2121);
+	WildTenantLimits         limits = {1, 0, 256 << 20};
+	WildTenantLimits         limitsHostile = {1, 200000, 256 << 20};
+	std::vector<std::string> rgGoodKeys(20000);
+	std::vector<std::string> rgHostileKeys(64);
+	std::vector<std::string> rgHostileWild;
+
+	for (std::string &strKey : rgGoodKeys)
+	{
+		WildBenchMakeKey(rng, strKey, rng.Below(4) == 0);
+	}
+
+	// Leading '*' patterns, each with several segments of its own, over
+	// long keys: nothing filters them out, and every segment is searched.
+	for (int i = 0; i < 4000; ++i)
+	{
+		std::string strWild;
+
+		for (int iSegment = 0; iSegment < 5; ++iSegment)
+		{
+			strWild += "*";
+			strWild += (char) ('a' + rng.Below(26));
+			strWild += (char) ('a' + rng.Below(26));
+			strWild += (char) ('a' + rng.Below(26));
+		}
+
+		rgHostileWild.push_back(strWild + "*");
+	}
+
+	for (std::string &strKey : rgHostileKeys)
+	{
+		for (int i = 0; i < 4096; ++i)
+		{
+			strKey += (char) ('a' + rng.Below(26));
+		}
+	}
+
+	printf("Service, %d well-behaved tenants (256-key batches) and a "
+	       "hostile one, 2 workers\n", cGood);
+
+	for (int iRun = 0; iRun < 3; ++iRun)
+	{
+		WildMatchService      service(2);
+		std::vector<int>      rgiGood;
+		std::vector<uint64_t> rguNanos;
+		int                   iHostile = -1;
+
+		service.SetFair(iRun != 2);
+
+		for (int iGood = 0; iGood < cGood; ++iGood)
+		{
+			std::vector<std::string> rgWild(300);
+
+			for (std::string &strWild : rgWild)
+			{
+				WildBenchMakePattern(rng, strWild);
+			}
+
+			rgiGood.push_back(service.AddTenant(limits));
+			service.SetPatterns(rgiGood.back(), rgWild);
+		}
+
+		if (iRun > 0)
+		{
+			iHostile = service.AddTenant(limitsHostile);
+			service.SetPatterns(iHostile, rgHostileWild);
+		}
+
+		uint64_t cKeys = RunServiceLoad(service, rgiGood, rgGoodKeys,
+		                                iHostile, rgHostileKeys, uRunNanos,
+		                                rguNanos);
+
+		std::sort(rguNanos.begin(), rguNanos.end());
+
+		uint64_t uGoodCpu = 0;
+
+		for (int iGood : rgiGood)
+		{
+			uGoodCpu += service.Stats(iGood).uCpuNanos;
+		}
+
+		WildTenantStats stats = service.Stats(iHostile);
+
+		printf("  %-22s good: %8.0f keys/s, batch p50 %7.2f ms, p99 "
+		       "%7.2f ms", iRun == 0 ? "alone" : iRun == 1 ?
+		       "with hostile, fair" : "with hostile, FIFO",
+		       cKeys / (uRunNanos / 1e9),
+		       rguNanos.empty() ? 0 : rguNanos[rguNanos.size() / 2] / 1e6,
+		       rguNanos.empty() ? 0 :
+		       rguNanos[rguNanos.size() * 99 / 100] / 1e6);
+
+		if (iHostile >= 0)
+		{
+			printf("; hostile: %llu keys (%llu past budget), CPU %.0f%% of "
+			       "the total", (unsigned long long) stats.cKeys,
+			       (unsigned long long) stats.cOverBudget,
+			       100.0 * stats.uCpuNanos / (stats.uCpuNanos + uGoodCpu));
+		}
+
+		printf("\n");
+	}
+
+	// Lookups sharing a tenant and its workers with a bulk sweep: in the
+	// sweep's lane, behind its batches, and in the interactive lane.
+	WildJobOptions optionsLookup = {WILD_LANE_INTERACTIVE, 2000000, false};
+
+	printf("Service lookups (8 keys) during a bulk sweep (2 x 20000-key "
+	       "batches queued), 2 workers\n");
+
+	for (int iLane = 0; iLane < 2; ++iLane)
+	{
+		WildMatchService         service(2);
+		std::vector<std::string> rgWild(300);
+		std::vector<std::string> rgSweep(rgGoodKeys.begin(),
+		                                 rgGoodKeys.end());
+		std::vector<uint64_t>    rguNanos;
+		int                      iTenant = service.AddTenant(limits);
+
+		for (std::string &strWild : rgWild)
+		{
+			WildBenchMakePattern(rng, strWild);
+		}
+
+		service.SetPatterns(iTenant, rgWild);
+		RunSweepLoad(service, iTenant, rgSweep,
+		             iLane ? &optionsLookup : NULL, iLane ? 3000 : 300,
+		             rguNanos);
+		std::sort(rguNanos.begin(), rguNanos.end());
+
+		WildTenantStats stats = service.Stats(iTenant);
+
+		printf("  %-28s p50 %8.3f ms, p99 %8.3f ms, p99.9 %8.3f ms%s",
+		       iLane ? "interactive, 2 ms deadline" : "bulk, behind the sweep",
+		       rguNanos[rguNanos.size() / 2] / 1e6,
+		       rguNanos[rguNanos.size() * 99 / 100] / 1e6,
+		       rguNanos[rguNanos.size() * 999 / 1000] / 1e6,
+		       iLane ? "" : "\n");
+
+		if (iLane)
+		{
+			printf(", %llu of %zu past deadline\n",
+			       (unsigned long long) stats.cMissed, rguNanos.size());
+		}
+	}
+
+	// Inline round trips, one key at a time from one caller, to workers
+	// that sleep and to workers that poll.
+	const size_t             cRoundTrips = 50000;
+	std::vector<std::string> rgWild(300);
+	WildPatternSet           set;
+	unsigned                 cCpus = std::thread::hardware_concurrency();
+
+	for (std::string &strWild : rgWild)
+	{
+		WildBenchMakePattern(rng, strWild);
+		set.Add(strWild.c_str());
+	}
+
+	set.Build();
+
+	WildSegmentMemo memo;
+	uint64_t        uStart = WildBenchNanos();
+
+	for (size_t i = 0; i < cRoundTrips; ++i)
+	{
+		set.MatchFirst(rgGoodKeys[i % rgGoodKeys.size()].c_str(), memo);
+	}
+
+	printf("Service inline round trips, %u CPUs, %zu keys, 300 patterns "
+	       "(matching in the caller: %.2f us a key)\n", cCpus, cRoundTrips,
+	       (WildBenchNanos() - uStart) / 1e3 / cRoundTrips);
+
+	// Polling workers go on the last CPU, away from the caller, if there's
+	// more than one.  With just one, pausing only delays the yield that
+	// lets the other side run.
+	int            iPinCpu = cCpus > 1 ? (int) cCpus - 1 : -1;
+	WildPollPolicy policyYield = {iPinCpu, cCpus > 1 ? 256u : 0u, 1000000,
+	                              0};
+	WildPollPolicy policySpin = {iPinCpu, 0xFFFFFFFF, 0, 0};
+
+	for (int iMode = 0; iMode < 3; ++iMode)
+	{
+		if (iMode == 2 && cCpus < 2)
+		{
+			printf("  %-28s skipped: it needs a core to spare\n",
+			       "poll, pausing only");
+			continue;
+		}
+
+		WildMatchService service(1, iMode == 0 ? NULL :
+		                         iMode == 1 ? &policyYield : &policySpin);
+		std::vector<uint64_t> rguNanos(cRoundTrips);
+		int                   iTenant = service.AddTenant(limits);
+
+		service.SetPatterns(iTenant, rgWild);
+
+		for (size_t i = 0; i < cRoundTrips; ++i)
+		{
+			const std::string &strKey = rgGoodKeys[i % rgGoodKeys.size()];
+
+			uStart = WildBenchNanos();
+			service.MatchOne(iTenant, strKey.data(), strKey.size());
+			rguNanos[i] = WildBenchNanos() - uStart;
+		}
+
+		std::sort(rguNanos.begin(), rguNanos.end());
+		printf("  %-28s p50 %8.2f us, p99 %8.2f us, p99.9 %8.2f us\n",
+		       iMode == 0 ? "blocking" : iMode == 1 ?
+		       "poll, pausing then yielding" : "poll, pausing only",
+		       rguNanos[cRoundTrips / 2] / 1e3,
+		       rguNanos[cRoundTrips * 99 / 100] / 1e3,
+		       rguNanos[cRoundTrips * 999 / 1000] / 1e3);
+	}
+
+	return 0;
+}
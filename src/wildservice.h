@@ -0,0 +1,276 @@
+// WildMatchService, a matching service shared by tenants, each with its
+// own patterns, share of the CPU, work budget, and memory limit
+//
+// Copyright 2025 Kirk J Krauss.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Many teams can share one service, each as a tenant with its own pattern
+// set.  A tenant submits batches of keys, and each key comes back with the
+// index of the first of the tenant's patterns that it matches.  A tenant
+// whose patterns or keys are costly to match should slow only itself.
+//
+// So the worker threads take batches in slices, of as many keys, up to
+// WILD_SERVICE_SLICE, as the tenant's recent keys say will take about
+// WILD_SERVICE_SLICE_NANOS, so that a costly tenant's slices hold a worker
+// no longer than a cheap one's.  Each slice is charged to its tenant: the
+// thread CPU time it took, divided by the tenant's weight.  The next slice
+// goes to the tenant with the least charged so far, so over time each busy
+// tenant gets CPU in proportion to its weight, whatever its slices cost.
+// A tenant that has been idle starts from where the busy ones are, not
+// from where it left off, so idling doesn't bank credit.  A slice is
+// charged what it's expected to cost as it starts, so that several threads
+// don't all pick the same tenant, and the difference once it's done.
+//
+// Each key's matching can also be held to a step budget: segment bytes
+// scanned plus pattern groups filtered.  A key that runs past it gets
+// WILD_SERVICE_OVER_BUDGET instead of an answer.  And a tenant's patterns
+// and queued keys are held to a memory limit, past which SetPatterns()
+// and Submit() turn them away.
+//
+// A batch can also go in the interactive lane, with a deadline.  Slices
+// of interactive batches go ahead of any bulk slice, earliest deadline
+// first, so a bulk sweep gives way to a lookup at its next slice, and
+// holds it up no longer than a slice takes.  A batch found past its
+// deadline when its next slice would go out is either dropped, its keys
+// not yet started getting WILD_SERVICE_EXPIRED, or moved to the bulk lane
+// to finish as work can be fitted in.
+//
+// For an inline request path, where a single key's match takes well under
+// a microsecond, MatchOne() hands a key to a worker through one of
+// WILD_SERVICE_SLOTS request slots, each on cache lines of its own, and
+// waits for the answer.  By default the workers sleep on a condition
+// variable, and each request costs a wakeup both ways.  With a
+// WildPollPolicy, the workers are pinned to cores and poll their share of
+// the slots, and the caller polls its slot, so that neither sleeps: each
+// waits by pausing, then yielding, then, if the policy allows, sleeping.
+// Inline keys count toward a tenant's stats and are held to its step
+// budget, but they aren't weighed against its share, and polling is only
+// worth its cores where there are cores to spare.
+//
+#ifndef WILDSERVICE_H
+#define WILDSERVICE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "wildpatternset.h"
+
+#define WILD_SERVICE_SLICE        32   // Most keys a worker takes at once
+#define WILD_SERVICE_SLICE_NANOS  200000  // CPU time a slice aims for
+#define WILD_SERVICE_SLOTS        64   // Inline requests under way at once
+#define WILD_SERVICE_TENANTS      1024 // Most tenants a service takes
+#define WILD_SERVICE_NO_MATCH     -1   // A key matched none of the patterns
+#define WILD_SERVICE_OVER_BUDGET  -2   // A key ran past the step budget
+#define WILD_SERVICE_NO_TENANT    -3   // MatchOne() got no such tenant
+#define WILD_SERVICE_EXPIRED      -4   // A key dropped past its deadline
+
+enum WildServiceLane
+{
+	WILD_LANE_BULK,          // Fair shares among tenants
+	WILD_LANE_INTERACTIVE    // Ahead of bulk, earliest deadline first
+};
+
+struct WildJobOptions
+{
+	WildServiceLane lane;
+	uint64_t        uDeadlineNanos;   // After Submit(), or 0 for none
+	bool            bDropLate;        // Past the deadline, drop the keys not
+	                                  // yet started, rather than finish them
+	                                  // in the bulk lane
+};
+
+// How polling workers, and callers waiting on them, spend idle polls.
+struct WildPollPolicy
+{
+	int      iFirstCpu;      // Worker i is pinned to CPU iFirstCpu + i, or
+	                         // none are pinned if this is negative
+	uint32_t cPauses;        // Idle polls spent pausing
+	uint32_t cYields;        // Then idle polls spent yielding
+	uint32_t uSleepMicros;   // Then a sleep per idle poll, or 0 to go on
+	                         // yielding
+};
+
+struct WildTenantLimits
+{
+	double   dWeight;        // Share of the CPU, relative to the others
+	uint64_t cStepBudget;    // Steps per key, or 0 for no limit
+	size_t   cbMemory;       // Bytes of patterns and queued keys, or 0
+};
+
+struct WildTenantStats
+{
+	uint64_t cBatches;       // Batches done
+	uint64_t cKeys;          // Keys matched, or run past the budget
+	uint64_t cMatched;
+	uint64_t cOverBudget;
+	uint64_t cInline;        // Keys from MatchOne(), counted in cKeys too
+	uint64_t cMissed;        // Batches done, or dropped, past deadline
+	uint64_t cExpired;       // Keys dropped past their batch's deadline
+	uint64_t cRejected;      // Batches and pattern sets turned away
+	uint64_t cSteps;
+	uint64_t uCpuNanos;      // Thread CPU time spent on the tenant's keys
+	uint64_t uLatencyNanos;  // Summed from each batch's Submit() to done
+	size_t   cbMemory;       // Bytes now held against the limit
+};
+
+// Called on a worker thread once every key of a batch has its result.
+typedef std::function<void(const std::vector<int> &rgResults)>
+    WildServiceDone;
+
+class WildMatchService
+{
+public:
+	// Starts cThreads worker threads, which poll by a policy if there's
+	// one, and otherwise sleep until there's work.
+	explicit WildMatchService(int cThreads,
+	                          const WildPollPolicy *pPoll = NULL);
+
+	// Waits for every batch submitted to be done, then stops the workers.
+	~WildMatchService();
+
+	// Adds a tenant with no patterns, and returns its number, or -1 if
+	// there are WILD_SERVICE_TENANTS already.
+	int AddTenant(const WildTenantLimits &limits);
+
+	// Replaces a tenant's patterns.  Batches already submitted go on with
+	// the patterns they were submitted under.  Returns false if there's no
+	// such tenant, or if the patterns would put it past its memory limit.
+	bool SetPatterns(int iTenant, const std::vector<std::string> &rgWild);
+
+	// Queues a batch of keys for matching, in the bulk lane with no
+	// deadline unless there are options saying otherwise, and calls done()
+	// with a result for each: the index of the first pattern it matches,
+	// or WILD_SERVICE_NO_MATCH, WILD_SERVICE_OVER_BUDGET, or
+	// WILD_SERVICE_EXPIRED.  Returns false, without calling done(), if
+	// there's no such tenant or the keys would put it past its memory
+	// limit.
+	bool Submit(int iTenant, std::vector<std::string> &&rgKeys,
+	            const WildServiceDone &done,
+	            const WildJobOptions *pOptions = NULL);
+
+	// Matches one key for a tenant on a worker, inline, and returns the
+	// result as done() would get it from Submit(), or
+	// WILD_SERVICE_NO_TENANT.  The key need not be terminated.
+	int MatchOne(int iTenant, const char *pKey, size_t cbKey);
+
+	// Waits until every batch submitted so far is done.
+	void Drain();
+
+	WildTenantStats Stats(int iTenant) const;
+
+	// With fairness off, slices go out in the order their batches came in,
+	// whatever the tenant.  For comparison only.
+	void SetFair(bool bFair);
+
+private:
+	struct WildServiceBatch
+	{
+		std::vector<std::string>              rgKeys;
+		std::vector<int>                      rgResults;
+		std::shared_ptr<const WildPatternSet> pSet;
+		WildServiceDone                       done;
+		size_t                                iNext;      // Next key to take
+		size_t                                cRunning;   // Slices under way
+		size_t                                cbMemory;
+		uint64_t                              uSequence;  // Order submitted
+		uint64_t                              uSubmitNanos;
+		uint64_t                              uDeadlineNanos;  // Or UINT64_MAX
+		int                                   iTenant;
+		WildServiceLane                       lane;
+		bool                                  bDropLate;
+		bool                                  bMissed;    // Found past it
+	};
+
+	enum WildSlotState
+	{
+		WILD_SLOT_FREE,
+		WILD_SLOT_CLAIMED,   // A caller is filling it in
+		WILD_SLOT_READY,     // Waiting for a worker
+		WILD_SLOT_TAKEN,     // A blocking worker is matching it
+		WILD_SLOT_DONE       // Waiting for the caller
+	};
+
+	struct alignas(64) WildServiceSlot
+	{
+		std::atomic<uint32_t>   uState;
+		int                     iTenant;
+		int                     iResult;
+		const WildPatternSet   *pSet;
+		const char             *pKey;
+		size_t                  cbKey;
+		std::condition_variable cvDone;    // For blocking workers
+	};
+
+	struct WildTenant
+	{
+		WildTenantLimits                      limits;
+		WildTenantStats                       stats;
+		std::shared_ptr<const WildPatternSet> pSet;
+		size_t                                cbPatterns;
+		std::deque<WildServiceBatch *>        queue;      // Keys not taken
+		size_t                                cBusy;      // Batches not done
+		double                                dPass;      // Charged so far
+		double                                dKeyNanos;  // Lately, per key
+		std::atomic<uint64_t>                 cInlineKeys;
+		std::atomic<uint64_t>                 cInlineMatched;
+		std::atomic<uint64_t>                 cInlineOverBudget;
+		std::atomic<uint64_t>                 cInlineSteps;
+	};
+
+	static bool DueLater(const WildServiceBatch *pA,
+	                     const WildServiceBatch *pB);
+	int PickTenant() const;
+	WildServiceBatch *PickBatch(std::unique_lock<std::mutex> &lock);
+	void Unqueue(WildServiceBatch *pBatch);
+	void FinishBatch(std::unique_lock<std::mutex> &lock,
+	                 WildServiceBatch *pBatch);
+	bool RunSlice(std::unique_lock<std::mutex> &lock, WildSegmentMemo &memo);
+	void ServeSlot(WildServiceSlot &slot, WildSegmentMemo &memo);
+	void WorkerLoop();
+	void PollLoop(int iWorker, int cWorkers);
+
+	mutable std::mutex       m_mutex;
+	std::condition_variable  m_cvWork;
+	std::condition_variable  m_cvIdle;
+	std::vector<std::unique_ptr<WildTenant>> m_rgTenants;
+	std::vector<WildServiceBatch *> m_rgInteractive;  // Heap, soonest due
+	                                                  // on top
+	std::atomic<int>         m_cTenants;   // For MatchOne(), without the lock
+	std::unique_ptr<WildServiceSlot[]> m_rgSlots;
+	std::vector<std::thread> m_rgThreads;
+	std::atomic<size_t>      m_cQueued;    // Batches with keys not taken,
+	                                       // in either lane
+	size_t                   m_cReadySlots;  // For blocking workers
+	uint64_t                 m_uSequence;
+	size_t                   m_cBusy;      // Batches not done, all tenants
+	double                   m_dPass;      // Where the busy tenants are
+	WildPollPolicy           m_poll;
+	bool                     m_bPoll;
+	bool                     m_bFair;
+	std::atomic<bool>        m_bStop;
+};
+
+extern "C" int testservice(void);
+extern "C" int benchservice(void);
+
+#endif  // WILDSERVICE_H
@@ -0,0 +1,433 @@
+// WildSearchSession, and related code
+//
+// Copyright 2025 Kirk J Krauss.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// This file provides the containment check and the search session.  It
+// also includes testcases for correctness and performance.
+//
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "fastwildcompare.h"
+#include "wildbytecode.h"
+#include "wildcompiled.h"
+#include "wilddfa.h"
+#include "wildsession.h"
+#include "wildbench.h"
+
+// Rewrites each run of wildcards as its '?'s, then one '*' if it had any.
+//
+static std::string NormalizeWildcards(const char *pWild)
+{
+	std::string strNormal;
+
+	while (*pWild)
+	{
+		if (*pWild != '*' && *pWild != '?')
+		{
+			strNormal += *pWild++;
+			continue;
+		}
+
+		bool bStar = false;
+
+		for (; *pWild == '*' || *pWild == '?'; ++pWild)
+		{
+			if (*pWild == '*')
+			{
+				bStar = true;
+			}
+			else
+			{
+				strNormal += '?';
+			}
+		}
+
+		if (bStar)
+		{
+			strNormal += '*';
+		}
+	}
+
+	return strNormal;
+}
+
+
+bool WildPatternContains(const char *pOuter, const char *pInner)
+{
+	std::string strOuter = NormalizeWildcards(pOuter);
+	std::string strInner = NormalizeWildcards(pInner);
+	size_t      cOuter = strOuter.size();
+	size_t      cInner = strInner.size();
+
+	// rgbCovers[j] says whether the outer pattern from position i on
+	// covers the inner one from position j on, for the current i, working
+	// back from the ends of both.
+	std::vector<uint8_t> rgbCovers(cInner + 1, 0);
+	std::vector<uint8_t> rgbNext(cInner + 1, 0);
+
+	rgbNext[cInner] = 1;
+
+	for (size_t i = cOuter; i-- > 0; )
+	{
+		char chOuter = strOuter[i];
+
+		rgbCovers[cInner] = chOuter == '*' && rgbNext[cInner];
+
+		for (size_t j = cInner; j-- > 0; )
+		{
+			char chInner = strInner[j];
+
+			if (chOuter == '*')
+			{
+				rgbCovers[j] = rgbNext[j] || rgbCovers[j + 1];
+			}
+			else if (chOuter == '?')
+			{
+				rgbCovers[j] = chInner != '*' && rgbNext[j + 1];
+			}
+			else
+			{
+				rgbCovers[j] = chInner == chOuter && rgbNext[j + 1];
+			}
+		}
+
+		rgbCovers.swap(rgbNext);
+	}
+
+	return rgbNext[0] != 0;
+}
+
+
+WildSearchSession::WildSearchSession(const WildCorpus &corpus,
+                                     int cThreads) :
+    m_corpus(corpus), m_lastKind(WILD_SEARCH_SCANNED), m_cLastChecked(0),
+    m_cThreads(cThreads)
+{
+}
+
+
+const std::vector<uint32_t> &WildSearchSession::Search(const char *pWild)
+{
+	WildSearchStep step;
+	size_t         iBase = m_rgSteps.size();
+
+	// The narrowest earlier result that holds every match.
+	for (size_t i = 0; i < m_rgSteps.size(); ++i)
+	{
+		if (WildPatternContains(m_rgSteps[i].strWild.c_str(), pWild) &&
+		    (iBase == m_rgSteps.size() ||
+		     m_rgSteps[i].rgMatches.size() <
+		     m_rgSteps[iBase].rgMatches.size()))
+		{
+			iBase = i;
+		}
+	}
+
+	step.strWild = pWild;
+
+	if (iBase < m_rgSteps.size() && m_rgSteps[iBase].strWild == pWild)
+	{
+		step.rgMatches = m_rgSteps[iBase].rgMatches;
+		m_lastKind = WILD_SEARCH_REPEATED;
+		m_cLastChecked = 0;
+	}
+	else if (iBase < m_rgSteps.size())
+	{
+		const std::vector<uint32_t> &rgCandidates =
+		    m_rgSteps[iBase].rgMatches;
+		WildDfa                      dfa;
+		WildProgram                  program;
+		WildCompiledPattern          compiled;
+		bool                         bDfa = dfa.Compile(pWild);
+
+		// A segment too long for the program's operands still compiles
+		// into a WildCompiledPattern, with FastWildCompare()'s results.
+		bool bCompiled = !bDfa && !program.Compile(pWild);
+
+		if (bCompiled)
+		{
+			compiled.Compile(pWild);
+		}
+
+		for (uint32_t iKey : rgCandidates)
+		{
+			size_t      cbKey;
+			const char *pKey = m_corpus.Key(iKey, &cbKey);
+
+			if (bDfa ? dfa.Match(pKey, cbKey) :
+			    bCompiled ? compiled.Match(pKey, cbKey) :
+			                program.Match(pKey, cbKey))
+			{
+				step.rgMatches.push_back(iKey);
+			}
+		}
+
+		m_lastKind = WILD_SEARCH_NARROWED;
+		m_cLastChecked = rgCandidates.size();
+	}
+	else
+	{
+		size_t cBlocks = WildCorpusScan(m_corpus, pWild, step.rgMatches,
+		                                m_cThreads);
+
+		m_lastKind = WILD_SEARCH_SCANNED;
+		m_cLastChecked = std::min(cBlocks * m_corpus.BlockKeys(),
+		                          m_corpus.Count());
+	}
+
+	if (m_rgSteps.size() == WILD_SESSION_HISTORY)
+	{
+		m_rgSteps.erase(m_rgSteps.begin());
+	}
+
+	m_rgSteps.push_back(std::move(step));
+	return m_rgSteps.back().rgMatches;
+}
+
+
+// A set of session tests: containment against brute force on short
+// patterns and strings, the shapes search boxes produce, and sessions of
+// typing and backspacing against scanning for every keystroke.
+//
+extern "C" int testsession(void)
+{
+	bool bAllPassed = true;
+
+	static const struct
+	{
+		const char *pszOuter;
+		const char *pszInner;
+		bool        bContains;
+	}
+	s_rgCases[] =
+	{
+		{ "ab*", "abc*", true }, { "*x*", "*xy*", true },
+		{ "*x*", "*x*y", true }, { "*x*", "x*", true },
+		{ "*", "", true }, { "", "", true }, { "abc", "abc", true },
+		{ "*?", "?*", true }, { "?*", "*?", true }, { "a**b", "a*b", true },
+		{ "a?c", "abc", true }, { "*.log", "/srv/*.log", true },
+		{ "*a*", "*a*a*", true }, { "a*", "*", false },
+		{ "abc*", "ab*", false }, { "*xy*", "*x*", false },
+		{ "abc", "a?c", false }, { "a?c", "a*c", false },
+		{ "?", "", false }, { "", "*", false }, { "ab", "abc", false },
+		{ "*x*y", "*x*", false }
+	};
+
+	for (const auto &test : s_rgCases)
+	{
+		bAllPassed &= WildPatternContains(test.pszOuter, test.pszInner) ==
+		              test.bContains;
+	}
+
+	// Soundness: on random patterns over "ab?*", every containment
+	// claimed holds for every string of up to 7 a's and b's.
+	std::vector<std::string> rgTame(1, "");
+	WildBenchRandom          rng(1818);
+
+	for (size_t i = 0; rgTame[i].size() < 7; ++i)
+	{
+		rgTame.push_back(rgTame[i] + "a");
+		rgTame.push_back(rgTame[i] + "b");
+	}
+
+	int cClaimed = 0;
+
+	for (int iPair = 0; iPair < 20000; ++iPair)
+	{
+		std::string strOuter, strInner;
+
+		for (uint32_t i = rng.Below(6); i > 0; --i)
+		{
+			strOuter += "ab?*"[rng.Below(4)];
+		}
+
+		for (uint32_t i = rng.Below(6); i > 0; --i)
+		{
+			strInner += "ab?*"[rng.Below(4)];
+		}
+
+		if (!WildPatternContains(strOuter.c_str(), strInner.c_str()))
+		{
+			continue;
+		}
+
+		++cClaimed;
+
+		for (const std::string &strTame : rgTame)
+		{
+			bAllPassed &=
+			    !FastWildCompare(const_cast<char *>(strInner.c_str()),
+			                     const_cast<char *>(strTame.c_str())) ||
+			    FastWildCompare(const_cast<char *>(strOuter.c_str()),
+			                    const_cast<char *>(strTame.c_str()));
+		}
+	}
+
+	bAllPassed &= cClaimed > 1000;
+
+	// Sessions over a small corpus.
+	std::string       strPath =
+	    WildBenchTempPath("wildsession_test.wcorp");
+	WildCorpusBuilder builder;
+	WildCorpus        corpus;
+	std::string       strKey;
+
+	for (int i = 0; i < 20000; ++i)
+	{
+		WildBenchMakeKey(rng, strKey, i % 5 == 0);
+		builder.Add(strKey.data(), strKey.size());
+	}
+
+	std::string strLong(70001, 'x');
+
+	builder.Add(strLong.data(), strLong.size());
+	bAllPassed &= builder.Write(strPath.c_str(), WILD_CORPUS_SIGNATURES) &&
+	              corpus.Open(strPath.c_str());
+
+	static const char *s_rgszTyped[] =
+	{
+		"/", "/s", "/sr", "/srv", "/srv/", "/srv/c", "/srv/ca", "/srv/c",
+		"/srv/", "/srv/d", "/srv/da"
+	};
+	WildSearchSession session(corpus);
+	int               rgcKinds[3] = { 0, 0, 0 };
+
+	for (int iBox = 0; iBox < 3; ++iBox)
+	{
+		for (const char *pszTyped : s_rgszTyped)
+		{
+			// The box as a prefix, as a substring, and as a substring
+			// with the extension typed after it.
+			std::string           strWild(pszTyped);
+			std::vector<uint32_t> rgExpected;
+
+			strWild = iBox == 0 ? strWild + "*" : "*" + strWild + "*";
+
+			if (iBox == 2)
+			{
+				strWild += ".l";
+			}
+
+			WildCorpusScan(corpus, strWild.c_str(), rgExpected);
+			bAllPassed &= session.Search(strWild.c_str()) == rgExpected;
+			++rgcKinds[session.LastKind()];
+		}
+	}
+
+	bAllPassed &= rgcKinds[WILD_SEARCH_NARROWED] > 10 &&
+	              rgcKinds[WILD_SEARCH_REPEATED] > 0 &&
+	              rgcKinds[WILD_SEARCH_SCANNED] > 0;
+
+	// Narrowing to a segment too long for a WildProgram.
+	std::string strLongWild = "*" + strLong.substr(1) + "*";
+
+	session.Search("*x*");
+	bAllPassed &= session.Search(strLongWild.c_str()).size() == 1 &&
+	              session.LastKind() == WILD_SEARCH_NARROWED;
+
+	corpus.Close();
+	remove(strPath.c_str());
+
+	if (bAllPassed)
+	{
+		printf("Passed session tests\n");
+	}
+	else
+	{
+		printf("Failed session tests\n");
+	}
+
+	return 0;
+}
+
+
+// Measures latency per keystroke on a 10M-key corpus, scanning for every
+// keystroke against a session, while a path prefix is typed, a substring
+// is typed and edited, and an extension is added after it.
+//
+extern "C" int benchsession(void)
+{
+	const size_t      cKeys = 10000000;
+	std::string       strPath =
+	    WildBenchTempPath("wildsession_bench.wcorp");
+	WildBenchRandom   rng(1919);
+	WildCorpus        corpus;
+	std::string       strKey;
+
+	{
+		WildCorpusBuilder builder;
+
+		for (size_t i = 0; i < cKeys; ++i)
+		{
+			WildBenchMakeKey(rng, strKey, i % 2 == 0);
+			builder.Add(strKey.data(), strKey.size());
+		}
+
+		if (!builder.Write(strPath.c_str(), WILD_CORPUS_SIGNATURES) ||
+		    !corpus.Open(strPath.c_str()))
+		{
+			return 0;
+		}
+	}
+
+	static const char *s_rgszKeystrokes[] =
+	{
+		"/h*", "/ho*", "/hom*", "/home*", "/home/*", "/home/s*",
+		"/home/sp*", "/home/spo*",
+		"*c*", "*ca*", "*cac*", "*cach*", "*cache*", "*cache4*",
+		"*cache42*", "*cache421*", "*cache42*", "*cache428*",
+		"*cache428*.", "*cache428*.j", "*cache428*.js", "*cache428*.json"
+	};
+	static const char *s_rgszKind[] = { "scanned", "narrowed", "repeated" };
+	WildSearchSession   session(corpus);
+	uint64_t            uScanTotal = 0, uSessionTotal = 0;
+
+	printf("Session, %zu keys, per keystroke:\n", cKeys);
+
+	for (const char *pszWild : s_rgszKeystrokes)
+	{
+		std::vector<uint32_t> rgScanned;
+		uint64_t              uStart = WildBenchNanos();
+
+		WildCorpusScan(corpus, pszWild, rgScanned);
+
+		uint64_t uScanNanos = WildBenchNanos() - uStart;
+
+		uStart = WildBenchNanos();
+
+		const std::vector<uint32_t> &rgMatches = session.Search(pszWild);
+
+		uint64_t uSessionNanos = WildBenchNanos() - uStart;
+
+		uScanTotal += uScanNanos;
+		uSessionTotal += uSessionNanos;
+		printf("  %-18s scan %7.1f ms, session %7.2f ms, %-8s %9zu keys "
+		       "checked, %8zu matches%s\n", pszWild, uScanNanos / 1e6,
+		       uSessionNanos / 1e6, s_rgszKind[session.LastKind()],
+		       session.LastChecked(), rgMatches.size(),
+		       rgMatches == rgScanned ? "" : " (RESULTS DIFFER)");
+	}
+
+	printf("  Total: scan %.0f ms, session %.0f ms\n", uScanTotal / 1e6,
+	       uSessionTotal / 1e6);
+
+	corpus.Close();
+	remove(strPath.c_str());
+	return 0;
+}
@@ -0,0 +1,103 @@
+// WildSearchSession, search-as-you-type over a corpus, narrowing the last
+// results when a new pattern can only match a subset of them
+//
+// Copyright 2025 Kirk J Krauss.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Each keystroke in a search box yields a new pattern, and most often the
+// new one is narrower than the one before: "ab*" becomes "abc*", "*x*"
+// becomes "*xy*", or "*x*" becomes "*x*y".  Every key the new pattern
+// matches was then among the last results, so only those need checking.
+//
+// WildPatternContains() decides that soundly: it says yes only if every
+// string the inner pattern matches, the outer one does too.  It matches
+// the outer pattern against the inner one's symbols, where an outer '*'
+// covers any run of inner symbols, an outer '?' covers one '?' or
+// literal, and a literal covers only itself.  A run of wildcards means
+// the same whatever its order, so each is first rewritten as its '?'s
+// followed by at most one '*'.  The check may miss a containment that
+// holds, which costs only a scan, but it never claims one that doesn't.
+//
+// A session keeps its last few results, so a backspace back to an earlier
+// pattern costs nothing, and a pattern narrower than several earlier ones
+// narrows the smallest of their results.
+//
+#ifndef WILDSESSION_H
+#define WILDSESSION_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "wildcorpus.h"
+
+#define WILD_SESSION_HISTORY  8   // Results kept for narrowing
+
+// Returns true only if every string pInner matches, pOuter matches too.
+bool WildPatternContains(const char *pOuter, const char *pInner);
+
+enum WildSearchKind
+{
+	WILD_SEARCH_SCANNED,    // The corpus was scanned
+	WILD_SEARCH_NARROWED,   // Earlier results were checked
+	WILD_SEARCH_REPEATED    // An earlier result was reused as it was
+};
+
+class WildSearchSession
+{
+public:
+	// The corpus must outlive the session.  Scans use cThreads threads.
+	explicit WildSearchSession(const WildCorpus &corpus, int cThreads = 1);
+
+	// Returns the keys matching a pattern of '*' and '?' wildcards, in
+	// ascending order.  The result stays valid until the next call.
+	const std::vector<uint32_t> &Search(const char *pWild);
+
+	// How the last Search() was answered, and how many keys it checked:
+	// the earlier results it narrowed, or, for a scan, the keys of the
+	// blocks scanned.
+	WildSearchKind LastKind() const
+	{
+		return m_lastKind;
+	}
+
+	size_t LastChecked() const
+	{
+		return m_cLastChecked;
+	}
+
+	void Clear()
+	{
+		m_rgSteps.clear();
+	}
+
+private:
+	struct WildSearchStep
+	{
+		std::string           strWild;
+		std::vector<uint32_t> rgMatches;
+	};
+
+	const WildCorpus           &m_corpus;
+	std::vector<WildSearchStep> m_rgSteps;   // Oldest first
+	WildSearchKind              m_lastKind;
+	size_t                      m_cLastChecked;
+	int                         m_cThreads;
+};
+
+extern "C" int testsession(void);
+extern "C" int benchsession(void);
+
+#endif  // WILDSESSION_H
@@ -0,0 +1,1069 @@
+// WildShardMap and WildShardCoordinator, and related code
+//
+// Copyright 2025 Kirk J Krauss.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// This file provides the shard planner and the scatter-gather coordinator
+// with its worker processes.  It also includes testcases for correctness
+// and performance.
+//
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#define WILD_HAVE_FORK
+#endif
+
+#include "fastwildcompare.h"
+#include "wildbytecode.h"
+#include "wildcompiled.h"
+#include "wilddfa.h"
+#include "wildshard.h"
+#include "wildbench.h"
+
+#define WILD_SHARD_FRAME   65536   // Bytes of keys a worker sends at once
+#define WILD_SHARD_BATCH   4096    // Keys a worker matches at once
+
+WildShardMap::WildShardMap(const std::vector<std::string> &rgstrLower) :
+    m_rgstrLower(rgstrLower)
+{
+	if (m_rgstrLower.empty())
+	{
+		m_rgstrLower.push_back(std::string());
+	}
+}
+
+
+size_t WildShardMap::ShardOf(const char *pKey, size_t cbKey) const
+{
+	std::string strKey(pKey, cbKey);
+
+	return std::upper_bound(m_rgstrLower.begin(), m_rgstrLower.end(),
+	                        strKey) - m_rgstrLower.begin() - 1;
+}
+
+
+// Appends the least bytes that fit a head from position i on: each
+// literal as it is, and a 0 byte for each '?'.
+//
+static void AppendLeastFill(const std::string &strHead, size_t i,
+                            std::string &strLeast)
+{
+	for (; i < strHead.size(); ++i)
+	{
+		strLeast += strHead[i] == '?' ? '\0' : strHead[i];
+	}
+}
+
+
+// Finds the least string at or above strLower that fits a head: as long as
+// the head, or, with bStar, at least that long, and agreeing with each of
+// its literals.  Returns false if there's none.
+//
+static bool LeastFit(const std::string &strLower, const std::string &strHead,
+                     bool bStar, std::string &strLeast)
+{
+	size_t cbHead = strHead.size();
+	size_t cbLower = strLower.size();
+	size_t i = 0;
+
+	for (; i < cbHead && i < cbLower; ++i)
+	{
+		uint8_t chHead = (uint8_t) strHead[i];
+		uint8_t chLower = (uint8_t) strLower[i];
+
+		if (chHead == '?' || chHead == chLower)
+		{
+			continue;
+		}
+
+		if (chLower < chHead)
+		{
+			// Taking the literal here puts everything after it above the
+			// bound, so the rest can be as low as it goes.
+			strLeast.assign(strLower, 0, i);
+			strLeast += (char) chHead;
+			AppendLeastFill(strHead, i + 1, strLeast);
+			return true;
+		}
+
+		break;
+	}
+
+	if (i == cbLower && i <= cbHead)
+	{
+		// The bound is a prefix of every string that fits from here.
+		strLeast = strLower;
+		AppendLeastFill(strHead, i, strLeast);
+		return true;
+	}
+
+	if (i == cbHead && bStar)
+	{
+		// The bound fits the head, and any bytes may follow it.
+		strLeast = strLower;
+		return true;
+	}
+
+	// The bound is past every string that agrees with it up to here, so
+	// raise the last '?' that can go higher and drop what follows.
+	while (i > 0)
+	{
+		--i;
+
+		if (strHead[i] == '?' && (uint8_t) strLower[i] != 0xFF)
+		{
+			strLeast.assign(strLower, 0, i);
+			strLeast += (char) ((uint8_t) strLower[i] + 1);
+			AppendLeastFill(strHead, i + 1, strLeast);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+void WildShardMap::Plan(const char *pWild,
+                        std::vector<uint32_t> &rgShards) const
+{
+	std::string strHead;
+	std::string strLeast;
+	bool        bStar = false;
+
+	for (; *pWild; ++pWild)
+	{
+		if (*pWild == '*')
+		{
+			bStar = true;
+			break;
+		}
+
+		strHead += *pWild;
+	}
+
+	rgShards.clear();
+
+	for (size_t iShard = 0; iShard < m_rgstrLower.size(); ++iShard)
+	{
+		if (LeastFit(m_rgstrLower[iShard], strHead, bStar, strLeast) &&
+		    (iShard + 1 == m_rgstrLower.size() ||
+		     strLeast < m_rgstrLower[iShard + 1]))
+		{
+			rgShards.push_back((uint32_t) iShard);
+		}
+	}
+}
+
+
+WildShardCoordinator::WildShardCoordinator() : m_pMap(NULL)
+{
+}
+
+
+WildShardCoordinator::~WildShardCoordinator()
+{
+	Stop();
+}
+
+
+#ifdef WILD_HAVE_FORK
+
+// Reads or writes all of cb bytes, through interruptions.  Returns false
+// at the end of the stream or on an error.
+//
+static bool ReadAll(int fd, void *pv, size_t cb)
+{
+	char *p = (char *) pv;
+
+	while (cb > 0)
+	{
+		ssize_t cbRead = read(fd, p, cb);
+
+		if (cbRead <= 0)
+		{
+			if (cbRead < 0 && errno == EINTR)
+			{
+				continue;
+			}
+
+			return false;
+		}
+
+		p += cbRead;
+		cb -= (size_t) cbRead;
+	}
+
+	return true;
+}
+
+
+static bool WriteAll(int fd, const void *pv, size_t cb)
+{
+	const char *p = (const char *) pv;
+
+	while (cb > 0)
+	{
+		ssize_t cbWritten = write(fd, p, cb);
+
+		if (cbWritten < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+
+			return false;
+		}
+
+		p += cbWritten;
+		cb -= (size_t) cbWritten;
+	}
+
+	return true;
+}
+
+
+// Writes to a pipe whose reader may have exited, without the SIGPIPE that
+// would end the process.  The signal is blocked for this thread during
+// the write, and one the write raised is taken before it's unblocked.
+//
+static bool WriteAllNoSignal(int fd, const void *pv, size_t cb)
+{
+	sigset_t setPipe, setOld, setPending;
+	int      iSignal;
+
+	sigemptyset(&setPipe);
+	sigaddset(&setPipe, SIGPIPE);
+	sigpending(&setPending);
+
+	bool bPending = sigismember(&setPending, SIGPIPE) == 1;
+
+	pthread_sigmask(SIG_BLOCK, &setPipe, &setOld);
+
+	bool bWritten = WriteAll(fd, pv, cb);
+
+	if (!bWritten && errno == EPIPE && !bPending &&
+	    sigpending(&setPending) == 0 && sigismember(&setPending, SIGPIPE))
+	{
+		sigwait(&setPipe, &iSignal);
+	}
+
+	pthread_sigmask(SIG_SETMASK, &setOld, NULL);
+	return bWritten;
+}
+
+#endif  // WILD_HAVE_FORK
+
+
+bool WildShardCoordinator::Start(const WildShardMap &map,
+                                 const std::vector<std::string> &rgKeys)
+{
+	Stop();
+	m_pMap = &map;
+	m_rgShards.assign(map.Count(), WildShardKeys());
+
+	std::vector<std::vector<const std::string *>> rgrgpKeys(map.Count());
+
+	for (const std::string &strKey : rgKeys)
+	{
+		rgrgpKeys[map.ShardOf(strKey.data(), strKey.size())].push_back(
+		    &strKey);
+	}
+
+	for (size_t iShard = 0; iShard < map.Count(); ++iShard)
+	{
+		std::vector<const std::string *> &rgpKeys = rgrgpKeys[iShard];
+		WildShardKeys                    &keys = m_rgShards[iShard];
+
+		std::sort(rgpKeys.begin(), rgpKeys.end(),
+		          [](const std::string *pA, const std::string *pB)
+		{
+			return *pA < *pB;
+		});
+
+		for (const std::string *pKey : rgpKeys)
+		{
+			keys.rgOffsets.push_back((uint32_t) keys.strBytes.size());
+			keys.strBytes += *pKey;
+		}
+
+		keys.rgOffsets.push_back((uint32_t) keys.strBytes.size());
+	}
+
+#ifdef WILD_HAVE_FORK
+	for (size_t iShard = 0; iShard < map.Count(); ++iShard)
+	{
+		int rgfdRequest[2];
+		int rgfdResponse[2];
+
+		if (pipe(rgfdRequest) != 0)
+		{
+			Stop();
+			return false;
+		}
+
+		if (pipe(rgfdResponse) != 0)
+		{
+			close(rgfdRequest[0]);
+			close(rgfdRequest[1]);
+			Stop();
+			return false;
+		}
+
+		pid_t iPid = fork();
+
+		if (iPid == 0)
+		{
+			// The worker keeps only its own ends, so that each worker sees
+			// the end of its requests once the coordinator closes them.
+			for (const WildShardWorker &worker : m_rgWorkers)
+			{
+				close(worker.fdRequest);
+				close(worker.fdResponse);
+			}
+
+			close(rgfdRequest[1]);
+			close(rgfdResponse[0]);
+			WorkerLoop(m_rgShards[iShard], rgfdRequest[0], rgfdResponse[1]);
+			_exit(0);
+		}
+
+		close(rgfdRequest[0]);
+		close(rgfdResponse[1]);
+
+		if (iPid < 0)
+		{
+			close(rgfdRequest[1]);
+			close(rgfdResponse[0]);
+			Stop();
+			return false;
+		}
+
+		WildShardWorker worker = {(int) iPid, rgfdRequest[1],
+		                          rgfdResponse[0]};
+
+		m_rgWorkers.push_back(worker);
+	}
+
+	// The workers have their own copies of the keys.
+	for (WildShardKeys &keys : m_rgShards)
+	{
+		WildShardKeys().strBytes.swap(keys.strBytes);
+		std::vector<uint32_t>().swap(keys.rgOffsets);
+	}
+#endif
+
+	return true;
+}
+
+
+void WildShardCoordinator::Stop()
+{
+#ifdef WILD_HAVE_FORK
+	for (const WildShardWorker &worker : m_rgWorkers)
+	{
+		close(worker.fdRequest);
+	}
+
+	for (const WildShardWorker &worker : m_rgWorkers)
+	{
+		close(worker.fdResponse);
+
+		while (waitpid(worker.iPid, NULL, 0) < 0 && errno == EINTR)
+		{
+		}
+	}
+#endif
+
+	m_rgWorkers.clear();
+	m_rgShards.clear();
+	m_pMap = NULL;
+}
+
+
+// Returns the least string above every string that starts with a prefix,
+// or an empty one if there's none.
+//
+static std::string PrefixSuccessor(std::string strPrefix)
+{
+	while (!strPrefix.empty() && (uint8_t) strPrefix.back() == 0xFF)
+	{
+		strPrefix.pop_back();
+	}
+
+	if (!strPrefix.empty())
+	{
+		strPrefix.back() = (char) ((uint8_t) strPrefix.back() + 1);
+	}
+
+	return strPrefix;
+}
+
+
+void WildShardCoordinator::Serve(const WildShardKeys &keys,
+                                 const char *pWild,
+                                 const std::function<void(const char *,
+                                                          size_t)> &flush)
+{
+	size_t cKeys = keys.rgOffsets.empty() ? 0 : keys.rgOffsets.size() - 1;
+
+	if (cKeys == 0)
+	{
+		return;
+	}
+
+	WildDfa             dfa;
+	WildProgram         program;
+	WildCompiledPattern compiled;
+	bool                bDfa = dfa.Compile(pWild);
+
+	// A segment too long for the program's operands still compiles into a
+	// WildCompiledPattern, which gets FastWildCompare()'s results.
+	bool bCompiled = !bDfa && !program.Compile(pWild);
+
+	if (bCompiled)
+	{
+		compiled.Compile(pWild);
+	}
+
+	// Only keys that start with the pattern's literal prefix can match, and
+	// they're together in the shard's order.
+	std::string strPrefix(pWild, strcspn(pWild, "*?"));
+	std::string strAbove = PrefixSuccessor(strPrefix);
+	auto        compare = [&](uint32_t iKey, const std::string &str)
+	{
+		return keys.strBytes.compare(keys.rgOffsets[iKey],
+		                             keys.rgOffsets[iKey + 1] -
+		                             keys.rgOffsets[iKey], str) < 0;
+	};
+	std::vector<uint32_t> rgKeys(cKeys);
+
+	for (size_t iKey = 0; iKey < cKeys; ++iKey)
+	{
+		rgKeys[iKey] = (uint32_t) iKey;
+	}
+
+	size_t iFirst = std::lower_bound(rgKeys.begin(), rgKeys.end(), strPrefix,
+	                                 compare) - rgKeys.begin();
+	size_t iEnd = strAbove.empty() ? cKeys :
+	              std::lower_bound(rgKeys.begin(), rgKeys.end(), strAbove,
+	                               compare) - rgKeys.begin();
+	std::vector<uint8_t> rgbResult(WILD_SHARD_BATCH);
+	std::string          strFrame;
+
+	for (size_t iChunk = iFirst; iChunk < iEnd; iChunk += WILD_SHARD_BATCH)
+	{
+		size_t cChunk = std::min((size_t) WILD_SHARD_BATCH, iEnd - iChunk);
+
+		if (bDfa)
+		{
+			dfa.MatchBatch(keys.strBytes.data(), &keys.rgOffsets[iChunk],
+			               cChunk, rgbResult.data());
+		}
+		else
+		{
+			for (size_t i = 0; i < cChunk; ++i)
+			{
+				uint32_t    uOffset = keys.rgOffsets[iChunk + i];
+				const char *pKey = keys.strBytes.data() + uOffset;
+				size_t      cbKey = keys.rgOffsets[iChunk + i + 1] - uOffset;
+
+				rgbResult[i] = bCompiled ? compiled.Match(pKey, cbKey) :
+				                           program.Match(pKey, cbKey);
+			}
+		}
+
+		for (size_t i = 0; i < cChunk; ++i)
+		{
+			if (!rgbResult[i])
+			{
+				continue;
+			}
+
+			uint32_t uOffset = keys.rgOffsets[iChunk + i];
+			uint32_t cbKey = keys.rgOffsets[iChunk + i + 1] - uOffset;
+
+			strFrame.append((const char *) &cbKey, sizeof(cbKey));
+			strFrame.append(keys.strBytes, uOffset, cbKey);
+
+			if (strFrame.size() >= WILD_SHARD_FRAME)
+			{
+				flush(strFrame.data(), strFrame.size());
+				strFrame.clear();
+			}
+		}
+	}
+
+	if (!strFrame.empty())
+	{
+		flush(strFrame.data(), strFrame.size());
+	}
+}
+
+
+// Passes each key of a frame on.
+//
+static void EmitFrame(const char *pFrame, size_t cbFrame,
+                      const WildShardEmit &emit)
+{
+	const char *pEnd = pFrame + cbFrame;
+
+	while (pFrame < pEnd)
+	{
+		uint32_t cbKey;
+
+		memcpy(&cbKey, pFrame, sizeof(cbKey));
+		emit(pFrame + sizeof(cbKey), cbKey);
+		pFrame += sizeof(cbKey) + cbKey;
+	}
+}
+
+
+#ifdef WILD_HAVE_FORK
+
+// Walks the complete frames of a response from byte iFrom on, passing
+// their keys on if there's an emit(), up to and including the empty frame
+// that ends it, if that's there, which sets *pbEnded.  Returns the offset
+// past the last complete frame.
+//
+static size_t WalkFrames(const std::string &strRead, size_t iFrom,
+                         bool *pbEnded, const WildShardEmit *pEmit)
+{
+	uint32_t cbFrame;
+
+	*pbEnded = false;
+
+	while (strRead.size() - iFrom >= sizeof(cbFrame))
+	{
+		memcpy(&cbFrame, strRead.data() + iFrom, sizeof(cbFrame));
+
+		if (strRead.size() - iFrom - sizeof(cbFrame) < cbFrame)
+		{
+			break;
+		}
+
+		if (pEmit)
+		{
+			EmitFrame(strRead.data() + iFrom + sizeof(cbFrame), cbFrame,
+			          *pEmit);
+		}
+
+		iFrom += sizeof(cbFrame) + cbFrame;
+
+		if (cbFrame == 0)
+		{
+			*pbEnded = true;
+			break;
+		}
+	}
+
+	return iFrom;
+}
+
+#endif  // WILD_HAVE_FORK
+
+
+// A worker answers each request, a pattern's length and bytes, with frames
+// of matching keys, each preceded by its length, and then an empty frame.
+// It exits once the coordinator closes its requests.
+//
+void WildShardCoordinator::WorkerLoop(const WildShardKeys &keys,
+                                      int fdRequest, int fdResponse)
+{
+#ifdef WILD_HAVE_FORK
+	uint32_t cbWild;
+
+	while (ReadAll(fdRequest, &cbWild, sizeof(cbWild)))
+	{
+		std::string strWild(cbWild, '\0');
+		bool        bWritten = true;
+
+		if (!ReadAll(fdRequest, &strWild[0], cbWild))
+		{
+			break;
+		}
+
+		Serve(keys, strWild.c_str(), [&](const char *pFrame, size_t cbFrame)
+		{
+			uint32_t cb = (uint32_t) cbFrame;
+
+			bWritten = bWritten && WriteAll(fdResponse, &cb, sizeof(cb)) &&
+			           WriteAll(fdResponse, pFrame, cbFrame);
+		});
+
+		uint32_t cbEnd = 0;
+
+		if (!bWritten || !WriteAll(fdResponse, &cbEnd, sizeof(cbEnd)))
+		{
+			break;
+		}
+	}
+
+	close(fdRequest);
+	close(fdResponse);
+#else
+	(void) keys;
+	(void) fdRequest;
+	(void) fdResponse;
+#endif
+}
+
+
+bool WildShardCoordinator::Query(const char *pWild, const WildShardEmit &emit,
+                                 size_t *pcShards, bool bBroadcast)
+{
+	std::vector<uint32_t> rgPlan;
+
+	if (pcShards)
+	{
+		*pcShards = 0;
+	}
+
+	if (!m_pMap)
+	{
+		return false;
+	}
+
+	if (bBroadcast)
+	{
+		for (size_t iShard = 0; iShard < m_pMap->Count(); ++iShard)
+		{
+			rgPlan.push_back((uint32_t) iShard);
+		}
+	}
+	else
+	{
+		m_pMap->Plan(pWild, rgPlan);
+	}
+
+	if (pcShards)
+	{
+		*pcShards = rgPlan.size();
+	}
+
+	if (!Forked())
+	{
+		for (uint32_t iShard : rgPlan)
+		{
+			Serve(m_rgShards[iShard], pWild,
+			      [&](const char *pFrame, size_t cbFrame)
+			{
+				EmitFrame(pFrame, cbFrame, emit);
+			});
+		}
+
+		return true;
+	}
+
+#ifdef WILD_HAVE_FORK
+	uint32_t cbWild = (uint32_t) strlen(pWild);
+
+	// After a failure, the workers still answering would leave frames
+	// behind for the next query, so they're all stopped.
+	for (uint32_t iShard : rgPlan)
+	{
+		int fd = m_rgWorkers[iShard].fdRequest;
+
+		if (!WriteAllNoSignal(fd, &cbWild, sizeof(cbWild)) ||
+		    !WriteAllNoSignal(fd, pWild, cbWild))
+		{
+			Stop();
+			return false;
+		}
+	}
+
+	// Each contacted shard's response as read so far, walked up to
+	// rgiWalked.  The lowest shard not yet done passes its keys on as they
+	// come, and drops them; those above it keep theirs until it's done.
+	std::vector<std::string> rgstrRead(rgPlan.size());
+	std::vector<size_t>      rgiWalked(rgPlan.size(), 0);
+	std::vector<bool>        rgbEnded(rgPlan.size(), false);
+	std::vector<pollfd>      rgPoll;
+	std::vector<size_t>      rgiPolled;
+	std::vector<char>        rgchRead(WILD_SHARD_FRAME);
+	size_t                   iEmit = 0;
+
+	while (iEmit < rgPlan.size())
+	{
+		if (rgbEnded[iEmit])
+		{
+			std::string().swap(rgstrRead[iEmit]);
+
+			if (++iEmit < rgPlan.size())
+			{
+				bool bEnded;
+
+				WalkFrames(rgstrRead[iEmit], 0, &bEnded, &emit);
+				rgstrRead[iEmit].erase(0, rgiWalked[iEmit]);
+				rgiWalked[iEmit] = 0;
+			}
+
+			continue;
+		}
+
+		rgPoll.clear();
+		rgiPolled.clear();
+
+		for (size_t i = iEmit; i < rgPlan.size(); ++i)
+		{
+			if (!rgbEnded[i])
+			{
+				pollfd pfd = {m_rgWorkers[rgPlan[i]].fdResponse, POLLIN, 0};
+
+				rgPoll.push_back(pfd);
+				rgiPolled.push_back(i);
+			}
+		}
+
+		if (poll(rgPoll.data(), rgPoll.size(), -1) < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+
+			Stop();
+			return false;
+		}
+
+		for (size_t iPoll = 0; iPoll < rgPoll.size(); ++iPoll)
+		{
+			if (!rgPoll[iPoll].revents)
+			{
+				continue;
+			}
+
+			size_t  i = rgiPolled[iPoll];
+			ssize_t cbRead = read(rgPoll[iPoll].fd, rgchRead.data(),
+			                      rgchRead.size());
+
+			if (cbRead < 0 && errno == EINTR)
+			{
+				continue;
+			}
+
+			if (cbRead <= 0)
+			{
+				// The worker is gone, and its shard's keys with it.
+				Stop();
+				return false;
+			}
+
+			std::string &strRead = rgstrRead[i];
+			bool         bEnded = false;
+
+			strRead.append(rgchRead.data(), (size_t) cbRead);
+			rgiWalked[i] = WalkFrames(strRead, rgiWalked[i], &bEnded,
+			                          i == iEmit ? &emit : NULL);
+			rgbEnded[i] = bEnded;
+
+			if (i == iEmit)
+			{
+				strRead.erase(0, rgiWalked[i]);
+				rgiWalked[i] = 0;
+			}
+		}
+	}
+
+	return true;
+#else
+	return false;
+#endif
+}
+
+
+// Checks that a plan includes the shard of every key a pattern matches.
+//
+static bool PlanCovers(const WildShardMap &map, const char *pWild,
+                       const std::vector<std::string> &rgKeys)
+{
+	std::vector<uint32_t> rgShards;
+
+	map.Plan(pWild, rgShards);
+
+	for (const std::string &strKey : rgKeys)
+	{
+		if (FastWildCompare(const_cast<char *>(pWild),
+		                    const_cast<char *>(strKey.c_str())) &&
+		    !std::binary_search(rgShards.begin(), rgShards.end(),
+		                        (uint32_t) map.ShardOf(strKey.data(),
+		                                               strKey.size())))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+// A set of shard tests: plans against every short string over a small
+// alphabet, with bounds that need a '?' raised or a 0xFF passed over;
+// plans for generated keys; plans that prune what they should; and the
+// coordinator's merged results against FastWildCompare() over all keys.
+//
+extern "C" int testshard(void)
+{
+	static const char s_rgchAlphabet[] = {'a', 'b', '\xFF'};
+	static const char s_rgchWild[] = {'a', 'b', '\xFF', '?', '*'};
+	WildBenchRandom          rng(1818);
+	std::vector<std::string> rgShort(1, std::string());
+	std::string              strKey;
+	bool                     bAllPassed = true;
+
+	for (size_t i = 0; i < rgShort.size() && rgShort[i].size() < 5; ++i)
+	{
+		for (char ch : s_rgchAlphabet)
+		{
+			rgShort.push_back(rgShort[i] + ch);
+		}
+	}
+
+	for (int iMap = 0; iMap < 40; ++iMap)
+	{
+		std::vector<std::string> rgstrLower(1, std::string());
+
+		for (uint32_t i = 1 + rng.Below(8); i > 0; --i)
+		{
+			rgstrLower.push_back(rgShort[1 + rng.Below(
+			    (uint32_t) rgShort.size() - 1)]);
+		}
+
+		std::sort(rgstrLower.begin(), rgstrLower.end());
+		rgstrLower.erase(std::unique(rgstrLower.begin(), rgstrLower.end()),
+		                 rgstrLower.end());
+
+		WildShardMap map(rgstrLower);
+
+		for (int iWild = 0; iWild < 200; ++iWild)
+		{
+			std::string strWild;
+
+			for (uint32_t i = rng.Below(6); i > 0; --i)
+			{
+				strWild += s_rgchWild[rng.Below(5)];
+			}
+
+			bAllPassed &= PlanCovers(map, strWild.c_str(), rgShort);
+		}
+	}
+
+	std::vector<std::string> rgKeys(3000);
+	std::vector<std::string> rgSorted;
+	std::vector<std::string> rgstrLower(1, std::string());
+
+	for (std::string &str : rgKeys)
+	{
+		WildBenchMakeKey(rng, str, rng.Below(4) == 0);
+	}
+
+	rgKeys[0].assign(70001, 'x');
+	rgSorted = rgKeys;
+	std::sort(rgSorted.begin(), rgSorted.end());
+
+	for (size_t iShard = 1; iShard < 7; ++iShard)
+	{
+		// Some bounds fall between keys, partway into one.
+		std::string strLower = rgSorted[rgSorted.size() * iShard / 7];
+
+		rgstrLower.push_back(strLower.substr(0, 3 + rng.Below(
+		    (uint32_t) strLower.size() - 2)));
+	}
+
+	std::sort(rgstrLower.begin(), rgstrLower.end());
+	rgstrLower.erase(std::unique(rgstrLower.begin(), rgstrLower.end()),
+	                 rgstrLower.end());
+
+	WildShardMap map(rgstrLower);
+
+	for (int iWild = 0; iWild < 300; ++iWild)
+	{
+		std::string strWild;
+
+		WildBenchMakePattern(rng, strWild);
+		bAllPassed &= PlanCovers(map, strWild.c_str(), rgKeys);
+	}
+
+	// Plans that prune.
+	static const char *s_rgszLower[] =
+	{
+		"", "/home", "/srv", "/var/cache1x", "/var/cache2"
+	};
+	WildShardMap          mapFixed(std::vector<std::string>(s_rgszLower,
+	                                s_rgszLower + 5));
+	std::vector<uint32_t> rgShards;
+
+	mapFixed.Plan("/srv/*", rgShards);
+	bAllPassed &= rgShards == std::vector<uint32_t>{2};
+	mapFixed.Plan("/var/cache?/*", rgShards);
+	bAllPassed &= rgShards == std::vector<uint32_t>({2, 4});
+	mapFixed.Plan("/var/cache1?", rgShards);
+	bAllPassed &= rgShards == std::vector<uint32_t>({2, 3});
+	mapFixed.Plan("/home/x", rgShards);
+	bAllPassed &= rgShards == std::vector<uint32_t>{1};
+	mapFixed.Plan("", rgShards);
+	bAllPassed &= rgShards == std::vector<uint32_t>{0};
+	mapFixed.Plan("*.log", rgShards);
+	bAllPassed &= rgShards.size() == 5;
+	bAllPassed &= mapFixed.ShardOf("/var/cache1x", 12) == 3 &&
+	              mapFixed.ShardOf("/var/cache1", 11) == 2 &&
+	              mapFixed.ShardOf("", 0) == 0;
+
+	// The coordinator's results, planned and broadcast.  The last
+	// pattern's segment is too long for a WildProgram.
+	std::string strLong = "*" + std::string(70000, 'x') + "*";
+	const char *rgszWild[] =
+	{
+		"/srv/*", "*.log", "/home/user*/*", "/var/cache1?/*", "*",
+		"/data/?ogs*", "/t*", "", "/opt/etc9*/*.csv", "*spool1*.db",
+		strLong.c_str()
+	};
+	WildShardCoordinator coordinator;
+
+	bAllPassed &= coordinator.Start(map, rgKeys);
+#ifdef WILD_HAVE_FORK
+	bAllPassed &= coordinator.Forked();
+#endif
+
+	for (const char *pszWild : rgszWild)
+	{
+		std::vector<std::string> rgExpected;
+
+		for (const std::string &str : rgSorted)
+		{
+			if (FastWildCompare(const_cast<char *>(pszWild),
+			                    const_cast<char *>(str.c_str())))
+			{
+				rgExpected.push_back(str);
+			}
+		}
+
+		for (int iBroadcast = 0; iBroadcast < 2; ++iBroadcast)
+		{
+			std::vector<std::string> rgMatches;
+			size_t                   cShards;
+
+			bAllPassed &= coordinator.Query(pszWild,
+			              [&](const char *pKey, size_t cbKey)
+			{
+				rgMatches.push_back(std::string(pKey, cbKey));
+			}, &cShards, iBroadcast != 0);
+			bAllPassed &= rgMatches == rgExpected &&
+			              cShards <= map.Count() &&
+			              (iBroadcast == 0 || cShards == map.Count());
+		}
+	}
+
+	coordinator.Stop();
+	bAllPassed &= !coordinator.Query("*", [](const char *, size_t) {});
+
+	if (bAllPassed)
+	{
+		printf("Passed shard tests\n");
+	}
+	else
+	{
+		printf("Failed shard tests\n");
+	}
+
+	return 0;
+}
+
+
+// Measures queries over 1M keys in 16 range shards, each shard a worker
+// process: shards contacted and latency with pruning, against sending
+// every query to every shard.
+//
+extern "C" int benchshard(void)
+{
+	static const char *s_rgszWild[] =
+	{
+		"/srv/*", "/home/user1*/*", "/var/cache1?/*", "/data/logs4?2/*",
+		"/tmp/run7?/run*.json", "/opt/*.parquet", "*.log", "*spool42*"
+	};
+	const size_t             cKeys = 1000000;
+	const size_t             cShards = 16;
+	const int                cRepeats = 5;
+	WildBenchRandom          rng(1919);
+	std::vector<std::string> rgKeys(cKeys);
+	std::vector<std::string> rgstrLower(1, std::string());
+
+	for (std::string &strKey : rgKeys)
+	{
+		WildBenchMakeKey(rng, strKey, rng.Below(4) == 0);
+	}
+
+	{
+		std::vector<std::string> rgSorted(rgKeys);
+
+		std::sort(rgSorted.begin(), rgSorted.end());
+
+		for (size_t iShard = 1; iShard < cShards; ++iShard)
+		{
+			rgstrLower.push_back(rgSorted[cKeys * iShard / cShards]);
+		}
+	}
+
+	WildShardMap         map(rgstrLower);
+	WildShardCoordinator coordinator;
+	uint64_t             uStart = WildBenchNanos();
+
+	if (!coordinator.Start(map, rgKeys))
+	{
+		printf("Shards: couldn't start the workers\n");
+		return 0;
+	}
+
+	printf("Shards, %zu keys in %zu %s, started in %.1f ms\n", cKeys,
+	       cShards, coordinator.Forked() ? "worker processes" : "in-process "
+	       "shards", (WildBenchNanos() - uStart) / 1e6);
+
+	for (const char *pszWild : s_rgszWild)
+	{
+		uint64_t rguNanos[2] = {0, 0};
+		size_t   rgcShards[2] = {0, 0};
+		size_t   cMatches = 0;
+
+		for (int iRepeat = 0; iRepeat < cRepeats; ++iRepeat)
+		{
+			for (int iBroadcast = 0; iBroadcast < 2; ++iBroadcast)
+			{
+				cMatches = 0;
+				uStart = WildBenchNanos();
+				coordinator.Query(pszWild, [&](const char *, size_t)
+				{
+					++cMatches;
+				}, &rgcShards[iBroadcast], iBroadcast != 0);
+				rguNanos[iBroadcast] += WildBenchNanos() - uStart;
+			}
+		}
+
+		printf("  %-22s %7zu matches: %2zu of %zu shards %8.2f ms, "
+		       "broadcast %8.2f ms\n", pszWild, cMatches, rgcShards[0],
+		       rgcShards[1], rguNanos[0] / 1e6 / cRepeats,
+		       rguNanos[1] / 1e6 / cRepeats);
+	}
+
+	return 0;
+}
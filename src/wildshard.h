@@ -0,0 +1,143 @@
+// WildShardMap and WildShardCoordinator, shard pruning and scatter-gather
+// for glob queries over range-partitioned keys
+//
+// Copyright 2025 Kirk J Krauss.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// When keys are split across nodes by range, shard i holds the keys from
+// its lower bound up to the next shard's, in byte order.  A pattern's head
+// (its bytes ahead of the first '*', literals and '?'s alike) says where
+// in that order a matching key can fall.  WildShardMap::Plan() contacts a
+// shard only if some string between its bounds fits the head: it finds
+// the least string at or above the lower bound whose bytes agree with the
+// head's literals, and checks that it's below the upper bound.  So
+// "/srv/*" goes to the shards that span "/srv/", and "/var/cache?/*" can
+// skip a shard holding only "/var/cache1x" up to "/var/cache2".  Patterns
+// that start with '*' go everywhere.
+//
+// WildShardCoordinator stands in for a cluster with a local process per
+// shard, started with fork(), each holding its shard's keys in order.  A
+// query goes to the planned shards over pipes.  Each worker narrows its
+// keys to the head's literal prefix by binary search, matches those with
+// WildDfa::MatchBatch(), and streams the matches back in frames as it
+// finds them.  The coordinator reads every contacted worker at once and
+// passes keys on in key order: the lowest shard's keys as they arrive,
+// and the others' once the shards below them are done.  Where fork()
+// isn't available, the shards are served in process.
+//
+#ifndef WILDSHARD_H
+#define WILDSHARD_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+class WildShardMap
+{
+public:
+	// Shard i holds keys from rgstrLower[i] up to rgstrLower[i + 1], and
+	// the last holds the rest.  The bounds must ascend, and the first must
+	// be empty.
+	explicit WildShardMap(const std::vector<std::string> &rgstrLower);
+
+	size_t Count() const
+	{
+		return m_rgstrLower.size();
+	}
+
+	const std::string &Lower(size_t iShard) const
+	{
+		return m_rgstrLower[iShard];
+	}
+
+	// The shard that holds a key.
+	size_t ShardOf(const char *pKey, size_t cbKey) const;
+
+	// Sets rgShards to the shards that may hold a key matching a pattern of
+	// '*' and '?' wildcards, in ascending order.
+	void Plan(const char *pWild, std::vector<uint32_t> &rgShards) const;
+
+private:
+	std::vector<std::string> m_rgstrLower;
+};
+
+
+// Keys as delivered by the coordinator: called once per matching key.
+typedef std::function<void(const char *pKey, size_t cbKey)> WildShardEmit;
+
+class WildShardCoordinator
+{
+public:
+	WildShardCoordinator();
+	~WildShardCoordinator();
+
+	// Splits keys among the map's shards and starts a worker for each.
+	// The map must outlive the coordinator.  Call this before starting any
+	// threads, as with any fork().  Returns false if a worker can't be
+	// started, in which case none are running.
+	bool Start(const WildShardMap &map,
+	           const std::vector<std::string> &rgKeys);
+
+	// Stops the workers and waits for them to exit.
+	void Stop();
+
+	// Queries the planned shards, or every shard with bBroadcast, passing
+	// each matching key to emit() in key order, and sets *pcShards, if
+	// that's not NULL, to the number of shards contacted.  Returns false
+	// if a worker fails, after passing on the keys that came before.  The
+	// coordinator is then stopped, since the other workers may still be
+	// answering, and later queries fail until it's started again.
+	bool Query(const char *pWild, const WildShardEmit &emit,
+	           size_t *pcShards = NULL, bool bBroadcast = false);
+
+	// Whether shards are served by worker processes rather than in
+	// process.
+	bool Forked() const
+	{
+		return !m_rgWorkers.empty();
+	}
+
+private:
+	// A shard's keys, in order, back to back.
+	struct WildShardKeys
+	{
+		std::string           strBytes;
+		std::vector<uint32_t> rgOffsets;   // Plus one
+	};
+
+	struct WildShardWorker
+	{
+		int iPid;
+		int fdRequest;    // Coordinator to worker
+		int fdResponse;   // Worker to coordinator
+	};
+
+	// Matches a shard's keys, passing them on in frames: each key as its
+	// 32-bit length and then its bytes.
+	static void Serve(const WildShardKeys &keys, const char *pWild,
+	                  const std::function<void(const char *, size_t)> &flush);
+	static void WorkerLoop(const WildShardKeys &keys, int fdRequest,
+	                       int fdResponse);
+
+	const WildShardMap          *m_pMap;
+	std::vector<WildShardKeys>   m_rgShards;
+	std::vector<WildShardWorker> m_rgWorkers;   // Empty if in process
+};
+
+extern "C" int testshard(void);
+extern "C" int benchshard(void);
+
+#endif  // WILDSHARD_H
@@ -0,0 +1,846 @@
+// WildRangeWriter, and related code
+//
+// Copyright 2025 Kirk J Krauss.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// This file provides the range writer and the system calls it picks from.
+// It also includes testcases for correctness and performance.
+//
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#define WILD_HAVE_POSIX_IO
+#endif
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#define WILD_HAVE_SPLICE
+#endif
+
+#include "fastwildcompare.h"
+#include "wildsplice.h"
+#include "wildbench.h"
+
+
+#if defined(WILD_HAVE_POSIX_IO)
+// Whether a failed call can go again: if it was interrupted, or if the
+// output was full, once there's room.
+//
+static bool RetryCall(int fdOut)
+{
+	if (errno == EINTR)
+	{
+		return true;
+	}
+
+	if (errno == EAGAIN || errno == EWOULDBLOCK)
+	{
+		pollfd pfd = {fdOut, POLLOUT, 0};
+
+		return poll(&pfd, 1, -1) >= 0 || errno == EINTR;
+	}
+
+	return false;
+}
+
+
+// Whether a failed call was turned down for this pair of descriptors, so
+// that another call might do.
+//
+static bool CallRefused()
+{
+	return errno == EINVAL || errno == EXDEV || errno == ENOSYS ||
+	       errno == EOPNOTSUPP || errno == ENOTSUP || errno == EBADF;
+}
+#endif
+
+
+WildRangeWriter::WildRangeWriter() :
+    m_fdIn(-1), m_fdOut(-1), m_pBase(NULL), m_cbIn(0), m_uPending(0),
+    m_cbPending(0), m_uWindow(0), m_cbWindow(0), m_bGatherVmsplice(false),
+    m_bOutPipe(false), m_bOutFile(false), m_bInFile(false),
+    m_bVmsplice(false), m_bSplice(false), m_bCopy(false), m_bFailed(true)
+{
+	memset(&m_stats, 0, sizeof(m_stats));
+}
+
+
+WildRangeWriter::~WildRangeWriter()
+{
+	Flush();
+}
+
+
+bool WildRangeWriter::Open(int fdIn, const char *pBase, uint64_t cbIn,
+                           int fdOut)
+{
+	m_fdIn = fdIn;
+	m_fdOut = fdOut;
+	m_pBase = pBase;
+	m_cbIn = cbIn;
+	m_uPending = 0;
+	m_cbPending = 0;
+	m_rgGather.clear();
+	m_cbWindow = 0;
+	m_bGatherVmsplice = false;
+	memset(&m_stats, 0, sizeof(m_stats));
+	m_bFailed = true;
+
+#if defined(WILD_HAVE_POSIX_IO)
+	struct stat st;
+
+	if (fdOut < 0 || (fdIn < 0 && pBase == NULL) || fstat(fdOut, &st))
+	{
+		return false;
+	}
+
+	m_bOutPipe = S_ISFIFO(st.st_mode);
+	m_bOutFile = S_ISREG(st.st_mode);
+	m_bInFile = fdIn >= 0 && fstat(fdIn, &st) == 0 && S_ISREG(st.st_mode);
+#if defined(WILD_HAVE_SPLICE)
+	m_bVmsplice = m_bSplice = m_bCopy = true;
+#else
+	m_bVmsplice = m_bSplice = m_bCopy = false;
+#endif
+	m_bFailed = false;
+	return true;
+#else
+	return false;
+#endif
+}
+
+
+bool WildRangeWriter::Add(uint64_t uOffset, size_t cb)
+{
+	if (m_bFailed || uOffset > m_cbIn || cb > m_cbIn - uOffset)
+	{
+		return false;
+	}
+
+	if (cb == 0)
+	{
+		return true;
+	}
+
+	if (m_cbPending && m_uPending + m_cbPending == uOffset)
+	{
+		m_cbPending += cb;
+		return true;
+	}
+
+	if (m_cbPending && !Emit(m_uPending, m_cbPending))
+	{
+		return false;
+	}
+
+	m_uPending = uOffset;
+	m_cbPending = cb;
+	return true;
+}
+
+
+bool WildRangeWriter::Flush()
+{
+	if (m_bFailed)
+	{
+		return false;
+	}
+
+	if (m_cbPending && !Emit(m_uPending, m_cbPending))
+	{
+		return false;
+	}
+
+	m_cbPending = 0;
+	return FlushGather();
+}
+
+
+// Passes on one joined range by the first call in the table that fits.
+// Gathered ranges all go by vmsplice() or all by writev(), so the ones
+// gathered so far go out when that changes.
+//
+bool WildRangeWriter::Emit(uint64_t uOffset, uint64_t cb)
+{
+	++m_stats.cRanges;
+
+	if (m_bOutFile && m_bInFile && m_bCopy && cb >= WILD_SPLICE_MIN_COPY)
+	{
+		return FlushGather() && CopyRange(uOffset, cb);
+	}
+
+	if (m_bOutPipe && cb >= WILD_SPLICE_MIN_ZERO)
+	{
+		if (m_pBase && m_bVmsplice)
+		{
+			if (!m_bGatherVmsplice && !FlushGather())
+			{
+				return false;
+			}
+
+			m_bGatherVmsplice = true;
+			return Gather(uOffset, cb);
+		}
+
+		if (m_pBase == NULL && m_bInFile && m_bSplice)
+		{
+			return FlushGather() && SpliceRange(uOffset, cb);
+		}
+	}
+
+	if (m_bGatherVmsplice && !FlushGather())
+	{
+		return false;
+	}
+
+	m_bGatherVmsplice = false;
+	return Gather(uOffset, cb);
+}
+
+
+// Adds a range to those gathered, from the mapping, or else from a window
+// of the input read for it, and writes them once there are
+// WILD_SPLICE_IOVECS.
+//
+bool WildRangeWriter::Gather(uint64_t uOffset, uint64_t cb)
+{
+	while (cb)
+	{
+		const char *p;
+		uint64_t    cbSpan = cb;
+
+		if (m_pBase)
+		{
+			p = m_pBase + uOffset;
+		}
+		else
+		{
+			if (uOffset < m_uWindow || uOffset >= m_uWindow + m_cbWindow)
+			{
+				// Gathered ranges may be in the window.
+				if (!FlushGather() || !ReadWindow(uOffset))
+				{
+					return false;
+				}
+			}
+
+			p = m_rgchWindow.data() + (uOffset - m_uWindow);
+			cbSpan = std::min(cb, m_uWindow + m_cbWindow - uOffset);
+		}
+
+		m_rgGather.push_back({p, cbSpan});
+		uOffset += cbSpan;
+		cb -= cbSpan;
+
+		if (m_rgGather.size() == WILD_SPLICE_IOVECS && !FlushGather())
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+// Reads up to WILD_SPLICE_WINDOW bytes of the input, from uOffset on.
+//
+bool WildRangeWriter::ReadWindow(uint64_t uOffset)
+{
+#if defined(WILD_HAVE_POSIX_IO)
+	uint64_t cbWant = std::min(m_cbIn - uOffset,
+	                           (uint64_t) WILD_SPLICE_WINDOW);
+
+	m_rgchWindow.resize(WILD_SPLICE_WINDOW);
+	m_uWindow = uOffset;
+	m_cbWindow = 0;
+
+	while (m_cbWindow < cbWant)
+	{
+		ssize_t cbRead = pread(m_fdIn, m_rgchWindow.data() + m_cbWindow,
+		                       (size_t) (cbWant - m_cbWindow),
+		                       (off_t) (uOffset + m_cbWindow));
+
+		if (cbRead < 0 && errno == EINTR)
+		{
+			continue;
+		}
+
+		if (cbRead <= 0)
+		{
+			m_cbWindow = 0;
+			m_bFailed = true;
+			return false;
+		}
+
+		m_cbWindow += cbRead;
+	}
+
+	return true;
+#else
+	(void) uOffset;
+	m_bFailed = true;
+	return false;
+#endif
+}
+
+
+// Writes the gathered ranges, by vmsplice() if they're of the mapping and
+// bound for a pipe, or else by writev().
+//
+bool WildRangeWriter::FlushGather()
+{
+#if defined(WILD_HAVE_POSIX_IO)
+	iovec  rgIov[WILD_SPLICE_IOVECS];
+	size_t cIov = m_rgGather.size();
+	size_t iIov = 0;
+
+	for (size_t i = 0; i < cIov; ++i)
+	{
+		rgIov[i].iov_base = (void *) m_rgGather[i].p;
+		rgIov[i].iov_len = (size_t) m_rgGather[i].cb;
+	}
+
+	m_rgGather.clear();
+
+	while (iIov < cIov)
+	{
+		bool    bVmsplice = m_bGatherVmsplice && m_bVmsplice;
+		ssize_t cbDone;
+
+#if defined(WILD_HAVE_SPLICE)
+		if (bVmsplice)
+		{
+			cbDone = vmsplice(m_fdOut, rgIov + iIov, cIov - iIov, 0);
+		}
+		else
+#endif
+		{
+			cbDone = writev(m_fdOut, rgIov + iIov, (int) (cIov - iIov));
+		}
+
+		if (cbDone < 0)
+		{
+			if (bVmsplice && CallRefused())
+			{
+				m_bVmsplice = false;
+			}
+			else if (!RetryCall(m_fdOut))
+			{
+				m_bFailed = true;
+				return false;
+			}
+
+			continue;
+		}
+
+		++m_stats.cCalls;
+		(bVmsplice ? m_stats.cbVmspliced : m_stats.cbWritten) += cbDone;
+
+		while (iIov < cIov && (size_t) cbDone >= rgIov[iIov].iov_len)
+		{
+			cbDone -= rgIov[iIov++].iov_len;
+		}
+
+		if (cbDone)
+		{
+			rgIov[iIov].iov_base = (char *) rgIov[iIov].iov_base + cbDone;
+			rgIov[iIov].iov_len -= cbDone;
+		}
+	}
+
+	return true;
+#else
+	return m_rgGather.empty();
+#endif
+}
+
+
+// Moves a range from the input file's page cache into the output pipe.
+//
+bool WildRangeWriter::SpliceRange(uint64_t uOffset, uint64_t cb)
+{
+#if defined(WILD_HAVE_SPLICE)
+	loff_t uIn = (loff_t) uOffset;
+	loff_t uEnd = (loff_t) (uOffset + cb);
+
+	while (uIn < uEnd)
+	{
+		ssize_t cbDone = splice(m_fdIn, &uIn, m_fdOut, NULL,
+		                        (size_t) (uEnd - uIn), SPLICE_F_MORE);
+
+		if (cbDone < 0 && CallRefused())
+		{
+			m_bSplice = false;
+			return Gather(uIn, uEnd - uIn);
+		}
+
+		if (cbDone == 0 || (cbDone < 0 && !RetryCall(m_fdOut)))
+		{
+			m_bFailed = true;
+			return false;
+		}
+
+		if (cbDone > 0)
+		{
+			++m_stats.cCalls;
+			m_stats.cbSpliced += cbDone;
+		}
+	}
+
+	return true;
+#else
+	m_bSplice = false;
+	return Gather(uOffset, cb);
+#endif
+}
+
+
+// Copies a range from the input file to the output file in the kernel,
+// which may share the blocks rather than copy them.
+//
+bool WildRangeWriter::CopyRange(uint64_t uOffset, uint64_t cb)
+{
+#if defined(WILD_HAVE_SPLICE) && defined(SYS_copy_file_range)
+	loff_t uIn = (loff_t) uOffset;
+	loff_t uEnd = (loff_t) (uOffset + cb);
+
+	while (uIn < uEnd)
+	{
+		ssize_t cbDone = syscall(SYS_copy_file_range, m_fdIn, &uIn, m_fdOut,
+		                         NULL, (size_t) (uEnd - uIn), 0);
+
+		if (cbDone < 0 && CallRefused())
+		{
+			m_bCopy = false;
+			return Gather(uIn, uEnd - uIn);
+		}
+
+		if (cbDone == 0 || (cbDone < 0 && !RetryCall(m_fdOut)))
+		{
+			m_bFailed = true;
+			return false;
+		}
+
+		if (cbDone > 0)
+		{
+			++m_stats.cCalls;
+			m_stats.cbCopied += cbDone;
+		}
+	}
+
+	return true;
+#else
+	m_bCopy = false;
+	return Gather(uOffset, cb);
+#endif
+}
+
+
+#if defined(WILD_HAVE_POSIX_IO)
+// Reads a descriptor to its end on a thread of its own, as whatever takes
+// the filter's output would, keeping the bytes if there's a string for
+// them.
+//
+class WildSpliceDrain
+{
+public:
+	WildSpliceDrain(int fd, std::string *pstrOut) :
+	    m_thread([fd, pstrOut]()
+	{
+		std::vector<char> rgch(1 << 20);
+		ssize_t           cb;
+
+		while ((cb = read(fd, rgch.data(), rgch.size())) != 0)
+		{
+			if (cb > 0 && pstrOut)
+			{
+				pstrOut->append(rgch.data(), cb);
+			}
+			else if (cb < 0 && errno != EINTR)
+			{
+				break;
+			}
+		}
+	})
+	{
+	}
+
+	void Join()
+	{
+		m_thread.join();
+	}
+
+private:
+	std::thread m_thread;
+};
+
+
+// Reads back a whole file from its start.
+//
+static std::string ReadBack(int fd)
+{
+	std::string strOut;
+	char        rgch[65536];
+	ssize_t     cb;
+	off_t       uOffset = 0;
+
+	while ((cb = pread(fd, rgch, sizeof(rgch), uOffset)) > 0)
+	{
+		strOut.append(rgch, cb);
+		uOffset += cb;
+	}
+
+	return strOut;
+}
+
+
+// Maps a file read-only, returning NULL if it can't be.
+//
+static const char *MapFile(int fd, size_t cb)
+{
+	void *pMap = mmap(NULL, cb, PROT_READ, MAP_PRIVATE, fd, 0);
+
+	return pMap == MAP_FAILED ? NULL : (const char *) pMap;
+}
+#endif
+
+
+extern "C" int testsplice(void)
+{
+	bool bAllPassed = true;
+
+#if defined(WILD_HAVE_POSIX_IO)
+	const std::string strPath = WildBenchTempPath("wildsplice_test.txt");
+	const std::string strOutPath = WildBenchTempPath("wildsplice_test.out");
+	WildBenchRandom   rng(1210);
+	std::string       strText;
+	std::string       strKey;
+
+	// More than a window of input, for the unmapped cases.
+	while (strText.size() < 3 * WILD_SPLICE_WINDOW / 2)
+	{
+		WildBenchMakeKey(rng, strKey, rng.Below(4) == 0);
+		strText += strKey + "\n";
+	}
+
+	int fdIn = open(strPath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+	int fdOut = open(strOutPath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+
+	bAllPassed &= fdIn >= 0 && fdOut >= 0 &&
+	              write(fdIn, strText.data(), strText.size()) ==
+	              (ssize_t) strText.size();
+
+	const char *pMap = bAllPassed ? MapFile(fdIn, strText.size()) : NULL;
+
+	bAllPassed &= pMap != NULL;
+
+	for (int iCase = 0; bAllPassed && iCase < 12; ++iCase)
+	{
+		// Every pairing of mapped or unmapped input and pipe or file
+		// output, for some of the lines, every line one at a time, and
+		// every line as one range: the output is what was added, in order.
+		bool        bMapped = iCase % 2 == 0;
+		bool        bPipe = iCase / 2 % 2 == 0;
+		int         iLines = iCase / 4;
+		std::string strExpected;
+		std::string strOut;
+		uint64_t    cRuns = 0;
+		bool        bLastAdded = false;
+		int         rgfdPipe[2] = {-1, -1};
+
+		if (bPipe && pipe(rgfdPipe) != 0)
+		{
+			bAllPassed = false;
+			break;
+		}
+
+		WildSpliceDrain *pDrain = bPipe ?
+		    new WildSpliceDrain(rgfdPipe[0], &strOut) : NULL;
+		WildRangeWriter  writer;
+
+		if (!bPipe)
+		{
+			bAllPassed &= ftruncate(fdOut, 0) == 0 &&
+			              lseek(fdOut, 0, SEEK_SET) == 0;
+		}
+
+		bAllPassed &= writer.Open(fdIn,
+		                          bMapped ? pMap : NULL, strText.size(),
+		                          bPipe ? rgfdPipe[1] : fdOut);
+
+		if (iLines == 2)
+		{
+			bAllPassed &= writer.Add(0, strText.size());
+			strExpected = strText;
+			cRuns = 1;
+		}
+
+		for (size_t iLine = 0; iLines < 2 && iLine < strText.size(); )
+		{
+			size_t iEnd = strText.find('\n', iLine) + 1;
+			bool   bAdd = iLines == 1 ||
+			              FastWildCompare((char *) "*a*",
+			                              (char *) strText.substr(iLine,
+			                              iEnd - iLine - 1).c_str());
+
+			if (bAdd)
+			{
+				bAllPassed &= writer.Add(iLine, iEnd - iLine);
+				strExpected += strText.substr(iLine, iEnd - iLine);
+				cRuns += !bLastAdded;
+			}
+
+			bLastAdded = bAdd;
+			iLine = iEnd;
+		}
+
+		bAllPassed &= writer.Add(strText.size(), 0) &&
+		              !writer.Add(strText.size() - 1, 2) && writer.Flush();
+
+		const WildSpliceStats &stats = writer.Stats();
+		uint64_t               cbAll = stats.cbVmspliced + stats.cbSpliced +
+		                               stats.cbCopied + stats.cbWritten;
+
+		if (bPipe)
+		{
+			close(rgfdPipe[1]);
+			pDrain->Join();
+			delete pDrain;
+			close(rgfdPipe[0]);
+		}
+		else
+		{
+			strOut = ReadBack(fdOut);
+		}
+
+		bAllPassed &= strOut == strExpected && stats.cRanges == cRuns &&
+		              cbAll == strExpected.size();
+
+#if defined(WILD_HAVE_SPLICE)
+		// Some of the lines go gathered by writev(), and every line, as one
+		// long range, to a pipe by vmsplice() from the mapping or by
+		// splice() from the file.
+		if (iLines == 0)
+		{
+			bAllPassed &= stats.cbWritten == strExpected.size();
+		}
+		else if (bPipe)
+		{
+			bAllPassed &= (bMapped ? stats.cbVmspliced : stats.cbSpliced) ==
+			              strExpected.size();
+		}
+#endif
+	}
+
+	if (pMap)
+	{
+		munmap((void *) pMap, strText.size());
+	}
+
+	if (fdIn >= 0)
+	{
+		close(fdIn);
+	}
+
+	if (fdOut >= 0)
+	{
+		close(fdOut);
+	}
+
+	remove(strPath.c_str());
+	remove(strOutPath.c_str());
+
+	{
+		// Neither input nor output, or no input at all, won't open.
+		WildRangeWriter writer;
+
+		bAllPassed &= !writer.Open(-1, NULL, 0, 1) &&
+		              !writer.Open(-1, "x", 1, -1) && !writer.Add(0, 1);
+	}
+#endif
+
+	if (bAllPassed)
+	{
+		printf("Passed splice tests\n");
+	}
+	else
+	{
+		printf("Failed splice tests\n");
+	}
+
+	return 0;
+}
+
+
+extern "C" int benchsplice(void)
+{
+#if defined(WILD_HAVE_POSIX_IO)
+	const size_t      cLines = 2000000;
+	const std::string strPath = WildBenchTempPath("wildsplice_bench.txt");
+	const std::string strOutPath = WildBenchTempPath("wildsplice_bench.out");
+	WildBenchRandom   rng(1211);
+	std::string       strText;
+	std::string       strKey;
+	std::vector<uint32_t> rgLines(1, 0);
+
+	for (size_t i = 0; i < cLines; ++i)
+	{
+		WildBenchMakeKey(rng, strKey, rng.Below(4) == 0);
+		strText += strKey + "\n";
+		rgLines.push_back((uint32_t) strText.size());
+	}
+
+	int fdIn = open(strPath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+	int fdOut = open(strOutPath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+
+	if (fdIn < 0 || fdOut < 0 ||
+	    write(fdIn, strText.data(), strText.size()) != (ssize_t) strText.size())
+	{
+		printf("Splice: couldn't write %s\n", strPath.c_str());
+		return 0;
+	}
+
+	const char *pMap = MapFile(fdIn, strText.size());
+
+	printf("Splice output, %zu lines, %.1f MB:\n", cLines,
+	       strText.size() / 1e6);
+
+	for (int iPercent : {100, 90, 50})
+	{
+		std::vector<bool> rgbMatch(cLines);
+		size_t            cbMatched = 0;
+
+		for (size_t i = 0; i < cLines; ++i)
+		{
+			rgbMatch[i] = (int) rng.Below(100) < iPercent;
+			cbMatched += rgbMatch[i] ? rgLines[i + 1] - rgLines[i] : 0;
+		}
+
+		for (int iOut = 0; iOut < 2; ++iOut)
+		{
+			printf("  %3d%% of lines matched, %.1f MB, to a %s:\n",
+			       iPercent, cbMatched / 1e6, iOut ? "file" : "pipe");
+
+			for (int iWay = 0; iWay < 3; ++iWay)
+			{
+				int              rgfdPipe[2] = {-1, -1};
+				int              fd = fdOut;
+				WildSpliceDrain *pDrain = NULL;
+				WildSpliceStats  stats = {0, 0, 0, 0, 0, 0};
+
+				if (iOut == 0)
+				{
+					if (pipe(rgfdPipe) != 0)
+					{
+						break;
+					}
+
+					fd = rgfdPipe[1];
+					pDrain = new WildSpliceDrain(rgfdPipe[0], NULL);
+				}
+				else if (ftruncate(fdOut, 0) || lseek(fdOut, 0, SEEK_SET))
+				{
+					break;
+				}
+
+				uint64_t uStart = WildBenchNanos();
+
+				if (iWay == 0)
+				{
+					// The mapped lines, copied into stdio buffers.
+					FILE *pFile = fdopen(dup(fd), "wb");
+
+					for (size_t i = 0; i < cLines; ++i)
+					{
+						if (rgbMatch[i])
+						{
+							fwrite(pMap + rgLines[i], 1,
+							       rgLines[i + 1] - rgLines[i], pFile);
+						}
+					}
+
+					fclose(pFile);
+				}
+				else
+				{
+					WildRangeWriter writer;
+
+					writer.Open(fdIn, iWay == 1 ? pMap : NULL,
+					            strText.size(), fd);
+
+					for (size_t i = 0; i < cLines; ++i)
+					{
+						if (rgbMatch[i])
+						{
+							writer.Add(rgLines[i],
+							           rgLines[i + 1] - rgLines[i]);
+						}
+					}
+
+					writer.Flush();
+					stats = writer.Stats();
+				}
+
+				if (pDrain)
+				{
+					close(rgfdPipe[1]);
+					pDrain->Join();
+					delete pDrain;
+					close(rgfdPipe[0]);
+				}
+
+				uint64_t uNanos = WildBenchNanos() - uStart;
+
+				printf("    %-16s %8.2f ms %8.1f MB/s", iWay == 0 ?
+				       "fwrite()" : iWay == 1 ? "ranges, mapped" :
+				       "ranges, unmapped", uNanos / 1e6,
+				       cbMatched * 1e3 / uNanos);
+
+				if (iWay)
+				{
+					printf(", %llu ranges in %llu calls: %s",
+					       (unsigned long long) stats.cRanges,
+					       (unsigned long long) stats.cCalls,
+					       stats.cbVmspliced ? "vmsplice()" :
+					       stats.cbSpliced ? "splice()" :
+					       stats.cbCopied ? "copy_file_range()" :
+					       "writev()");
+				}
+
+				printf("\n");
+			}
+		}
+	}
+
+	munmap((void *) pMap, strText.size());
+	close(fdIn);
+	close(fdOut);
+	remove(strPath.c_str());
+	remove(strOutPath.c_str());
+#endif
+
+	return 0;
+}
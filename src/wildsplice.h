@@ -0,0 +1,142 @@
+// WildRangeWriter, an output stage that passes matched byte ranges of an
+// input file straight to an output file descriptor
+//
+// Copyright 2025 Kirk J Krauss.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// A filter that finds matching lines in a mapped file, then copies them
+// into stdio buffers to write them, can spend more time copying than
+// matching.  A WildRangeWriter takes the matching lines as byte ranges of
+// the input, joins ranges that adjoin, and has the kernel move them to the
+// output with as few copies, and as few calls, as the two descriptors and
+// the ranges allow:
+//
+//   output  input     range                 call
+//   pipe    mapped    WILD_SPLICE_MIN_ZERO  vmsplice(), gathered, no copy
+//                     or more
+//   pipe    file      WILD_SPLICE_MIN_ZERO  splice() per range, from the
+//                     or more               page cache, no copy
+//   file    file      WILD_SPLICE_MIN_COPY  copy_file_range() per range,
+//                     or more               which may share blocks or copy
+//                                           in-kernel
+//   any     mapped    shorter               writev(), gathered
+//   any     file      shorter               writev(), gathered from a
+//                                           window read by pread()
+//
+// Gathered ranges go WILD_SPLICE_IOVECS at a time.  Short ranges aren't
+// spliced because each one would take a pipe buffer, a page, of its own,
+// so that a pipe would hold only a few lines at a time, and a call per
+// line would cost more than the copy it saves.  Where the kernel turns a
+// call down for a pair of descriptors (EINVAL, EXDEV and the like), the
+// writer gathers the rest instead.  splice(), vmsplice() and
+// copy_file_range() are Linux calls; elsewhere on POSIX systems, ranges
+// are all gathered.
+//
+// vmsplice() puts references to the mapped pages into the pipe, not copies
+// of their bytes.  So the mapped input must not change until whatever
+// reads the pipe has read them: mapped input should be a read-only file
+// mapping, not a buffer that's reused.
+//
+#ifndef WILDSPLICE_H
+#define WILDSPLICE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#define WILD_SPLICE_IOVECS    256          // Ranges gathered per call
+#define WILD_SPLICE_MIN_ZERO  4096         // Least range spliced
+#define WILD_SPLICE_MIN_COPY  (64 << 10)   // Least range copy_file_range()
+                                           // takes
+#define WILD_SPLICE_WINDOW    (256 << 10)  // Bytes read at once, to gather
+                                           // from, without a mapping
+
+struct WildSpliceStats
+{
+	uint64_t cRanges;       // Ranges passed on, once joined
+	uint64_t cCalls;        // Calls made to pass them on
+	uint64_t cbVmspliced;
+	uint64_t cbSpliced;
+	uint64_t cbCopied;      // By copy_file_range()
+	uint64_t cbWritten;     // By writev()
+};
+
+class WildRangeWriter
+{
+public:
+	WildRangeWriter();
+
+	// Flushes, ignoring any failure; call Flush() first to check.
+	~WildRangeWriter();
+
+	// Starts writing ranges of an input of cbIn bytes to fdOut, at its
+	// current position.  The input is fdIn, mapped at pBase, or either one
+	// alone: fdIn can be -1 if there's only memory, and pBase NULL if
+	// there's only a file.  The writer doesn't close or unmap either.
+	// Returns false if there's neither, or if the platform has no
+	// descriptors.
+	bool Open(int fdIn, const char *pBase, uint64_t cbIn, int fdOut);
+
+	// Queues bytes [uOffset, uOffset + cb) of the input to be written,
+	// after those queued before.  Returns false if the range runs past the
+	// input or if a write has failed.
+	bool Add(uint64_t uOffset, size_t cb);
+
+	// Writes every range queued.  Returns false if a write has failed.
+	bool Flush();
+
+	const WildSpliceStats &Stats() const
+	{
+		return m_stats;
+	}
+
+private:
+	struct WildSpliceSpan
+	{
+		const char *p;
+		uint64_t    cb;
+	};
+
+	bool Emit(uint64_t uOffset, uint64_t cb);
+	bool Gather(uint64_t uOffset, uint64_t cb);
+	bool ReadWindow(uint64_t uOffset);
+	bool FlushGather();
+	bool SpliceRange(uint64_t uOffset, uint64_t cb);
+	bool CopyRange(uint64_t uOffset, uint64_t cb);
+
+	int                         m_fdIn;
+	int                         m_fdOut;
+	const char                 *m_pBase;
+	uint64_t                    m_cbIn;
+	uint64_t                    m_uPending;   // Joined from adjoining ranges
+	uint64_t                    m_cbPending;
+	std::vector<WildSpliceSpan> m_rgGather;   // For vmsplice() or writev()
+	std::vector<char>           m_rgchWindow; // Input read, without a mapping
+	uint64_t                    m_uWindow;
+	uint64_t                    m_cbWindow;
+	bool                        m_bGatherVmsplice;
+	bool                        m_bOutPipe;
+	bool                        m_bOutFile;
+	bool                        m_bInFile;
+	bool                        m_bVmsplice;  // Each while it works
+	bool                        m_bSplice;
+	bool                        m_bCopy;
+	bool                        m_bFailed;
+	WildSpliceStats             m_stats;
+};
+
+extern "C" int testsplice(void);
+extern "C" int benchsplice(void);
+
+#endif  // WILDSPLICE_H
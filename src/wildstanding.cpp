@@ -0,0 +1,425 @@
+// WildStandingQueries, and related code
+//
+// Copyright 2025 Kirk J Krauss.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// This file provides the standing-query engine and its posting lists.  It
+// also includes testcases for correctness and performance.
+//
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "fastwildcompare.h"
+#include "wildstanding.h"
+#include "wildbench.h"
+
+WildStandingQueries::WildStandingQueries() :
+    m_cKeys(0), m_cDeleted(0), m_cDeletedSinceCompact(0), m_cPostings(0),
+    m_cCompactions(0), m_bBuilt(false)
+{
+}
+
+
+int WildStandingQueries::Register(const char *pWild)
+{
+	if (m_bBuilt)
+	{
+		return -1;
+	}
+
+	auto it = m_mapLists.find(pWild);
+
+	if (it == m_mapLists.end())
+	{
+		it = m_mapLists.emplace(pWild, m_set.Add(pWild)).first;
+	}
+
+	m_rgListOfPattern.push_back(it->second);
+	return (int) m_rgListOfPattern.size() - 1;
+}
+
+
+void WildStandingQueries::Build()
+{
+	m_set.Build();
+	m_rgLists.resize(m_set.Count());
+	m_mapLists.clear();
+
+	for (WildPostingList &list : m_rgLists)
+	{
+		list.uLast = 0;
+		list.cPostings = 0;
+	}
+
+	m_bBuilt = true;
+}
+
+
+// Appends a key number, greater than any in the list, as its distance
+// from the last one.
+//
+void WildStandingQueries::Append(WildPostingList &list, uint32_t iKey)
+{
+	uint32_t uDelta = iKey - list.uLast;
+
+	while (uDelta >= 0x80)
+	{
+		list.rgBytes.push_back((uint8_t) (uDelta | 0x80));
+		uDelta >>= 7;
+	}
+
+	list.rgBytes.push_back((uint8_t) uDelta);
+	list.uLast = iKey;
+	++list.cPostings;
+}
+
+
+// Calls visit() with each key number of a posting list, in order.
+//
+template <typename Visit>
+static void DecodePostings(const std::vector<uint8_t> &rgBytes, Visit visit)
+{
+	const uint8_t *p = rgBytes.data();
+	const uint8_t *pEnd = p + rgBytes.size();
+	uint32_t       iKey = 0;
+
+	while (p < pEnd)
+	{
+		uint32_t uDelta = *p & 0x7F;
+		unsigned uShift = 7;
+
+		while (*p++ & 0x80)
+		{
+			uDelta |= (uint32_t) (*p & 0x7F) << uShift;
+			uShift += 7;
+		}
+
+		iKey += uDelta;
+		visit(iKey);
+	}
+}
+
+
+uint32_t WildStandingQueries::Ingest(const char *pKey, size_t cbKey)
+{
+	uint32_t iKey = (uint32_t) m_cKeys++;
+
+	if (!m_bBuilt)
+	{
+		Build();
+	}
+
+	if (m_rgDeletedWords.size() * 64 < m_cKeys)
+	{
+		m_rgDeletedWords.push_back(0);
+	}
+
+	m_rgHits.clear();
+	m_memo.Reset(pKey, cbKey);
+	m_set.MatchAll(pKey, cbKey, m_rgHits, m_memo);
+
+	for (int iPattern : m_rgHits)
+	{
+		Append(m_rgLists[iPattern], iKey);
+	}
+
+	m_cPostings += m_rgHits.size();
+	return iKey;
+}
+
+
+bool WildStandingQueries::Delete(uint32_t iKey)
+{
+	if (iKey >= m_cKeys || IsDeleted(iKey))
+	{
+		return false;
+	}
+
+	m_rgDeletedWords[iKey / 64] |= (uint64_t) 1 << (iKey % 64);
+	++m_cDeleted;
+
+	if (++m_cDeletedSinceCompact * 8 > LiveCount())
+	{
+		Compact();
+	}
+
+	return true;
+}
+
+
+void WildStandingQueries::Matches(int iPattern,
+                                  std::vector<uint32_t> &rgKeys) const
+{
+	// The posting lists are built with the first key, and until then
+	// there are no matches.
+	if (!m_bBuilt || iPattern < 0 ||
+	    (size_t) iPattern >= m_rgListOfPattern.size())
+	{
+		return;
+	}
+
+	const WildPostingList &list = m_rgLists[m_rgListOfPattern[iPattern]];
+
+	DecodePostings(list.rgBytes, [&](uint32_t iKey)
+	{
+		if (!IsDeleted(iKey))
+		{
+			rgKeys.push_back(iKey);
+		}
+	});
+}
+
+
+void WildStandingQueries::Compact()
+{
+	m_cPostings = 0;
+
+	for (WildPostingList &list : m_rgLists)
+	{
+		WildPostingList compacted;
+
+		compacted.uLast = 0;
+		compacted.cPostings = 0;
+		DecodePostings(list.rgBytes, [&](uint32_t iKey)
+		{
+			if (!IsDeleted(iKey))
+			{
+				Append(compacted, iKey);
+			}
+		});
+
+		compacted.rgBytes.shrink_to_fit();
+		list = std::move(compacted);
+		m_cPostings += list.cPostings;
+	}
+
+	m_cDeletedSinceCompact = 0;
+	++m_cCompactions;
+}
+
+
+size_t WildStandingQueries::Bytes() const
+{
+	size_t cb = m_rgLists.capacity() * sizeof(WildPostingList) +
+	            m_rgListOfPattern.capacity() * sizeof(int) +
+	            m_rgDeletedWords.capacity() * sizeof(uint64_t);
+
+	for (const WildPostingList &list : m_rgLists)
+	{
+		cb += list.rgBytes.capacity();
+	}
+
+	return cb;
+}
+
+
+// A set of standing-query tests: each pattern's matches against
+// FastWildCompare() over the live keys, as keys arrive and are deleted,
+// through compactions, with deltas of every length.
+//
+extern "C" int teststanding(void)
+{
+	static const char *s_rgszWild[] =
+	{
+		"/srv/*", "*.log", "*cache1*", "/home/*/etc?*.csv", "*", "",
+		"*.idx", "/var/*/*7.bin", "*spool42*", "/tmp/run?1?/*", "*.log",
+		"*/data*/*", "/opt/*", "?*", "*.db", "*9"
+	};
+	const int                cWild =
+	    (int) (sizeof(s_rgszWild) / sizeof(s_rgszWild[0]));
+	WildBenchRandom          rng(1616);
+	WildStandingQueries      standing;
+	std::vector<std::string> rgKeys;
+	std::vector<bool>        rgbDeleted;
+	std::string              strKey;
+	bool                     bAllPassed = true;
+
+	for (int iWild = 0; iWild < cWild; ++iWild)
+	{
+		bAllPassed &= standing.Register(s_rgszWild[iWild]) == iWild;
+	}
+
+	// Before the first key, every pattern matches nothing.
+	{
+		std::vector<uint32_t> rgMatches;
+
+		for (int iWild = 0; iWild < cWild; ++iWild)
+		{
+			standing.Matches(iWild, rgMatches);
+		}
+
+		bAllPassed &= rgMatches.empty() && standing.KeyCount() == 0;
+	}
+
+	for (int iRound = 0; iRound < 30; ++iRound)
+	{
+		// Empty keys, which most patterns don't match, leave gaps in their
+		// postings, so that deltas take two bytes and, once, three.
+		for (uint32_t cGap = iRound == 10 ? 17000 : rng.Below(300); cGap > 0;
+		     --cGap)
+		{
+			rgKeys.push_back("");
+			rgbDeleted.push_back(false);
+			standing.Ingest("", 0);
+		}
+
+		for (uint32_t i = rng.Below(400); i > 0; --i)
+		{
+			WildBenchMakeKey(rng, strKey, rng.Below(4) == 0);
+			bAllPassed &= standing.Ingest(strKey.data(), strKey.size()) ==
+			              rgKeys.size();
+			rgKeys.push_back(strKey);
+			rgbDeleted.push_back(false);
+		}
+
+		for (uint32_t i = rng.Below(150); i > 0 && !rgKeys.empty(); --i)
+		{
+			uint32_t iKey = rng.Below((uint32_t) rgKeys.size());
+
+			bAllPassed &= standing.Delete(iKey) == !rgbDeleted[iKey];
+			rgbDeleted[iKey] = true;
+		}
+
+		bAllPassed &= standing.Register("*.csv") == -1 &&
+		              !standing.Delete((uint32_t) rgKeys.size());
+
+		for (int iWild = 0; iWild < cWild; ++iWild)
+		{
+			std::vector<uint32_t> rgExpected, rgMatches;
+
+			for (size_t iKey = 0; iKey < rgKeys.size(); ++iKey)
+			{
+				if (!rgbDeleted[iKey] &&
+				    FastWildCompare(const_cast<char *>(s_rgszWild[iWild]),
+				                    const_cast<char *>(rgKeys[iKey].c_str())))
+				{
+					rgExpected.push_back((uint32_t) iKey);
+				}
+			}
+
+			standing.Matches(iWild, rgMatches);
+			bAllPassed &= rgMatches == rgExpected;
+		}
+	}
+
+	bAllPassed &= standing.CompactionCount() > 0 &&
+	              standing.KeyCount() == rgKeys.size() &&
+	              standing.PatternCount() == cWild &&
+	              standing.ListCount() == cWild - 1;
+
+	if (bAllPassed)
+	{
+		printf("Passed standing query tests\n");
+	}
+	else
+	{
+		printf("Failed standing query tests\n");
+	}
+
+	return 0;
+}
+
+
+// Measures ingest at 10K standing queries, against FastWildCompare() on
+// every pattern for each key, along with the memory the postings take,
+// deletes, and reading every pattern's matches.
+//
+extern "C" int benchstanding(void)
+{
+	const int                cPatterns = 10000;
+	const size_t             cKeys = 200000;
+	const size_t             cLoopKeys = 2000;
+	WildBenchRandom          rng(1717);
+	WildStandingQueries      standing;
+	std::vector<std::string> rgWild(cPatterns);
+	std::vector<std::string> rgKeys(cKeys);
+
+	for (std::string &strWild : rgWild)
+	{
+		WildBenchMakePattern(rng, strWild);
+		standing.Register(strWild.c_str());
+	}
+
+	for (std::string &strKey : rgKeys)
+	{
+		WildBenchMakeKey(rng, strKey, rng.Below(4) == 0);
+	}
+
+	uint64_t uStart = WildBenchNanos();
+
+	for (const std::string &strKey : rgKeys)
+	{
+		standing.Ingest(strKey.data(), strKey.size());
+	}
+
+	uint64_t uIngestNanos = WildBenchNanos() - uStart;
+	uint64_t cLoopHits = 0;
+
+	uStart = WildBenchNanos();
+
+	for (size_t iKey = 0; iKey < cLoopKeys; ++iKey)
+	{
+		for (const std::string &strWild : rgWild)
+		{
+			cLoopHits += FastWildCompare(const_cast<char *>(strWild.c_str()),
+			             const_cast<char *>(rgKeys[iKey].c_str()));
+		}
+	}
+
+	uint64_t uLoopNanos = WildBenchNanos() - uStart;
+	uint64_t cPostings = standing.PostingCount();
+
+	printf("Standing queries, %d patterns (%d distinct), %zu keys: ingest "
+	       "%.0f keys/s (%.1f us each; per-pattern loop %.1f us), %.1f "
+	       "postings per key\n", cPatterns, standing.ListCount(), cKeys,
+	       cKeys / (uIngestNanos / 1e9),
+	       uIngestNanos / 1e3 / cKeys, uLoopNanos / 1e3 / cLoopKeys,
+	       (double) cPostings / cKeys);
+	printf("  Postings: %.1f MB compressed, %.2f bytes each (uint32 lists "
+	       "%.1f MB, bitmaps %.1f MB)\n", standing.Bytes() / 1e6,
+	       (double) standing.Bytes() / cPostings, cPostings * 4 / 1e6,
+	       (double) standing.ListCount() * cKeys / 8 / 1e6);
+
+	uStart = WildBenchNanos();
+
+	for (size_t i = 0; i < cKeys / 4; ++i)
+	{
+		standing.Delete(rng.Below((uint32_t) cKeys));
+	}
+
+	uint64_t uDeleteNanos = WildBenchNanos() - uStart;
+	uint64_t cMatched = 0;
+
+	uStart = WildBenchNanos();
+
+	for (int iPattern = 0; iPattern < cPatterns; ++iPattern)
+	{
+		std::vector<uint32_t> rgMatches;
+
+		standing.Matches(iPattern, rgMatches);
+		cMatched += rgMatches.size();
+	}
+
+	uint64_t uReadNanos = WildBenchNanos() - uStart;
+
+	printf("  %zu deletes in %.1f ms (%llu compactions), %.1f MB after; "
+	       "reading all matches %.1f us per pattern (%.0f keys each)\n",
+	       cKeys / 4, uDeleteNanos / 1e6,
+	       (unsigned long long) standing.CompactionCount(),
+	       standing.Bytes() / 1e6, uReadNanos / 1e3 / cPatterns,
+	       (double) cMatched / cPatterns);
+	return 0;
+}
@@ -0,0 +1,143 @@
+// WildStandingQueries, registered patterns whose matching keys are kept
+// current as keys stream in
+//
+// Copyright 2025 Kirk J Krauss.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// A standing query is a pattern registered once, for which "every key now
+// matching it" should be answerable at any moment.  The patterns go into
+// a WildPatternSet.  Each key that arrives is numbered, run through the
+// set once with WildPatternSet::MatchAll(), and its number is appended to
+// the posting list of every pattern it matches.  Keys arrive in number
+// order, so each list only ever grows at its end, and it's kept as
+// variable-length deltas: a key number's distance from the one before, 7
+// bits per byte, low bits first, with the top bit set on all but the last
+// byte.
+//
+// Patterns registered more than once, as the same dashboard panel open in
+// many places would be, share one entry in the set and one list.
+//
+// Deleting a key marks its number dead, without finding the lists that
+// hold it.  Reading a list passes over dead numbers.  Once enough keys are
+// dead, every list is rewritten without them.
+//
+#ifndef WILDSTANDING_H
+#define WILDSTANDING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "wildpatternset.h"
+
+class WildStandingQueries
+{
+public:
+	WildStandingQueries();
+
+	// Registers a pattern and returns its number, in order from 0.
+	// Returns -1 once a key has been ingested, since earlier keys weren't
+	// matched against it.
+	int Register(const char *pWild);
+
+	// Numbers a key, matches it against every pattern, and appends it to
+	// the postings of those it matches.  Returns the key's number.  Keys
+	// need not be terminated.
+	uint32_t Ingest(const char *pKey, size_t cbKey);
+
+	// Deletes a key by number.  Returns false if there's no such key, or
+	// it's already deleted.
+	bool Delete(uint32_t iKey);
+
+	// Appends the live keys that match a pattern to rgKeys, in ascending
+	// order.  Appends nothing before the first key is ingested.
+	void Matches(int iPattern, std::vector<uint32_t> &rgKeys) const;
+
+	// Rewrites every posting list without the deleted keys.  Delete()
+	// calls this when keys deleted since the last time outnumber an eighth
+	// of the live ones.
+	void Compact();
+
+	int PatternCount() const
+	{
+		return (int) m_rgListOfPattern.size();
+	}
+
+	// Distinct patterns, each with a posting list.
+	int ListCount() const
+	{
+		return m_set.Count();
+	}
+
+	size_t KeyCount() const
+	{
+		return m_cKeys;
+	}
+
+	size_t LiveCount() const
+	{
+		return m_cKeys - m_cDeleted;
+	}
+
+	// Postings held, counting those of deleted keys not yet compacted.
+	uint64_t PostingCount() const
+	{
+		return m_cPostings;
+	}
+
+	// Bytes the postings and deletion marks take, allocated.
+	size_t Bytes() const;
+
+	uint64_t CompactionCount() const
+	{
+		return m_cCompactions;
+	}
+
+private:
+	struct WildPostingList
+	{
+		std::vector<uint8_t> rgBytes;
+		uint32_t             uLast;       // The last key number appended
+		uint32_t             cPostings;
+	};
+
+	void Build();
+	static void Append(WildPostingList &list, uint32_t iKey);
+
+	bool IsDeleted(uint32_t iKey) const
+	{
+		return (m_rgDeletedWords[iKey / 64] >> (iKey % 64)) & 1;
+	}
+
+	WildPatternSet                       m_set;
+	WildSegmentMemo                      m_memo;
+	std::vector<WildPostingList>         m_rgLists;   // One per set pattern
+	std::vector<int>                     m_rgListOfPattern;
+	std::unordered_map<std::string, int> m_mapLists;  // Until the first key
+	std::vector<int>                     m_rgHits;
+	std::vector<uint64_t>                m_rgDeletedWords;
+	size_t                               m_cKeys;
+	size_t                               m_cDeleted;
+	size_t                               m_cDeletedSinceCompact;
+	uint64_t                             m_cPostings;
+	uint64_t                             m_cCompactions;
+	bool                                 m_bBuilt;
+};
+
+extern "C" int teststanding(void);
+extern "C" int benchstanding(void);
+
+#endif  // WILDSTANDING_H
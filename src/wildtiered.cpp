@@ -0,0 +1,652 @@
+// WildTieredSet, and related code
+//
+// Copyright 2025 Kirk J Krauss.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// This file provides the tiered set's sampling, rebuilding and lookups.
+// It also includes testcases for correctness and performance.
+//
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "wildtiered.h"
+#include "wildbench.h"
+
+
+WildTieredSet::WildTieredSet(const WildPatternSet &set,
+                             uint64_t cRebuildLookups,
+                             std::pmr::memory_resource *pResource) :
+    m_set(set), m_hot(pResource), m_memo(pResource), m_hotMemo(pResource),
+    m_rgHot(pResource), m_rgConflicts(pResource),
+    m_rgHits(set.Count(), 0, pResource),
+    m_rgPrefixLen(set.Count(), 0, pResource),
+    m_rgTailLen(set.Count(), 0, pResource),
+    m_rgWildLen(set.Count(), 0, pResource),
+    m_cRebuildLookups(cRebuildLookups), m_cSinceRebuild(0),
+    m_uCountdown(WILD_HOT_SAMPLE), m_stats()
+{
+	for (int iPattern = 0; iPattern < set.Count(); ++iPattern)
+	{
+		const char *pWild = set.Pattern(iPattern);
+		size_t      cbWild = strlen(pWild);
+		size_t      cbPrefix = 0;
+		size_t      cbTail = 0;
+
+		while (cbPrefix < cbWild && pWild[cbPrefix] != '*')
+		{
+			++cbPrefix;
+		}
+
+		while (cbTail < cbWild && pWild[cbWild - 1 - cbTail] != '*')
+		{
+			++cbTail;
+		}
+
+		m_rgPrefixLen[iPattern] = (uint32_t) cbPrefix;
+		m_rgTailLen[iPattern] = (uint32_t) cbTail;
+		m_rgWildLen[iPattern] = (uint32_t) cbWild;
+	}
+}
+
+
+// Whether some string might match both patterns.  It can't if their bytes
+// ahead of the first '*' disagree anywhere both have them, and likewise
+// their bytes after the last '*', counting from the end, or if neither has
+// a '*' and their lengths differ.  Otherwise it's assumed that one might.
+//
+bool WildTieredSet::MayBothMatch(int iLow, int iHigh) const
+{
+	const char *pLow = m_set.Pattern(iLow);
+	const char *pHigh = m_set.Pattern(iHigh);
+	size_t      cbLow = m_rgWildLen[iLow];
+	size_t      cbHigh = m_rgWildLen[iHigh];
+	size_t      cbPrefix = std::min(m_rgPrefixLen[iLow],
+	                                m_rgPrefixLen[iHigh]);
+	size_t      cbTail = std::min(m_rgTailLen[iLow], m_rgTailLen[iHigh]);
+
+	if (m_rgPrefixLen[iLow] == cbLow && m_rgPrefixLen[iHigh] == cbHigh &&
+	    cbLow != cbHigh)
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < cbPrefix; ++i)
+	{
+		if (pLow[i] != pHigh[i] && pLow[i] != '?' && pHigh[i] != '?')
+		{
+			return false;
+		}
+	}
+
+	for (size_t i = 1; i <= cbTail; ++i)
+	{
+		char chLow = pLow[cbLow - i];
+		char chHigh = pHigh[cbHigh - i];
+
+		if (chLow != chHigh && chLow != '?' && chHigh != '?')
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+// Lists the lower patterns that might match along with a hot one, or
+// marks it not final if there are more than WILD_HOT_CONFLICTS.
+//
+void WildTieredSet::FindConflicts(WildHotEntry &entry,
+                                  std::pmr::vector<int> &rgConflicts) const
+{
+	entry.iFirstConflict = (uint32_t) rgConflicts.size();
+	entry.cConflicts = 0;
+	entry.bFinal = true;
+
+	for (int iLow = 0; iLow < entry.iPattern; ++iLow)
+	{
+		if (!MayBothMatch(iLow, entry.iPattern))
+		{
+			continue;
+		}
+		else if (entry.cConflicts == WILD_HOT_CONFLICTS)
+		{
+			rgConflicts.resize(entry.iFirstConflict);
+			entry.cConflicts = 0;
+			entry.bFinal = false;
+			return;
+		}
+
+		rgConflicts.push_back(iLow);
+		++entry.cConflicts;
+	}
+}
+
+
+// Takes the most often sampled patterns, in index order, so that the hot
+// set's first match is the lowest-indexed hot match.  Conflicts found at
+// the last rebuild are kept for patterns that stay hot.
+//
+void WildTieredSet::Rebuild()
+{
+	std::pmr::memory_resource     *pResource = m_rgHot.get_allocator()
+	                                           .resource();
+	std::pmr::vector<int>          rgOrder(pResource);
+	std::pmr::vector<WildHotEntry> rgHot(pResource);
+	std::pmr::vector<int>          rgConflicts(pResource);
+
+	for (int iPattern = 0; iPattern < m_set.Count(); ++iPattern)
+	{
+		if (m_rgHits[iPattern])
+		{
+			rgOrder.push_back(iPattern);
+		}
+	}
+
+	if (rgOrder.size() > WILD_HOT_PATTERNS)
+	{
+		std::nth_element(rgOrder.begin(),
+		                 rgOrder.begin() + WILD_HOT_PATTERNS - 1,
+		                 rgOrder.end(), [&](int iLeft, int iRight)
+		{
+			return m_rgHits[iLeft] > m_rgHits[iRight];
+		});
+		rgOrder.resize(WILD_HOT_PATTERNS);
+		std::sort(rgOrder.begin(), rgOrder.end());
+	}
+
+	m_hot = WildPatternSet(pResource);
+
+	for (int iPattern : rgOrder)
+	{
+		WildHotEntry entry = { iPattern, 0, 0, false };
+		auto         it = std::lower_bound(
+		    m_rgHot.begin(), m_rgHot.end(), iPattern,
+		    [](const WildHotEntry &hot, int i)
+		{
+			return hot.iPattern < i;
+		});
+
+		if (it != m_rgHot.end() && it->iPattern == iPattern)
+		{
+			entry = *it;
+			entry.iFirstConflict = (uint32_t) rgConflicts.size();
+			rgConflicts.insert(rgConflicts.end(),
+			                   m_rgConflicts.begin() + it->iFirstConflict,
+			                   m_rgConflicts.begin() + it->iFirstConflict +
+			                   it->cConflicts);
+		}
+		else
+		{
+			FindConflicts(entry, rgConflicts);
+		}
+
+		rgHot.push_back(entry);
+		m_hot.Add(m_set.Pattern(iPattern));
+	}
+
+	m_hot.Build();
+	m_rgHot.swap(rgHot);
+	m_rgConflicts.swap(rgConflicts);
+
+	for (uint32_t &cHits : m_rgHits)
+	{
+		cHits >>= 1;
+	}
+
+	m_cSinceRebuild = 0;
+	++m_stats.cRebuilds;
+}
+
+
+int WildTieredSet::Lookup(const char *pTame, size_t cbTame, bool bAny)
+{
+	int  iMatch = -1;
+	bool bHot = false;
+
+	++m_stats.cLookups;
+
+	if (!m_rgHot.empty())
+	{
+		int iHot;
+
+		m_hotMemo.Reset(pTame, cbTame);
+		iHot = m_hot.MatchFirstInGroups(pTame, cbTame, 0, m_hot.GroupCount(),
+		                                m_hotMemo);
+		m_stats.cGroupsScanned += iHot < 0 ? m_hot.GroupCount() :
+		                          iHot / WILD_GROUP_LANES + 1;
+
+		if (iHot >= 0)
+		{
+			const WildHotEntry &hot = m_rgHot[iHot];
+
+			bHot = true;
+			iMatch = hot.iPattern;
+			++m_stats.cHotHits;
+
+			if (bAny)
+			{
+				++m_stats.cHotFinal;
+			}
+			else if (hot.bFinal)
+			{
+				// Conflicts are listed lowest first.
+				m_memo.Reset(pTame, cbTame);
+
+				for (uint32_t i = 0; i < hot.cConflicts; ++i)
+				{
+					int iLow = m_rgConflicts[hot.iFirstConflict + i];
+
+					if (m_set.MatchPattern(iLow, pTame, cbTame, m_memo))
+					{
+						iMatch = iLow;
+						break;
+					}
+				}
+
+				++m_stats.cHotFinal;
+			}
+			else
+			{
+				m_memo.Reset(pTame, cbTame);
+				iMatch = m_set.MatchFirstInGroups(pTame, cbTame, 0,
+				    hot.iPattern / WILD_GROUP_LANES + 1, m_memo);
+				m_stats.cGroupsScanned += iMatch / WILD_GROUP_LANES + 1;
+			}
+		}
+	}
+
+	if (!bHot)
+	{
+		m_memo.Reset(pTame, cbTame);
+		iMatch = m_set.MatchFirstInGroups(pTame, cbTame, 0,
+		                                  m_set.GroupCount(), m_memo);
+		m_stats.cGroupsScanned += iMatch < 0 ? m_set.GroupCount() :
+		                          iMatch / WILD_GROUP_LANES + 1;
+	}
+
+	if (!--m_uCountdown)
+	{
+		m_uCountdown = WILD_HOT_SAMPLE;
+
+		if (iMatch >= 0)
+		{
+			++m_rgHits[iMatch];
+		}
+	}
+
+	if (m_cRebuildLookups && ++m_cSinceRebuild >= m_cRebuildLookups)
+	{
+		Rebuild();
+	}
+
+	return iMatch;
+}
+
+
+int WildTieredSet::MatchFirst(const char *pTame, size_t cbTame)
+{
+	return Lookup(pTame, cbTame, false);
+}
+
+
+bool WildTieredSet::MatchAny(const char *pTame, size_t cbTame)
+{
+	return Lookup(pTame, cbTame, true) >= 0;
+}
+
+
+// A pattern as a rule set might have one: a key with its file name cut
+// short, its file name wildcarded, or a digit wildcarded.  Few keys match
+// any one of them.
+//
+static void MakeRulePattern(WildBenchRandom &rng, std::string &strWild)
+{
+	std::string strKey;
+	size_t      iDigit;
+
+	WildBenchMakeKey(rng, strKey);
+
+	switch (rng.Below(3))
+	{
+	case 0:
+		strWild = strKey.substr(0, strKey.rfind('.')) + "*";
+		break;
+
+	case 1:
+		strWild = strKey.substr(0, strKey.rfind('/') + 1) + "*" +
+		          strKey.substr(strKey.rfind('.'));
+		break;
+
+	default:
+		strWild = strKey;
+		iDigit = strKey.find_first_of("0123456789");
+		strWild[iDigit] = '?';
+		break;
+	}
+}
+
+
+// A key that matches a pattern: each '*' filled with a few letters, and
+// each '?' with a digit.
+//
+static void MakeMatchingKey(WildBenchRandom &rng, const char *pWild,
+                            std::string &strKey)
+{
+	strKey.clear();
+
+	for (const char *p = pWild; *p; ++p)
+	{
+		if (*p == '*')
+		{
+			for (uint32_t c = rng.Below(5); c; --c)
+			{
+				strKey += (char) ('a' + rng.Below(26));
+			}
+		}
+		else
+		{
+			strKey += *p == '?' ? (char) ('0' + rng.Below(10)) : *p;
+		}
+	}
+}
+
+
+// Every lookup, whether the hot tier has it or not, must give what the
+// whole set gives, through many rebuilds, with broad patterns that
+// conflict with many others mixed in among specific ones.
+//
+extern "C" int testtiered(void)
+{
+	const int                cPatterns = 3000;
+	const int                cHot = 40;
+	bool                     bAllPassed = true;
+	WildBenchRandom          rng(1250);
+	WildPatternSet           set;
+	WildSegmentMemo          memo;
+	std::vector<std::string> rgWild(cPatterns);
+	std::vector<int>         rgHot(cHot);
+	std::string              strKey;
+
+	for (int i = 0; i < cPatterns; ++i)
+	{
+		if (rng.Below(8) == 0)
+		{
+			WildBenchMakePattern(rng, rgWild[i]);
+		}
+		else
+		{
+			MakeRulePattern(rng, rgWild[i]);
+		}
+
+		set.Add(rgWild[i].c_str());
+	}
+
+	set.Build();
+
+	for (int &iHot : rgHot)
+	{
+		iHot = (int) rng.Below(cPatterns);
+	}
+
+	WildTieredSet tiered(set, 512);
+
+	for (int i = 0; i < 100000; ++i)
+	{
+		// Hot patterns shift partway through.
+		int iHot = rgHot[(rng.Below(cHot) * rng.Below(cHot)) / cHot];
+
+		if (i == 50000)
+		{
+			for (int &iNew : rgHot)
+			{
+				iNew = (int) rng.Below(cPatterns);
+			}
+		}
+
+		if (rng.Below(10) == 0)
+		{
+			WildBenchMakeKey(rng, strKey, rng.Below(2) == 0);
+		}
+		else
+		{
+			MakeMatchingKey(rng, rgWild[iHot].c_str(), strKey);
+		}
+
+		memo.Reset(strKey.data(), strKey.size());
+
+		int iExpected = set.MatchFirstInGroups(strKey.data(), strKey.size(),
+		                                       0, set.GroupCount(), memo);
+
+		bAllPassed &= i % 2 ?
+		    tiered.MatchFirst(strKey.data(), strKey.size()) == iExpected :
+		    tiered.MatchAny(strKey.data(), strKey.size()) ==
+		    (iExpected >= 0);
+	}
+
+	const WildTierStats &stats = tiered.Stats();
+
+	bAllPassed &= tiered.HotCount() > 0 && stats.cRebuilds > 100 &&
+	              stats.cHotHits > stats.cLookups / 2 &&
+	              stats.cHotFinal > 0 && stats.cHotFinal < stats.cHotHits;
+
+	{
+		// No lookups, no hot tier; a rebuild without samples empties it.
+		WildTieredSet cold(set, 0);
+
+		bAllPassed &= cold.MatchFirst("/srv/x") == set.MatchFirst("/srv/x");
+		cold.Rebuild();
+		bAllPassed &= cold.HotCount() == 0;
+	}
+
+	if (bAllPassed)
+	{
+		printf("Passed tiered set tests\n");
+	}
+	else
+	{
+		printf("Failed tiered set tests\n");
+	}
+
+	return 0;
+}
+
+
+// Opens a counter of the calling thread's L1 data cache read misses, in
+// user mode, or returns -1 where there's none to be had.
+//
+static int OpenMissCounter()
+{
+#if defined(__linux__)
+	struct perf_event_attr attr;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = PERF_TYPE_HW_CACHE;
+	attr.config = PERF_COUNT_HW_CACHE_L1D |
+	              (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+	              (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	return (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+	return -1;
+#endif
+}
+
+
+static uint64_t ReadMissCounter(int fd)
+{
+	uint64_t cMisses = 0;
+
+#if defined(__linux__)
+	if (fd >= 0 && read(fd, &cMisses, sizeof(cMisses)) != sizeof(cMisses))
+	{
+		cMisses = 0;
+	}
+#endif
+
+	return cMisses;
+}
+
+
+// A skewed workload: nearly every key matches one of a few dozen patterns
+// spread through a large rule set, the rest match little or nothing.
+// Lookups go to the whole set as is, then to a tiered set that has seen a
+// pass over the same keys.
+//
+extern "C" int benchtiered(void)
+{
+	const int                cPatterns = 1 << 16;
+	const int                cHot = 64;
+	const size_t             cLookups = 40000;
+	const size_t             cbGroupLines = sizeof(WildPatternGroup) / 64;
+	WildBenchRandom          rng(1251);
+	WildPatternSet           set;
+	WildSegmentMemo          memo;
+	std::vector<std::string> rgWild(cPatterns);
+	std::vector<std::string> rgKeys(cLookups);
+	std::vector<int>         rgExpected(cLookups);
+	int                      fdMisses = OpenMissCounter();
+
+	for (int i = 0; i < cPatterns; ++i)
+	{
+		MakeRulePattern(rng, rgWild[i]);
+		set.Add(rgWild[i].c_str());
+	}
+
+	set.Build();
+
+	std::vector<int> rgHot(cHot);
+
+	for (int &iHot : rgHot)
+	{
+		iHot = (int) rng.Below(cPatterns);
+	}
+
+	for (std::string &strKey : rgKeys)
+	{
+		if (rng.Below(20) == 0)
+		{
+			WildBenchMakeKey(rng, strKey, rng.Below(2) == 0);
+		}
+		else
+		{
+			int iHot = rgHot[(rng.Below(cHot) * rng.Below(cHot)) / cHot];
+
+			MakeMatchingKey(rng, rgWild[iHot].c_str(), strKey);
+		}
+	}
+
+	printf("Tiered pattern set, %d patterns, %zu lookups, 95%% of keys "
+	       "matching %d hot patterns:\n", cPatterns, cLookups, cHot);
+
+	WildTieredSet tiered(set, 1 << 14);
+
+	for (const std::string &strKey : rgKeys)
+	{
+		tiered.MatchFirst(strKey.data(), strKey.size());
+	}
+
+	for (int iWay = 0; iWay < 4; ++iWay)
+	{
+		bool           bAny = iWay % 2 != 0;
+		size_t         cMatches = 0;
+		size_t         cWrong = 0;
+		uint64_t       cGroups = 0;
+		WildTierStats  statsBefore = tiered.Stats();
+		uint64_t       cMissesBefore = ReadMissCounter(fdMisses);
+		uint64_t       uStart = WildBenchNanos();
+
+		for (size_t i = 0; i < cLookups; ++i)
+		{
+			const std::string &strKey = rgKeys[i];
+			int                iMatch;
+
+			if (iWay < 2)
+			{
+				memo.Reset(strKey.data(), strKey.size());
+				iMatch = set.MatchFirstInGroups(strKey.data(), strKey.size(),
+				                                0, set.GroupCount(), memo);
+				cGroups += iMatch < 0 ? set.GroupCount() :
+				           iMatch / WILD_GROUP_LANES + 1;
+				rgExpected[i] = iMatch;
+			}
+			else if (bAny)
+			{
+				iMatch = tiered.MatchAny(strKey.data(), strKey.size()) ?
+				         rgExpected[i] : -1;
+			}
+			else
+			{
+				iMatch = tiered.MatchFirst(strKey.data(), strKey.size());
+			}
+
+			cMatches += iMatch >= 0;
+			cWrong += (iMatch >= 0) != (rgExpected[i] >= 0) ||
+			          (!bAny && iMatch != rgExpected[i]);
+		}
+
+		uint64_t uNanos = WildBenchNanos() - uStart;
+		uint64_t cMisses = ReadMissCounter(fdMisses) - cMissesBefore;
+
+		if (iWay >= 2)
+		{
+			cGroups = tiered.Stats().cGroupsScanned -
+			          statsBefore.cGroupsScanned;
+		}
+
+		printf("  %-20s %8.2f ms %8.1f ns/lookup, %7.1f filter lines/lookup",
+		       iWay == 0 ? "Flat, MatchFirst()" :
+		       iWay == 1 ? "Flat, MatchAny()" :
+		       iWay == 2 ? "Tiered, MatchFirst()" : "Tiered, MatchAny()",
+		       uNanos / 1e6, (double) uNanos / cLookups,
+		       (double) cGroups * cbGroupLines / cLookups);
+
+		if (fdMisses >= 0)
+		{
+			printf(", %.1f L1D misses/lookup",
+			       (double) cMisses / cLookups);
+		}
+
+		printf(", %zu matched%s\n", cMatches, cWrong ? ", WRONG" : "");
+	}
+
+	const WildTierStats &stats = tiered.Stats();
+
+	printf("  Hot tier: %zu patterns, %.1f%% of lookups hot, %.1f%% of "
+	       "those answered without filtering, %llu rebuilds%s\n",
+	       tiered.HotCount(), 100.0 * stats.cHotHits / stats.cLookups,
+	       100.0 * stats.cHotFinal / stats.cHotHits,
+	       (unsigned long long) stats.cRebuilds,
+	       fdMisses >= 0 ? "" : "; no cache miss counter on this system");
+
+#if defined(__linux__)
+	if (fdMisses >= 0)
+	{
+		close(fdMisses);
+	}
+#endif
+
+	return 0;
+}
@@ -0,0 +1,132 @@
+// WildTieredSet, a pattern set with a small tier of its most often matched
+// patterns kept ahead of the rest
+//
+// Copyright 2025 Kirk J Krauss.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// In most traffic a few patterns get nearly all the matches, but in a
+// WildPatternSet they sit wherever they were added, among many thousands
+// that rarely match, and a lookup filters every group ahead of the one
+// that matches.  A WildTieredSet samples which pattern each lookup matched,
+// one lookup in WILD_HOT_SAMPLE, and every so many lookups rebuilds a hot
+// tier of the WILD_HOT_PATTERNS most often sampled.  The hot tier is a
+// WildPatternSet of its own, a couple of groups and their pattern text,
+// small enough to stay in the L1 cache, and it's tried first.
+//
+// A hot match answers MatchAny() at once.  MatchFirst() must return the
+// lowest matching index, so a hot match stands only if no lower pattern
+// also matches.  When the tier is rebuilt, each hot pattern's lower
+// patterns are compared with it, by their bytes ahead of the first '*'
+// and after the last: where those disagree, no string matches both.  If
+// that leaves at most WILD_HOT_CONFLICTS lower patterns, those are matched
+// one by one after a hot match; otherwise the groups up to the hot
+// pattern's own are filtered as usual.  Sample counts are halved at each
+// rebuild, so patterns that cool off leave the tier.
+//
+// A tiered set updates its counts and memos as it looks up, so it should
+// be used by one thread at a time, as a WildSegmentMemo is.
+//
+#ifndef WILDTIERED_H
+#define WILDTIERED_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <memory_resource>
+
+#include "wildpatternset.h"
+
+#define WILD_HOT_PATTERNS   64          // Patterns in the hot tier
+#define WILD_HOT_SAMPLE     16          // Lookups per sampled match
+#define WILD_HOT_CONFLICTS  16          // Lower patterns checked one by one
+#define WILD_HOT_REBUILD    (1 << 16)   // Default lookups between rebuilds
+
+struct WildTierStats
+{
+	uint64_t cLookups;
+	uint64_t cHotHits;        // Lookups with a hot match
+	uint64_t cHotFinal;       // Of those, answered without filtering groups
+	uint64_t cGroupsScanned;  // Hot and full groups filtered
+	uint64_t cRebuilds;
+};
+
+class WildTieredSet
+{
+public:
+	// The set must be built, and must outlive this.  With cRebuildLookups
+	// 0, the hot tier is rebuilt only by Rebuild().
+	explicit WildTieredSet(const WildPatternSet &set,
+	                       uint64_t cRebuildLookups = WILD_HOT_REBUILD,
+	                       std::pmr::memory_resource *pResource =
+	                       std::pmr::get_default_resource());
+
+	// Returns the lowest index of a pattern matching a tame string of
+	// cbTame bytes, or -1, as WildPatternSet::MatchFirst() does.
+	int MatchFirst(const char *pTame, size_t cbTame);
+
+	int MatchFirst(const char *pTame)
+	{
+		return MatchFirst(pTame, strlen(pTame));
+	}
+
+	bool MatchAny(const char *pTame, size_t cbTame);
+
+	// Rebuilds the hot tier from the counts sampled so far.
+	void Rebuild();
+
+	size_t HotCount() const
+	{
+		return m_rgHot.size();
+	}
+
+	const WildTierStats &Stats() const
+	{
+		return m_stats;
+	}
+
+private:
+	// A hot pattern, and where its lower conflicts are listed, if bFinal.
+	struct WildHotEntry
+	{
+		int      iPattern;
+		uint32_t iFirstConflict;
+		uint32_t cConflicts;
+		bool     bFinal;
+	};
+
+	int Lookup(const char *pTame, size_t cbTame, bool bAny);
+	bool MayBothMatch(int iLow, int iHigh) const;
+	void FindConflicts(WildHotEntry &entry,
+	                   std::pmr::vector<int> &rgConflicts) const;
+
+	const WildPatternSet              &m_set;
+	WildPatternSet                     m_hot;
+	WildSegmentMemo                    m_memo;
+	WildSegmentMemo                    m_hotMemo;
+	std::pmr::vector<WildHotEntry>     m_rgHot;        // By hot index
+	std::pmr::vector<int>              m_rgConflicts;
+	std::pmr::vector<uint32_t>         m_rgHits;       // Sampled, by pattern
+	std::pmr::vector<uint32_t>         m_rgPrefixLen;  // Ahead of the first
+	std::pmr::vector<uint32_t>         m_rgTailLen;    // '*', after the last
+	std::pmr::vector<uint32_t>         m_rgWildLen;
+	uint64_t                           m_cRebuildLookups;
+	uint64_t                           m_cSinceRebuild;
+	uint32_t                           m_uCountdown;   // To the next sample
+	WildTierStats                      m_stats;
+};
+
+extern "C" int testtiered(void);
+extern "C" int benchtiered(void);
+
+#endif  // WILDTIERED_H
@@ -0,0 +1,538 @@
+// WildTokenPattern, and related code
+//
+// Copyright 2025 Kirk J Krauss.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// This file provides component interning and token-level matching.  It
+// also includes testcases for correctness and performance.
+//
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "fastwildcompare.h"
+#include "wildtoken.h"
+#include "wildbench.h"
+
+
+uint32_t WildTokenDictionary::Intern(const char *pText, size_t cbText)
+{
+	std::string strText(pText, cbText);
+	auto        it = m_mapIds.find(strText);
+
+	if (it != m_mapIds.end())
+	{
+		return it->second;
+	}
+
+	uint32_t uId = (uint32_t) m_rgstrText.size();
+
+	m_mapIds.emplace(strText, uId);
+	m_rgstrText.push_back(strText);
+	return uId;
+}
+
+
+void WildTokenDictionary::Tokenize(const char *pPath,
+                                   std::vector<uint32_t> &rgIds,
+                                   char chSeparator)
+{
+	rgIds.clear();
+
+	while (true)
+	{
+		const char *pSeparator = strchr(pPath, chSeparator);
+		size_t      cb = pSeparator ? (size_t) (pSeparator - pPath) :
+		                              strlen(pPath);
+
+		rgIds.push_back(Intern(pPath, cb));
+
+		if (!pSeparator)
+		{
+			return;
+		}
+
+		pPath = pSeparator + 1;
+	}
+}
+
+
+WildTokenPattern::WildTokenPattern() :
+    m_pDictionary(NULL), m_cPrefix(0), m_cSuffix(0), m_bStar(false),
+    m_cResolves(0)
+{
+}
+
+
+void WildTokenPattern::Compile(const char *pWild,
+                               WildTokenDictionary &dictionary,
+                               char chSeparator)
+{
+	m_rgElements.clear();
+	m_rgGlobs.clear();
+	m_pDictionary = &dictionary;
+	m_bStar = false;
+	m_cPrefix = m_cSuffix = 0;
+
+	// Split here rather than with Tokenize(), so that only the literal
+	// components are interned.
+	const char *p = pWild;
+
+	while (p)
+	{
+		const char *pSeparator = strchr(p, chSeparator);
+		size_t      cb = pSeparator ? (size_t) (pSeparator - p) : strlen(p);
+		std::string strText(p, cb);
+
+		WildTokenElement element = { WILD_TOKEN_LITERAL, 0 };
+
+		p = pSeparator ? pSeparator + 1 : NULL;
+
+		if (strText == "**")
+		{
+			// Consecutive runs amount to one.
+			if (!m_rgElements.empty() &&
+			    m_rgElements.back().kind == WILD_TOKEN_STAR)
+			{
+				continue;
+			}
+
+			element.kind = WILD_TOKEN_STAR;
+			m_bStar = true;
+			m_cSuffix = 0;
+		}
+		else if (strText == "*" || strText == "?")
+		{
+			element.kind = WILD_TOKEN_ONE;
+		}
+		else if (strText.find_first_of("*?") != std::string::npos)
+		{
+			element.kind = WILD_TOKEN_GLOB;
+			element.uValue = (uint32_t) m_rgGlobs.size();
+			m_rgGlobs.push_back(WildTokenGlob());
+			m_rgGlobs.back().strWild = strText;
+		}
+		else
+		{
+			element.uValue = dictionary.Intern(strText.data(), cb);
+		}
+
+		if (element.kind != WILD_TOKEN_STAR)
+		{
+			++(m_bStar ? m_cSuffix : m_cPrefix);
+		}
+
+		m_rgElements.push_back(element);
+	}
+}
+
+
+inline bool WildTokenPattern::ElementMatches(const WildTokenElement &element,
+                                             uint32_t uId)
+{
+	if (element.kind == WILD_TOKEN_LITERAL)
+	{
+		return uId == element.uValue;
+	}
+	else if (element.kind == WILD_TOKEN_ONE)
+	{
+		return true;
+	}
+
+	WildTokenGlob &glob = m_rgGlobs[element.uValue];
+
+	if (uId >= glob.rgKnown.size())
+	{
+		glob.rgKnown.resize(m_pDictionary->Count(), 0);
+	}
+
+	if (!glob.rgKnown[uId])
+	{
+		++m_cResolves;
+		glob.rgKnown[uId] = FastWildCompare(
+		    const_cast<char *>(glob.strWild.c_str()),
+		    const_cast<char *>(m_pDictionary->Text(uId).c_str())) ? 2 : 1;
+	}
+
+	return glob.rgKnown[uId] == 2;
+}
+
+
+// Checks the anchored prefix and suffix first, since they're most likely
+// to rule a path out.  The middle, from the first "**" through the last,
+// is placed leftmost with the most recent "**" as the one fallback point,
+// as FastWildCompare() does with '*'.
+//
+bool WildTokenPattern::Match(const uint32_t *rgIds, size_t cIds)
+{
+	const WildTokenElement *rgElements = m_rgElements.data();
+	size_t                  cElements = m_rgElements.size();
+
+	if (!m_bStar)
+	{
+		if (cIds != cElements)
+		{
+			return false;
+		}
+
+		for (size_t i = 0; i < cIds; ++i)
+		{
+			if (!ElementMatches(rgElements[i], rgIds[i]))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	if (cIds < m_cPrefix + m_cSuffix)
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < m_cPrefix; ++i)
+	{
+		if (!ElementMatches(rgElements[i], rgIds[i]))
+		{
+			return false;
+		}
+	}
+
+	for (size_t i = 1; i <= m_cSuffix; ++i)
+	{
+		if (!ElementMatches(rgElements[cElements - i], rgIds[cIds - i]))
+		{
+			return false;
+		}
+	}
+
+	// The middle ends with a "**", which absorbs whatever is left over.
+	size_t iElement = m_cPrefix, iEndElement = cElements - m_cSuffix;
+	size_t iId = m_cPrefix, iEndId = cIds - m_cSuffix;
+	size_t iStarElement = 0, iStarId = 0;
+
+	while (iElement < iEndElement)
+	{
+		if (rgElements[iElement].kind == WILD_TOKEN_STAR)
+		{
+			iStarElement = ++iElement;
+			iStarId = iId;
+		}
+		else if (iId < iEndId && ElementMatches(rgElements[iElement],
+		                                        rgIds[iId]))
+		{
+			++iElement;
+			++iId;
+		}
+		else if (++iStarId <= iEndId)
+		{
+			iElement = iStarElement;
+			iId = iStarId;
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+// A plain recursive token matcher, for checking the other against.
+//
+static bool ReferenceTokens(const std::vector<std::string> &rgWild,
+                            size_t iWild,
+                            const std::vector<std::string> &rgTame,
+                            size_t iTame)
+{
+	if (iWild == rgWild.size())
+	{
+		return iTame == rgTame.size();
+	}
+	else if (rgWild[iWild] == "**")
+	{
+		for (size_t i = iTame; i <= rgTame.size(); ++i)
+		{
+			if (ReferenceTokens(rgWild, iWild + 1, rgTame, i))
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	return iTame < rgTame.size() &&
+	       FastWildCompare(const_cast<char *>(rgWild[iWild].c_str()),
+	                       const_cast<char *>(rgTame[iTame].c_str())) &&
+	       ReferenceTokens(rgWild, iWild + 1, rgTame, iTame + 1);
+}
+
+
+static void SplitComponents(const std::string &strPath,
+                            std::vector<std::string> &rgstrParts)
+{
+	size_t iStart = 0, iSlash;
+
+	rgstrParts.clear();
+
+	while ((iSlash = strPath.find('/', iStart)) != std::string::npos)
+	{
+		rgstrParts.push_back(strPath.substr(iStart, iSlash - iStart));
+		iStart = iSlash + 1;
+	}
+
+	rgstrParts.push_back(strPath.substr(iStart));
+}
+
+
+// A set of token matching tests: specific cases, then random patterns and
+// paths over a small alphabet of components, against the reference.
+//
+extern "C" int testtoken(void)
+{
+	static const struct
+	{
+		const char *pszWild;
+		const char *pszTame;
+		bool        bExpected;
+	}
+	s_rgCases[] =
+	{
+		{ "/srv/**/*.log", "/srv/a/b/c.log", true },
+		{ "/srv/**/*.log", "/srv/c.log", true },
+		{ "/srv/**/*.log", "/srv/c.txt", false },
+		{ "/srv/*/c.log", "/srv/a/b/c.log", false },
+		{ "/srv/?/c.log", "/srv/a/c.log", true },
+		{ "**", "", true },
+		{ "**/b/**/b", "a/b/b/c/b", true },
+		{ "**/b/**/b", "a/b/c", false },
+		{ "a", "a/", false },
+		{ "a/", "a/", true },
+		{ "a/**/**/b", "a/b", true },
+		{ "x*y/**", "xAy/q", true }
+	};
+	WildTokenDictionary   dictionary;
+	WildTokenPattern      pattern;
+	std::vector<uint32_t> rgIds;
+	bool                  bAllPassed = true;
+
+	for (const auto &test : s_rgCases)
+	{
+		pattern.Compile(test.pszWild, dictionary);
+		dictionary.Tokenize(test.pszTame, rgIds);
+		bAllPassed &= pattern.Match(rgIds.data(), rgIds.size()) ==
+		              test.bExpected;
+	}
+
+	// Compiling interns literal components only.
+	size_t cIds = dictionary.Count();
+
+	pattern.Compile("**/new*/?/*/fresh", dictionary);
+	bAllPassed &= dictionary.Count() == cIds + 1;
+
+	static const char *s_rgszWild[] = { "**", "*", "a", "b", "a*", "?b", "" };
+	static const char *s_rgszTame[] = { "a", "b", "ab", "bb", "" };
+	WildBenchRandom    rng(909);
+	std::vector<std::string> rgstrWild, rgstrTame;
+
+	for (int iRound = 0; iRound < 100000; ++iRound)
+	{
+		std::string strWild, strTame;
+		size_t      cWild = 1 + rng.Below(6);
+		size_t      cTame = 1 + rng.Below(8);
+
+		for (size_t i = 0; i < cWild; ++i)
+		{
+			strWild += (i ? "/" : "");
+			strWild += s_rgszWild[rng.Below(7)];
+		}
+
+		for (size_t i = 0; i < cTame; ++i)
+		{
+			strTame += (i ? "/" : "");
+			strTame += s_rgszTame[rng.Below(5)];
+		}
+
+		SplitComponents(strWild, rgstrWild);
+		SplitComponents(strTame, rgstrTame);
+		pattern.Compile(strWild.c_str(), dictionary);
+		dictionary.Tokenize(strTame.c_str(), rgIds);
+
+		if (pattern.Match(rgIds.data(), rgIds.size()) !=
+		    ReferenceTokens(rgstrWild, 0, rgstrTame, 0))
+		{
+			printf("Token match of \"%s\" against \"%s\" is wrong\n",
+			       strWild.c_str(), strTame.c_str());
+			bAllPassed = false;
+		}
+	}
+
+	if (bAllPassed)
+	{
+		printf("Passed token tests\n");
+	}
+	else
+	{
+		printf("Failed token tests\n");
+	}
+
+	return 0;
+}
+
+
+// Makes a deep path of 8 to 15 components, such as
+// "/data/tenant12/region3/.../part00042.parquet".
+//
+static void MakeDeepPath(WildBenchRandom &rng, std::string &strPath)
+{
+	static const char *s_rgszDirs[] =
+	{
+		"data", "tenant", "region", "year", "month", "day", "hour", "shard",
+		"logs", "cache", "build", "tmp", "archive", "prod", "stage", "user"
+	};
+	static const char *s_rgszExts[] =
+	{
+		".log", ".parquet", ".json", ".tar.gz"
+	};
+	size_t cDirs = 7 + rng.Below(8);
+	char   szNum[16];
+
+	strPath.clear();
+
+	for (size_t i = 0; i < cDirs; ++i)
+	{
+		strPath += "/";
+		strPath += s_rgszDirs[rng.Below(16)];
+
+		if (rng.Below(2))
+		{
+			snprintf(szNum, sizeof(szNum), "%u", rng.Below(50));
+			strPath += szNum;
+		}
+	}
+
+	snprintf(szNum, sizeof(szNum), "/part%05u", rng.Below(100000));
+	strPath += szNum;
+	strPath += s_rgszExts[rng.Below(4)];
+}
+
+
+// Compares token matching of interned paths with FastWildCompare() on the
+// joined strings, for rules in the style of retention and access policies.
+// The byte-level rules use '*' where the token rules use "**" or a
+// component glob, so their results differ where a '*' crosses a '/'.
+//
+extern "C" int benchtoken(void)
+{
+	static const struct
+	{
+		const char *pszTokens;
+		const char *pszBytes;
+	}
+	s_rgRules[] =
+	{
+		{ "/data/**/*.parquet", "/data/*.parquet" },
+		{ "/data/**/logs/**/*.log", "/data/*/logs/*.log" },
+		{ "/**/cache*/**", "/*/cache*" },
+		{ "/data/tenant*/**/prod/**", "/data/tenant*/prod/*" },
+		{ "/**/archive/**/part0000?.*", "/*/archive/*/part0000?.*" },
+		{ "/user/**/tmp/*", "/user/*/tmp/*" }
+	};
+	const size_t          cPaths = 100000;
+	const int             cRules = sizeof(s_rgRules) / sizeof(s_rgRules[0]);
+	WildBenchRandom       rng(99);
+	WildTokenDictionary   dictionary;
+	std::vector<std::string> rgstrPaths(cPaths);
+	std::vector<uint32_t> rgIds, rgOffsets(1, 0);
+	WildTokenPattern      rgPattern[cRules];
+	size_t                cbPaths = 0;
+
+	for (size_t i = 0; i < cPaths; ++i)
+	{
+		MakeDeepPath(rng, rgstrPaths[i]);
+		cbPaths += rgstrPaths[i].size();
+
+		std::vector<uint32_t> rgPathIds;
+
+		dictionary.Tokenize(rgstrPaths[i].c_str(), rgPathIds);
+		rgIds.insert(rgIds.end(), rgPathIds.begin(), rgPathIds.end());
+		rgOffsets.push_back((uint32_t) rgIds.size());
+	}
+
+	for (int i = 0; i < cRules; ++i)
+	{
+		rgPattern[i].Compile(s_rgRules[i].pszTokens, dictionary);
+	}
+
+	uint64_t uHitsBytes = 0, uResolves = 0;
+	uint64_t uStart = WildBenchNanos();
+
+	for (int i = 0; i < cRules; ++i)
+	{
+		for (size_t iPath = 0; iPath < cPaths; ++iPath)
+		{
+			uHitsBytes += FastWildCompare(
+			    const_cast<char *>(s_rgRules[i].pszBytes),
+			    const_cast<char *>(rgstrPaths[iPath].c_str()));
+		}
+	}
+
+	double cMatches = (double) cRules * cPaths;
+
+	printf("Tokens, %d rules x %zu paths (%.1f bytes, %.1f components "
+	       "each, %zu distinct):\n  FastWildCompare %.1f ns/match "
+	       "(%llu hits)\n", cRules, cPaths, (double) cbPaths / cPaths,
+	       (double) rgIds.size() / cPaths, dictionary.Count(),
+	       (WildBenchNanos() - uStart) / cMatches,
+	       (unsigned long long) uHitsBytes);
+
+	// The first pass resolves each glob for each component it meets; the
+	// second finds every answer cached, as repeated scans of a store would.
+	for (int iPass = 0; iPass < 2; ++iPass)
+	{
+		uint64_t uHitsTokens = 0;
+
+		uStart = WildBenchNanos();
+
+		for (int i = 0; i < cRules; ++i)
+		{
+			for (size_t iPath = 0; iPath < cPaths; ++iPath)
+			{
+				uHitsTokens += rgPattern[i].Match(
+				    rgIds.data() + rgOffsets[iPath],
+				    rgOffsets[iPath + 1] - rgOffsets[iPath]);
+			}
+		}
+
+		uint64_t uNanos = WildBenchNanos() - uStart;
+
+		uResolves = 0;
+
+		for (int i = 0; i < cRules; ++i)
+		{
+			uResolves += rgPattern[i].ResolveCount();
+		}
+
+		printf("  tokens, %s: %.1f ns/match (%llu hits, %llu glob "
+		       "resolutions so far)\n", iPass ? "warm" : "cold",
+		       uNanos / cMatches, (unsigned long long) uHitsTokens,
+		       (unsigned long long) uResolves);
+	}
+
+	return 0;
+}
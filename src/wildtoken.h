@@ -0,0 +1,133 @@
+// WildTokenPattern, wildcard matching over sequences of interned path or
+// topic components
+//
+// Copyright 2025 Kirk J Krauss.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// A store that keeps paths as sequences of interned component IDs can
+// match them without ever joining the components into a string.  A token
+// pattern is a path pattern split at its separators.  Each component of
+// the pattern becomes one element:
+//
+//   "**"        any run of components, including none: the token '*'
+//   "*" or "?"  exactly one component: the token '?'
+//   "cache*"    one component that matches a byte-level pattern
+//   "logs"      one component with that ID
+//
+// Matching runs FastWildCompare()'s algorithm over IDs: elements ahead of
+// the first "**" and after the last one are anchored, and the rest are
+// placed leftmost with one fallback point.  A literal element costs one
+// integer compare.  A byte-level element is resolved with
+// FastWildCompare() the first time each distinct component ID meets it,
+// and remembered, so a deep path typically costs a handful of compares.
+//
+#ifndef WILDTOKEN_H
+#define WILDTOKEN_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Interns components, giving each distinct one a small dense ID.
+//
+class WildTokenDictionary
+{
+public:
+	// Returns the ID of a component, adding it if it's new.
+	uint32_t Intern(const char *pText, size_t cbText);
+
+	// Splits a path at each separator and interns its components.  A
+	// leading separator yields an empty first component, as does a
+	// trailing one at the end, so that joining the components gives the
+	// path back.
+	void Tokenize(const char *pPath, std::vector<uint32_t> &rgIds,
+	              char chSeparator = '/');
+
+	const std::string &Text(uint32_t uId) const
+	{
+		return m_rgstrText[uId];
+	}
+
+	size_t Count() const
+	{
+		return m_rgstrText.size();
+	}
+
+private:
+	std::unordered_map<std::string, uint32_t> m_mapIds;
+	std::vector<std::string>                  m_rgstrText;
+};
+
+
+class WildTokenPattern
+{
+public:
+	WildTokenPattern();
+
+	// Compiles a path pattern against a dictionary, which must outlive the
+	// pattern.  Literal components are interned; wildcard ones are not.
+	void Compile(const char *pWild, WildTokenDictionary &dictionary,
+	             char chSeparator = '/');
+
+	// Matches a sequence of cIds component IDs from the same dictionary.
+	// Results for byte-level elements are cached in the pattern, so one
+	// pattern should be used by one thread at a time.
+	bool Match(const uint32_t *rgIds, size_t cIds);
+
+	// Byte-level element resolutions so far, for measuring the cache.
+	uint64_t ResolveCount() const
+	{
+		return m_cResolves;
+	}
+
+private:
+	enum WildTokenKind
+	{
+		WILD_TOKEN_LITERAL,   // One component with a given ID
+		WILD_TOKEN_ONE,       // Any one component
+		WILD_TOKEN_GLOB,      // One component matching a byte pattern
+		WILD_TOKEN_STAR       // Any run of components
+	};
+
+	struct WildTokenElement
+	{
+		WildTokenKind kind;
+		uint32_t      uValue;   // The ID, or the index of the glob
+	};
+
+	// A byte-level element, with what's known so far for each component
+	// ID: 0 not yet resolved, 1 no match, 2 a match.
+	struct WildTokenGlob
+	{
+		std::string          strWild;
+		std::vector<uint8_t> rgKnown;
+	};
+
+	bool ElementMatches(const WildTokenElement &element, uint32_t uId);
+
+	std::vector<WildTokenElement> m_rgElements;
+	std::vector<WildTokenGlob>    m_rgGlobs;
+	const WildTokenDictionary    *m_pDictionary;
+	size_t                        m_cPrefix;   // Elements ahead of any "**"
+	size_t                        m_cSuffix;   // Elements after the last one
+	bool                          m_bStar;
+	uint64_t                      m_cResolves;
+};
+
+extern "C" int testtoken(void);
+extern "C" int benchtoken(void);
+
+#endif  // WILDTOKEN_H